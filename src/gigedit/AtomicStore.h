@@ -0,0 +1,45 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_ATOMICSTORE_H
+#define GIGEDIT_ATOMICSTORE_H
+
+#include <stddef.h>
+
+template<typename T, bool lockFree =
+    (sizeof(T) <= sizeof(void*) && (sizeof(T) & (sizeof(T) - 1)) == 0 &&
+     alignof(T) >= sizeof(T))>
+struct AtomicStoreImpl {
+    static void store(T& dst, const T& value) {
+        dst = value;
+    }
+};
+
+template<typename T>
+struct AtomicStoreImpl<T, true> {
+    static void store(T& dst, T value) {
+#if defined(__GNUC__)
+        __atomic_store(&dst, &value, __ATOMIC_RELEASE);
+#else
+        dst = value;
+#endif
+    }
+};
+
+/**
+ * Writes @a value to @a dst, which may concurrently be read by the sampler's
+ * audio thread. The value is stored as one single atomic write if the type
+ * allows that (i.e. for all numbers, enums and pointers), so the other thread
+ * either sees the old or the new value, but never a partially written one.
+ * Larger types are simply assigned.
+ */
+template<typename T>
+inline void atomicStore(T& dst, const T& value) {
+    AtomicStoreImpl<T>::store(dst, value);
+}
+
+#endif // GIGEDIT_ATOMICSTORE_H
@@ -0,0 +1,248 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "BatchMode.h"
+#include "FileOperations.h"
+#include "InPlaceSave.h"
+#include "ParallelFor.h"
+#include "Settings.h"
+
+#include <glibmm/init.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace {
+
+struct BatchOptions {
+    int jobs;
+    bool removeUnused;
+    bool save;
+    std::vector<Serialization::Archive> macros;
+    std::vector< std::pair<std::string,std::string> > repoints;
+
+    BatchOptions() : jobs(-1), removeUnused(false), save(true) {}
+};
+
+struct BatchResult {
+    bool ok;
+    double seconds;
+    std::string message;
+};
+
+void printUsage() {
+    printf(
+        "Usage: gigedit --batch [OPTIONS] FILE...\n"
+        "\n"
+        "Applies the given operations to all given .gig files without GUI.\n"
+        "\n"
+        "  -j, --jobs N               process N files concurrently (default: number of CPU cores)\n"
+        "  -m, --macro NAME           apply the saved macro NAME (or its number) to all dimension regions\n"
+        "  -u, --remove-unused-samples\n"
+        "                             delete all samples not used by any instrument\n"
+        "  -r, --repoint OLD=NEW      let all dimension regions using sample OLD use sample NEW instead\n"
+        "  -n, --no-save              apply the operations, but do not save the files\n"
+        "  -h, --help                 show this help\n"
+    );
+}
+
+/// Resolves a saved macro by its name or by its number (starting with 1).
+bool findMacro(const std::vector<Serialization::Archive>& macros,
+               const std::string& name, Serialization::Archive& macro)
+{
+    for (size_t i = 0; i < macros.size(); ++i) {
+        if (macros[i].name() == name) {
+            macro = macros[i];
+            return true;
+        }
+    }
+    char* end = NULL;
+    const long index = strtol(name.c_str(), &end, 10);
+    if (end && !*end && index >= 1 && index <= (long) macros.size()) {
+        macro = macros[index - 1];
+        return true;
+    }
+    return false;
+}
+
+/// libgig shares some lookup tables (i.e. velocity curves) among all files,
+/// so the instruments of several files must not be loaded or destroyed
+/// concurrently.
+std::mutex g_loadMutex;
+
+void unloadFile(gig::File* gig, RIFF::File* riff) {
+    std::lock_guard<std::mutex> lock(g_loadMutex);
+    if (gig) delete gig;
+    if (riff) delete riff;
+}
+
+void processFile(const std::string& path, const BatchOptions& options,
+                 std::string& report)
+{
+    RIFF::File* riff = NULL;
+    gig::File* gig = NULL;
+    try {
+        {
+            std::lock_guard<std::mutex> lock(g_loadMutex);
+            riff = new RIFF::File(path);
+            gig = new gig::File(riff);
+            gig->GetFirstSample();
+            gig->GetFirstInstrument();
+        }
+
+        bool structureChanged = false;
+        bool changed = false;
+
+        for (size_t i = 0; i < options.macros.size(); ++i) {
+            // each file gets its own copy of the macro, as resolving a macro
+            // is not thread safe
+            Serialization::Archive macro = options.macros[i];
+            // updates libgig's shared lookup tables as well
+            std::unique_lock<std::mutex> lock(g_loadMutex);
+            const int n = applyMacroToFile(gig, macro);
+            lock.unlock();
+            report += "macro '" + macro.name() + "' applied to " +
+                      ToString(n) + " dimension regions; ";
+            if (n) changed = true;
+        }
+        for (size_t i = 0; i < options.repoints.size(); ++i) {
+            const int n = repointSampleReferences(gig, options.repoints[i].first,
+                                                  options.repoints[i].second);
+            report += ToString(n) + " references of '" +
+                      options.repoints[i].first + "' repointed; ";
+            if (n) changed = structureChanged = true;
+        }
+        if (options.removeUnused) {
+            const int n = removeUnusedSamples(gig);
+            report += ToString(n) + " unused samples removed; ";
+            if (n) changed = structureChanged = true;
+        }
+
+        if (!changed) {
+            report += "unchanged";
+        } else if (!options.save) {
+            report += "not saved";
+        } else if (!structureChanged && saveArticulationInPlace(gig) >= 0) {
+            report += "saved in place";
+        } else {
+            gig->Save();
+            report += "saved";
+        }
+    } catch (...) {
+        unloadFile(gig, riff);
+        throw;
+    }
+    unloadFile(gig, riff);
+}
+
+} // namespace
+
+bool isBatchModeRequested(int argc, char* argv[]) {
+    return argc >= 2 && !strcmp(argv[1], "--batch");
+}
+
+int runBatchMode(int argc, char* argv[]) {
+    BatchOptions options;
+    std::vector<std::string> files;
+    std::vector<Serialization::Archive> savedMacros;
+    bool macrosLoaded = false;
+
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = (i + 1 < argc);
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if ((arg == "-j" || arg == "--jobs") && hasValue) {
+            options.jobs = atoi(argv[++i]);
+        } else if ((arg == "-m" || arg == "--macro") && hasValue) {
+            if (!macrosLoaded) {
+                // Settings is a Glib::Object, which requires glibmm to be
+                // initialized, which is otherwise done by Gtk::Main
+                Glib::init();
+                Settings::singleton()->loadMacros(savedMacros);
+                macrosLoaded = true;
+            }
+            Serialization::Archive macro;
+            if (!findMacro(savedMacros, argv[++i], macro)) {
+                fprintf(stderr, "No saved macro '%s'\n", argv[i]);
+                return 2;
+            }
+            options.macros.push_back(macro);
+        } else if (arg == "-u" || arg == "--remove-unused-samples") {
+            options.removeUnused = true;
+        } else if ((arg == "-r" || arg == "--repoint") && hasValue) {
+            const std::string value = argv[++i];
+            const size_t pos = value.find('=');
+            if (pos == std::string::npos) {
+                fprintf(stderr, "Expected OLD=NEW for %s\n", arg.c_str());
+                return 2;
+            }
+            options.repoints.push_back(
+                std::make_pair(value.substr(0, pos), value.substr(pos + 1))
+            );
+        } else if (arg == "-n" || arg == "--no-save") {
+            options.save = false;
+        } else if (!arg.empty() && arg[0] == '-') {
+            fprintf(stderr, "Unknown or incomplete option '%s'\n\n", arg.c_str());
+            printUsage();
+            return 2;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    std::vector<BatchResult> results(files.size());
+    std::mutex printMutex;
+    const auto batchStart = std::chrono::steady_clock::now();
+
+    parallelFor(files.size(), [&](size_t i) {
+        const auto start = std::chrono::steady_clock::now();
+        BatchResult& result = results[i];
+        try {
+            processFile(files[i], options, result.message);
+            result.ok = true;
+        } catch (RIFF::Exception e) {
+            result.ok = false;
+            result.message = e.Message;
+        } catch (Serialization::Exception e) {
+            result.ok = false;
+            result.message = e.Message;
+        } catch (...) {
+            result.ok = false;
+            result.message = "unknown exception";
+        }
+        result.seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+
+        std::lock_guard<std::mutex> lock(printMutex);
+        printf("[%s] %s (%.3f s): %s\n", result.ok ? "ok" : "error",
+               files[i].c_str(), result.seconds, result.message.c_str());
+        fflush(stdout);
+    }, options.jobs);
+
+    int failed = 0;
+    for (size_t i = 0; i < results.size(); ++i)
+        if (!results[i].ok) ++failed;
+    const double total = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - batchStart
+    ).count();
+    printf("%d of %d files processed successfully in %.3f s.\n",
+           int(files.size()) - failed, int(files.size()), total);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,26 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_BATCHMODE_H
+#define GIGEDIT_BATCHMODE_H
+
+/**
+ * Returns true if the command line requests batch mode (that is if the first
+ * argument is "--batch").
+ */
+bool isBatchModeRequested(int argc, char* argv[]);
+
+/**
+ * Runs gigedit without GUI: applies the operations given on the command line
+ * to all .gig files given on the command line, processing several files
+ * concurrently, and prints timing and errors for each file to stdout.
+ *
+ * @returns process exit code (0: success, 1: some file failed, 2: bad usage)
+ */
+int runBatchMode(int argc, char* argv[]);
+
+#endif // GIGEDIT_BATCHMODE_H
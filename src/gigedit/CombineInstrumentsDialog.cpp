@@ -7,6 +7,7 @@
 
 #include "global.h"
 #include "CombineInstrumentsDialog.h"
+#include "JobScheduler.h"
 
 // enable this for debug messages being printed while combining the instruments
 #define DEBUG_COMBINE_INSTRUMENTS 0
@@ -14,6 +15,8 @@
 #include "compat.h"
 
 #include <set>
+#include <atomic>
+#include <functional>
 #include <iostream>
 #include <assert.h>
 #include <stdarg.h>
@@ -28,6 +31,7 @@
 #include <gtk/gtkwidget.h> // for gtk_widget_modify_*()
 
 Glib::ustring dimTypeAsString(gig::dimension_t d);
+Glib::ustring note_str(int note);
 
 typedef std::vector< std::pair<gig::Instrument*, gig::Region*> > OrderedRegionGroup;
 typedef std::map<gig::Instrument*, gig::Region*> RegionGroup;
@@ -40,10 +44,38 @@ typedef std::map<gig::dimension_t, int> DimensionRegionUpperLimits;
 
 typedef std::set<Glib::ustring> Warnings;
 
+/**
+ * Regions of an instrument to be combined. They are collected on the GUI
+ * thread, so that the jobs below never have to use the instrument's region
+ * iteration methods, which are not thread safe.
+ */
+struct SourceInstrument {
+    gig::Instrument* instrument;
+    std::vector<gig::Region*> regions;
+};
+typedef std::vector<SourceInstrument> SourceInstruments;
+
+/// Region of the combined instrument to be created.
+struct CombinePlanRegion {
+    DLS::range_t keyRange;
+    OrderedRegionGroup sources; ///< source regions, in order of the instruments
+    Dimensions dims; ///< dimensions to be created, except of the main dimension
+    int mainZones; ///< zones of the main dimension, which is not created if 1
+};
+
+/// Result of the planning phase of combining instruments.
+struct CombinePlan {
+    gig::dimension_t mainDimension;
+    SourceInstruments instruments;
+    std::vector<CombinePlanRegion> regions;
+    Warnings warnings;
+};
+
 ///////////////////////////////////////////////////////////////////////////
 // private static data
 
-static Warnings g_warnings;
+/// Where addWarning() stores warnings of the job running on the current thread.
+static thread_local Warnings* t_warnings = NULL;
 
 ///////////////////////////////////////////////////////////////////////////
 // private functions
@@ -74,9 +106,20 @@ inline void addWarning(const char* fmt, ...) {
     delete [] buf;
     va_end(arg);
     std::cerr << _("WARNING:") << " " << s << std::endl << std::flush;
-    g_warnings.insert(s);
+    if (t_warnings) t_warnings->insert(s);
 }
 
+/// Directs addWarning() calls of the current thread to a warnings list.
+class WarningsScope {
+public:
+    WarningsScope(Warnings* warnings) : m_previous(t_warnings) {
+        t_warnings = warnings;
+    }
+    ~WarningsScope() { t_warnings = m_previous; }
+private:
+    Warnings* m_previous;
+};
+
 /**
  * If the two ranges overlap, then this function returns the smallest point
  * within that overlapping zone. If the two ranges do not overlap, then this
@@ -96,12 +139,12 @@ inline int smallestOverlapPoint(const DLS::range_t& r1, const DLS::range_t& r2)
  * @returns very first region point >= iStart, or -1 if no region could be
  *          found with a range member point >= iStart
  */
-static int findLowestRegionPoint(std::vector<gig::Instrument*>& instruments, int iStart) {
+static int findLowestRegionPoint(const SourceInstruments& instruments, int iStart) {
     DLS::range_t searchRange = { uint16_t(iStart), 127 };
     int result = -1;
     for (uint i = 0; i < instruments.size(); ++i) {
-        gig::Instrument* instr = instruments[i];
-        for (gig::Region* rgn = instr->GetFirstRegion(); rgn; rgn = instr->GetNextRegion()) {
+        for (uint r = 0; r < instruments[i].regions.size(); ++r) {
+            gig::Region* rgn = instruments[i].regions[r];
             if (rgn->KeyRange.overlaps(searchRange)) {
                 int lowest = smallestOverlapPoint(rgn->KeyRange, searchRange);
                 if (result == -1 || lowest < result) result = lowest;
@@ -118,12 +161,12 @@ static int findLowestRegionPoint(std::vector<gig::Instrument*>& instruments, int
  * @returns very first region end >= iStart, or -1 if no region could be found
  *          with a range end >= iStart
  */
-static int findFirstRegionEnd(std::vector<gig::Instrument*>& instruments, int iStart) {
+static int findFirstRegionEnd(const SourceInstruments& instruments, int iStart) {
     DLS::range_t searchRange = { uint16_t(iStart), 127 };
     int result = -1;
     for (uint i = 0; i < instruments.size(); ++i) {
-        gig::Instrument* instr = instruments[i];
-        for (gig::Region* rgn = instr->GetFirstRegion(); rgn; rgn = instr->GetNextRegion()) {
+        for (uint r = 0; r < instruments[i].regions.size(); ++r) {
+            gig::Region* rgn = instruments[i].regions[r];
             if (rgn->KeyRange.overlaps(searchRange)) {
                 if (result == -1 || rgn->KeyRange.high < result)
                     result = rgn->KeyRange.high;
@@ -137,10 +180,11 @@ static int findFirstRegionEnd(std::vector<gig::Instrument*>& instruments, int iS
  * Returns a list of all regions of the given @a instrument where the respective
  * region's key range overlaps the given @a range.
  */
-static std::vector<gig::Region*> getAllRegionsWhichOverlapRange(gig::Instrument* instrument, DLS::range_t range) {
+static std::vector<gig::Region*> getAllRegionsWhichOverlapRange(const SourceInstrument& instrument, DLS::range_t range) {
     //std::cout << "All regions which overlap { " << (int)range.low << ".." << (int)range.high << " } : " << std::flush;
     std::vector<gig::Region*> v;
-    for (gig::Region* rgn = instrument->GetFirstRegion(); rgn; rgn = instrument->GetNextRegion()) {
+    for (uint r = 0; r < instrument.regions.size(); ++r) {
+        gig::Region* rgn = instrument.regions[r];
         if (rgn->KeyRange.overlaps(range)) {
             v.push_back(rgn);
             //std::cout << (int)rgn->KeyRange.low << ".." << (int)rgn->KeyRange.high << ", " << std::flush;
@@ -155,16 +199,15 @@ static std::vector<gig::Region*> getAllRegionsWhichOverlapRange(gig::Instrument*
  * key range overlaps the given @a range. The regions returned are ordered (in a
  * map) by their instrument pointer.
  */
-static RegionGroup getAllRegionsWhichOverlapRange(std::vector<gig::Instrument*>& instruments, DLS::range_t range) {
+static RegionGroup getAllRegionsWhichOverlapRange(const SourceInstruments& instruments, DLS::range_t range) {
     RegionGroup group;
     for (uint i = 0; i < instruments.size(); ++i) {
-        gig::Instrument* instr = instruments[i];
-        std::vector<gig::Region*> v = getAllRegionsWhichOverlapRange(instr, range);
+        std::vector<gig::Region*> v = getAllRegionsWhichOverlapRange(instruments[i], range);
         if (v.empty()) continue;
         if (v.size() > 1) {
             addWarning("More than one region found!");
         }
-        group[instr] = v[0];
+        group[instruments[i].instrument] = v[0];
     }
     return group;
 }
@@ -184,14 +227,18 @@ static RegionGroup getAllRegionsWhichOverlapRange(std::vector<gig::Instrument*>&
  *      created.
  *
  * @param instruments - list of instruments that are planned to be combined
+ * @param cancel - optional, grouping is aborted as soon as it becomes true
  * @returns structured result of the tasks described above
  */
-static RegionGroups groupByRegionIntersections(std::vector<gig::Instrument*>& instruments) {
+static RegionGroups groupByRegionIntersections(const SourceInstruments& instruments,
+                                               const std::atomic<bool>* cancel)
+{
     RegionGroups groups;
 
     // find all region intersections of all instruments
     std::vector<DLS::range_t> intersections;
     for (int iStart = 0; iStart <= 127; ) {
+        if (cancel && *cancel) return groups;
         iStart = findLowestRegionPoint(instruments, iStart);
         if (iStart < 0) break;
         const int iEnd = findFirstRegionEnd(instruments, iStart);
@@ -202,6 +249,7 @@ static RegionGroups groupByRegionIntersections(std::vector<gig::Instrument*>& in
 
     // now sort all regions to those found intersections
     for (uint i = 0; i < intersections.size(); ++i) {
+        if (cancel && *cancel) return groups;
         const DLS::range_t& range = intersections[i];
         RegionGroup group = getAllRegionsWhichOverlapRange(instruments, range);
         if (!group.empty())
@@ -556,12 +604,12 @@ static void scheduleCopyDimensionRegions(gig::Region* outRgn, gig::Region* inRgn
     }
 }
 
-static OrderedRegionGroup sortRegionGroup(const RegionGroup& group, const std::vector<gig::Instrument*>& instruments) {
+static OrderedRegionGroup sortRegionGroup(const RegionGroup& group, const SourceInstruments& instruments) {
     OrderedRegionGroup result;
-    for (std::vector<gig::Instrument*>::const_iterator it = instruments.begin();
+    for (SourceInstruments::const_iterator it = instruments.begin();
          it != instruments.end(); ++it)
     {
-        RegionGroup::const_iterator itRgn = group.find(*it);
+        RegionGroup::const_iterator itRgn = group.find(it->instrument);
         if (itRgn == group.end()) continue;
         result.push_back(
             std::pair<gig::Instrument*, gig::Region*>(
@@ -572,43 +620,29 @@ static OrderedRegionGroup sortRegionGroup(const RegionGroup& group, const std::v
     return result;
 }
 
-/** @brief Combine given list of instruments to one instrument.
+/** @brief Plan combining given list of instruments to one instrument.
  *
- * Takes a list of @a instruments as argument and combines them to one single
- * new @a output instrument. For this task, it will create a dimension of type
- * given by @a mainDimension in the new instrument and copies the source
- * instruments to those dimension zones.
+ * Identifies the regions (see groupByRegionIntersections()) and dimensions
+ * (see getDimensionsForRegionGroup()) of the new instrument combining the
+ * instruments of @a plan, without creating anything yet. Since the source
+ * instruments are only read, this is safe to be called on a worker thread
+ * while the file is not being modified.
  *
- * @param instruments - (input) list of instruments that shall be combined,
- *                      they will only be read, so they will be left untouched
- * @param gig - (input/output) .gig file where the new combined instrument shall
- *              be created
- * @param output - (output) on success this pointer will be set to the new
- *                 instrument being created
- * @param mainDimension - the dimension that shall be used to combine the
- *                        instruments
- * @throw RIFF::Exception on any kinds of errors
+ * @param plan - (input/output) main dimension and source instruments are
+ *               expected to be set, the regions to be created are added
+ * @param cancel - optional, planning is aborted as soon as it becomes true
  */
-static void combineInstruments(std::vector<gig::Instrument*>& instruments, gig::File* gig, gig::Instrument*& output, gig::dimension_t mainDimension) {
-    output = NULL;
-
+static void planCombination(CombinePlan& plan, const std::atomic<bool>* cancel) {
     // divide the individual regions to (probably even smaller) groups of
     // regions, coping with the fact that the source regions of the instruments
     // might have quite different range sizes and start and end points
-    RegionGroups groups = groupByRegionIntersections(instruments);
+    RegionGroups groups = groupByRegionIntersections(plan.instruments, cancel);
     #if DEBUG_COMBINE_INSTRUMENTS
     std::cout << std::endl << "New regions: " << std::flush;
     printRanges(groups);
     std::cout << std::endl;
     #endif
 
-    if (groups.empty())
-        throw gig::Exception(_("No regions found to create a new instrument with."));
-
-    // create a new output instrument
-    gig::Instrument* outInstr = gig->AddInstrument();
-    outInstr->pInfo->Name = _("NEW COMBINATION");
-
     // Distinguishing in the following code block between 'horizontal' and
     // 'vertical' regions. The 'horizontal' ones are meant to be the key ranges
     // in the output instrument, while the 'vertical' regions are meant to be
@@ -616,81 +650,126 @@ static void combineInstruments(std::vector<gig::Instrument*>& instruments, gig::
     // region / key range. It is important to know, that the key ranges defined
     // in the 'horizontal' and 'vertical' regions might differ.
 
-    // merge the instruments to the new output instrument
     for (RegionGroups::iterator itGroup = groups.begin();
          itGroup != groups.end(); ++itGroup) // iterate over 'horizontal' / target regions ...
     {
-        gig::Region* outRgn = outInstr->AddRegion();
-        outRgn->SetKeyRange(itGroup->first.low, itGroup->first.high);
-        #if DEBUG_COMBINE_INSTRUMENTS
-        printf("---> Start target region %d..%d\n", itGroup->first.low, itGroup->first.high);
-        #endif
+        if (cancel && *cancel) return;
+
+        CombinePlanRegion target;
+        target.keyRange = itGroup->first;
 
         // detect the total amount of zones required for the given main
         // dimension to build up this combi for current key range
-        int iTotalZones = 0;
+        target.mainZones = 0;
         for (RegionGroup::iterator itRgn = itGroup->second.begin();
              itRgn != itGroup->second.end(); ++itRgn)
         {
             gig::Region* inRgn = itRgn->second;
-            gig::dimension_def_t* def = inRgn->GetDimensionDefinition(mainDimension);
-            iTotalZones += (def) ? def->zones : 1;
+            gig::dimension_def_t* def = inRgn->GetDimensionDefinition(plan.mainDimension);
+            target.mainZones += (def) ? def->zones : 1;
+        }
+
+        // identify all required dimensions for this output region
+        // (except the main dimension used for separating the individual
+        // instruments, which is created separately by
+        // buildCombinedInstrument())
+        target.dims = getDimensionsForRegionGroup(itGroup->second);
+        // the main dimension should not be part of dims here, because dims is
+        // also used for iterating all dimensions zones, which would lead to
+        // this dimensions being iterated twice
+        target.dims.erase(plan.mainDimension);
+        // prevent a misbehavior (i.e. crash) of the combine algorithm in case
+        // one of the source instruments has a dimension with only one zone,
+        // which is not standard conform
+        for (Dimensions::iterator itDim = target.dims.begin();
+             itDim != target.dims.end(); )
+        {
+            if (itDim->second.size() < 2) {
+                addWarning(
+                    "Attempt to create dimension with type=0x%x with only "
+                    "ONE zone (because at least one of the source "
+                    "instruments seems to have such a velocity dimension "
+                    "with only ONE zone, which is odd)! Skipping this "
+                    "dimension for now.",
+                    (int)itDim->first
+                );
+                target.dims.erase(itDim++);
+            } else {
+                ++itDim;
+            }
         }
+
+        // for the copy task we need to have the current RegionGroup to be
+        // sorted by instrument in the same sequence as the instruments to be
+        // combined (because the std::map behind the 'RegionGroup' type sorts by
+        // memory address instead, and that would sometimes lead to the source
+        // instruments' region to be sorted into the wrong target layer)
+        target.sources = sortRegionGroup(itGroup->second, plan.instruments);
+
+        plan.regions.push_back(target);
+    }
+}
+
+/** @brief Combine planned list of instruments to one instrument.
+ *
+ * Creates the regions and dimensions identified by planCombination() in the
+ * new, empty @a outInstr and copies the source instruments' dimension regions
+ * to the respective zones of the main dimension.
+ *
+ * @param plan - (input) result of planCombination(), the source instruments
+ *               will only be read, so they will be left untouched
+ * @param outInstr - (output) new instrument to be filled
+ * @param cancel - optional, combining is aborted as soon as it becomes true
+ * @param progress - optional, called with the fraction done so far
+ * @throw RIFF::Exception on any kinds of errors
+ */
+static void buildCombinedInstrument(const CombinePlan& plan, gig::Instrument* outInstr,
+                                    const std::atomic<bool>* cancel,
+                                    std::function<void(float)> progress)
+{
+    if (plan.regions.empty())
+        throw gig::Exception(_("No regions found to create a new instrument with."));
+
+    const gig::dimension_t mainDimension = plan.mainDimension;
+
+    // merge the instruments to the new output instrument
+    for (size_t iRegion = 0; iRegion < plan.regions.size(); ++iRegion) // iterate over 'horizontal' / target regions ...
+    {
+        if (cancel && *cancel) return;
+        if (progress) progress(float(iRegion) / float(plan.regions.size()));
+
+        const CombinePlanRegion& target = plan.regions[iRegion];
+        gig::Region* outRgn = outInstr->AddRegion();
+        outRgn->SetKeyRange(target.keyRange.low, target.keyRange.high);
         #if DEBUG_COMBINE_INSTRUMENTS
-        printf("Required total zones: %d, vertical regions: %d\n", iTotalZones, itGroup->second.size());
+        printf("---> Start target region %d..%d\n", target.keyRange.low, target.keyRange.high);
+        printf("Required total zones: %d, vertical regions: %d\n", target.mainZones, (int)target.sources.size());
         #endif
 
         // create all required dimensions for this output region
         // (except the main dimension used for separating the individual
         // instruments, we create that particular dimension as next step)
-        Dimensions dims = getDimensionsForRegionGroup(itGroup->second);
-        // the given main dimension which is used to combine the instruments is
-        // created separately after the next code block, and the main dimension
-        // should not be part of dims here, because it also used for iterating
-        // all dimensions zones, which would lead to this dimensions being
-        // iterated twice
-        dims.erase(mainDimension);
+        for (Dimensions::const_iterator itDim = target.dims.begin();
+             itDim != target.dims.end(); ++itDim)
         {
-            std::vector<gig::dimension_t> skipTheseDimensions; // used to prevent a misbehavior (i.e. crash) of the combine algorithm in case one of the source instruments has a dimension with only one zone, which is not standard conform
-
-            for (Dimensions::iterator itDim = dims.begin();
-                itDim != dims.end(); ++itDim)
-            {
-                gig::dimension_def_t def;
-                def.dimension = itDim->first; // dimension type
-                def.zones = itDim->second.size();
-                def.bits = zoneCountToBits(def.zones);
-                if (def.zones < 2) {
-                    addWarning(
-                        "Attempt to create dimension with type=0x%x with only "
-                        "ONE zone (because at least one of the source "
-                        "instruments seems to have such a velocity dimension "
-                        "with only ONE zone, which is odd)! Skipping this "
-                        "dimension for now.",
-                        (int)itDim->first
-                    );
-                    skipTheseDimensions.push_back(itDim->first);
-                    continue;
-                }
-                #if DEBUG_COMBINE_INSTRUMENTS
-                std::cout << "Adding new regular dimension type=" << std::hex << (int)def.dimension << std::dec << ", zones=" << (int)def.zones << ", bits=" << (int)def.bits << " ... " << std::flush;
-                #endif
-                outRgn->AddDimension(&def);
-                #if DEBUG_COMBINE_INSTRUMENTS
-                std::cout << "OK" << std::endl << std::flush;
-                #endif
-            }
-            // prevent the following dimensions to be processed further below
-            // (since the respective dimension was not created above)
-            for (int i = 0; i < skipTheseDimensions.size(); ++i)
-                dims.erase(skipTheseDimensions[i]);
+            gig::dimension_def_t def;
+            def.dimension = itDim->first; // dimension type
+            def.zones = itDim->second.size();
+            def.bits = zoneCountToBits(def.zones);
+            #if DEBUG_COMBINE_INSTRUMENTS
+            std::cout << "Adding new regular dimension type=" << std::hex << (int)def.dimension << std::dec << ", zones=" << (int)def.zones << ", bits=" << (int)def.bits << " ... " << std::flush;
+            #endif
+            outRgn->AddDimension(&def);
+            #if DEBUG_COMBINE_INSTRUMENTS
+            std::cout << "OK" << std::endl << std::flush;
+            #endif
         }
 
         // create the main dimension (if necessary for current key range)
-        if (iTotalZones > 1) {
+        if (target.mainZones > 1) {
             gig::dimension_def_t def;
             def.dimension = mainDimension; // dimension type
-            def.zones = iTotalZones;
+            def.zones = target.mainZones;
             def.bits = zoneCountToBits(def.zones);
             #if DEBUG_COMBINE_INSTRUMENTS
             std::cout << "Adding new main combi dimension type=" << std::hex << (int)def.dimension << std::dec << ", zones=" << (int)def.zones << ", bits=" << (int)def.bits << " ... " << std::flush;
@@ -699,24 +778,14 @@ static void combineInstruments(std::vector<gig::Instrument*>& instruments, gig::
             #if DEBUG_COMBINE_INSTRUMENTS
             std::cout << "OK" << std::endl << std::flush;
             #endif
-        } else {
-            dims.erase(mainDimension);
         }
 
-        // for the next task we need to have the current RegionGroup to be
-        // sorted by instrument in the same sequence as the 'instruments' vector
-        // argument passed to this function (because the std::map behind the
-        // 'RegionGroup' type sorts by memory address instead, and that would
-        // sometimes lead to the source instruments' region to be sorted into
-        // the wrong target layer)
-        OrderedRegionGroup currentGroup = sortRegionGroup(itGroup->second, instruments);
-
         // schedule copying the source dimension regions to the target dimension
         // regions
         CopyAssignSchedule schedule;
         int iDstMainBit = 0;
-        for (OrderedRegionGroup::iterator itRgn = currentGroup.begin();
-             itRgn != currentGroup.end(); ++itRgn) // iterate over 'vertical' / source regions ...
+        for (OrderedRegionGroup::const_iterator itRgn = target.sources.begin();
+             itRgn != target.sources.end(); ++itRgn) // iterate over 'vertical' / source regions ...
         {
             gig::Region* inRgn = itRgn->second;
             #if DEBUG_COMBINE_INSTRUMENTS
@@ -729,7 +798,7 @@ static void combineInstruments(std::vector<gig::Instrument*>& instruments, gig::
 
             for (uint iSrcMainBit = 0; iSrcMainBit < inRgnMainZones; ++iSrcMainBit, ++iDstMainBit) {
                 scheduleCopyDimensionRegions(
-                    outRgn, inRgn, dims, mainDimension,
+                    outRgn, inRgn, target.dims, mainDimension,
                     iDstMainBit, iSrcMainBit, &schedule
                 );
             }
@@ -737,6 +806,7 @@ static void combineInstruments(std::vector<gig::Instrument*>& instruments, gig::
 
         // finally copy the scheduled source -> target dimension regions
         for (uint i = 0; i < schedule.size(); ++i) {
+            if (cancel && *cancel) return;
             CopyAssignSchedEntry& e = schedule[i];
 
             // backup the target DimensionRegion's current dimension zones upper
@@ -751,6 +821,8 @@ static void combineInstruments(std::vector<gig::Instrument*>& instruments, gig::
             const gig::Region* const origRgn = e.dst->GetParent(); // just for sanity check below
             e.dst->CopyAssign(e.src);
             assert(origRgn == e.dst->GetParent()); // if gigedit is crashing here, then you must update libgig (to at least SVN r2547, v3.3.0.svn10)
+            // CopyAssign() does not take over sample references of another file
+            e.dst->pSample = e.src->pSample;
 
             // restore all original dimension zone upper limits except of the
             // velocity dimension, because the velocity dimension zone sizes are
@@ -773,11 +845,87 @@ static void combineInstruments(std::vector<gig::Instrument*>& instruments, gig::
             restoreDimensionRegionUpperLimits(e.dst, dstUpperLimits);
         }
     }
+}
+
+/**
+ * Adds a copy of @a instrument, which was built in another gig file, to
+ * @a gig. Sample references are not taken over by CopyAssign() across files,
+ * so they are restored here (they already refer to samples of @a gig).
+ */
+static gig::Instrument* addCombinedInstrument(gig::File* gig, gig::Instrument* instrument) {
+    gig::Instrument* outInstr = gig->AddInstrument();
+    outInstr->CopyAssign(instrument);
+    outInstr->pInfo->Name = _("NEW COMBINATION");
 
-    // success
-    output = outInstr;
+    gig::Region* srcRgn = instrument->GetFirstRegion();
+    for (gig::Region* dstRgn = outInstr->GetFirstRegion(); dstRgn && srcRgn;
+         dstRgn = outInstr->GetNextRegion(), srcRgn = instrument->GetNextRegion())
+    {
+        const int sz = sizeof(dstRgn->pDimensionRegions) / sizeof(gig::DimensionRegion*);
+        for (int i = 0; i < sz; ++i) {
+            if (dstRgn->pDimensionRegions[i] && srcRgn->pDimensionRegions[i])
+                dstRgn->pDimensionRegions[i]->pSample = srcRgn->pDimensionRegions[i]->pSample;
+        }
+    }
+    return outInstr;
 }
 
+///////////////////////////////////////////////////////////////////////////
+// jobs of class 'CombineInstrumentsDialog'
+
+/// Plans combining the selected instruments for the preview of CombineInstrumentsDialog.
+class CombineInstrumentsPlanJob : public Job {
+public:
+    CombineInstrumentsPlanJob(const std::shared_ptr<CombinePlan>& plan) :
+        Job(_("Planning instrument combination ..."), PRIORITY_HIGH),
+        plan(plan)
+    {
+        setOwnProgressDisplay(true);
+    }
+
+    const std::shared_ptr<CombinePlan> plan; ///< regions and warnings are valid once finished
+
+protected:
+    void run() {
+        WarningsScope scope(&plan->warnings);
+        planCombination(*plan, cancelToken());
+        checkCancelled();
+    }
+};
+
+/**
+ * Combines instruments on behalf of CombineInstrumentsDialog. The combined
+ * instrument is built in a private file, which is not visible to anybody else,
+ * so the open file is not touched before the dialog adds a copy of it there.
+ */
+class CombineInstrumentsJob : public Job {
+public:
+    CombineInstrumentsJob(const std::shared_ptr<const CombinePlan>& plan,
+                          const DLS::version_t* version) :
+        Job(_("Combining instruments ..."), PRIORITY_HIGH),
+        plan(plan), instrument(NULL)
+    {
+        setOwnProgressDisplay(true);
+        // same format as the open file, which affects the dimensions' zones
+        if (version && scratch.pVersion) *scratch.pVersion = *version;
+    }
+
+    const std::shared_ptr<const CombinePlan> plan;
+    gig::File scratch; ///< private file the combined instrument is built in
+    gig::Instrument* instrument; ///< combined instrument in scratch, valid once finished
+    Warnings warnings;
+
+protected:
+    void run() {
+        WarningsScope scope(&warnings);
+        instrument = scratch.AddInstrument();
+        buildCombinedInstrument(*plan, instrument, cancelToken(),
+            [this](float fraction) { setProgress(fraction); }
+        );
+        checkCancelled();
+    }
+};
+
 ///////////////////////////////////////////////////////////////////////////
 // class 'CombineInstrumentsDialog'
 
@@ -796,7 +944,8 @@ CombineInstrumentsDialog::CombineInstrumentsDialog(Gtk::Window& parent, gig::Fil
       m_tableDimCombo(2, 2),
 #endif
       m_comboDimType(),
-      m_labelDimType(Glib::ustring(_("Combine by Dimension:")) + "  ", Gtk::ALIGN_END)
+      m_labelDimType(Glib::ustring(_("Combine by Dimension:")) + "  ", Gtk::ALIGN_END),
+      m_previewLabel("", Gtk::ALIGN_START)
 {
     if (!Settings::singleton()->autoRestoreWindowDimension) {
         set_default_size(500, 600);
@@ -805,6 +954,8 @@ CombineInstrumentsDialog::CombineInstrumentsDialog(Gtk::Window& parent, gig::Fil
 
     m_scrolledWindow.add(m_treeView);
     m_scrolledWindow.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+    m_previewScrolledWindow.add(m_previewView);
+    m_previewScrolledWindow.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
 
 #if USE_GTKMM_BOX
     get_content_area()->pack_start(m_descriptionLabel, Gtk::PACK_SHRINK);
@@ -812,6 +963,9 @@ CombineInstrumentsDialog::CombineInstrumentsDialog(Gtk::Window& parent, gig::Fil
     get_content_area()->pack_start(m_scrolledWindow);
     get_content_area()->pack_start(m_labelOrder, Gtk::PACK_SHRINK);
     get_content_area()->pack_start(m_iconView, Gtk::PACK_SHRINK);
+    get_content_area()->pack_start(m_previewScrolledWindow);
+    get_content_area()->pack_start(m_previewLabel, Gtk::PACK_SHRINK);
+    get_content_area()->pack_start(m_progressBar, Gtk::PACK_SHRINK);
     get_content_area()->pack_start(m_buttonBox, Gtk::PACK_SHRINK);
 #else
     get_vbox()->pack_start(m_descriptionLabel, Gtk::PACK_SHRINK);
@@ -819,6 +973,9 @@ CombineInstrumentsDialog::CombineInstrumentsDialog(Gtk::Window& parent, gig::Fil
     get_vbox()->pack_start(m_scrolledWindow);
     get_vbox()->pack_start(m_labelOrder, Gtk::PACK_SHRINK);
     get_vbox()->pack_start(m_iconView, Gtk::PACK_SHRINK);
+    get_vbox()->pack_start(m_previewScrolledWindow);
+    get_vbox()->pack_start(m_previewLabel, Gtk::PACK_SHRINK);
+    get_vbox()->pack_start(m_progressBar, Gtk::PACK_SHRINK);
     get_vbox()->pack_start(m_buttonBox, Gtk::PACK_SHRINK);
 #endif
 
@@ -922,6 +1079,21 @@ CombineInstrumentsDialog::CombineInstrumentsDialog(Gtk::Window& parent, gig::Fil
 
     m_labelOrder.set_text(_("Order of the instruments to be combined:"));
 
+    m_refPreviewModel = Gtk::ListStore::create(m_previewColumns);
+    m_previewView.set_model(m_refPreviewModel);
+    m_previewView.set_tooltip_text(_(
+        "Regions the combined instrument will have, with their dimensions "
+        "(and zones) and the instruments (by order number) combined in them."
+    ));
+    m_previewView.append_column(_("Keys"), m_previewColumns.m_col_keys);
+    m_previewView.append_column(_("Dimensions"), m_previewColumns.m_col_dimensions);
+    m_previewView.append_column(_("Instruments"), m_previewColumns.m_col_instruments);
+    m_previewView.set_headers_visible(true);
+    m_previewView.get_selection()->set_mode(Gtk::SELECTION_NONE);
+#if GTKMM_MAJOR_VERSION >= 3
+    m_previewLabel.set_line_wrap();
+#endif
+
     // establish drag&drop within the instrument tree view, allowing to reorder
     // the sequence of instruments within the gig file
     {
@@ -962,6 +1134,10 @@ CombineInstrumentsDialog::CombineInstrumentsDialog(Gtk::Window& parent, gig::Fil
         sigc::mem_fun(*this, &CombineInstrumentsDialog::combineSelectedInstruments)
     );
 
+    m_comboDimType.signal_changed().connect(
+        sigc::mem_fun(*this, &CombineInstrumentsDialog::launchPlan)
+    );
+
 #if HAS_GTKMM_SHOW_ALL_CHILDREN
     show_all_children();
 #endif
@@ -1104,6 +1280,8 @@ void CombineInstrumentsDialog::on_order_drop_drag_data_received(
                 "<span foreground='black' background='white'>" + ToString(iSrc+1) + ".</span>\n<span foreground='green' background='white'>" + name + "</span>";
             rowDst[m_orderColumns.m_col_markup] = markup;
         }
+        // the order decides which dimension zones the instruments get
+        launchPlan();
     }
 }
 
@@ -1122,59 +1300,212 @@ void CombineInstrumentsDialog::setSelectedInstruments(const std::set<int>& instr
     m_OKButton.grab_focus();
 }
 
-void CombineInstrumentsDialog::combineSelectedInstruments() {
+CombineInstrumentsDialog::~CombineInstrumentsDialog() {
+    // a combination not finished yet is discarded, it did not touch the file
+    if (m_planJob) m_planJob->cancel();
+    if (m_combineJob) m_combineJob->cancel();
+    // the jobs read the source instruments, which may be deleted after the
+    // dialog was closed
+    if (m_planJob) JobScheduler::singleton()->wait(m_planJob);
+    if (m_combineJob) JobScheduler::singleton()->wait(m_combineJob);
+    for (std::list<std::shared_ptr<CombineInstrumentsPlanJob> >::iterator it =
+         m_supersededPlanJobs.begin(); it != m_supersededPlanJobs.end(); ++it)
+    {
+        JobScheduler::singleton()->wait(*it);
+    }
+}
+
+std::vector<gig::Instrument*> CombineInstrumentsDialog::orderedInstruments() const {
     std::vector<gig::Instrument*> instruments;
+    typedef Gtk::TreeModel::Children Children;
+    Children selection = m_refOrderModel->children();
+    for (Children::iterator it = selection.begin(); it != selection.end(); ++it) {
+        Gtk::TreeModel::Row row = *it;
+        gig::Instrument* instrument = row[m_orderColumns.m_col_instr];
+        instruments.push_back(instrument);
+    }
+    return instruments;
+}
+
+bool CombineInstrumentsDialog::selectedMainDimension(gig::dimension_t& type) {
+    Gtk::TreeModel::iterator iterType = m_comboDimType.get_active();
+    if (!iterType) return false;
+    Gtk::TreeModel::Row rowType = *iterType;
+    if (!rowType) return false;
+    int iTypeID = rowType[m_comboDimsModel.m_type_id];
+    type = static_cast<gig::dimension_t>(iTypeID);
+    return true;
+}
+
+void CombineInstrumentsDialog::launchPlan() {
+    if (m_combineJob) return; // input is frozen while combining
+    if (m_planJob) {
+        // may still be reading the source instruments, so it is waited for
+        // by the destructor
+        m_planJob->cancel();
+        m_supersededPlanJobs.push_back(m_planJob);
+        m_planJob.reset();
+    }
+    // forget the ones which are done by now
+    for (std::list<std::shared_ptr<CombineInstrumentsPlanJob> >::iterator it =
+         m_supersededPlanJobs.begin(); it != m_supersededPlanJobs.end(); )
     {
-        typedef Gtk::TreeModel::Children Children;
-        int i = 0;
-        Children selection = m_refOrderModel->children();
-        for (Children::iterator it = selection.begin();
-             it != selection.end(); ++it, ++i)
+        if ((*it)->isCompleted()) it = m_supersededPlanJobs.erase(it);
+        else ++it;
+    }
+    m_plan.reset();
+    m_refPreviewModel->clear();
+    m_OKButton.set_sensitive(false);
+    m_progressBar.set_fraction(0.f);
+
+    std::vector<gig::Instrument*> instruments = orderedInstruments();
+    gig::dimension_t mainDimension;
+    if (instruments.size() < 2 || !selectedMainDimension(mainDimension)) {
+        m_previewLabel.set_text("");
+        return;
+    }
+
+    std::shared_ptr<CombinePlan> plan(new CombinePlan);
+    plan->mainDimension = mainDimension;
+    for (uint i = 0; i < instruments.size(); ++i) {
+        SourceInstrument src;
+        src.instrument = instruments[i];
+        for (gig::Region* rgn = src.instrument->GetFirstRegion(); rgn;
+             rgn = src.instrument->GetNextRegion())
         {
-            Gtk::TreeModel::Row row = *it;
-            Glib::ustring name = row[m_orderColumns.m_col_name];
-            gig::Instrument* instrument = row[m_orderColumns.m_col_instr];
-            #if DEBUG_COMBINE_INSTRUMENTS
-            printf("Selection %d. '%s' %p\n\n", (i+1), name.c_str(), instrument));
-            #endif
-            instruments.push_back(instrument);
+            src.regions.push_back(rgn);
         }
+        plan->instruments.push_back(src);
     }
 
-    g_warnings.clear();
+    m_previewLabel.set_text(_("Planning combination ..."));
+    m_planJob.reset(new CombineInstrumentsPlanJob(plan));
+    // the job is not referenced by its own signals' slots, and the dialog's
+    // slots are disconnected automatically when the dialog is destroyed
+    m_planJob->signal_finished().connect(sigc::bind(
+        sigc::mem_fun(*this, &CombineInstrumentsDialog::onPlanFinished), m_planJob.get()
+    ));
+    m_planJob->signal_error().connect(sigc::bind(
+        sigc::mem_fun(*this, &CombineInstrumentsDialog::onPlanError), m_planJob.get()
+    ));
+    JobScheduler::singleton()->submit(m_planJob);
+}
 
-    try {
-        // which main dimension was selected in the combo box?
-        gig::dimension_t mainDimension;
+void CombineInstrumentsDialog::onPlanFinished(CombineInstrumentsPlanJob* job) {
+    if (job != m_planJob.get()) return; // outdated plan
+    m_plan = job->plan;
+    m_planJob.reset();
+    updatePreview();
+}
+
+void CombineInstrumentsDialog::onPlanError(CombineInstrumentsPlanJob* job) {
+    if (job != m_planJob.get()) return; // outdated plan
+    m_previewLabel.set_text(job->errorMessage());
+    m_planJob.reset();
+}
+
+void CombineInstrumentsDialog::updatePreview() {
+    m_refPreviewModel->clear();
+    if (!m_plan) return;
+
+    for (uint r = 0; r < m_plan->regions.size(); ++r) {
+        const CombinePlanRegion& target = m_plan->regions[r];
+
+        Glib::ustring dims;
+        if (target.mainZones > 1)
+            dims = dimTypeAsString(m_plan->mainDimension) + " (" + ToString(target.mainZones) + ")";
+        for (Dimensions::const_iterator itDim = target.dims.begin();
+             itDim != target.dims.end(); ++itDim)
         {
-            Gtk::TreeModel::iterator iterType = m_comboDimType.get_active();
-            if (!iterType) throw gig::Exception("No dimension selected");
-            Gtk::TreeModel::Row rowType = *iterType;
-            if (!rowType) throw gig::Exception("Something is wrong regarding dimension selection");
-            int iTypeID = rowType[m_comboDimsModel.m_type_id];
-            mainDimension = static_cast<gig::dimension_t>(iTypeID);
+            if (!dims.empty()) dims += ", ";
+            dims += dimTypeAsString(itDim->first) + " (" + ToString(itDim->second.size()) + ")";
         }
 
-        // now start the actual combination task ...
-        combineInstruments(instruments, m_gig, m_newCombinedInstrument, mainDimension);
-    } catch (RIFF::Exception e) {;
-        Gtk::MessageDialog msg(*this, e.Message, false, Gtk::MESSAGE_ERROR);
-        msg.run();
-        return;
-    } catch (...) {
-        Glib::ustring txt = _("An unknown exception occurred!");
-        Gtk::MessageDialog msg(*this, txt, false, Gtk::MESSAGE_ERROR);
-        msg.run();
+        Glib::ustring instruments;
+        for (uint s = 0; s < target.sources.size(); ++s) {
+            for (uint i = 0; i < m_plan->instruments.size(); ++i) {
+                if (m_plan->instruments[i].instrument != target.sources[s].first)
+                    continue;
+                if (!instruments.empty()) instruments += ", ";
+                instruments += ToString(i+1);
+            }
+        }
+
+        Gtk::TreeModel::Row row = *m_refPreviewModel->append();
+        row[m_previewColumns.m_col_keys] =
+            note_str(target.keyRange.low) + " - " + note_str(target.keyRange.high);
+        row[m_previewColumns.m_col_dimensions] = dims.empty() ? Glib::ustring("-") : dims;
+        row[m_previewColumns.m_col_instruments] = instruments;
+    }
+
+    if (m_plan->regions.empty()) {
+        m_previewLabel.set_text(_("No regions found to create a new instrument with."));
         return;
     }
 
-    if (!g_warnings.empty()) {
+    Glib::ustring txt = ToString(m_plan->regions.size()) + " " +
+                        _("regions will be created.");
+    for (Warnings::const_iterator itWarn = m_plan->warnings.begin();
+         itWarn != m_plan->warnings.end(); ++itWarn)
+    {
+        txt += "\n-> " + *itWarn;
+    }
+    m_previewLabel.set_text(txt);
+    m_OKButton.set_sensitive(true);
+}
+
+void CombineInstrumentsDialog::setInputSensitive(bool b) {
+    m_treeView.set_sensitive(b);
+    m_iconView.set_sensitive(b);
+    m_comboDimType.set_sensitive(b);
+    m_OKButton.set_sensitive(b && m_plan && !m_plan->regions.empty());
+}
+
+void CombineInstrumentsDialog::combineSelectedInstruments() {
+    if (!m_plan || m_plan->regions.empty() || m_combineJob) return;
+
+    setInputSensitive(false);
+    m_progressBar.set_fraction(0.f);
+    m_previewLabel.set_text(_("Combining instruments ..."));
+
+    // now start the actual combination task ...
+    m_combineJob.reset(new CombineInstrumentsJob(m_plan, m_gig->pVersion));
+    m_combineJob->signal_progress().connect(sigc::bind(
+        sigc::mem_fun(*this, &CombineInstrumentsDialog::onCombineProgress), m_combineJob.get()
+    ));
+    m_combineJob->signal_finished().connect(sigc::bind(
+        sigc::mem_fun(*this, &CombineInstrumentsDialog::onCombineFinished), m_combineJob.get()
+    ));
+    m_combineJob->signal_error().connect(sigc::bind(
+        sigc::mem_fun(*this, &CombineInstrumentsDialog::onCombineError), m_combineJob.get()
+    ));
+    JobScheduler::singleton()->submit(m_combineJob);
+}
+
+void CombineInstrumentsDialog::onCombineProgress(CombineInstrumentsJob* job) {
+    if (job != m_combineJob.get()) return;
+    m_progressBar.set_fraction(job->progress());
+}
+
+void CombineInstrumentsDialog::onCombineFinished(CombineInstrumentsJob* job) {
+    if (job != m_combineJob.get()) return;
+    m_progressBar.set_fraction(1.f);
+
+    // the only moment the gig file is actually modified
+    m_newCombinedInstrument = addCombinedInstrument(m_gig, job->instrument);
+    m_fileWasChanged = true;
+
+    Warnings warnings = m_plan->warnings;
+    warnings.insert(job->warnings.begin(), job->warnings.end());
+    m_combineJob.reset();
+
+    if (!warnings.empty()) {
         Glib::ustring txt = _(
             "Combined instrument was created successfully, but there were warnings:"
         );
         txt += "\n\n";
-        for (Warnings::const_iterator itWarn = g_warnings.begin();
-             itWarn != g_warnings.end(); ++itWarn)
+        for (Warnings::const_iterator itWarn = warnings.begin();
+             itWarn != warnings.end(); ++itWarn)
         {
             txt += "-> " + *itWarn + "\n";
         }
@@ -1187,14 +1518,22 @@ void CombineInstrumentsDialog::combineSelectedInstruments() {
         msg.run();
     }
 
-    // no error occurred
-    m_fileWasChanged = true;
     hide();
 }
 
+void CombineInstrumentsDialog::onCombineError(CombineInstrumentsJob* job) {
+    if (job != m_combineJob.get()) return;
+    Glib::ustring txt = job->errorMessage();
+    m_combineJob.reset();
+    m_progressBar.set_fraction(0.f);
+    updatePreview();
+    setInputSensitive(true);
+    Gtk::MessageDialog msg(*this, txt, false, Gtk::MESSAGE_ERROR);
+    msg.run();
+}
+
 void CombineInstrumentsDialog::onSelectionChanged() {
     std::vector<Gtk::TreeModel::Path> v = m_treeView.get_selection()->get_selected_rows();
-    m_OKButton.set_sensitive(v.size() >= 2);
 
     typedef Gtk::TreeModel::Children Children;
 
@@ -1262,6 +1601,8 @@ void CombineInstrumentsDialog::onSelectionChanged() {
             rowOrder[m_orderColumns.m_col_markup] = markup;
         }
     }
+
+    launchPlan();
 }
 
 void CombineInstrumentsDialog::on_show_tooltips_changed() {
@@ -1269,6 +1610,7 @@ void CombineInstrumentsDialog::on_show_tooltips_changed() {
 
     m_treeView.set_has_tooltip(b);
     m_iconView.set_has_tooltip(b);
+    m_previewView.set_has_tooltip(b);
 
     set_has_tooltip(b);
 }
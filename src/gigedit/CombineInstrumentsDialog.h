@@ -1,5 +1,5 @@
 /*
-    Copyright (c) 2014-2018 Christian Schoenebeck
+    Copyright (c) 2014-2020 Christian Schoenebeck
     
     This file is part of "gigedit" and released under the terms of the
     GNU General Public License version 2.
@@ -28,13 +28,20 @@
 # include <gtkmm/table.h>
 #endif
 #include <gtkmm/comboboxtext.h>
+#include <gtkmm/progressbar.h>
 #include <gtkmm/scrolledwindow.h>
 
 #include "wrapLabel.hh"
 #include "ManagedWindow.h"
 
+#include <list>
+#include <memory>
 #include <set>
 
+struct CombinePlan;
+class CombineInstrumentsPlanJob;
+class CombineInstrumentsJob;
+
 /**
  * @brief Modal dialog which allows to merge instruments.
  *
@@ -42,12 +49,19 @@
  * in gigedit and allows the user to shift select a set of instruments to be
  * combined.
  *
+ * The regions and dimensions the combined instrument would have are planned by
+ * a background job whenever the selection changes and are listed as preview.
+ * The combination itself is built by another background job showing its
+ * progress in this dialog, the gig file is only modified after that job
+ * finished. Closing the dialog before cancels the combination.
+ *
  * If the user successfully combined instruments in this dialog, then
  * newCombinedInstrument() will return a pointer to that new instrument.
  */
 class CombineInstrumentsDialog : public ManagedDialog {
 public:
     CombineInstrumentsDialog(Gtk::Window& parent, gig::File* gig);
+    ~CombineInstrumentsDialog();
     bool fileWasChanged() const;
     gig::Instrument* newCombinedInstrument() const;
     void setSelectedInstruments(const std::set<int>& instrumentIndeces);
@@ -62,6 +76,10 @@ protected:
     gig::File* m_gig;
     bool m_fileWasChanged;
     gig::Instrument* m_newCombinedInstrument;
+    std::shared_ptr<CombinePlan> m_plan; ///< of current selection, NULL while being planned
+    std::shared_ptr<CombineInstrumentsPlanJob> m_planJob;
+    std::list<std::shared_ptr<CombineInstrumentsPlanJob> > m_supersededPlanJobs; ///< cancelled, but maybe not stopped yet
+    std::shared_ptr<CombineInstrumentsJob> m_combineJob;
 
     HButtonBox m_buttonBox;
     Gtk::ScrolledWindow m_scrolledWindow;
@@ -82,6 +100,10 @@ protected:
     Gtk::ComboBox   m_comboDimType;
     Gtk::Label      m_labelDimType;
     Gtk::Label      m_labelOrder;
+    Gtk::ScrolledWindow m_previewScrolledWindow;
+    Gtk::TreeView   m_previewView;
+    Gtk::Label      m_previewLabel;
+    Gtk::ProgressBar m_progressBar;
 
     class ComboDimsModel : public Gtk::TreeModel::ColumnRecord {
     public:
@@ -120,11 +142,35 @@ protected:
         Gtk::TreeModelColumn<gig::Instrument*> m_col_instr;
     } m_orderColumns;
 
+    class PreviewModel : public Gtk::TreeModel::ColumnRecord {
+    public:
+        PreviewModel() {
+            add(m_col_keys);
+            add(m_col_dimensions);
+            add(m_col_instruments);
+        }
+
+        Gtk::TreeModelColumn<Glib::ustring> m_col_keys;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_dimensions;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_instruments;
+    } m_previewColumns;
+
     Glib::RefPtr<Gtk::ListStore> m_refTreeModel;
     Glib::RefPtr<Gtk::ListStore> m_refOrderModel;
+    Glib::RefPtr<Gtk::ListStore> m_refPreviewModel;
     bool first_call_to_drag_data_get;
 
+    std::vector<gig::Instrument*> orderedInstruments() const;
+    bool selectedMainDimension(gig::dimension_t& type);
+    void launchPlan();
+    void onPlanFinished(CombineInstrumentsPlanJob* job);
+    void onPlanError(CombineInstrumentsPlanJob* job);
+    void updatePreview();
     void combineSelectedInstruments();
+    void onCombineProgress(CombineInstrumentsJob* job);
+    void onCombineFinished(CombineInstrumentsJob* job);
+    void onCombineError(CombineInstrumentsJob* job);
+    void setInputSensitive(bool b);
     void onSelectionChanged();
     void on_order_drag_begin(const Glib::RefPtr<Gdk::DragContext>& context);
     void on_order_drag_data_get(const Glib::RefPtr<Gdk::DragContext>&,
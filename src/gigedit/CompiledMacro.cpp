@@ -0,0 +1,129 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "CompiledMacro.h"
+
+#include <string.h>
+
+CompiledMacro::CompiledMacro() : m_valid(false) {
+}
+
+template<typename T>
+static void encodeValue(uint8_t* dst, T value) {
+    memcpy(dst, &value, sizeof(T));
+}
+
+bool CompiledMacro::compileObject(Serialization::Archive& src,
+                                  const Serialization::Object& srcObject,
+                                  Serialization::Archive& dst,
+                                  const Serialization::Object& dstObject,
+                                  const gig::DimensionRegion* layout)
+{
+    for (size_t i = 0; i < srcObject.members().size(); ++i) {
+        const Serialization::Member& srcMember = srcObject.members()[i];
+        const Serialization::Member dstMember = dstObject.memberNamed(srcMember.name());
+        // leave resolving members of a different layout or type to deserialize()
+        if (!dstMember || dstMember.type() != srcMember.type()) return false;
+
+        const Serialization::DataType& type = dstMember.type();
+        if (type.isPointer()) return false;
+
+        const Serialization::Object& srcMemberObject = src.objectByUID(srcMember.uid());
+        const Serialization::Object& dstMemberObject = dst.objectByUID(dstMember.uid());
+        if (!srcMemberObject || !dstMemberObject) return false;
+
+        if (type.isClass()) {
+            if (!compileObject(src, srcMemberObject, dst, dstMemberObject, layout))
+                return false;
+            continue;
+        }
+
+        // the destination archive was created from 'layout', so its UIDs are
+        // the memory addresses of the respective fields of 'layout'
+        const uint8_t* addr = (const uint8_t*) dstMember.uid().id;
+        const uint8_t* base = (const uint8_t*) layout;
+        if (addr < base || addr + type.size() > base + sizeof(gig::DimensionRegion))
+            return false;
+
+        Patch patch;
+        patch.offset = addr - base;
+        patch.size = type.size();
+        if (type.isInteger() || type.isEnum()) {
+            const int64_t value = src.valueAsInt(srcMemberObject);
+            switch (patch.size) {
+                case 1: encodeValue(patch.value, int8_t(value)); break;
+                case 2: encodeValue(patch.value, int16_t(value)); break;
+                case 4: encodeValue(patch.value, int32_t(value)); break;
+                case 8: encodeValue(patch.value, int64_t(value)); break;
+                default: return false;
+            }
+        } else if (type.isReal()) {
+            const double value = src.valueAsReal(srcMemberObject);
+            if (patch.size == sizeof(float))
+                encodeValue(patch.value, float(value));
+            else if (patch.size == sizeof(double))
+                encodeValue(patch.value, value);
+            else
+                return false;
+        } else if (type.isBool()) {
+            if (patch.size != sizeof(bool)) return false;
+            encodeValue(patch.value, bool(src.valueAsBool(srcMemberObject)));
+        } else {
+            return false; // i.e. strings
+        }
+        m_patches.push_back(patch);
+    }
+    return true;
+}
+
+void CompiledMacro::compile(Serialization::Archive& macro, gig::DimensionRegion* layout) {
+    m_patches.clear();
+    m_valid = false;
+    if (!layout) return;
+
+    const Serialization::Object& srcRoot = macro.rootObject();
+    if (!srcRoot) return;
+
+    // serialize the destination once, to get its members' types and offsets
+    Serialization::Archive dst;
+    dst.serialize(layout);
+    const Serialization::Object& dstRoot = dst.rootObject();
+    if (!dstRoot || dstRoot.type() != srcRoot.type()) return;
+
+    m_valid = compileObject(macro, srcRoot, dst, dstRoot, layout);
+    if (!m_valid) m_patches.clear();
+}
+
+void CompiledMacro::apply(gig::DimensionRegion* dimrgn) const {
+    uint8_t* base = (uint8_t*) dimrgn;
+    for (size_t i = 0; i < m_patches.size(); ++i)
+        memcpy(base + m_patches[i].offset, m_patches[i].value, m_patches[i].size);
+    updateDerivedTables(dimrgn);
+}
+
+void updateDerivedTables(gig::DimensionRegion* d) {
+    d->SetVelocityResponseCurve(d->VelocityResponseCurve);
+    d->SetVelocityResponseDepth(d->VelocityResponseDepth);
+    d->SetVelocityResponseCurveScaling(d->VelocityResponseCurveScaling);
+    d->SetReleaseVelocityResponseCurve(d->ReleaseVelocityResponseCurve);
+    d->SetReleaseVelocityResponseDepth(d->ReleaseVelocityResponseDepth);
+    d->SetVCFCutoffController(d->VCFCutoffController);
+    d->SetVCFVelocityCurve(d->VCFVelocityCurve);
+    d->SetVCFVelocityDynamicRange(d->VCFVelocityDynamicRange);
+    d->SetVCFVelocityScale(d->VCFVelocityScale);
+}
+
+void CompiledMacro::addPatch(size_t offset, size_t size, const uint8_t* value) {
+    if (size > sizeof(Patch::value) ||
+        offset + size > sizeof(gig::DimensionRegion)) return;
+    Patch patch;
+    patch.offset = offset;
+    patch.size = size;
+    memcpy(patch.value, value, size);
+    m_patches.push_back(patch);
+    m_valid = true;
+}
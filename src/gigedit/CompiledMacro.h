@@ -0,0 +1,89 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_COMPILEDMACRO_H
+#define GIGEDIT_COMPILEDMACRO_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+# include LIBGIG_HEADER_FILE(Serialization.h)
+#else
+# include <gig.h>
+# include <Serialization.h>
+#endif
+
+#include <vector>
+#include <stdint.h>
+
+/** @brief Macro precompiled to a flat list of field patches.
+ *
+ * Applying a macro (or pasted clipboard content) by calling
+ * Serialization::Archive::deserialize() for each dimension region re-walks the
+ * archive's object graph and re-resolves all of its members by name and type
+ * over and over again. A CompiledMacro resolves the archive's members against
+ * the memory layout of gig::DimensionRegion just once, and then merely writes
+ * the precomputed values at their resolved offsets for each dimension region.
+ *
+ * Only primitive members (numbers, bools and enums, also those nested in
+ * struct members) can be compiled that way. If the archive contains anything
+ * else (e.g. strings or pointers), isValid() returns false and the archive has
+ * to be applied by Serialization::Archive::deserialize() instead.
+ */
+class CompiledMacro {
+public:
+    CompiledMacro();
+
+    /**
+     * Resolves all members of @a macro against dimension region @a layout
+     * (which is not modified). The resulting patches can then be applied to
+     * any dimension region.
+     */
+    void compile(Serialization::Archive& macro, gig::DimensionRegion* layout);
+
+    /// Whether the last call to compile() succeeded.
+    bool isValid() const { return m_valid; }
+
+    /**
+     * Adds a patch writing the @a size bytes at @a value (native memory
+     * representation) to byte offset @a offset of each dimension region. This
+     * allows building a macro directly from known fields (e.g. by the
+     * parameter sheet) without an archive. Makes the macro valid.
+     */
+    void addPatch(size_t offset, size_t size, const uint8_t* value);
+
+    /**
+     * Writes all resolved values of the macro to @a dimrgn, and updates the
+     * tables derived from them by calling updateDerivedTables().
+     */
+    void apply(gig::DimensionRegion* dimrgn) const;
+
+private:
+    struct Patch {
+        size_t offset; ///< byte offset of the field within gig::DimensionRegion
+        size_t size; ///< size of the field in bytes
+        uint8_t value[8]; ///< new value of the field (in native memory representation)
+    };
+
+    std::vector<Patch> m_patches;
+    bool m_valid;
+
+    bool compileObject(Serialization::Archive& src, const Serialization::Object& srcObject,
+                       Serialization::Archive& dst, const Serialization::Object& dstObject,
+                       const gig::DimensionRegion* layout);
+};
+
+/**
+ * Restores the lookup tables (i.e. velocity and filter curves) which
+ * gig::DimensionRegion derives from its fields. Must be called after fields
+ * of @a dimrgn were written directly, i.e. by patches or by deserialization.
+ *
+ * The tables are shared among all gig files, so this must not be called
+ * concurrently with loading, destroying or updating other dimension regions.
+ */
+void updateDerivedTables(gig::DimensionRegion* dimrgn);
+
+#endif // GIGEDIT_COMPILEDMACRO_H
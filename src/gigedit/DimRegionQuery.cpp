@@ -0,0 +1,581 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "DimRegionQuery.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <set>
+
+// DimRegionIndex
+
+static void velocityZone(gig::Region* rgn, int index, double& low, double& high) {
+    low = 0;
+    high = 127;
+    int bitpos = 0;
+    for (uint d = 0; d < rgn->Dimensions; ++d) {
+        const gig::dimension_def_t& def = rgn->pDimensionDefinitions[d];
+        if (def.dimension != gig::dimension_velocity) {
+            bitpos += def.bits;
+            continue;
+        }
+        const int mask = ((1 << def.bits) - 1) << bitpos;
+        const int zone = (index & mask) >> bitpos;
+        const int base = index & ~mask;
+        if (zone >= def.zones) return; // unused dimension region
+
+        // custom velocity splits are stored in the dimension regions, same
+        // as DimRegionChooser draws them
+        gig::DimensionRegion* first = rgn->pDimensionRegions[base];
+        if (first && (first->DimensionUpperLimits[d] || first->VelocityUpperLimit)) {
+            int lower = 0;
+            for (int z = 0; z <= zone; ++z) {
+                gig::DimensionRegion* dr = rgn->pDimensionRegions[base | (z << bitpos)];
+                if (!dr) return;
+                int upper = dr->DimensionUpperLimits[d];
+                if (!upper) upper = dr->VelocityUpperLimit;
+                if (z == zone) {
+                    low = lower;
+                    high = upper;
+                    return;
+                }
+                lower = upper + 1;
+            }
+        } else {
+            low = zone * 128 / def.zones;
+            high = (zone + 1) * 128 / def.zones - 1;
+        }
+        return;
+    }
+}
+
+DimRegionIndex::DimRegionIndex() {
+}
+
+void DimRegionIndex::clear() {
+    m_params.clear();
+    m_instruments.clear();
+    for (int f = 0; f < FIELD_COUNT; ++f) m_fields[f].clear();
+}
+
+void DimRegionIndex::build(gig::File* gig) {
+    clear();
+    if (!gig) return;
+    for (gig::Instrument* instrument = gig->GetFirstInstrument(); instrument;
+         instrument = gig->GetNextInstrument())
+    {
+        m_instruments.push_back(instrument);
+    }
+    m_params.build(gig, NULL);
+}
+
+bool DimRegionIndex::hasInstrumentsOf(gig::File* gig) const {
+    size_t i = 0;
+    for (gig::Instrument* instrument = gig->GetFirstInstrument(); instrument;
+         instrument = gig->GetNextInstrument(), ++i)
+    {
+        if (i >= m_instruments.size() || m_instruments[i] != instrument)
+            return false;
+    }
+    return i == m_instruments.size();
+}
+
+double DimRegionIndex::fieldValue(Field field, size_t i) const {
+    const ParamTable::Row& r = m_params.rowAt(i);
+    const gig::Sample* sample = r.dimrgn->pSample;
+    switch (field) {
+        case FIELD_KEY_LOW: return r.keyLow;
+        case FIELD_KEY_HIGH: return r.keyHigh;
+        case FIELD_VELOCITY_LOW:
+        case FIELD_VELOCITY_HIGH: {
+            double low, high;
+            velocityZone(r.region, r.index, low, high);
+            return (field == FIELD_VELOCITY_LOW) ? low : high;
+        }
+        case FIELD_SAMPLE_LOOPS: return r.dimrgn->SampleLoops;
+        case FIELD_HAS_SAMPLE: return sample ? 1 : 0;
+        case FIELD_SAMPLE_LOOP_COUNT: return sample ? sample->Loops : 0;
+        case FIELD_SAMPLE_CHANNELS: return sample ? sample->Channels : 0;
+        case FIELD_SAMPLE_RATE: return sample ? sample->SamplesPerSecond : 0;
+        case FIELD_SAMPLE_BITS: return sample ? sample->BitDepth : 0;
+        case FIELD_SAMPLE_FRAMES: return sample ? double(sample->SamplesTotal) : 0;
+        case FIELD_COUNT: break;
+    }
+    return 0;
+}
+
+const std::vector<double>* DimRegionIndex::fieldValues(Field field) {
+    std::vector<double>& values = m_fields[field];
+    if (values.size() != rowCount()) {
+        if (isStale()) return NULL;
+        values.resize(rowCount());
+        for (size_t i = 0; i < values.size(); ++i)
+            values[i] = fieldValue(field, i);
+    }
+    return &values;
+}
+
+bool DimRegionIndex::update(gig::DimensionRegion* dimrgn) {
+    const long i = m_params.rowOf(dimrgn);
+    if (i < 0) return false;
+    m_params.update(dimrgn);
+    for (int f = 0; f < FIELD_COUNT; ++f)
+        if (m_fields[f].size() == rowCount())
+            m_fields[f][i] = fieldValue(Field(f), i);
+    return true;
+}
+
+bool DimRegionIndex::updateRegion(gig::Region* rgn) {
+    if (!m_params.updateRegion(rgn)) return false;
+    for (int k = 0; k < int(rgn->DimensionRegions); ++k) {
+        const long i = m_params.rowOf(rgn->pDimensionRegions[k]);
+        if (i < 0) continue;
+        for (int f = 0; f < FIELD_COUNT; ++f)
+            if (m_fields[f].size() == rowCount())
+                m_fields[f][i] = fieldValue(Field(f), i);
+    }
+    return true;
+}
+
+void DimRegionIndex::samplesChanged() {
+    for (int f = FIELD_HAS_SAMPLE; f <= FIELD_SAMPLE_FRAMES; ++f)
+        m_fields[f].clear();
+}
+
+// DimRegionQuery
+
+struct DimRegionQuery::Node {
+    enum Type { AND, OR, NOT, COMPARE };
+
+    Type type;
+    std::unique_ptr<Node> left;
+    std::unique_ptr<Node> right;
+    // COMPARE
+    std::string field;
+    std::string op;
+    std::string value;
+};
+
+namespace {
+
+typedef DimRegionQuery::Node Node;
+typedef std::vector<char> Mask;
+
+enum TokenType {
+    TOKEN_END,
+    TOKEN_WORD, ///< field name, number or bare string
+    TOKEN_STRING, ///< quoted string
+    TOKEN_OP,
+    TOKEN_AND,
+    TOKEN_OR,
+    TOKEN_NOT,
+    TOKEN_LPAREN,
+    TOKEN_RPAREN
+};
+
+struct Token {
+    TokenType type;
+    std::string text;
+};
+
+bool tokenize(const std::string& s, std::vector<Token>& tokens, std::string& error) {
+    size_t i = 0;
+    while (i < s.size()) {
+        const char c = s[i];
+        Token t;
+        if (isspace((unsigned char)c)) {
+            ++i;
+            continue;
+        } else if (c == '(' || c == ')') {
+            t.type = (c == '(') ? TOKEN_LPAREN : TOKEN_RPAREN;
+            t.text = c;
+            ++i;
+        } else if (c == '"' || c == '\'') {
+            const size_t end = s.find(c, i + 1);
+            if (end == std::string::npos) {
+                error = "Missing closing quote";
+                return false;
+            }
+            t.type = TOKEN_STRING;
+            t.text = s.substr(i + 1, end - i - 1);
+            i = end + 1;
+        } else if (s.compare(i, 2, "&&") == 0 || s.compare(i, 2, "||") == 0) {
+            t.type = (c == '&') ? TOKEN_AND : TOKEN_OR;
+            t.text = s.substr(i, 2);
+            i += 2;
+        } else if (strchr("=!<>~", c)) {
+            t.type = TOKEN_OP;
+            t.text = c;
+            ++i;
+            if (i < s.size() && s[i] == '=' && c != '~') {
+                t.text += '=';
+                ++i;
+            }
+            if (t.text == "!") t.type = TOKEN_NOT;
+            if (t.text == "==") t.text = "=";
+        } else {
+            size_t end = i;
+            while (end < s.size() && !isspace((unsigned char)s[end]) &&
+                   !strchr("()\"'=!<>~&|", s[end])) ++end;
+            if (end == i) {
+                error = "Unexpected character '" + std::string(1, c) + "'";
+                return false;
+            }
+            t.type = TOKEN_WORD;
+            t.text = s.substr(i, end - i);
+            i = end;
+            if (!strcasecmp(t.text.c_str(), "and")) t.type = TOKEN_AND;
+            else if (!strcasecmp(t.text.c_str(), "or")) t.type = TOKEN_OR;
+            else if (!strcasecmp(t.text.c_str(), "not")) t.type = TOKEN_NOT;
+        }
+        tokens.push_back(t);
+    }
+    Token end;
+    end.type = TOKEN_END;
+    tokens.push_back(end);
+    return true;
+}
+
+class Parser {
+public:
+    Parser(const std::vector<Token>& tokens) : m_tokens(tokens), m_pos(0) {}
+
+    std::unique_ptr<Node> parse(std::string& error) {
+        std::unique_ptr<Node> node = expression(error);
+        if (node && peek().type != TOKEN_END) {
+            error = "Unexpected '" + peek().text + "'";
+            node.reset();
+        }
+        return node;
+    }
+
+private:
+    const std::vector<Token>& m_tokens;
+    size_t m_pos;
+
+    const Token& peek() const { return m_tokens[m_pos]; }
+
+    static std::unique_ptr<Node> binary(Node::Type type, std::unique_ptr<Node> left,
+                                        std::unique_ptr<Node> right)
+    {
+        std::unique_ptr<Node> node(new Node);
+        node->type = type;
+        node->left = std::move(left);
+        node->right = std::move(right);
+        return node;
+    }
+
+    std::unique_ptr<Node> expression(std::string& error) {
+        std::unique_ptr<Node> node = term(error);
+        while (node && peek().type == TOKEN_OR) {
+            ++m_pos;
+            std::unique_ptr<Node> right = term(error);
+            if (!right) return right;
+            node = binary(Node::OR, std::move(node), std::move(right));
+        }
+        return node;
+    }
+
+    std::unique_ptr<Node> term(std::string& error) {
+        std::unique_ptr<Node> node = factor(error);
+        while (node && peek().type == TOKEN_AND) {
+            ++m_pos;
+            std::unique_ptr<Node> right = factor(error);
+            if (!right) return right;
+            node = binary(Node::AND, std::move(node), std::move(right));
+        }
+        return node;
+    }
+
+    std::unique_ptr<Node> factor(std::string& error) {
+        const Token& t = peek();
+        if (t.type == TOKEN_NOT) {
+            ++m_pos;
+            std::unique_ptr<Node> operand = factor(error);
+            if (!operand) return operand;
+            return binary(Node::NOT, std::move(operand), std::unique_ptr<Node>());
+        }
+        if (t.type == TOKEN_LPAREN) {
+            ++m_pos;
+            std::unique_ptr<Node> node = expression(error);
+            if (!node) return node;
+            if (peek().type != TOKEN_RPAREN) {
+                error = "Missing ')'";
+                return std::unique_ptr<Node>();
+            }
+            ++m_pos;
+            return node;
+        }
+        if (t.type != TOKEN_WORD) {
+            error = (t.type == TOKEN_END) ?
+                "Unexpected end of expression" : "Expected a field name instead of '" + t.text + "'";
+            return std::unique_ptr<Node>();
+        }
+        std::unique_ptr<Node> node(new Node);
+        node->type = Node::COMPARE;
+        node->field = t.text;
+        ++m_pos;
+        if (peek().type != TOKEN_OP) {
+            error = "Expected a comparison after '" + node->field + "'";
+            return std::unique_ptr<Node>();
+        }
+        node->op = peek().text;
+        ++m_pos;
+        if (peek().type != TOKEN_WORD && peek().type != TOKEN_STRING) {
+            error = "Expected a value after '" + node->field + " " + node->op + "'";
+            return std::unique_ptr<Node>();
+        }
+        node->value = peek().text;
+        ++m_pos;
+        return node;
+    }
+};
+
+std::string lowercase(std::string s) {
+    for (size_t i = 0; i < s.size(); ++i)
+        s[i] = tolower((unsigned char)s[i]);
+    return s;
+}
+
+bool matchString(const std::string& lowerText, const std::string& op,
+                 const std::string& lowerValue)
+{
+    if (op == "~") return lowerText.find(lowerValue) != std::string::npos;
+    const bool equal = (lowerText == lowerValue);
+    return (op == "=") ? equal : !equal;
+}
+
+bool compareNumber(double a, const std::string& op, double b) {
+    if (op == "=") return a == b;
+    if (op == "!=") return a != b;
+    if (op == "<") return a < b;
+    if (op == "<=") return a <= b;
+    if (op == ">") return a > b;
+    return a >= b;
+}
+
+bool parseNumber(const std::string& text, double& value) {
+    const std::string s = lowercase(text);
+    if (s == "on" || s == "true" || s == "yes") {
+        value = 1;
+        return true;
+    }
+    if (s == "off" || s == "false" || s == "no") {
+        value = 0;
+        return true;
+    }
+    char* end;
+    value = strtod(s.c_str(), &end);
+    return !s.empty() && *end == '\0';
+}
+
+bool derivedField(const std::string& name, DimRegionIndex::Field& field) {
+    static const struct {
+        const char* name;
+        DimRegionIndex::Field field;
+    } fields[] = {
+        { "keylow", DimRegionIndex::FIELD_KEY_LOW },
+        { "keyhigh", DimRegionIndex::FIELD_KEY_HIGH },
+        { "vellow", DimRegionIndex::FIELD_VELOCITY_LOW },
+        { "velhigh", DimRegionIndex::FIELD_VELOCITY_HIGH },
+        { "sampleloops", DimRegionIndex::FIELD_SAMPLE_LOOPS },
+        { "hassample", DimRegionIndex::FIELD_HAS_SAMPLE },
+        { "sample.loops", DimRegionIndex::FIELD_SAMPLE_LOOP_COUNT },
+        { "sample.channels", DimRegionIndex::FIELD_SAMPLE_CHANNELS },
+        { "sample.rate", DimRegionIndex::FIELD_SAMPLE_RATE },
+        { "sample.bits", DimRegionIndex::FIELD_SAMPLE_BITS },
+        { "sample.frames", DimRegionIndex::FIELD_SAMPLE_FRAMES },
+    };
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i) {
+        if (name == fields[i].name) {
+            field = fields[i].field;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool evaluateStrings(const Node& node, const std::string& field,
+                     DimRegionIndex& index, Mask& mask, std::string& error)
+{
+    if (node.op != "=" && node.op != "!=" && node.op != "~") {
+        error = "Field '" + node.field + "' only supports =, != and ~";
+        return false;
+    }
+    const std::string value = lowercase(node.value);
+    const size_t n = index.rowCount();
+    mask.resize(n);
+
+    if (field == "sample") {
+        // many dimension regions share the same sample
+        std::map<gig::Sample*, bool> matches;
+        for (size_t i = 0; i < n; ++i) {
+            gig::Sample* sample = index.row(i).dimrgn->pSample;
+            std::map<gig::Sample*, bool>::iterator it = matches.find(sample);
+            if (it == matches.end()) {
+                const std::string name = sample ? lowercase(sample->pInfo->Name) : "";
+                it = matches.insert(std::make_pair(sample, matchString(name, node.op, value))).first;
+            }
+            mask[i] = it->second;
+        }
+        return true;
+    }
+
+    // instrument and script fields are evaluated once per instrument
+    std::map<gig::Instrument*, bool> matches;
+    for (size_t i = 0; i < n; ++i) {
+        gig::Instrument* instrument = index.instrument(i);
+        std::map<gig::Instrument*, bool>::iterator it = matches.find(instrument);
+        if (it == matches.end()) {
+            bool match;
+            if (field == "instrument") {
+                match = matchString(lowercase(instrument->pInfo->Name), node.op, value);
+            } else { // script
+                bool any = false;
+                for (size_t s = 0; s < instrument->ScriptSlotCount() && !any; ++s) {
+                    gig::Script* script = instrument->GetScriptOfSlot(s);
+                    if (script)
+                        any = matchString(lowercase(script->Name),
+                                          (node.op == "!=") ? "=" : node.op, value);
+                }
+                // "script != x": the instrument does not use script x
+                match = (node.op == "!=") ? !any : any;
+            }
+            it = matches.insert(std::make_pair(instrument, match)).first;
+        }
+        mask[i] = it->second;
+    }
+    return true;
+}
+
+bool evaluateNode(const Node& node, DimRegionIndex& index, Mask& mask,
+                  std::string& error)
+{
+    const size_t n = index.rowCount();
+    switch (node.type) {
+        case Node::AND:
+        case Node::OR: {
+            Mask right;
+            if (!evaluateNode(*node.left, index, mask, error) ||
+                !evaluateNode(*node.right, index, right, error)) return false;
+            if (node.type == Node::AND) {
+                for (size_t i = 0; i < n; ++i) mask[i] &= right[i];
+            } else {
+                for (size_t i = 0; i < n; ++i) mask[i] |= right[i];
+            }
+            return true;
+        }
+        case Node::NOT:
+            if (!evaluateNode(*node.left, index, mask, error)) return false;
+            for (size_t i = 0; i < n; ++i) mask[i] = !mask[i];
+            return true;
+        case Node::COMPARE:
+            break;
+    }
+
+    const std::string field = lowercase(node.field);
+    if (field == "instrument" || field == "sample" || field == "script")
+        return evaluateStrings(node, field, index, mask, error);
+
+    if (node.op == "~") {
+        error = "Operator ~ is only supported for instrument, sample and script";
+        return false;
+    }
+    double value;
+    if (!parseNumber(node.value, value)) {
+        error = "Field '" + node.field + "' expects a number instead of '" + node.value + "'";
+        return false;
+    }
+    mask.resize(n);
+
+    // ranges: the whole key range / velocity zone has to satisfy the condition
+    if (field == "key" || field == "velocity") {
+        const bool key = (field == "key");
+        const std::vector<double>* low = index.fieldValues(
+            key ? DimRegionIndex::FIELD_KEY_LOW : DimRegionIndex::FIELD_VELOCITY_LOW
+        );
+        const std::vector<double>* high = index.fieldValues(
+            key ? DimRegionIndex::FIELD_KEY_HIGH : DimRegionIndex::FIELD_VELOCITY_HIGH
+        );
+        if (!low || !high) {
+            error = "Index is being updated";
+            return false;
+        }
+        const std::string& op = node.op;
+        for (size_t i = 0; i < n; ++i) {
+            const double lo = (*low)[i], hi = (*high)[i];
+            bool match;
+            if (op == "=" || op == "!=") {
+                match = (lo <= value && value <= hi) == (op == "=");
+            } else if (op == "<" || op == "<=") {
+                match = compareNumber(hi, op, value);
+            } else {
+                match = compareNumber(lo, op, value);
+            }
+            mask[i] = match;
+        }
+        return true;
+    }
+
+    const std::vector<double>* values = NULL;
+    DimRegionIndex::Field derived;
+    if (derivedField(field, derived)) {
+        values = index.fieldValues(derived);
+    } else {
+        const int c = index.params().findColumn(node.field);
+        if (c < 0) {
+            error = "Unknown field '" + node.field + "'";
+            return false;
+        }
+        values = index.params().columnValues(c);
+    }
+    if (!values) {
+        error = "Index is being updated";
+        return false;
+    }
+    for (size_t i = 0; i < n; ++i)
+        mask[i] = compareNumber((*values)[i], node.op, value);
+    return true;
+}
+
+} // namespace
+
+DimRegionQuery::DimRegionQuery() {
+}
+
+DimRegionQuery::~DimRegionQuery() {
+}
+
+bool DimRegionQuery::parse(const std::string& expression, std::string& error) {
+    m_root.reset();
+    std::vector<Token> tokens;
+    if (!tokenize(expression, tokens, error)) return false;
+    Parser parser(tokens);
+    m_root = parser.parse(error);
+    return bool(m_root);
+}
+
+bool DimRegionQuery::evaluate(DimRegionIndex& index, std::vector<size_t>& rows,
+                              std::string& error)
+{
+    rows.clear();
+    if (!m_root) {
+        error = "No query";
+        return false;
+    }
+    if (index.isStale()) {
+        error = "Index is being updated";
+        return false;
+    }
+    Mask mask;
+    if (!evaluateNode(*m_root, index, mask, error)) return false;
+    for (size_t i = 0; i < mask.size(); ++i)
+        if (mask[i]) rows.push_back(i);
+    return true;
+}
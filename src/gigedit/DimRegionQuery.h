@@ -0,0 +1,135 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_DIMREGIONQUERY_H
+#define GIGEDIT_DIMREGIONQUERY_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#include "ParamTable.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/** @brief Columnar index over all dimension regions of a gig file.
+ *
+ * Besides the parameters of gig::DimensionRegion (see ParamTable), the index
+ * provides derived numeric fields, i.e. the key range of the region, the
+ * velocity zone of the dimension region and the properties of its sample.
+ * Like the parameter columns, each derived column is only computed when it is
+ * queried for the first time, and is then kept up to date by update(),
+ * updateRegion() and samplesChanged().
+ *
+ * String fields (names of instrument, sample and scripts) are not cached, but
+ * read from the gig objects while evaluating a query.
+ */
+class DimRegionIndex {
+public:
+    /// Derived numeric fields.
+    enum Field {
+        FIELD_KEY_LOW,
+        FIELD_KEY_HIGH,
+        FIELD_VELOCITY_LOW,
+        FIELD_VELOCITY_HIGH,
+        FIELD_SAMPLE_LOOPS, ///< loops of the dimension region (SampleLoops)
+        FIELD_HAS_SAMPLE,
+        FIELD_SAMPLE_LOOP_COUNT, ///< loops of the sample (gig::Sample::Loops)
+        FIELD_SAMPLE_CHANNELS,
+        FIELD_SAMPLE_RATE,
+        FIELD_SAMPLE_BITS,
+        FIELD_SAMPLE_FRAMES,
+        FIELD_COUNT
+    };
+
+    DimRegionIndex();
+
+    void build(gig::File* gig);
+    void clear();
+
+    /// Whether the index still covers exactly the instruments of @a gig.
+    bool hasInstrumentsOf(gig::File* gig) const;
+
+    size_t rowCount() const { return m_params.rowCount(); }
+    const ParamTable::Row& row(size_t i) const { return m_params.rowAt(i); }
+    gig::Instrument* instrument(size_t i) const { return m_instruments[m_params.rowAt(i).instrument]; }
+
+    /// Column of the dimension region parameters, @see ParamTable::findColumn().
+    ParamTable& params() { return m_params; }
+
+    /// Values of derived field @a field for all rows, NULL while stale.
+    const std::vector<double>* fieldValues(Field field);
+
+    /// Re-reads all cached values of @a dimrgn, false if not indexed.
+    bool update(gig::DimensionRegion* dimrgn);
+    /// Re-reads all cached values of region @a rgn, false if a rebuild is required.
+    bool updateRegion(gig::Region* rgn);
+    /// Drops the cached sample properties.
+    void samplesChanged();
+
+    void setStale(bool stale) { m_params.setStale(stale); }
+    bool isStale() const { return m_params.isStale(); }
+
+private:
+    ParamTable m_params;
+    std::vector<gig::Instrument*> m_instruments;
+    std::vector<double> m_fields[FIELD_COUNT]; ///< empty if not computed yet
+
+    double fieldValue(Field field, size_t row) const;
+};
+
+/** @brief Filter expression evaluated against a DimRegionIndex.
+ *
+ * Syntax:
+ * @code
+ * expression := term { ("or" | "||") term }
+ * term       := factor { ("and" | "&&") factor }
+ * factor     := ("not" | "!") factor | "(" expression ")" | field op value
+ * op         := "=" | "==" | "!=" | "<" | "<=" | ">" | ">=" | "~"
+ * @endcode
+ *
+ * A field is either the name of a gig::DimensionRegion parameter (e.g.
+ * "EG1Release" or "SampleLoops", case insensitive) or one of the derived
+ * fields "keylow", "keyhigh", "vellow", "velhigh", "sample.loops",
+ * "sample.channels", "sample.rate", "sample.bits", "sample.frames" and
+ * "hassample". Values are numbers, or on/off, true/false.
+ *
+ * The fields "key" and "velocity" compare the whole range, i.e.
+ * "velocity < 40" matches velocity zones ending below 40, "key = 60" matches
+ * regions containing note 60.
+ *
+ * The string fields "instrument", "sample" and "script" (name of any script
+ * of the instrument) take a quoted or bare string value and support "=", "!="
+ * and "~" (contains), all case insensitive.
+ */
+class DimRegionQuery {
+public:
+    DimRegionQuery();
+    ~DimRegionQuery();
+
+    /// Parses @a expression, returns false with @a error set on syntax errors.
+    bool parse(const std::string& expression, std::string& error);
+
+    /**
+     * Collects the rows (in build order) of @a index matching the parsed
+     * expression. Returns false with @a error set if a field is unknown or
+     * the index is stale.
+     */
+    bool evaluate(DimRegionIndex& index, std::vector<size_t>& rows, std::string& error);
+
+    struct Node;
+
+private:
+    std::unique_ptr<Node> m_root;
+};
+
+#endif // GIGEDIT_DIMREGIONQUERY_H
@@ -0,0 +1,239 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "DimRegionSearch.h"
+#include "global.h"
+
+#if HAS_GTKMM_STOCK
+# include <gtkmm/stock.h>
+#endif
+
+Glib::ustring gig_to_utf8(const gig::String& gig_string);
+Glib::ustring note_str(int note);
+
+// the list view would be slow to fill with hundreds of thousands of rows
+static const size_t MAX_LISTED_RESULTS = 2000;
+
+DimRegionSearch::DimRegionSearch() :
+    m_gig(NULL), m_rebuildScheduled(false),
+    m_queryLabel(_("Find:")),
+    m_findButton(_("_Find"), true),
+    m_statusLabel("", Gtk::ALIGN_START),
+    m_selectButton(_("_Edit Found Dimension Regions"), true),
+#if HAS_GTKMM_STOCK
+    m_closeButton(Gtk::Stock::CLOSE)
+#else
+    m_closeButton(_("_Close"), true)
+#endif
+{
+    if (!Settings::singleton()->autoRestoreWindowDimension) {
+        set_default_size(600, 450);
+        set_position(Gtk::WIN_POS_MOUSE);
+    }
+
+    set_title(_("Find Dimension Regions"));
+#if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && GTKMM_MINOR_VERSION > 24)
+    set_margin(6);
+#else
+    set_border_width(6);
+#endif
+
+#if !HAS_GTKMM_STOCK
+    m_closeButton.set_icon_name("window-close");
+#endif
+
+    add(m_vbox);
+    m_vbox.set_spacing(6);
+
+    m_queryBox.set_spacing(6);
+    m_queryBox.pack_start(m_queryLabel, Gtk::PACK_SHRINK);
+    m_queryBox.pack_start(m_queryEntry);
+    m_queryBox.pack_start(m_findButton, Gtk::PACK_SHRINK);
+    m_vbox.pack_start(m_queryBox, Gtk::PACK_SHRINK);
+
+    m_queryEntry.set_tooltip_text(_(
+        "Filter expression, i.e.\n"
+        "  SampleLoops > 0 and sample.loops = 0\n"
+        "  sample = \"Piano C4\" and velocity < 40\n"
+        "  script ~ legato\n\n"
+        "Fields are the dimension region's parameters (i.e. EG1Release), "
+        "keylow, keyhigh, key, vellow, velhigh, velocity, hassample, "
+        "sample.loops, sample.channels, sample.rate, sample.bits, "
+        "sample.frames, and the names instrument, sample and script. "
+        "Operators are = != < <= > >= and ~ (contains), combined by and, or, "
+        "not and parentheses."
+    ));
+
+    m_refListStore = Gtk::ListStore::create(m_columns);
+    m_treeView.set_model(m_refListStore);
+    m_treeView.append_column(_("Instrument"), m_columns.m_col_instrument);
+    m_treeView.append_column(_("Region"), m_columns.m_col_region);
+    m_treeView.append_column(_("Dimension Region"), m_columns.m_col_dimrgn_index);
+    m_treeView.append_column(_("Velocity"), m_columns.m_col_velocity);
+    m_treeView.append_column(_("Sample"), m_columns.m_col_sample);
+    m_treeView.set_headers_visible(true);
+    m_treeView.get_selection()->set_mode(Gtk::SELECTION_SINGLE);
+    m_treeView.set_tooltip_text(_(
+        "Double click to edit the respective dimension region."
+    ));
+    m_scrolledWindow.add(m_treeView);
+    m_scrolledWindow.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+    m_vbox.pack_start(m_scrolledWindow);
+    m_vbox.pack_start(m_statusLabel, Gtk::PACK_SHRINK);
+
+    m_selectButton.set_tooltip_text(_(
+        "Select all found dimension regions in the main window, so that "
+        "subsequent changes are applied to all of them."
+    ));
+    m_selectButton.set_sensitive(false);
+    m_buttonBox.set_layout(Gtk::BUTTONBOX_END);
+    m_buttonBox.set_spacing(6);
+    m_buttonBox.pack_start(m_selectButton, Gtk::PACK_SHRINK);
+    m_buttonBox.pack_start(m_closeButton, Gtk::PACK_SHRINK);
+    m_vbox.pack_start(m_buttonBox, Gtk::PACK_SHRINK);
+
+    m_findButton.signal_clicked().connect(
+        sigc::mem_fun(*this, &DimRegionSearch::on_find)
+    );
+    m_queryEntry.signal_activate().connect(
+        sigc::mem_fun(*this, &DimRegionSearch::on_find)
+    );
+    m_selectButton.signal_clicked().connect(
+        sigc::mem_fun(*this, &DimRegionSearch::on_select_edit_set)
+    );
+    m_closeButton.signal_clicked().connect(
+        sigc::mem_fun(*this, &DimRegionSearch::hide)
+    );
+    m_treeView.signal_row_activated().connect(
+        sigc::mem_fun(*this, &DimRegionSearch::on_row_activated)
+    );
+
+#if HAS_GTKMM_SHOW_ALL_CHILDREN
+    show_all_children();
+#endif
+}
+
+void DimRegionSearch::set_file(gig::File* gig) {
+    if (gig == m_gig) return;
+    m_gig = gig;
+    clear_results();
+    m_index.clear();
+    // the index is built when idle, so loading the file is not slowed down
+    if (gig) schedule_rebuild();
+}
+
+void DimRegionSearch::schedule_rebuild() {
+    if (m_rebuildScheduled) return;
+    m_rebuildScheduled = true;
+    Glib::signal_idle().connect_once(
+        sigc::mem_fun(*this, &DimRegionSearch::rebuild),
+        Glib::PRIORITY_LOW
+    );
+}
+
+void DimRegionSearch::rebuild() {
+    m_rebuildScheduled = false;
+    m_index.build(m_gig);
+}
+
+void DimRegionSearch::clear_results() {
+    m_results.clear();
+    m_refListStore->clear();
+    m_statusLabel.set_text("");
+    m_selectButton.set_sensitive(false);
+}
+
+void DimRegionSearch::on_find() {
+    clear_results();
+    if (!m_gig) return;
+    // i.e. instruments were added since the index was built
+    if (m_rebuildScheduled || !m_index.hasInstrumentsOf(m_gig)) rebuild();
+
+    std::string error;
+    std::vector<size_t> rows;
+    DimRegionQuery query;
+    if (!query.parse(m_queryEntry.get_text(), error) ||
+        !query.evaluate(m_index, rows, error))
+    {
+        m_statusLabel.set_text(error);
+        return;
+    }
+
+    const std::vector<double>* velLow =
+        m_index.fieldValues(DimRegionIndex::FIELD_VELOCITY_LOW);
+    const std::vector<double>* velHigh =
+        m_index.fieldValues(DimRegionIndex::FIELD_VELOCITY_HIGH);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const ParamTable::Row& r = m_index.row(rows[i]);
+        m_results.insert(r.dimrgn);
+        if (i >= MAX_LISTED_RESULTS) continue;
+
+        Gtk::TreeModel::Row row = *m_refListStore->append();
+        row[m_columns.m_col_instrument] =
+            gig_to_utf8(m_index.instrument(rows[i])->pInfo->Name);
+        row[m_columns.m_col_region] =
+            note_str(r.keyLow) + " - " + note_str(r.keyHigh);
+        row[m_columns.m_col_dimrgn_index] = r.index;
+        row[m_columns.m_col_velocity] =
+            ToString(int((*velLow)[rows[i]])) + " - " +
+            ToString(int((*velHigh)[rows[i]]));
+        row[m_columns.m_col_sample] = (r.dimrgn->pSample) ?
+            gig_to_utf8(r.dimrgn->pSample->pInfo->Name) : Glib::ustring();
+        row[m_columns.m_col_dimrgn] = r.dimrgn;
+    }
+
+    Glib::ustring status =
+        ToString(rows.size()) + " " + _("dimension regions found");
+    if (rows.size() > MAX_LISTED_RESULTS)
+        status += " (" + ToString(MAX_LISTED_RESULTS) + " " + _("listed") + ")";
+    m_statusLabel.set_text(status);
+    m_selectButton.set_sensitive(!m_results.empty());
+}
+
+void DimRegionSearch::on_select_edit_set() {
+    if (m_results.empty()) return;
+    m_selectEditSet.emit(m_results);
+}
+
+void DimRegionSearch::on_row_activated(const Gtk::TreeModel::Path& path,
+                                       Gtk::TreeViewColumn* column)
+{
+    Gtk::TreeModel::iterator it = m_refListStore->get_iter(path);
+    if (!it) return;
+    Gtk::TreeModel::Row row = *it;
+    gig::DimensionRegion* dimrgn = row[m_columns.m_col_dimrgn];
+    if (dimrgn) m_dimrgnActivated.emit(dimrgn);
+}
+
+void DimRegionSearch::dimrgn_changed(gig::DimensionRegion* dimrgn) {
+    if (m_index.isStale()) return;
+    m_index.update(dimrgn);
+}
+
+void DimRegionSearch::region_changed(gig::Region* rgn) {
+    if (m_index.isStale()) return;
+    if (!m_index.updateRegion(rgn)) {
+        // the dimension regions of the region were replaced
+        m_index.setStale(true);
+        clear_results();
+        schedule_rebuild();
+    }
+}
+
+void DimRegionSearch::samples_changed() {
+    m_index.samplesChanged();
+}
+
+void DimRegionSearch::file_structure_to_be_changed() {
+    // results and index might refer to objects about to be deleted
+    m_index.setStale(true);
+    clear_results();
+}
+
+void DimRegionSearch::file_structure_changed() {
+    if (m_gig) schedule_rebuild();
+}
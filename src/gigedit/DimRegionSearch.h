@@ -0,0 +1,109 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_DIMREGIONSEARCH_H
+#define GIGEDIT_DIMREGIONSEARCH_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#ifdef GTKMM_HEADER_FILE
+# include GTKMM_HEADER_FILE(gtkmm.h)
+#else
+# include <gtkmm.h>
+#endif
+
+#include "compat.h"
+#include "ManagedWindow.h"
+#include "DimRegionQuery.h"
+
+#include <set>
+
+/** @brief Finds dimension regions by a filter expression.
+ *
+ * Evaluates a DimRegionQuery entered by the user against a DimRegionIndex of
+ * the whole gig file. The index is built at idle time right after a file was
+ * loaded, and afterwards kept up to date by the change notifications of the
+ * main window, so queries do not have to walk the gig file.
+ */
+class DimRegionSearch : public ManagedWindow {
+public:
+    DimRegionSearch();
+
+    void set_file(gig::File* gig);
+
+    // notifications by the main window
+    void dimrgn_changed(gig::DimensionRegion* dimrgn);
+    void region_changed(gig::Region* rgn);
+    void samples_changed();
+    void file_structure_to_be_changed();
+    void file_structure_changed();
+
+    /// The user wants the found dimension regions to be edited together.
+    sigc::signal<void, const std::set<gig::DimensionRegion*>&>& signal_select_edit_set() { return m_selectEditSet; }
+    /// The user wants to edit @a dimrgn in the main window.
+    sigc::signal<bool, gig::DimensionRegion*>& signal_dimrgn_activated() { return m_dimrgnActivated; }
+
+    // implementation for abstract methods of interface class "ManagedWindow"
+    virtual Settings::Property<int>* windowSettingX() { return &Settings::singleton()->dimRegionSearchWindowX; }
+    virtual Settings::Property<int>* windowSettingY() { return &Settings::singleton()->dimRegionSearchWindowY; }
+    virtual Settings::Property<int>* windowSettingWidth() { return &Settings::singleton()->dimRegionSearchWindowW; }
+    virtual Settings::Property<int>* windowSettingHeight() { return &Settings::singleton()->dimRegionSearchWindowH; }
+
+protected:
+    gig::File* m_gig;
+    DimRegionIndex m_index;
+    bool m_rebuildScheduled;
+    std::set<gig::DimensionRegion*> m_results;
+    sigc::signal<void, const std::set<gig::DimensionRegion*>&> m_selectEditSet;
+    sigc::signal<bool, gig::DimensionRegion*> m_dimrgnActivated;
+
+    VBox m_vbox;
+    HBox m_queryBox;
+    Gtk::Label m_queryLabel;
+    Gtk::Entry m_queryEntry;
+    Gtk::Button m_findButton;
+    Gtk::ScrolledWindow m_scrolledWindow;
+    Gtk::TreeView m_treeView;
+    Gtk::Label m_statusLabel;
+    HButtonBox m_buttonBox;
+    Gtk::Button m_selectButton;
+    Gtk::Button m_closeButton;
+
+    class ResultsModel : public Gtk::TreeModel::ColumnRecord {
+    public:
+        ResultsModel() {
+            add(m_col_instrument);
+            add(m_col_region);
+            add(m_col_dimrgn_index);
+            add(m_col_velocity);
+            add(m_col_sample);
+            add(m_col_dimrgn);
+        }
+
+        Gtk::TreeModelColumn<Glib::ustring> m_col_instrument;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_region;
+        Gtk::TreeModelColumn<int> m_col_dimrgn_index;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_velocity;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_sample;
+        Gtk::TreeModelColumn<gig::DimensionRegion*> m_col_dimrgn;
+    } m_columns;
+
+    Glib::RefPtr<Gtk::ListStore> m_refListStore;
+
+    void rebuild();
+    void schedule_rebuild();
+    void clear_results();
+    void on_find();
+    void on_select_edit_set();
+    void on_row_activated(const Gtk::TreeModel::Path& path, Gtk::TreeViewColumn* column);
+};
+
+#endif // GIGEDIT_DIMREGIONSEARCH_H
@@ -0,0 +1,326 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "DuplicateSamples.h"
+#include "ParallelFor.h"
+
+#include <string.h>
+#include <algorithm>
+#include <mutex>
+
+// amount of sample points (frames) read from disk at once for hashing
+#define HASH_CHUNK_FRAMES 65536
+
+///////////////////////////////////////////////////////////////////////////
+// class 'ContentHash'
+
+static const uint64_t PRIME1 = 11400714785074694791ULL;
+static const uint64_t PRIME2 = 14029467366897019727ULL;
+static const uint64_t PRIME3 =  1609587929392839161ULL;
+static const uint64_t PRIME4 =  9650029242287828579ULL;
+static const uint64_t PRIME5 =  2870177450012600261ULL;
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hashRound(uint64_t acc, uint64_t input) {
+    acc += input * PRIME2;
+    acc  = rotl64(acc, 31);
+    return acc * PRIME1;
+}
+
+static inline uint64_t hashMergeRound(uint64_t acc, uint64_t val) {
+    acc ^= hashRound(0, val);
+    return acc * PRIME1 + PRIME4;
+}
+
+ContentHash::ContentHash(uint64_t seed) :
+    m_totalSize(0), m_seed(seed), m_pendingSize(0)
+{
+    m_acc[0] = seed + PRIME1 + PRIME2;
+    m_acc[1] = seed + PRIME2;
+    m_acc[2] = seed;
+    m_acc[3] = seed - PRIME1;
+}
+
+void ContentHash::update(const void* data, size_t size) {
+    const uint8_t* p = (const uint8_t*) data;
+    const uint8_t* const end = p + size;
+    m_totalSize += size;
+
+    // complete a stripe left over from the previous call first
+    if (m_pendingSize) {
+        const size_t n = std::min(size, 32 - m_pendingSize);
+        memcpy(m_pending + m_pendingSize, p, n);
+        m_pendingSize += n;
+        p += n;
+        if (m_pendingSize < 32) return;
+        for (int i = 0; i < 4; ++i)
+            m_acc[i] = hashRound(m_acc[i], read64(m_pending + 8*i));
+        m_pendingSize = 0;
+    }
+
+    // bulk of the data: 32 byte stripes, 4 independent lanes
+    uint64_t v1 = m_acc[0], v2 = m_acc[1], v3 = m_acc[2], v4 = m_acc[3];
+    for (; p + 32 <= end; p += 32) {
+        v1 = hashRound(v1, read64(p));
+        v2 = hashRound(v2, read64(p + 8));
+        v3 = hashRound(v3, read64(p + 16));
+        v4 = hashRound(v4, read64(p + 24));
+    }
+    m_acc[0] = v1; m_acc[1] = v2; m_acc[2] = v3; m_acc[3] = v4;
+
+    if (p < end) {
+        m_pendingSize = end - p;
+        memcpy(m_pending, p, m_pendingSize);
+    }
+}
+
+uint64_t ContentHash::digest() const {
+    uint64_t h;
+    if (m_totalSize >= 32) {
+        h = rotl64(m_acc[0], 1) + rotl64(m_acc[1], 7) +
+            rotl64(m_acc[2], 12) + rotl64(m_acc[3], 18);
+        for (int i = 0; i < 4; ++i)
+            h = hashMergeRound(h, m_acc[i]);
+    } else {
+        h = m_seed + PRIME5;
+    }
+    h += m_totalSize;
+
+    const uint8_t* p = m_pending;
+    const uint8_t* const end = m_pending + m_pendingSize;
+    for (; p + 8 <= end; p += 8) {
+        h ^= hashRound(0, read64(p));
+        h  = rotl64(h, 27) * PRIME1 + PRIME4;
+    }
+    if (p + 4 <= end) {
+        h ^= uint64_t(read32(p)) * PRIME1;
+        h  = rotl64(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= (*p) * PRIME5;
+        h  = rotl64(h, 11) * PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// duplicate search
+
+/**
+ * All sample header fields which must be equal for two samples to be
+ * considered as duplicates. Samples with different loops or tuning are not
+ * interchangeable for playback, even if their audio data is identical.
+ */
+static std::vector<uint64_t> sampleHeaderKey(gig::Sample* s) {
+    std::vector<uint64_t> key;
+    key.push_back(s->SamplesTotal);
+    key.push_back(s->Channels);
+    key.push_back(s->BitDepth);
+    key.push_back(s->FrameSize);
+    key.push_back(s->SamplesPerSecond);
+    key.push_back(s->MIDIUnityNote);
+    key.push_back(s->FineTune);
+    key.push_back(s->Loops);
+    if (s->Loops) {
+        key.push_back(s->LoopType);
+        key.push_back(s->LoopStart);
+        key.push_back(s->LoopEnd);
+        key.push_back(s->LoopPlayCount);
+    }
+    return key;
+}
+
+std::map<gig::Sample*,int> sampleRefCounts(gig::File* gig) {
+    std::map<gig::Sample*,int> refs;
+    for (gig::Instrument* instr = gig->GetFirstInstrument(); instr;
+         instr = gig->GetNextInstrument())
+    {
+        for (gig::Region* rgn = instr->GetFirstRegion(); rgn;
+             rgn = instr->GetNextRegion())
+        {
+            for (int i = 0; i < rgn->DimensionRegions; ++i) {
+                gig::DimensionRegion* dimrgn = rgn->pDimensionRegions[i];
+                if (dimrgn && dimrgn->pSample) refs[dimrgn->pSample]++;
+            }
+        }
+    }
+    return refs;
+}
+
+std::vector<DuplicateSampleSet> findDuplicateSamples(gig::File* gig,
+    const std::set<gig::Sample*>& ignore, std::atomic<bool>* cancel,
+    std::function<void(float)> progress)
+{
+    std::vector<DuplicateSampleSet> result;
+    if (!gig) return result;
+
+    // stage 1: group by header fields, only groups with more than one sample
+    // are candidates that need to be read from disk at all
+    std::vector<gig::Sample*> fileOrder;
+    std::map<std::vector<uint64_t>, std::vector<size_t> > byHeader;
+    for (gig::Sample* s = gig->GetFirstSample(); s; s = gig->GetNextSample()) {
+        if (ignore.count(s)) continue;
+        byHeader[sampleHeaderKey(s)].push_back(fileOrder.size());
+        fileOrder.push_back(s);
+    }
+
+    std::vector<size_t> candidates;
+    for (auto it = byHeader.begin(); it != byHeader.end(); ++it)
+        if (it->second.size() > 1)
+            candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+    if (candidates.empty()) return result;
+
+    // biggest samples first for a better load balance among worker threads
+    std::sort(candidates.begin(), candidates.end(), [&](size_t a, size_t b) {
+        const uint64_t sizeA = fileOrder[a]->SamplesTotal * fileOrder[a]->FrameSize;
+        const uint64_t sizeB = fileOrder[b]->SamplesTotal * fileOrder[b]->FrameSize;
+        return sizeA > sizeB;
+    });
+
+    uint64_t totalBytes = 0;
+    for (size_t i = 0; i < candidates.size(); ++i)
+        totalBytes += fileOrder[candidates[i]]->SamplesTotal * fileOrder[candidates[i]]->FrameSize;
+
+    // stage 2: hash the audio data of all candidates
+    std::vector<uint64_t> hashes(fileOrder.size(), 0);
+    std::mutex ioMutex;
+    std::atomic<uint64_t> bytesDone(0);
+    std::atomic<int> lastPercent(-1);
+
+    parallelFor(candidates.size(), [&](size_t c) {
+        if (cancel && *cancel) return;
+        gig::Sample* sample = fileOrder[candidates[c]];
+        const size_t frameSize = sample->FrameSize;
+        std::vector<uint8_t> buffer(HASH_CHUNK_FRAMES * frameSize);
+        gig::buffer_t decompressionBuffer;
+        if (sample->Compressed)
+            decompressionBuffer =
+                gig::Sample::CreateDecompressionBuffer(HASH_CHUNK_FRAMES);
+
+        // seed with the length, so that a zero padded tail of a sample does
+        // not collide with the shorter version of it
+        ContentHash hash(sample->SamplesTotal);
+        try {
+            {
+                std::lock_guard<std::mutex> lock(ioMutex);
+                sample->SetPos(0);
+            }
+            gig::file_offset_t remaining = sample->SamplesTotal;
+            while (remaining) {
+                if (cancel && *cancel) break;
+                gig::file_offset_t n;
+                {
+                    std::lock_guard<std::mutex> lock(ioMutex);
+                    n = sample->Read(
+                        &buffer[0], std::min<gig::file_offset_t>(remaining, HASH_CHUNK_FRAMES),
+                        sample->Compressed ? &decompressionBuffer : NULL
+                    );
+                }
+                if (!n) break; // premature end of sample data
+                hash.update(&buffer[0], n * frameSize);
+                remaining -= n;
+
+                const uint64_t done = (bytesDone += n * frameSize);
+                const int percent = int(done * 100 / totalBytes);
+                if (progress && percent != lastPercent.exchange(percent))
+                    progress(float(done) / float(totalBytes));
+            }
+            {
+                std::lock_guard<std::mutex> lock(ioMutex);
+                sample->SetPos(0);
+            }
+            // a truncated sample must never match a complete one
+            hashes[candidates[c]] = (remaining) ? 0 : hash.digest();
+        } catch (...) {
+            if (sample->Compressed)
+                gig::Sample::DestroyDecompressionBuffer(decompressionBuffer);
+            throw;
+        }
+        if (sample->Compressed)
+            gig::Sample::DestroyDecompressionBuffer(decompressionBuffer);
+    });
+
+    if (cancel && *cancel) return result;
+
+    // stage 3: samples with same header and same hash are duplicates
+    std::map<gig::Sample*,int> refs = sampleRefCounts(gig);
+    for (auto it = byHeader.begin(); it != byHeader.end(); ++it) {
+        const std::vector<size_t>& group = it->second;
+        if (group.size() < 2) continue;
+        std::map<uint64_t, DuplicateSampleSet> byHash;
+        for (size_t i = 0; i < group.size(); ++i) {
+            if (!hashes[group[i]]) continue; // could not be read completely
+            byHash[hashes[group[i]]].push_back(fileOrder[group[i]]);
+        }
+        for (auto itHash = byHash.begin(); itHash != byHash.end(); ++itHash) {
+            DuplicateSampleSet& set = itHash->second;
+            if (set.size() < 2) continue;
+            // survivor: the sample with the most references
+            std::stable_sort(set.begin(), set.end(), [&](gig::Sample* a, gig::Sample* b) {
+                return refs[a] > refs[b];
+            });
+            result.push_back(set);
+        }
+    }
+
+    // sets wasting most space first
+    std::stable_sort(result.begin(), result.end(),
+        [](const DuplicateSampleSet& a, const DuplicateSampleSet& b) {
+            return a[0]->SamplesTotal * a[0]->FrameSize * (a.size() - 1) >
+                   b[0]->SamplesTotal * b[0]->FrameSize * (b.size() - 1);
+        }
+    );
+
+    if (progress) progress(1.f);
+    return result;
+}
+
+int replaceSampleReferences(gig::File* gig,
+    const std::map<gig::Sample*,gig::Sample*>& replacements)
+{
+    int count = 0;
+    if (!gig || replacements.empty()) return count;
+    for (gig::Instrument* instr = gig->GetFirstInstrument(); instr;
+         instr = gig->GetNextInstrument())
+    {
+        for (gig::Region* rgn = instr->GetFirstRegion(); rgn;
+             rgn = instr->GetNextRegion())
+        {
+            for (int i = 0; i < rgn->DimensionRegions; ++i) {
+                gig::DimensionRegion* dimrgn = rgn->pDimensionRegions[i];
+                if (!dimrgn || !dimrgn->pSample) continue;
+                auto it = replacements.find(dimrgn->pSample);
+                if (it == replacements.end()) continue;
+                dimrgn->pSample = it->second;
+                ++count;
+            }
+        }
+    }
+    return count;
+}
@@ -0,0 +1,93 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_DUPLICATESAMPLES_H
+#define GIGEDIT_DUPLICATESAMPLES_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#include <vector>
+#include <set>
+#include <map>
+#include <atomic>
+#include <functional>
+#include <stdint.h>
+
+/**
+ * Set of samples of the same gig file with bit identical audio data and
+ * identical playback relevant sample header fields. The first sample of the
+ * set is the suggested survivor when merging the set (the one with the most
+ * references by dimension regions).
+ */
+typedef std::vector<gig::Sample*> DuplicateSampleSet;
+
+/** @brief Streaming 64 bit content hash (xxHash64 algorithm).
+ *
+ * Fast non-cryptographic hash used to compare sample audio data. Data can be
+ * fed in arbitrary sized pieces by calling update() multiple times, the
+ * result does not depend on how the data was split up.
+ */
+class ContentHash {
+public:
+    ContentHash(uint64_t seed = 0);
+    void update(const void* data, size_t size);
+    uint64_t digest() const;
+private:
+    uint64_t m_acc[4];
+    uint64_t m_totalSize;
+    uint64_t m_seed;
+    uint8_t  m_pending[32];
+    size_t   m_pendingSize;
+};
+
+/**
+ * Searches the gig file @a gig for samples with bit identical audio data.
+ *
+ * Only samples whose header fields (format, length, sample rate, unity note,
+ * fine tune and loops) match at least one other sample are read from disk at
+ * all. Those candidates are streamed in chunks and hashed on several worker
+ * threads. Access to the gig file itself is serialized, since libgig's file
+ * I/O is not thread safe, so hashing of one sample overlaps with reading the
+ * next ones.
+ *
+ * This function blocks until the search completed, so it should be called
+ * from a background thread when used from the GUI. The file must not be
+ * modified while the search is running.
+ *
+ * @param gig - gig file to be searched
+ * @param ignore - samples to be excluded (i.e. samples not yet imported)
+ * @param cancel - optional flag, search is aborted if set to true
+ * @param progress - optional callback receiving the current progress (0..1)
+ * @returns all duplicate sets found, each with at least two samples
+ */
+std::vector<DuplicateSampleSet> findDuplicateSamples(gig::File* gig,
+    const std::set<gig::Sample*>& ignore = std::set<gig::Sample*>(),
+    std::atomic<bool>* cancel = NULL,
+    std::function<void(float)> progress = std::function<void(float)>());
+
+/**
+ * Counts how many dimension regions of all instruments of @a gig reference
+ * each sample. Samples not referenced at all are not contained.
+ */
+std::map<gig::Sample*,int> sampleRefCounts(gig::File* gig);
+
+/**
+ * Changes the sample reference of all dimension regions of all instruments
+ * of @a gig which reference a key of @a replacements to the respective mapped
+ * sample. This function does not emit any signals, it is up to the caller to
+ * notify about the changes.
+ *
+ * @returns amount of dimension regions which were changed
+ */
+int replaceSampleReferences(gig::File* gig,
+    const std::map<gig::Sample*,gig::Sample*>& replacements);
+
+#endif // GIGEDIT_DUPLICATESAMPLES_H
@@ -0,0 +1,242 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "DuplicateSamplesDialog.h"
+#include "global.h"
+
+#include <gtkmm/messagedialog.h>
+#if HAS_GTKMM_STOCK
+# include <gtkmm/stock.h>
+#endif
+
+Glib::ustring gig_to_utf8(const gig::String& gig_string);
+
+static Glib::ustring sizeAsString(uint64_t bytes) {
+    if (bytes >= 1024*1024)
+        return ToString(int(bytes / (1024*1024))) + " MB";
+    if (bytes >= 1024)
+        return ToString(int(bytes / 1024)) + " KB";
+    return ToString(int(bytes)) + " " + _("Bytes");
+}
+
+DuplicateSamplesDialog::DuplicateSamplesDialog(Gtk::Window& parent, gig::File* gig,
+                                               const std::set<gig::Sample*>& ignore)
+    : ManagedDialog(_("Duplicate Samples"), parent, true),
+      m_gig(gig), m_ignore(ignore), m_mergeRequested(false),
+#if HAS_GTKMM_STOCK
+      m_closeButton(Gtk::Stock::CLOSE),
+#else
+      m_closeButton(_("_Close"), true),
+#endif
+      m_mergeButton(_("_Merge Duplicates"), true),
+      m_descriptionLabel(),
+      m_cancel(false), m_progress(0)
+{
+    if (!Settings::singleton()->autoRestoreWindowDimension) {
+        set_default_size(500, 450);
+        set_position(Gtk::WIN_POS_MOUSE);
+    }
+
+#if !HAS_GTKMM_STOCK
+    m_closeButton.set_icon_name("window-close");
+#endif
+
+    m_scrolledWindow.add(m_treeView);
+    m_scrolledWindow.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+
+#if USE_GTKMM_BOX
+    get_content_area()->pack_start(m_descriptionLabel, Gtk::PACK_SHRINK);
+    get_content_area()->pack_start(m_progressBar, Gtk::PACK_SHRINK);
+    get_content_area()->pack_start(m_scrolledWindow);
+    get_content_area()->pack_start(m_summaryLabel, Gtk::PACK_SHRINK);
+    get_content_area()->pack_start(m_buttonBox, Gtk::PACK_SHRINK);
+#else
+    get_vbox()->pack_start(m_descriptionLabel, Gtk::PACK_SHRINK);
+    get_vbox()->pack_start(m_progressBar, Gtk::PACK_SHRINK);
+    get_vbox()->pack_start(m_scrolledWindow);
+    get_vbox()->pack_start(m_summaryLabel, Gtk::PACK_SHRINK);
+    get_vbox()->pack_start(m_buttonBox, Gtk::PACK_SHRINK);
+#endif
+
+#if GTKMM_MAJOR_VERSION >= 3
+    m_descriptionLabel.set_line_wrap();
+#endif
+    m_descriptionLabel.set_text(_(
+        "The following sets of samples have bit identical audio data, the same "
+        "sample rate, tuning and loops. Merging a set lets all dimension regions "
+        "use the first sample of the set and deletes the other samples of the "
+        "set from the file. Uncheck the sets which shall be left untouched."
+    ));
+
+    m_refTreeModel = Gtk::TreeStore::create(m_columns);
+    m_treeView.set_model(m_refTreeModel);
+    {
+        Gtk::CellRendererToggle* renderer = Gtk::manage(new Gtk::CellRendererToggle);
+        renderer->signal_toggled().connect(
+            sigc::mem_fun(*this, &DuplicateSamplesDialog::onMergeToggled)
+        );
+        Gtk::TreeViewColumn* column = Gtk::manage(new Gtk::TreeViewColumn(_("Merge")));
+        column->pack_start(*renderer, false);
+        column->add_attribute(renderer->property_active(), m_columns.m_col_merge);
+        column->add_attribute(renderer->property_visible(), m_columns.m_col_is_set);
+        m_treeView.append_column(*column);
+    }
+    m_treeView.append_column(_("Sample"), m_columns.m_col_name);
+    m_treeView.append_column(_("Size"), m_columns.m_col_size);
+    m_treeView.append_column(_("References"), m_columns.m_col_refcount);
+    m_treeView.set_headers_visible(true);
+    m_treeView.get_selection()->set_mode(Gtk::SELECTION_SINGLE);
+
+    m_buttonBox.set_layout(Gtk::BUTTONBOX_END);
+#if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && GTKMM_MINOR_VERSION > 24)
+    m_buttonBox.set_margin(5);
+#else
+    m_buttonBox.set_border_width(5);
+#endif
+    m_buttonBox.pack_start(m_closeButton, Gtk::PACK_SHRINK);
+    m_buttonBox.pack_start(m_mergeButton, Gtk::PACK_SHRINK);
+    m_mergeButton.set_sensitive(false);
+
+    m_closeButton.signal_clicked().connect(
+        sigc::mem_fun(*this, &DuplicateSamplesDialog::hide)
+    );
+    m_mergeButton.signal_clicked().connect(
+        sigc::mem_fun(*this, &DuplicateSamplesDialog::onMergeClicked)
+    );
+
+    m_progressDispatcher.connect(
+        sigc::mem_fun(*this, &DuplicateSamplesDialog::onSearchProgress)
+    );
+    m_finishedDispatcher.connect(
+        sigc::mem_fun(*this, &DuplicateSamplesDialog::onSearchFinished)
+    );
+
+#if HAS_GTKMM_SHOW_ALL_CHILDREN
+    show_all_children();
+#endif
+
+    launchSearch();
+}
+
+DuplicateSamplesDialog::~DuplicateSamplesDialog() {
+    stopSearch();
+}
+
+void DuplicateSamplesDialog::launchSearch() {
+    m_summaryLabel.set_text(_("Searching for duplicate samples ..."));
+    m_thread = std::thread([this]() {
+        try {
+            m_sets = findDuplicateSamples(m_gig, m_ignore, &m_cancel,
+                [this](float fraction) {
+                    m_progress = int(fraction * 1000.f);
+                    m_progressDispatcher();
+                }
+            );
+        } catch (RIFF::Exception e) {
+            m_sets.clear();
+            m_errorMessage = e.Message;
+        } catch (...) {
+            m_sets.clear();
+            m_errorMessage = _("Unknown exception occurred");
+        }
+        m_finishedDispatcher();
+    });
+}
+
+void DuplicateSamplesDialog::stopSearch() {
+    m_cancel = true;
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void DuplicateSamplesDialog::onSearchProgress() {
+    m_progressBar.set_fraction(float(m_progress) / 1000.f);
+}
+
+void DuplicateSamplesDialog::onSearchFinished() {
+    if (m_thread.joinable()) m_thread.join();
+    m_progressBar.set_fraction(1.f);
+    if (m_cancel) return;
+
+    if (!m_errorMessage.empty()) {
+        m_summaryLabel.set_text("");
+        Gtk::MessageDialog msg(*this, m_errorMessage, false, Gtk::MESSAGE_ERROR);
+        msg.run();
+        return;
+    }
+
+    std::map<gig::Sample*,int> refs = sampleRefCounts(m_gig);
+
+    uint64_t wasted = 0;
+    int duplicates = 0;
+    for (int iSet = 0; iSet < m_sets.size(); ++iSet) {
+        const DuplicateSampleSet& set = m_sets[iSet];
+        const uint64_t size = set[0]->SamplesTotal * set[0]->FrameSize;
+        wasted += size * (set.size() - 1);
+        duplicates += set.size() - 1;
+
+        Gtk::TreeModel::iterator iterSet = m_refTreeModel->append();
+        Gtk::TreeModel::Row rowSet = *iterSet;
+        rowSet[m_columns.m_col_merge]  = true;
+        rowSet[m_columns.m_col_is_set] = true;
+        rowSet[m_columns.m_col_name]   = gig_to_utf8(set[0]->pInfo->Name) +
+            " (" + ToString(set.size()) + " " + _("Samples") + ")";
+        rowSet[m_columns.m_col_size]   = sizeAsString(size);
+        rowSet[m_columns.m_col_set]    = iSet;
+
+        for (int s = 0; s < set.size(); ++s) {
+            Gtk::TreeModel::iterator iterSample = m_refTreeModel->append(rowSet.children());
+            Gtk::TreeModel::Row rowSample = *iterSample;
+            rowSample[m_columns.m_col_merge]    = false;
+            rowSample[m_columns.m_col_is_set]   = false;
+            rowSample[m_columns.m_col_name]     = gig_to_utf8(set[s]->pInfo->Name) +
+                ((s == 0) ? Glib::ustring(" ") + _("(kept)") : Glib::ustring());
+            rowSample[m_columns.m_col_refcount] = ToString(refs[set[s]]) + " " + _("Refs.");
+            rowSample[m_columns.m_col_set]      = -1;
+        }
+    }
+
+    if (m_sets.empty()) {
+        m_summaryLabel.set_text(_("No duplicate samples found."));
+    } else {
+        m_summaryLabel.set_text(
+            ToString(duplicates) + " " + _("duplicate samples found, merging them frees") +
+            " " + sizeAsString(wasted) + "."
+        );
+        m_mergeButton.set_sensitive(true);
+        m_treeView.expand_all();
+    }
+}
+
+void DuplicateSamplesDialog::onMergeToggled(const Glib::ustring& path) {
+    Gtk::TreeModel::iterator it = m_refTreeModel->get_iter(path);
+    if (!it) return;
+    Gtk::TreeModel::Row row = *it;
+    if (!row[m_columns.m_col_is_set]) return;
+    row[m_columns.m_col_merge] = !row[m_columns.m_col_merge];
+}
+
+void DuplicateSamplesDialog::onMergeClicked() {
+    m_mergeRequested = true;
+    hide();
+}
+
+bool DuplicateSamplesDialog::mergeRequested() const {
+    return m_mergeRequested;
+}
+
+std::vector<DuplicateSampleSet> DuplicateSamplesDialog::selectedSets() const {
+    std::vector<DuplicateSampleSet> sets;
+    Gtk::TreeModel::Children rows = m_refTreeModel->children();
+    for (Gtk::TreeModel::iterator it = rows.begin(); it != rows.end(); ++it) {
+        Gtk::TreeModel::Row row = *it;
+        if (!row[m_columns.m_col_merge]) continue;
+        const int iSet = row[m_columns.m_col_set];
+        if (iSet < 0 || iSet >= m_sets.size()) continue;
+        sets.push_back(m_sets[iSet]);
+    }
+    return sets;
+}
@@ -0,0 +1,115 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_DUPLICATESAMPLESDIALOG_H
+#define GIGEDIT_DUPLICATESAMPLESDIALOG_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#include "compat.h"
+
+#include <gtkmm/buttonbox.h>
+#include <gtkmm/dialog.h>
+#include <gtkmm/treeview.h>
+#include <gtkmm/treestore.h>
+#include <gtkmm/scrolledwindow.h>
+#include <gtkmm/progressbar.h>
+#include <glibmm/dispatcher.h>
+
+#include "wrapLabel.hh"
+#include "ManagedWindow.h"
+#include "DuplicateSamples.h"
+
+#include <thread>
+#include <atomic>
+
+/** @brief Modal dialog which finds and merges duplicate samples.
+ *
+ * When shown, this dialog starts searching the gig file for samples with bit
+ * identical audio data on background threads and lists the duplicate sets
+ * found. The user may then deselect individual sets and let all remaining
+ * sets be merged.
+ *
+ * This dialog does not modify the gig file by itself. If the user clicked on
+ * "Merge", then mergeRequested() returns true after run() returned and
+ * selectedSets() returns the sets to be merged by the caller.
+ */
+class DuplicateSamplesDialog : public ManagedDialog {
+public:
+    DuplicateSamplesDialog(Gtk::Window& parent, gig::File* gig,
+                           const std::set<gig::Sample*>& ignore);
+    ~DuplicateSamplesDialog();
+    bool mergeRequested() const;
+    std::vector<DuplicateSampleSet> selectedSets() const;
+
+    // implementation for abstract methods of interface class "ManagedDialog"
+    virtual Settings::Property<int>* windowSettingX() { return &Settings::singleton()->duplicateSamplesWindowX; }
+    virtual Settings::Property<int>* windowSettingY() { return &Settings::singleton()->duplicateSamplesWindowY; }
+    virtual Settings::Property<int>* windowSettingWidth() { return &Settings::singleton()->duplicateSamplesWindowW; }
+    virtual Settings::Property<int>* windowSettingHeight() { return &Settings::singleton()->duplicateSamplesWindowH; }
+
+protected:
+    gig::File* m_gig;
+    std::set<gig::Sample*> m_ignore;
+    bool m_mergeRequested;
+
+    HButtonBox           m_buttonBox;
+    Gtk::ScrolledWindow  m_scrolledWindow;
+    Gtk::TreeView        m_treeView;
+    Gtk::ProgressBar     m_progressBar;
+    Gtk::Button          m_closeButton;
+    Gtk::Button          m_mergeButton;
+#if GTKMM_MAJOR_VERSION < 3
+    view::WrapLabel      m_descriptionLabel;
+#else
+    Gtk::Label           m_descriptionLabel;
+#endif
+    Gtk::Label           m_summaryLabel;
+
+    class DupsTreeModel : public Gtk::TreeModel::ColumnRecord {
+    public:
+        DupsTreeModel() {
+            add(m_col_merge);
+            add(m_col_is_set);
+            add(m_col_name);
+            add(m_col_size);
+            add(m_col_refcount);
+            add(m_col_set);
+        }
+
+        Gtk::TreeModelColumn<bool>          m_col_merge;
+        Gtk::TreeModelColumn<bool>          m_col_is_set;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_name;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_size;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_refcount;
+        Gtk::TreeModelColumn<int>           m_col_set; ///< index of duplicate set (-1 on sample rows)
+    } m_columns;
+
+    Glib::RefPtr<Gtk::TreeStore> m_refTreeModel;
+
+    // background search
+    std::thread m_thread;
+    std::atomic<bool> m_cancel;
+    std::atomic<int> m_progress; ///< per mille
+    Glib::Dispatcher m_progressDispatcher;
+    Glib::Dispatcher m_finishedDispatcher;
+    std::vector<DuplicateSampleSet> m_sets;
+    Glib::ustring m_errorMessage;
+
+    void launchSearch();
+    void stopSearch();
+    void onSearchProgress();
+    void onSearchFinished();
+    void onMergeToggled(const Glib::ustring& path);
+    void onMergeClicked();
+};
+
+#endif // GIGEDIT_DUPLICATESAMPLESDIALOG_H
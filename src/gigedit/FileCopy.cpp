@@ -0,0 +1,183 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "FileCopy.h"
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(RIFF.h)
+#else
+# include <RIFF.h>
+#endif
+
+#include <vector>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#if defined(WIN32)
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+#if defined(__linux__)
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <linux/fs.h>
+#endif
+
+#ifndef O_BINARY
+# define O_BINARY 0
+#endif
+
+static void throwErrno(const std::string& what) {
+    throw RIFF::Exception(what + ": " + strerror(errno));
+}
+
+#if defined(__linux__)
+
+/// Tries to share the range between both files, returns false if unsupported.
+static bool cloneRange(int srcFd, uint64_t srcOffset, int dstFd,
+                       uint64_t dstOffset, uint64_t length)
+{
+#ifdef FICLONERANGE
+    struct file_clone_range range;
+    range.src_fd = srcFd;
+    range.src_offset = srcOffset;
+    range.src_length = length;
+    range.dest_offset = dstOffset;
+    // fails with EINVAL if the range is not aligned to file system blocks,
+    // with EXDEV / EOPNOTSUPP if both files are not on the same reflink
+    // capable file system
+    return ioctl(dstFd, FICLONERANGE, &range) == 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Lets the kernel copy the range, returns the amount of bytes copied (which
+ * is less than @a length if copy_file_range() is not supported).
+ */
+static uint64_t kernelCopyRange(int srcFd, uint64_t srcOffset, int dstFd,
+                                uint64_t dstOffset, uint64_t length)
+{
+    uint64_t done = 0;
+#ifdef SYS_copy_file_range
+    while (done < length) {
+        loff_t in  = srcOffset + done;
+        loff_t out = dstOffset + done;
+        const size_t n = (length - done > 0x40000000) ?
+                         0x40000000 : size_t(length - done);
+        const ssize_t res = syscall(SYS_copy_file_range, srcFd, &in, dstFd,
+                                    &out, n, 0);
+        if (res < 0) {
+            // not supported by kernel or file system; copy the rest in
+            // user space
+            if (errno == ENOSYS || errno == EXDEV || errno == EINVAL ||
+                errno == EOPNOTSUPP || errno == EBADF)
+                break;
+            throwErrno("Could not copy file data");
+        }
+        if (res == 0) break; // premature end of source file
+        done += res;
+    }
+#endif
+    return done;
+}
+
+#endif // __linux__
+
+static void bufferedCopyRange(int srcFd, uint64_t srcOffset, int dstFd,
+                              uint64_t dstOffset, uint64_t length)
+{
+    std::vector<char> buf(1024 * 1024);
+    uint64_t done = 0;
+    while (done < length) {
+        const size_t n = (length - done > buf.size()) ?
+                         buf.size() : size_t(length - done);
+#if defined(WIN32)
+        if (_lseeki64(srcFd, srcOffset + done, SEEK_SET) < 0)
+            throwErrno("Could not read file data");
+        const int res = _read(srcFd, &buf[0], (unsigned int) n);
+#else
+        const ssize_t res = pread(srcFd, &buf[0], n, srcOffset + done);
+#endif
+        if (res < 0) {
+            if (errno == EINTR) continue;
+            throwErrno("Could not read file data");
+        }
+        if (res == 0)
+            throw RIFF::Exception("Could not read file data: unexpected end of file");
+        for (size_t written = 0; written < size_t(res); ) {
+#if defined(WIN32)
+            if (_lseeki64(dstFd, dstOffset + done + written, SEEK_SET) < 0)
+                throwErrno("Could not write file data");
+            const int w = _write(dstFd, &buf[written], (unsigned int)(res - written));
+#else
+            const ssize_t w = pwrite(dstFd, &buf[written], res - written,
+                                     dstOffset + done + written);
+#endif
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                throwErrno("Could not write file data");
+            }
+            written += w;
+        }
+        done += res;
+    }
+}
+
+void copyFileRange(int srcFd, uint64_t srcOffset, int dstFd, uint64_t dstOffset,
+                   uint64_t length)
+{
+    if (!length) return;
+#if defined(__linux__)
+    if (cloneRange(srcFd, srcOffset, dstFd, dstOffset, length)) return;
+    const uint64_t done =
+        kernelCopyRange(srcFd, srcOffset, dstFd, dstOffset, length);
+    srcOffset += done;
+    dstOffset += done;
+    length    -= done;
+#endif
+    bufferedCopyRange(srcFd, srcOffset, dstFd, dstOffset, length);
+}
+
+void copyFile(const std::string& src, const std::string& dst) {
+    const int srcFd = open(src.c_str(), O_RDONLY | O_BINARY);
+    if (srcFd < 0) throwErrno("Could not open '" + src + "'");
+    struct stat st;
+    if (fstat(srcFd, &st)) {
+        const int err = errno;
+        close(srcFd);
+        errno = err;
+        throwErrno("Could not open '" + src + "'");
+    }
+    const int dstFd = open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_BINARY,
+                           st.st_mode & 0777);
+    if (dstFd < 0) {
+        const int err = errno;
+        close(srcFd);
+        errno = err;
+        throwErrno("Could not create '" + dst + "'");
+    }
+    try {
+#if defined(__linux__) && defined(FICLONE)
+        // share the whole file at once if possible (no block alignment
+        // restrictions for the file's tail this way)
+        if (ioctl(dstFd, FICLONE, srcFd) != 0)
+#endif
+            copyFileRange(srcFd, 0, dstFd, 0, st.st_size);
+    } catch (...) {
+        close(srcFd);
+        close(dstFd);
+        remove(dst.c_str());
+        throw;
+    }
+    close(srcFd);
+    if (close(dstFd)) throwErrno("Could not write '" + dst + "'");
+}
@@ -0,0 +1,35 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_FILECOPY_H
+#define GIGEDIT_FILECOPY_H
+
+#include <string>
+#include <stdint.h>
+
+/**
+ * Copies @a length bytes from position @a srcOffset of file descriptor
+ * @a srcFd to position @a dstOffset of file descriptor @a dstFd.
+ *
+ * Where the file system supports it, the range is shared between both files
+ * (reflink, e.g. on btrfs or XFS) or copied by the kernel without passing
+ * the data through user space. Otherwise it is copied with a buffer.
+ *
+ * @throws RIFF::Exception on I/O errors
+ */
+void copyFileRange(int srcFd, uint64_t srcOffset, int dstFd, uint64_t dstOffset,
+                   uint64_t length);
+
+/**
+ * Creates (or overwrites) file @a dst with the content of file @a src, in
+ * the most efficient way the file system supports (see copyFileRange()).
+ *
+ * @throws RIFF::Exception on I/O errors
+ */
+void copyFile(const std::string& src, const std::string& dst);
+
+#endif // GIGEDIT_FILECOPY_H
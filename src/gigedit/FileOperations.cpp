@@ -0,0 +1,261 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "FileOperations.h"
+#include "CompiledMacro.h"
+#include "global.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <set>
+
+gig::File* loadGigFile(RIFF::File* riff,
+    const std::function<void(const std::vector<std::string>&)>& headersLoaded,
+    gig::progress_t* progress)
+{
+    gig::File* gig = new gig::File(riff);
+    try {
+        if (headersLoaded) headersLoaded(readInstrumentNames(riff));
+        gig->GetInstrument(0, progress);
+    } catch (...) {
+        delete gig;
+        throw;
+    }
+    return gig;
+}
+
+std::map<gig::Sample*,int> countSampleReferences(gig::File* gig) {
+    std::map<gig::Sample*,int> refs;
+    for (gig::Instrument* instrument = gig->GetFirstInstrument(); instrument;
+                          instrument = gig->GetNextInstrument())
+    {
+        for (gig::Region* rgn = instrument->GetFirstRegion(); rgn;
+                          rgn = instrument->GetNextRegion())
+        {
+            for (int i = 0; i < 256; ++i) {
+                if (!rgn->pDimensionRegions[i]) continue;
+                if (rgn->pDimensionRegions[i]->pSample)
+                    refs[rgn->pDimensionRegions[i]->pSample]++;
+            }
+        }
+    }
+    return refs;
+}
+
+//TODO: this function and dimensionCaseOf() from global.h are duplicates, eliminate either one of them!
+static DimensionCase caseOfDimRegion(gig::DimensionRegion* dr, bool* isValidZone) {
+    DimensionCase dimCase;
+    if (!dr) {
+        *isValidZone = false;
+        return dimCase;
+    }
+
+    gig::Region* rgn = (gig::Region*) dr->GetParent();
+
+    // find the dimension region index of the passed dimension region
+    int drIndex;
+    for (drIndex = 0; drIndex < 256; ++drIndex)
+        if (rgn->pDimensionRegions[drIndex] == dr)
+            break;
+
+    // not found in region, something's horribly wrong
+    if (drIndex == 256) {
+        fprintf(stderr, "selectDimRegions: ERROR: index of dim region not found!\n");
+        *isValidZone = false;
+        return DimensionCase();
+    }
+
+    for (int d = 0, baseBits = 0; d < rgn->Dimensions; ++d) {
+        const int bits = rgn->pDimensionDefinitions[d].bits;
+        dimCase[rgn->pDimensionDefinitions[d].dimension] =
+            (drIndex >> baseBits) & ((1 << bits) - 1);
+        baseBits += bits;
+        // there are also DimensionRegion objects of unused zones, skip them
+        if (dimCase[rgn->pDimensionDefinitions[d].dimension] >= rgn->pDimensionDefinitions[d].zones) {
+            *isValidZone = false;
+            return DimensionCase();
+        }
+    }
+
+    *isValidZone = true;
+    return dimCase;
+}
+
+void selectDimRegions(const gig::Region* region, bool stereo,
+                      const std::map<gig::dimension_t, std::set<int> >& dimzones,
+                      std::set<gig::DimensionRegion*>& dimregs)
+{
+    for (int iDimRgn = 0; iDimRgn < 256; ++iDimRgn) {
+        gig::DimensionRegion* dimRgn = region->pDimensionRegions[iDimRgn];
+        if (!dimRgn) continue;
+        bool isValidZone;
+        std::map<gig::dimension_t,int> dimCase = caseOfDimRegion(dimRgn, &isValidZone);
+        if (!isValidZone) continue;
+        for (std::map<gig::dimension_t,int>::const_iterator it = dimCase.begin();
+             it != dimCase.end(); ++it)
+        {
+            if (stereo && it->first == gig::dimension_samplechannel) continue; // is selected
+
+            std::map<gig::dimension_t, std::set<int> >::const_iterator itSelectedDimension =
+                dimzones.find(it->first);
+            if (itSelectedDimension != dimzones.end()) {
+                if (itSelectedDimension->second.count(it->second))
+                    continue; // is selected
+                // special case: no selection of dimzone yet; assume zone 0
+                // being selected in this case
+                //
+                // (this is more or less a workaround for a bug, that is when
+                // no explicit dimregion case had been selected [ever] by user
+                // by clicking on some dimregionchooser zone yet, then the
+                // individual dimension entries of dimzones are empty)
+                if (itSelectedDimension->second.empty() && it->second == 0)
+                    continue; // is selected
+            }
+
+            goto notSelected;
+        }
+
+        dimregs.insert(dimRgn);
+
+        notSelected:
+        ;
+    }
+}
+
+std::list<gig::Sample*> findUnusedSamples(gig::File* gig) {
+    // collect all samples referenced by any instrument first, instead of
+    // searching all instruments for each sample
+    std::set<gig::Sample*> used;
+    for (gig::Instrument* instrument = gig->GetFirstInstrument(); instrument;
+                          instrument = gig->GetNextInstrument())
+    {
+        for (gig::Region* rgn = instrument->GetFirstRegion(); rgn;
+                          rgn = instrument->GetNextRegion())
+        {
+            for (int i = 0; i < 256; ++i) {
+                if (!rgn->pDimensionRegions[i]) continue;
+                used.insert(rgn->pDimensionRegions[i]->pSample);
+            }
+        }
+    }
+
+    std::list<gig::Sample*> unused;
+    for (int iSample = 0; gig->GetSample(iSample); ++iSample) {
+        gig::Sample* sample = gig->GetSample(iSample);
+        if (!used.count(sample)) unused.push_back(sample);
+    }
+    return unused;
+}
+
+int removeUnusedSamples(gig::File* gig) {
+    std::list<gig::Sample*> samples = findUnusedSamples(gig);
+    for (std::list<gig::Sample*>::iterator it = samples.begin();
+         it != samples.end(); ++it)
+    {
+        gig->DeleteSample(*it);
+    }
+    return samples.size();
+}
+
+int applyMacroToFile(gig::File* gig, Serialization::Archive& macro) {
+    std::set<gig::DimensionRegion*> dimregs;
+    gig::DimensionRegion* first = NULL;
+    for (gig::Instrument* instrument = gig->GetFirstInstrument(); instrument;
+                          instrument = gig->GetNextInstrument())
+    {
+        for (gig::Region* rgn = instrument->GetFirstRegion(); rgn;
+                          rgn = instrument->GetNextRegion())
+        {
+            for (int i = 0; i < rgn->DimensionRegions; ++i) {
+                gig::DimensionRegion* dimrgn = rgn->pDimensionRegions[i];
+                if (!dimrgn) continue;
+                if (!first) first = dimrgn;
+                dimregs.insert(dimrgn);
+            }
+        }
+    }
+    if (!first) return 0;
+    // resolve the macro just once for the whole file
+    CompiledMacro compiled;
+    compiled.compile(macro, first);
+    return applyMacroToDimRegions(dimregs, compiled, &macro);
+}
+
+int applyMacroToDimRegions(const std::set<gig::DimensionRegion*>& dimregs,
+                           const CompiledMacro& compiled,
+                           Serialization::Archive* macro)
+{
+    if (!compiled.isValid() && !macro) return 0;
+    for (std::set<gig::DimensionRegion*>::const_iterator itDimReg = dimregs.begin();
+         itDimReg != dimregs.end(); ++itDimReg)
+    {
+        if (compiled.isValid()) {
+            compiled.apply(*itDimReg);
+        } else {
+            macro->deserialize(*itDimReg);
+            updateDerivedTables(*itDimReg);
+        }
+    }
+    return dimregs.size();
+}
+
+static gig::Sample* sampleNamed(gig::File* gig, const std::string& name) {
+    for (int i = 0; gig->GetSample(i); ++i)
+        if (gig->GetSample(i)->pInfo->Name == name)
+            return gig->GetSample(i);
+    return NULL;
+}
+
+int repointSampleReferences(gig::File* gig, const std::string& oldName,
+                            const std::string& newName)
+{
+    gig::Sample* oldSample = sampleNamed(gig, oldName);
+    if (!oldSample)
+        throw RIFF::Exception("No sample named '" + oldName + "'");
+    gig::Sample* newSample = sampleNamed(gig, newName);
+    if (!newSample)
+        throw RIFF::Exception("No sample named '" + newName + "'");
+
+    int count = 0;
+    for (gig::Instrument* instrument = gig->GetFirstInstrument(); instrument;
+                          instrument = gig->GetNextInstrument())
+    {
+        for (gig::Region* rgn = instrument->GetFirstRegion(); rgn;
+                          rgn = instrument->GetNextRegion())
+        {
+            for (int i = 0; i < rgn->DimensionRegions; ++i) {
+                gig::DimensionRegion* dimrgn = rgn->pDimensionRegions[i];
+                if (!dimrgn || dimrgn->pSample != oldSample) continue;
+                dimrgn->pSample = newSample;
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+std::vector<std::string> readInstrumentNames(RIFF::File* riff) {
+    std::vector<std::string> names;
+    RIFF::List* lins = riff->GetSubList(LIST_TYPE_LINS);
+    if (!lins) return names;
+    for (RIFF::List* ins = lins->GetFirstSubList(); ins;
+                     ins = lins->GetNextSubList())
+    {
+        if (ins->GetListType() != LIST_TYPE_INS) continue;
+        std::string name;
+        RIFF::List* info = ins->GetSubList(LIST_TYPE_INFO);
+        RIFF::Chunk* inam = info ? info->GetSubChunk(CHUNK_ID_INAM) : NULL;
+        if (inam && inam->GetSize()) {
+            std::vector<char> buf(inam->GetSize());
+            inam->SetPos(0);
+            inam->Read(&buf[0], buf.size(), 1);
+            name.assign(buf.begin(), std::find(buf.begin(), buf.end(), '\0'));
+        }
+        names.push_back(name);
+    }
+    return names;
+}
@@ -0,0 +1,111 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_FILEOPERATIONS_H
+#define GIGEDIT_FILEOPERATIONS_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+# include LIBGIG_HEADER_FILE(Serialization.h)
+#else
+# include <gig.h>
+# include <Serialization.h>
+#endif
+
+#include <functional>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+class CompiledMacro;
+
+// Editing operations on whole gig files, which neither require the GUI nor
+// notify the sampler, so they can be used by the main window as well as by
+// the command line batch mode.
+
+/**
+ * Loads the .gig file @a riff with all its instruments, regions and dimension
+ * regions. As soon as the names of the instruments are known (see
+ * readInstrumentNames()), they are passed to @a headersLoaded, before libgig
+ * loads the instruments. If @a headersLoaded throws an exception, the
+ * gig::File is deleted again and the exception is passed on.
+ */
+gig::File* loadGigFile(RIFF::File* riff,
+    const std::function<void(const std::vector<std::string>&)>& headersLoaded,
+    gig::progress_t* progress = NULL);
+
+/**
+ * Returns the amount of dimension regions of all instruments of @a gig
+ * referencing each sample. Samples which are not referenced are omitted.
+ */
+std::map<gig::Sample*,int> countSampleReferences(gig::File* gig);
+
+/**
+ * Adds all dimension regions of @a region to @a dimregs whose dimension zones
+ * are selected by @a dimzones. For dimensions without selected zone, zone 0
+ * is assumed to be selected. If @a stereo is true, dimension regions of both
+ * audio channels are added. Dimension regions of unused zones are skipped.
+ */
+void selectDimRegions(const gig::Region* region, bool stereo,
+                      const std::map<gig::dimension_t, std::set<int> >& dimzones,
+                      std::set<gig::DimensionRegion*>& dimregs);
+
+/**
+ * Returns all samples of @a gig which are not referenced by any dimension
+ * region of any instrument.
+ */
+std::list<gig::Sample*> findUnusedSamples(gig::File* gig);
+
+/**
+ * Deletes all samples of @a gig which are not referenced by any instrument.
+ *
+ * @returns amount of samples deleted
+ */
+int removeUnusedSamples(gig::File* gig);
+
+/**
+ * Applies @a macro to all dimension regions of all instruments of @a gig.
+ * This also updates libgig's lookup tables shared among all files (see
+ * updateDerivedTables()).
+ *
+ * @returns amount of dimension regions modified
+ * @throws Serialization::Exception if the macro does not match
+ */
+int applyMacroToFile(gig::File* gig, Serialization::Archive& macro);
+
+/**
+ * Applies @a compiled to all dimension regions @a dimregs, or deserializes
+ * @a macro to them if @a compiled is not valid. This also updates libgig's
+ * lookup tables shared among all files (see updateDerivedTables()).
+ *
+ * @returns amount of dimension regions modified
+ * @throws Serialization::Exception if the macro does not match
+ */
+int applyMacroToDimRegions(const std::set<gig::DimensionRegion*>& dimregs,
+                           const CompiledMacro& compiled,
+                           Serialization::Archive* macro);
+
+/**
+ * Lets all dimension regions of @a gig referencing the sample named
+ * @a oldName reference the sample named @a newName instead.
+ *
+ * @returns amount of dimension regions modified
+ * @throws RIFF::Exception if one of the samples does not exist
+ */
+int repointSampleReferences(gig::File* gig, const std::string& oldName,
+                            const std::string& newName);
+
+/**
+ * Reads just the names of all instruments of the .gig file @a riff from the
+ * file's instrument list, without letting libgig load any instrument, region
+ * or sample. This is much faster than loading the instruments with libgig.
+ */
+std::vector<std::string> readInstrumentNames(RIFF::File* riff);
+
+#endif // GIGEDIT_FILEOPERATIONS_H
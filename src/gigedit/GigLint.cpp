@@ -0,0 +1,225 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "GigLint.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+
+// checks custom split zones of velocity dimension @a d of @a rgn, the same
+// way DimRegionChooser and libgig interpret them
+static void lintZones(gig::Region* rgn, int d, int bitpos,
+                      std::vector<LintFinding>& findings)
+{
+    const gig::dimension_def_t& def = rgn->pDimensionDefinitions[d];
+    const int mask = ((1 << def.bits) - 1) << bitpos;
+    for (int base = 0; base < 256; ++base) {
+        if (base & mask) continue;
+        gig::DimensionRegion* first = rgn->pDimensionRegions[base];
+        if (!first || !(first->DimensionUpperLimits[d] || first->VelocityUpperLimit))
+            continue; // no custom splits
+
+        int lower = 0;
+        bool ascending = true;
+        for (int z = 0; z < def.zones; ++z) {
+            gig::DimensionRegion* dr = rgn->pDimensionRegions[base | (z << bitpos)];
+            if (!dr) break;
+            int upper = dr->DimensionUpperLimits[d];
+            if (!upper) upper = dr->VelocityUpperLimit;
+            if (upper < lower) {
+                LintFinding f(LintFinding::ZONES_NOT_ASCENDING);
+                f.region = rgn;
+                f.dimrgn = dr;
+                f.dimension = d;
+                findings.push_back(f);
+                ascending = false;
+                break;
+            }
+            lower = upper + 1;
+        }
+        if (!ascending) return; // one finding per dimension is enough
+        if (lower <= 127) {
+            LintFinding f(LintFinding::ZONES_INCOMPLETE);
+            f.region = rgn;
+            f.dimrgn = first;
+            f.dimension = d;
+            findings.push_back(f);
+            return;
+        }
+    }
+}
+
+// whether the dimension region at @a index can be selected by any
+// combination of dimension values
+static bool isReachable(gig::Region* rgn, int index) {
+    int bitpos = 0;
+    for (uint d = 0; d < rgn->Dimensions; ++d) {
+        const gig::dimension_def_t& def = rgn->pDimensionDefinitions[d];
+        const int zone = (index >> bitpos) & ((1 << def.bits) - 1);
+        if (zone >= def.zones) return false;
+        bitpos += def.bits;
+    }
+    return index < (1 << bitpos);
+}
+
+static void lintRegion(gig::Region* rgn, const std::set<gig::Sample*>& samples,
+                       const std::set<gig::Sample*>& ignore,
+                       std::vector<LintFinding>& findings)
+{
+    // per dimension region findings are aggregated per region
+    LintFinding deleted(LintFinding::DELETED_SAMPLE);
+    LintFinding loop(LintFinding::LOOP_BEYOND_END);
+    LintFinding silent(LintFinding::SILENT_DIMRGNS);
+    LintFinding unused(LintFinding::UNUSED_DIMRGNS);
+    LintFinding* aggregates[] = { &deleted, &loop, &silent, &unused };
+    for (int i = 0; i < 4; ++i) {
+        aggregates[i]->region = rgn;
+        aggregates[i]->count = 0;
+    }
+
+    for (int i = 0; i < 256; ++i) {
+        gig::DimensionRegion* dr = rgn->pDimensionRegions[i];
+        if (!dr) continue;
+        gig::Sample* sample = dr->pSample;
+        LintFinding* f = NULL;
+        if (!isReachable(rgn, i)) {
+            if (sample) f = &unused;
+        } else if (!sample) {
+            f = &silent;
+        } else if (!samples.count(sample)) {
+            f = &deleted;
+        } else if (!ignore.count(sample)) {
+            for (uint l = 0; l < dr->SampleLoops; ++l) {
+                const DLS::sample_loop_t& sl = dr->pSampleLoops[l];
+                if (uint64_t(sl.LoopStart) + sl.LoopLength > uint64_t(sample->SamplesTotal)) {
+                    f = &loop;
+                    break;
+                }
+            }
+        }
+        if (!f) continue;
+        if (!f->count++) {
+            f->dimrgn = dr;
+            f->sample = sample;
+        }
+    }
+    for (int i = 0; i < 4; ++i)
+        if (aggregates[i]->count) findings.push_back(*aggregates[i]);
+
+    int bitpos = 0;
+    for (uint d = 0; d < rgn->Dimensions; ++d) {
+        const gig::dimension_def_t& def = rgn->pDimensionDefinitions[d];
+        if (def.dimension == gig::dimension_velocity)
+            lintZones(rgn, d, bitpos, findings);
+        bitpos += def.bits;
+    }
+}
+
+static void lintInstrument(gig::Instrument* instr,
+                           const std::set<gig::Sample*>& samples,
+                           const std::set<gig::Sample*>& ignore,
+                           std::vector<LintFinding>& findings)
+{
+    std::vector<gig::Region*> regions;
+    for (gig::Region* rgn = instr->GetFirstRegion(); rgn;
+         rgn = instr->GetNextRegion())
+    {
+        regions.push_back(rgn);
+        lintRegion(rgn, samples, ignore, findings);
+    }
+    if (regions.empty()) {
+        findings.push_back(LintFinding(LintFinding::NO_REGIONS));
+    } else {
+        struct ByLowKey {
+            bool operator()(gig::Region* a, gig::Region* b) const {
+                return a->KeyRange.low < b->KeyRange.low;
+            }
+        };
+        std::stable_sort(regions.begin(), regions.end(), ByLowKey());
+        gig::Region* highest = regions[0];
+        for (size_t i = 1; i < regions.size(); ++i) {
+            if (regions[i]->KeyRange.low <= highest->KeyRange.high) {
+                LintFinding f(LintFinding::OVERLAPPING_REGIONS);
+                f.region = regions[i];
+                f.otherRegion = highest;
+                findings.push_back(f);
+            }
+            if (regions[i]->KeyRange.high > highest->KeyRange.high)
+                highest = regions[i];
+        }
+    }
+
+    for (size_t i = 0; i < findings.size(); ++i)
+        findings[i].instrument = instr;
+    struct ErrorsFirst {
+        bool operator()(const LintFinding& a, const LintFinding& b) const {
+            return a.isError() && !b.isError();
+        }
+    };
+    std::stable_sort(findings.begin(), findings.end(), ErrorsFirst());
+}
+
+std::vector<LintFinding> lintGigFile(gig::File* gig,
+                                     const std::set<gig::Sample*>& ignore)
+{
+    std::vector<LintFinding> result;
+
+    // collected on the calling thread, since the gig file's sample and
+    // instrument iterators are not thread safe
+    std::vector<gig::Sample*> samples;
+    for (gig::Sample* s = gig->GetFirstSample(); s; s = gig->GetNextSample())
+        samples.push_back(s);
+    std::vector<gig::Instrument*> instruments;
+    std::vector<size_t> cost;
+    for (gig::Instrument* instr = gig->GetFirstInstrument(); instr;
+         instr = gig->GetNextInstrument())
+    {
+        size_t dimregs = 0;
+        for (gig::Region* rgn = instr->GetFirstRegion(); rgn;
+             rgn = instr->GetNextRegion())
+        {
+            dimregs += rgn->DimensionRegions;
+        }
+        instruments.push_back(instr);
+        cost.push_back(dimregs);
+    }
+    const std::set<gig::Sample*> sampleSet(samples.begin(), samples.end());
+
+    if (samples.empty() && !instruments.empty())
+        result.push_back(LintFinding(LintFinding::NO_SAMPLES));
+
+    // big instruments first for a good load balance
+    std::vector<size_t> order(instruments.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return cost[a] > cost[b];
+    });
+
+    // the last slot collects the sample findings
+    std::vector< std::vector<LintFinding> > findings(instruments.size() + 1);
+    parallelFor(instruments.size() + 1, [&](size_t i) {
+        if (i < order.size()) {
+            lintInstrument(instruments[order[i]], sampleSet, ignore,
+                           findings[order[i]]);
+            return;
+        }
+        for (size_t s = 0; s < samples.size(); ++s) {
+            gig::Sample* sample = samples[s];
+            if (!sample->Loops || ignore.count(sample)) continue;
+            if (uint64_t(sample->LoopStart) + sample->LoopSize > uint64_t(sample->SamplesTotal)) {
+                LintFinding f(LintFinding::SAMPLE_LOOP_BEYOND_END);
+                f.sample = sample;
+                findings.back().push_back(f);
+            }
+        }
+    });
+
+    result.insert(result.end(), findings.back().begin(), findings.back().end());
+    for (size_t i = 0; i < instruments.size(); ++i)
+        result.insert(result.end(), findings[i].begin(), findings[i].end());
+    return result;
+}
@@ -0,0 +1,74 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_GIGLINT_H
+#define GIGEDIT_GIGLINT_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#include <vector>
+#include <set>
+
+/**
+ * Problem of a gig file found by lintGigFile(). Findings concerning several
+ * dimension regions of the same region are reported once for the region,
+ * with @c dimrgn pointing to the first affected dimension region and
+ * @c count being the amount of affected dimension regions.
+ */
+struct LintFinding {
+    enum Kind {
+        NO_SAMPLES, ///< file contains no samples (error)
+        NO_REGIONS, ///< instrument has no regions (error)
+        DELETED_SAMPLE, ///< dimension regions reference a sample not in the file anymore (error)
+        LOOP_BEYOND_END, ///< dimension regions have a loop exceeding the end of their sample (error)
+        SAMPLE_LOOP_BEYOND_END, ///< sample's own loop exceeds its end (error)
+        ZONES_NOT_ASCENDING, ///< custom split zones of a dimension overlap (error)
+        OVERLAPPING_REGIONS, ///< key ranges of two regions overlap (warning)
+        ZONES_INCOMPLETE, ///< custom split zones of a dimension do not cover 0..127 (warning)
+        SILENT_DIMRGNS, ///< reachable dimension regions without sample (warning)
+        UNUSED_DIMRGNS ///< unreachable dimension regions still referencing a sample (warning)
+    };
+
+    Kind kind;
+    gig::Instrument* instrument;
+    gig::Region* region;
+    gig::DimensionRegion* dimrgn;
+    gig::Sample* sample;
+    gig::Region* otherRegion; ///< only for OVERLAPPING_REGIONS
+    int dimension; ///< index of the dimension definition, -1 if none
+    int count;
+
+    LintFinding(Kind kind) :
+        kind(kind), instrument(NULL), region(NULL), dimrgn(NULL), sample(NULL),
+        otherRegion(NULL), dimension(-1), count(1) {}
+
+    /// Whether the finding will most probably cause misbehavior of a sampler.
+    bool isError() const { return kind < OVERLAPPING_REGIONS; }
+};
+
+/**
+ * Checks the gig file @a gig for inconsistencies. Instruments and samples are
+ * checked in parallel on several worker threads. File wide and sample findings
+ * come first, followed by the findings of each instrument in file order (errors
+ * before warnings).
+ *
+ * This function blocks until all checks completed. It only reads the gig
+ * file's objects already in memory (no disk I/O), but the file must not be
+ * modified while it is running.
+ *
+ * @param gig - gig file to be checked
+ * @param ignore - samples to be excluded from loop checks (i.e. samples not
+ *                 yet imported)
+ */
+std::vector<LintFinding> lintGigFile(gig::File* gig,
+    const std::set<gig::Sample*>& ignore = std::set<gig::Sample*>());
+
+#endif // GIGEDIT_GIGLINT_H
@@ -0,0 +1,222 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "InPlaceSave.h"
+#include "FileCopy.h"
+
+#include <vector>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(WIN32)
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+/// Position of the chunk's data body in the file (0 if not in the file yet).
+static RIFF::file_offset_t dataPosOf(RIFF::Chunk* ck) {
+    return ck->GetFilePos() - ck->GetPos();
+}
+
+/**
+ * Checks whether the sub chunks of @a list (recursively) are still stored in
+ * the file exactly as they are arranged in memory: same order, same sizes,
+ * no chunks added or removed. Only then chunks may be overwritten in place.
+ */
+static bool layoutMatchesFile(RIFF::List* list, int headerSize) {
+    const RIFF::file_offset_t start = dataPosOf(list);
+    if (!start) return false;
+    RIFF::file_offset_t pos = start;
+    for (RIFF::Chunk* ck = list->GetFirstSubChunk(); ck; ck = list->GetNextSubChunk()) {
+        const bool isList = (ck->GetChunkID() == CHUNK_ID_LIST);
+        // list chunks have their list type in front of their data body
+        pos += headerSize + (isList ? 4 : 0);
+        if (dataPosOf(ck) != pos) return false;
+        if (ck->GetNewSize() != ck->GetSize()) return false;
+        if (isList && !layoutMatchesFile(static_cast<RIFF::List*>(ck), headerSize))
+            return false;
+        // chunks are padded to even size
+        pos += ck->GetSize() + (ck->GetSize() & 1);
+    }
+    return pos == start + list->GetSize();
+}
+
+/// Collects all data (non list) chunks below @a list.
+static void collectDataChunks(RIFF::List* list, std::vector<RIFF::Chunk*>& chunks) {
+    for (RIFF::Chunk* ck = list->GetFirstSubChunk(); ck; ck = list->GetNextSubChunk()) {
+        if (ck->GetChunkID() == CHUNK_ID_LIST)
+            collectDataChunks(static_cast<RIFF::List*>(ck), chunks);
+        else
+            chunks.push_back(ck);
+    }
+}
+
+/**
+ * Serializes the articulation of all instruments and collects the instrument
+ * chunks to be written, if the file's chunk layout allows that.
+ */
+static bool prepareArticulationChunks(gig::File* gig, std::vector<RIFF::Chunk*>& chunks) {
+    RIFF::File* riff = gig->GetRiffFile();
+    if (!riff || gig->GetFileName().empty()) return false;
+
+    // serialize the articulation of all instruments to their chunks (in RAM)
+    for (gig::Instrument* instr = gig->GetFirstInstrument(); instr;
+         instr = gig->GetNextInstrument())
+    {
+        instr->UpdateChunks(NULL);
+    }
+
+    // chunks may have been added, removed or resized by the above
+    const int headerSize = 4 + riff->GetFileOffsetSize();
+    if (!layoutMatchesFile(riff, headerSize)) return false;
+
+    RIFF::List* lins = riff->GetSubList(LIST_TYPE_LINS);
+    if (!lins) return false;
+    collectDataChunks(lins, chunks);
+    return true;
+}
+
+#if !defined(WIN32)
+/// Makes sure the patched chunks are on disk before reporting success.
+static void syncFile(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+#endif
+
+int saveArticulationInPlace(gig::File* gig) {
+    std::vector<RIFF::Chunk*> chunks;
+    if (!prepareArticulationChunks(gig, chunks)) return -1;
+
+    RIFF::File* riff = gig->GetRiffFile();
+    riff->SetMode(RIFF::stream_mode_read_write);
+    int written = 0;
+    try {
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            RIFF::Chunk* ck = chunks[i];
+            if (!ck->GetSize()) continue;
+            void* data = ck->LoadChunkData();
+            if (!data) continue;
+            ck->SetPos(0);
+            ck->Write(data, ck->GetSize(), 1);
+            ck->SetPos(0);
+            ++written;
+        }
+    } catch (...) {
+        riff->SetMode(RIFF::stream_mode_read);
+        throw;
+    }
+    riff->SetMode(RIFF::stream_mode_read);
+
+#if !defined(WIN32)
+    syncFile(gig->GetFileName());
+#endif
+    return written;
+}
+
+int saveArticulationToCopy(gig::File* gig, const std::string& path) {
+#if defined(WIN32)
+    return -1;
+#else
+    std::vector<RIFF::Chunk*> chunks;
+    if (!prepareArticulationChunks(gig, chunks)) return -1;
+
+    // load the chunk bodies before creating the copy, so the original file
+    // is only read from here on
+    for (size_t i = 0; i < chunks.size(); ++i)
+        if (chunks[i]->GetSize()) chunks[i]->LoadChunkData();
+
+    copyFile(gig->GetFileName(), path);
+
+    const int fd = open(path.c_str(), O_WRONLY);
+    if (fd < 0)
+        throw RIFF::Exception("Could not open '" + path + "': " + strerror(errno));
+    int written = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        RIFF::Chunk* ck = chunks[i];
+        if (!ck->GetSize()) continue;
+        const char* data = (const char*) ck->LoadChunkData();
+        if (!data) continue;
+        const RIFF::file_offset_t pos = dataPosOf(ck);
+        for (RIFF::file_offset_t done = 0; done < ck->GetSize(); ) {
+            const ssize_t n = pwrite(fd, data + done, ck->GetSize() - done, pos + done);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                const int err = errno;
+                close(fd);
+                throw RIFF::Exception("Could not write '" + path + "': " + strerror(err));
+            }
+            done += n;
+        }
+        ++written;
+    }
+    if (fsync(fd) || close(fd))
+        throw RIFF::Exception("Could not write '" + path + "': " + strerror(errno));
+    return written;
+#endif
+}
+
+/**
+ * Gives access to the file name of a RIFF::File, which libgig only changes
+ * when saving to another file.
+ */
+struct RiffFileName : RIFF::File {
+    static void set(RIFF::File* riff, const RIFF::String& path) {
+        riff->*(&RiffFileName::Filename) = path;
+    }
+};
+
+/**
+ * Associates @a gig with the file at @a path and reopens it from there. The
+ * file at @a path must have the same chunk layout as the one @a gig was read
+ * from or saved to before.
+ */
+static void reopenAs(gig::File* gig, const std::string& path) {
+    RIFF::File* riff = gig->GetRiffFile();
+    RiffFileName::set(riff, path);
+    // SetMode() opens the file by its name again
+    riff->SetMode(RIFF::stream_mode_closed);
+    riff->SetMode(RIFF::stream_mode_read);
+}
+
+void saveWithTemporaryFile(gig::File* gig, bool articulationOnly,
+                           gig::progress_t* progress)
+{
+    const std::string path = gig->GetFileName();
+    const std::string tmpname = path + ".TMP";
+    // if just articulation was changed, the temporary file is a copy of the
+    // original file (sharing its data blocks where the file system supports
+    // it) with only the instrument chunks patched
+    if (!articulationOnly || saveArticulationToCopy(gig, tmpname) < 0)
+        gig->Save(tmpname, progress);
+#if defined(WIN32)
+    if (!DeleteFile(path.c_str())) {
+        throw RIFF::Exception("Could not replace original file with temporary file (unable to remove original file).");
+    }
+#else // POSIX ...
+    if (unlink(path.c_str())) {
+        throw RIFF::Exception("Could not replace original file with temporary file (unable to remove original file): " + std::string(strerror(errno)));
+    }
+#endif
+    if (rename(tmpname.c_str(), path.c_str())) {
+#if defined(WIN32)
+        throw RIFF::Exception("Could not replace original file with temporary file (unable to rename temp file).");
+#else
+        throw RIFF::Exception("Could not replace original file with temporary file (unable to rename temp file): " + std::string(strerror(errno)));
+#endif
+    }
+    // gig::File::Save() associated the file with the temporary file's name,
+    // whereas saveArticulationToCopy() left it opened on the original file,
+    // which was just deleted
+    reopenAs(gig, path);
+}
@@ -0,0 +1,58 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_INPLACESAVE_H
+#define GIGEDIT_INPLACESAVE_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#include <string>
+
+/**
+ * Saves the articulation of all instruments of @a gig (instrument headers,
+ * regions and dimension regions) by overwriting just the respective chunks
+ * of the existing .gig file, instead of rewriting the whole file with all its
+ * sample data as gig::File::Save() does.
+ *
+ * This is only possible if nothing but articulation data was modified, which
+ * the caller has to ensure, and if the updated chunks still have exactly the
+ * same sizes and positions as in the file. The latter is checked for the
+ * entire RIFF tree, and the file is not touched at all if it does not match.
+ *
+ * @returns amount of chunks written, or -1 if gig::File::Save() is required
+ * @throws RIFF::Exception on I/O errors
+ */
+int saveArticulationInPlace(gig::File* gig);
+
+/**
+ * Same as saveArticulationInPlace(), but leaves the .gig file untouched and
+ * writes the result to the new file @a path instead. The unchanged content
+ * (i.e. all the sample data) is transferred with copyFile(), so on file
+ * systems supporting it, this is mostly a metadata operation.
+ *
+ * @returns amount of chunks written, or -1 if gig::File::Save() is required
+ * @throws RIFF::Exception on I/O errors
+ */
+int saveArticulationToCopy(gig::File* gig, const std::string& path);
+
+/**
+ * Saves @a gig over its own file by writing a temporary file next to it first,
+ * which then replaces the original file. The temporary file is written by
+ * saveArticulationToCopy() if @a articulationOnly is true (and the file's
+ * layout allows that), otherwise by gig::File::Save(). Afterwards @a gig is
+ * associated with its original path again and reads from the new file.
+ *
+ * @throws RIFF::Exception on errors
+ */
+void saveWithTemporaryFile(gig::File* gig, bool articulationOnly,
+                           gig::progress_t* progress = NULL);
+
+#endif // GIGEDIT_INPLACESAVE_H
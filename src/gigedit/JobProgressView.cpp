@@ -0,0 +1,106 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "JobProgressView.h"
+#include "global.h"
+
+#if HAS_GTKMM_STOCK
+# include <gtkmm/stock.h>
+#endif
+
+JobProgressView::JobProgressView(Gtk::Window& parent) :
+    m_dismissed(false),
+    m_label("", Gtk::ALIGN_START),
+#if HAS_GTKMM_STOCK
+    m_cancelButton(Gtk::Stock::CANCEL)
+#else
+    m_cancelButton(_("_Cancel"), true)
+#endif
+{
+    set_title(_("Progress"));
+    set_transient_for(parent);
+    set_position(Gtk::WIN_POS_CENTER_ON_PARENT);
+    set_default_size(600, -1);
+#if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && GTKMM_MINOR_VERSION > 24)
+    set_margin(6);
+#else
+    set_border_width(6);
+#endif
+
+    add(m_vbox);
+    m_vbox.set_spacing(6);
+    m_vbox.pack_start(m_label, Gtk::PACK_SHRINK);
+    m_vbox.pack_start(m_progressBar, Gtk::PACK_SHRINK);
+    m_buttonBox.set_layout(Gtk::BUTTONBOX_END);
+    m_buttonBox.pack_start(m_cancelButton, Gtk::PACK_SHRINK);
+    m_vbox.pack_start(m_buttonBox, Gtk::PACK_SHRINK);
+
+    m_cancelButton.signal_clicked().connect(
+        sigc::mem_fun(*this, &JobProgressView::on_cancel)
+    );
+    JobScheduler::singleton()->signal_changed().connect(
+        sigc::mem_fun(*this, &JobProgressView::on_jobs_changed)
+    );
+
+#if HAS_GTKMM_SHOW_ALL_CHILDREN
+    show_all_children();
+#endif
+}
+
+void JobProgressView::on_jobs_changed() {
+    // jobs of dialogs showing their progress by themselves are left out
+    std::vector<JobRef> jobs;
+    const std::vector<JobRef>& allJobs = JobScheduler::singleton()->jobs();
+    for (size_t i = 0; i < allJobs.size(); ++i)
+        if (!allJobs[i]->hasOwnProgressDisplay()) jobs.push_back(allJobs[i]);
+    if (jobs.empty()) {
+        m_dismissed = false;
+        set_modal(false);
+        hide();
+        return;
+    }
+    bool modal = false, cancellable = false;
+    float progress = 0.f;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (jobs[i]->isModal()) modal = true;
+        if (jobs[i]->isCancellable() && !jobs[i]->isCancelled())
+            cancellable = true;
+        progress += jobs[i]->progress();
+    }
+    if (jobs.size() == 1) {
+        m_label.set_text(jobs[0]->title());
+    } else {
+        // show the title of the first running job and the amount of the others
+        size_t running = 0;
+        while (running + 1 < jobs.size() &&
+               jobs[running]->state() != Job::RUNNING) ++running;
+        m_label.set_text(
+            jobs[running]->title() + " (" + ToString(jobs.size() - 1) + " " +
+            _("more jobs pending") + ")"
+        );
+    }
+    m_progressBar.set_fraction(progress / float(jobs.size()));
+    m_cancelButton.set_sensitive(cancellable);
+    if (modal != get_modal()) set_modal(modal);
+    if (modal) m_dismissed = false;
+    if (!m_dismissed && !get_visible()) show();
+}
+
+void JobProgressView::on_cancel() {
+    const std::vector<JobRef>& jobs = JobScheduler::singleton()->jobs();
+    for (size_t i = 0; i < jobs.size(); ++i)
+        if (!jobs[i]->hasOwnProgressDisplay()) jobs[i]->cancel();
+    m_cancelButton.set_sensitive(false);
+}
+
+bool JobProgressView::on_delete_event(GdkEventAny* event) {
+    // the user must wait for modal jobs, others just keep running unseen
+    if (get_modal()) return true;
+    m_dismissed = true;
+    hide();
+    return true;
+}
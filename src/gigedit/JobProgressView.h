@@ -0,0 +1,45 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_JOBPROGRESSVIEW_H
+#define GIGEDIT_JOBPROGRESSVIEW_H
+
+#ifdef GTKMM_HEADER_FILE
+# include GTKMM_HEADER_FILE(gtkmm.h)
+#else
+# include <gtkmm.h>
+#endif
+
+#include "compat.h"
+#include "JobScheduler.h"
+
+/** @brief Shows the progress of all jobs of the JobScheduler.
+ *
+ * This window appears by itself as soon as a job was submitted and hides
+ * itself again when all jobs completed. It shows the aggregate progress of all
+ * pending jobs and lets the user cancel them. The window is not modal, unless
+ * one of the pending jobs is (see Job::isModal()), so the user may also close
+ * it and keep working while jobs run.
+ */
+class JobProgressView : public Gtk::Window {
+public:
+    JobProgressView(Gtk::Window& parent);
+
+protected:
+    bool m_dismissed; ///< closed by the user while jobs were pending
+    VBox m_vbox;
+    Gtk::Label m_label;
+    Gtk::ProgressBar m_progressBar;
+    HButtonBox m_buttonBox;
+    Gtk::Button m_cancelButton;
+
+    void on_jobs_changed();
+    void on_cancel();
+    bool on_delete_event(GdkEventAny* event);
+};
+
+#endif // GIGEDIT_JOBPROGRESSVIEW_H
@@ -0,0 +1,235 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "JobScheduler.h"
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+#include "ParallelFor.h"
+#include "Trace.h"
+#include "global.h"
+
+#include <algorithm>
+
+Job::Job(const Glib::ustring& title, Priority priority, bool cancellable) :
+    m_title(title), m_priority(priority), m_cancellable(cancellable),
+    m_modal(false), m_ownProgressDisplay(false), m_state(QUEUED), m_executed(false), m_cancel(false), m_progress(0),
+    m_progressPending(false), m_scheduler(NULL)
+{
+}
+
+Job::~Job() {
+}
+
+void Job::cancel() {
+    if (m_cancellable) m_cancel = true;
+}
+
+void Job::checkCancelled() const {
+    if (m_cancel) throw Cancelled();
+}
+
+void Job::setProgress(float fraction) {
+    m_progress = int(fraction * 1000.f);
+    // coalesce updates, the GUI only needs the latest value
+    if (m_progressPending.exchange(true)) return;
+    m_scheduler->post([this]() {
+        m_progressPending = false;
+        m_signalProgress.emit();
+        m_scheduler->m_signalChanged.emit();
+    });
+}
+
+void Job::notify(const std::function<void()>& fn) {
+    m_scheduler->post(fn);
+}
+
+sigc::signal<void>& Job::signal_progress() {
+    return m_signalProgress;
+}
+
+sigc::signal<void>& Job::signal_finished() {
+    return m_signalFinished;
+}
+
+sigc::signal<void>& Job::signal_error() {
+    return m_signalError;
+}
+
+sigc::signal<void>& Job::signal_cancelled() {
+    return m_signalCancelled;
+}
+
+
+// highest priority first, FIFO among jobs of the same priority
+bool JobScheduler::queueLess(const QueueEntry& a, const QueueEntry& b) {
+    if (a.job->priority() != b.job->priority())
+        return a.job->priority() < b.job->priority();
+    return a.sequence > b.sequence;
+}
+
+static JobScheduler* _instance = NULL;
+
+JobScheduler* JobScheduler::singleton() {
+    if (!_instance) _instance = new JobScheduler;
+    return _instance;
+}
+
+JobScheduler::JobScheduler(int maxThreads) :
+    m_maxThreads((maxThreads < 1) ? defaultWorkerThreadCount() : maxThreads),
+    m_sequence(0), m_idleThreads(0), m_quit(false)
+{
+    m_dispatcher.connect(sigc::mem_fun(*this, &JobScheduler::processEvents));
+}
+
+JobScheduler::~JobScheduler() {
+    cancelAll();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_condition.notify_all();
+    for (size_t i = 0; i < m_threads.size(); ++i)
+        m_threads[i].join();
+}
+
+void JobScheduler::submit(const JobRef& job) {
+    job->m_scheduler = this;
+    job->m_state = Job::QUEUED;
+    m_jobs.push_back(job);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        QueueEntry entry = { job, m_sequence++ };
+        m_queue.push_back(entry);
+        std::push_heap(m_queue.begin(), m_queue.end(), queueLess);
+        if (m_queue.size() > size_t(m_idleThreads) &&
+            m_threads.size() < size_t(m_maxThreads))
+        {
+            m_threads.push_back(std::thread([this]() { workerThread(); }));
+        }
+    }
+    m_condition.notify_one();
+    m_signalChanged.emit();
+}
+
+void JobScheduler::cancelAll() {
+    for (size_t i = 0; i < m_jobs.size(); ++i)
+        m_jobs[i]->cancel();
+}
+
+void JobScheduler::wait(const JobRef& job) {
+    if (job->m_scheduler != this) return;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleCondition.wait(lock, [&job]() { return job->m_executed; });
+}
+
+float JobScheduler::progress() const {
+    if (m_jobs.empty()) return 0.f;
+    float sum = 0.f;
+    for (size_t i = 0; i < m_jobs.size(); ++i)
+        sum += m_jobs[i]->progress();
+    return sum / float(m_jobs.size());
+}
+
+sigc::signal<void>& JobScheduler::signal_changed() {
+    return m_signalChanged;
+}
+
+void JobScheduler::post(const std::function<void()>& fn) {
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        wake = m_events.empty();
+        m_events.push_back(fn);
+    }
+    // the dispatcher processes all pending events at once
+    if (wake) m_dispatcher();
+}
+
+void JobScheduler::processEvents() {
+    // one by one, since an event handler might run a nested main loop (i.e.
+    // of a message box), which processes the remaining events by itself
+    while (true) {
+        std::function<void()> fn;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_events.empty()) return;
+            fn = m_events.front();
+            m_events.pop_front();
+        }
+        fn();
+    }
+}
+
+#if defined(WIN32) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 2))
+// make sure stack is 16-byte aligned for SSE instructions
+__attribute__((force_align_arg_pointer))
+#endif
+void JobScheduler::workerThread() {
+    setTraceThreadName("Job Worker");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        while (!m_quit && m_queue.empty()) {
+            ++m_idleThreads;
+            m_condition.wait(lock);
+            --m_idleThreads;
+        }
+        if (m_quit) return;
+        std::pop_heap(m_queue.begin(), m_queue.end(), queueLess);
+        JobRef job = m_queue.back().job;
+        m_queue.pop_back();
+        lock.unlock();
+
+        execute(job);
+
+        lock.lock();
+        job->m_executed = true;
+        m_idleCondition.notify_all();
+    }
+}
+
+void JobScheduler::execute(const JobRef& job) {
+    if (job->isCancelled()) {
+        complete(job, Job::CANCELLED, "");
+        return;
+    }
+    post([this, job]() {
+        job->m_state = Job::RUNNING;
+        m_signalChanged.emit();
+    });
+    GIGEDIT_TRACE_SCOPE("Job::run");
+    try {
+        job->run();
+        complete(job, Job::FINISHED, "");
+    } catch (Job::Cancelled) {
+        complete(job, Job::CANCELLED, "");
+    } catch (RIFF::Exception e) {
+        complete(job, Job::FAILED, e.Message);
+    } catch (std::string what) {
+        complete(job, Job::FAILED, what);
+    } catch (...) {
+        complete(job, Job::FAILED, _("Unknown exception occurred"));
+    }
+}
+
+void JobScheduler::complete(const JobRef& job, Job::State state,
+                            const Glib::ustring& error)
+{
+    post([this, job, state, error]() {
+        job->m_state = state;
+        job->m_errorMessage = error;
+        m_jobs.erase(std::find(m_jobs.begin(), m_jobs.end(), job));
+        switch (state) {
+            case Job::FINISHED:  job->m_signalFinished.emit(); break;
+            case Job::FAILED:    job->m_signalError.emit(); break;
+            default:             job->m_signalCancelled.emit(); break;
+        }
+        m_signalChanged.emit();
+    });
+}
@@ -0,0 +1,192 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_JOBSCHEDULER_H
+#define GIGEDIT_JOBSCHEDULER_H
+
+#include <glibmm/dispatcher.h>
+#include <glibmm/ustring.h>
+#include <sigc++/signal.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** @brief Long running operation executed by the JobScheduler.
+ *
+ * Subclasses implement run(), which is called on one of the scheduler's worker
+ * threads. All signals of a job are emitted on the GUI thread though, so they
+ * may be connected directly to GUI code. A job is completed once exactly one of
+ * signal_finished(), signal_error() or signal_cancelled() was emitted.
+ *
+ * Cancellation is cooperative: cancel() just sets the job's cancellation token,
+ * and run() is expected to check it regularly, either by calling
+ * checkCancelled() or by passing cancelToken() to functions accepting one
+ * (i.e. findDuplicateSamples()).
+ */
+class Job {
+public:
+    enum Priority {
+        PRIORITY_LOW,
+        PRIORITY_NORMAL,
+        PRIORITY_HIGH ///< i.e. jobs the user is waiting for
+    };
+
+    enum State {
+        QUEUED,
+        RUNNING,
+        FINISHED,
+        FAILED,
+        CANCELLED
+    };
+
+    /// Thrown by checkCancelled(), caught by the scheduler.
+    class Cancelled {};
+
+    virtual ~Job();
+
+    const Glib::ustring& title() const { return m_title; }
+    Priority priority() const { return m_priority; }
+    State state() const { return m_state; }
+    bool isCompleted() const { return m_state > RUNNING; }
+    /// Whether the user must not interact with the application while this job runs.
+    bool isModal() const { return m_modal; }
+    /// Whether the GUI which started this job displays its progress by itself.
+    bool hasOwnProgressDisplay() const { return m_ownProgressDisplay; }
+    /// Error of a FAILED job.
+    const Glib::ustring& errorMessage() const { return m_errorMessage; }
+
+    bool isCancellable() const { return m_cancellable; }
+    /// Asks the job to stop as soon as possible (may be called from any thread).
+    void cancel();
+    bool isCancelled() const { return m_cancel; }
+    const std::atomic<bool>* cancelToken() const { return &m_cancel; }
+
+    /// Progress of run() in the range [0, 1] (may be called from any thread).
+    float progress() const { return float(m_progress) / 1000.f; }
+
+    sigc::signal<void>& signal_progress();
+    sigc::signal<void>& signal_finished(); ///< Finished successfully, without error.
+    sigc::signal<void>& signal_error();
+    sigc::signal<void>& signal_cancelled();
+
+protected:
+    Job(const Glib::ustring& title, Priority priority = PRIORITY_NORMAL,
+        bool cancellable = true);
+
+    /// For jobs racing with edits of the user, i.e. saving the open file.
+    void setModal(bool modal) { m_modal = modal; }
+    /// For jobs started by a dialog showing the job's progress, which keeps JobProgressView hidden.
+    void setOwnProgressDisplay(bool b) { m_ownProgressDisplay = b; }
+
+    /// Does the actual work on a worker thread, errors are reported by exceptions.
+    virtual void run() = 0;
+
+    // the following may only be called by run()
+    void setProgress(float fraction);
+    /// Throws Cancelled if cancel() was called.
+    void checkCancelled() const;
+    /// Calls @a fn on the GUI thread (asynchronously, but before the job completes).
+    void notify(const std::function<void()>& fn);
+
+private:
+    friend class JobScheduler;
+
+    Glib::ustring m_title;
+    Priority m_priority;
+    bool m_cancellable;
+    bool m_modal;
+    bool m_ownProgressDisplay;
+    State m_state; ///< only accessed by the GUI thread
+    bool m_executed; ///< run() returned, guarded by the scheduler's mutex
+    Glib::ustring m_errorMessage;
+    std::atomic<bool> m_cancel;
+    std::atomic<int> m_progress; ///< per mille
+    std::atomic<bool> m_progressPending; ///< signal_progress() emission already posted
+    class JobScheduler* m_scheduler;
+    sigc::signal<void> m_signalProgress;
+    sigc::signal<void> m_signalFinished;
+    sigc::signal<void> m_signalError;
+    sigc::signal<void> m_signalCancelled;
+};
+
+typedef std::shared_ptr<Job> JobRef;
+
+/** @brief Runs Jobs on a pool of worker threads.
+ *
+ * Submitted jobs are queued by priority (jobs of the same priority in the
+ * order they were submitted) and handed to the worker threads, which are
+ * spawned on demand. Results are passed back to the GUI thread by a single
+ * Glib::Dispatcher, which emits the jobs' signals there. The scheduler keeps a
+ * reference to each job until it completed, so callers do not have to care
+ * about the lifetime of jobs.
+ *
+ * All methods except Job::cancel() and Job::progress() must be called on the
+ * GUI thread, which is also the thread the singleton has to be created on.
+ */
+class JobScheduler {
+public:
+    static JobScheduler* singleton();
+
+    JobScheduler(int maxThreads = -1);
+    ~JobScheduler();
+
+    void submit(const JobRef& job);
+    /// Cancels all queued and running jobs (does not wait for them).
+    void cancelAll();
+    /**
+     * Blocks until run() of @a job returned. The job's signals are still
+     * emitted asynchronously by the main loop afterwards.
+     */
+    void wait(const JobRef& job);
+
+    /// Jobs submitted but not completed yet, in order of submission.
+    const std::vector<JobRef>& jobs() const { return m_jobs; }
+    bool isBusy() const { return !m_jobs.empty(); }
+    /// Average progress of all jobs not completed yet.
+    float progress() const;
+
+    /// Emitted on the GUI thread whenever a job was added, made progress or completed.
+    sigc::signal<void>& signal_changed();
+
+private:
+    struct QueueEntry {
+        JobRef job;
+        unsigned long sequence;
+    };
+
+    std::vector<JobRef> m_jobs; ///< only accessed by the GUI thread
+    int m_maxThreads;
+    unsigned long m_sequence;
+    sigc::signal<void> m_signalChanged;
+
+    // shared with the worker threads
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::condition_variable m_idleCondition;
+    std::vector<QueueEntry> m_queue; ///< heap, highest priority first
+    std::vector<std::thread> m_threads;
+    int m_idleThreads;
+    bool m_quit;
+    std::deque<std::function<void()> > m_events; ///< to be called on the GUI thread
+    Glib::Dispatcher m_dispatcher;
+
+    friend class Job;
+    static bool queueLess(const QueueEntry& a, const QueueEntry& b);
+    void post(const std::function<void()>& fn);
+    void processEvents();
+    void workerThread();
+    void execute(const JobRef& job);
+    void complete(const JobRef& job, Job::State state, const Glib::ustring& error);
+};
+
+#endif // GIGEDIT_JOBSCHEDULER_H
@@ -0,0 +1,176 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "LintView.h"
+#include "global.h"
+
+#if HAS_GTKMM_STOCK
+# include <gtkmm/stock.h>
+#endif
+
+Glib::ustring gig_to_utf8(const gig::String& gig_string);
+Glib::ustring note_str(int note);
+
+static Glib::ustring regionStr(gig::Region* rgn) {
+    return note_str(rgn->KeyRange.low) + " - " + note_str(rgn->KeyRange.high);
+}
+
+static Glib::ustring locationStr(const LintFinding& f) {
+    Glib::ustring s;
+    if (f.instrument) s = gig_to_utf8(f.instrument->pInfo->Name);
+    if (f.region) s += " / " + regionStr(f.region);
+    if (!f.instrument && f.sample) s = gig_to_utf8(f.sample->pInfo->Name);
+    return s;
+}
+
+static Glib::ustring problemStr(const LintFinding& f) {
+    switch (f.kind) {
+        case LintFinding::NO_SAMPLES:
+            return _("The file contains no samples.");
+        case LintFinding::NO_REGIONS:
+            return _("The instrument has no regions.");
+        case LintFinding::DELETED_SAMPLE:
+            return ToString(f.count) + " " +
+                   _("dimension region(s) use a sample which is not part of the file anymore.");
+        case LintFinding::LOOP_BEYOND_END:
+            return ToString(f.count) + " " +
+                   _("dimension region(s) have a loop exceeding the end of sample") +
+                   " '" + gig_to_utf8(f.sample->pInfo->Name) + "'.";
+        case LintFinding::SAMPLE_LOOP_BEYOND_END:
+            return _("The sample's loop exceeds the end of the sample.");
+        case LintFinding::ZONES_NOT_ASCENDING:
+            return _("The velocity zones overlap, their upper limits are not ascending.");
+        case LintFinding::OVERLAPPING_REGIONS:
+            return _("The key range overlaps with region") + Glib::ustring(" ") +
+                   regionStr(f.otherRegion) + ".";
+        case LintFinding::ZONES_INCOMPLETE:
+            return _("The velocity zones do not cover velocities up to 127.");
+        case LintFinding::SILENT_DIMRGNS:
+            return ToString(f.count) + " " +
+                   _("dimension region(s) have no sample assigned.");
+        case LintFinding::UNUSED_DIMRGNS:
+            return ToString(f.count) + " " +
+                   _("unused dimension region(s) still reference a sample.");
+    }
+    return "";
+}
+
+LintView::LintView() :
+    m_statusLabel("", Gtk::ALIGN_START),
+    m_checkButton(_("Check _Again"), true),
+#if HAS_GTKMM_STOCK
+    m_closeButton(Gtk::Stock::CLOSE)
+#else
+    m_closeButton(_("_Close"), true)
+#endif
+{
+    if (!Settings::singleton()->autoRestoreWindowDimension) {
+        set_default_size(600, 350);
+        set_position(Gtk::WIN_POS_MOUSE);
+    }
+
+    set_title(_("File Check"));
+#if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && GTKMM_MINOR_VERSION > 24)
+    set_margin(6);
+#else
+    set_border_width(6);
+#endif
+
+#if !HAS_GTKMM_STOCK
+    m_closeButton.set_icon_name("window-close");
+#endif
+
+    add(m_vbox);
+    m_vbox.set_spacing(6);
+
+    m_refListStore = Gtk::ListStore::create(m_columns);
+    m_treeView.set_model(m_refListStore);
+    m_treeView.append_column(_("Severity"), m_columns.m_col_severity);
+    m_treeView.append_column(_("Location"), m_columns.m_col_location);
+    m_treeView.append_column(_("Problem"), m_columns.m_col_problem);
+    m_treeView.set_headers_visible(true);
+    m_treeView.get_selection()->set_mode(Gtk::SELECTION_SINGLE);
+    m_treeView.set_tooltip_text(_(
+        "Double click to show the affected instrument, region, dimension "
+        "region or sample."
+    ));
+    m_scrolledWindow.add(m_treeView);
+    m_scrolledWindow.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+    m_vbox.pack_start(m_scrolledWindow);
+    m_vbox.pack_start(m_statusLabel, Gtk::PACK_SHRINK);
+
+    m_buttonBox.set_layout(Gtk::BUTTONBOX_END);
+    m_buttonBox.set_spacing(6);
+    m_buttonBox.pack_start(m_checkButton, Gtk::PACK_SHRINK);
+    m_buttonBox.pack_start(m_closeButton, Gtk::PACK_SHRINK);
+    m_vbox.pack_start(m_buttonBox, Gtk::PACK_SHRINK);
+
+    m_checkButton.signal_clicked().connect(
+        sigc::mem_fun(*this, &LintView::on_check)
+    );
+    m_closeButton.signal_clicked().connect(
+        sigc::mem_fun(*this, &LintView::hide)
+    );
+    m_treeView.signal_row_activated().connect(
+        sigc::mem_fun(*this, &LintView::on_row_activated)
+    );
+
+#if HAS_GTKMM_SHOW_ALL_CHILDREN
+    show_all_children();
+#endif
+}
+
+void LintView::set_findings(const std::vector<LintFinding>& findings) {
+    clear();
+    m_findings = findings;
+    int errors = 0;
+    for (size_t i = 0; i < m_findings.size(); ++i) {
+        const LintFinding& f = m_findings[i];
+        if (f.isError()) ++errors;
+        Gtk::TreeModel::Row row = *m_refListStore->append();
+        row[m_columns.m_col_severity] = f.isError() ? _("Error") : _("Warning");
+        row[m_columns.m_col_location] = locationStr(f);
+        row[m_columns.m_col_problem] = problemStr(f);
+        row[m_columns.m_col_index] = int(i);
+    }
+    if (m_findings.empty()) {
+        m_statusLabel.set_text(_("No problems found."));
+    } else {
+        m_statusLabel.set_text(
+            ToString(errors) + " " + _("errors") + ", " +
+            ToString(m_findings.size() - errors) + " " + _("warnings")
+        );
+    }
+}
+
+void LintView::clear() {
+    m_findings.clear();
+    m_refListStore->clear();
+    m_statusLabel.set_text("");
+}
+
+void LintView::set_outdated() {
+    if (m_findings.empty()) return;
+    m_statusLabel.set_text(
+        _("The file was modified since it was checked, the list might be outdated.")
+    );
+}
+
+void LintView::on_check() {
+    m_check.emit();
+}
+
+void LintView::on_row_activated(const Gtk::TreeModel::Path& path,
+                                Gtk::TreeViewColumn* column)
+{
+    Gtk::TreeModel::iterator it = m_refListStore->get_iter(path);
+    if (!it) return;
+    Gtk::TreeModel::Row row = *it;
+    const int index = row[m_columns.m_col_index];
+    if (index >= 0 && index < int(m_findings.size()))
+        m_findingActivated.emit(m_findings[index]);
+}
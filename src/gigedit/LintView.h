@@ -0,0 +1,89 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_LINTVIEW_H
+#define GIGEDIT_LINTVIEW_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#ifdef GTKMM_HEADER_FILE
+# include GTKMM_HEADER_FILE(gtkmm.h)
+#else
+# include <gtkmm.h>
+#endif
+
+#include "compat.h"
+#include "ManagedWindow.h"
+#include "GigLint.h"
+
+#include <vector>
+
+/** @brief Lists the problems of a gig file found by lintGigFile().
+ *
+ * The checks themselves are run by the main window (after a file was loaded,
+ * before it is saved and on request by the user); this window just shows
+ * their results and lets the user jump to the affected objects.
+ */
+class LintView : public ManagedWindow {
+public:
+    LintView();
+
+    void set_findings(const std::vector<LintFinding>& findings);
+    void clear();
+    /// The file was modified since the findings were shown.
+    void set_outdated();
+
+    /// The user wants the file to be checked again.
+    sigc::signal<void>& signal_check() { return m_check; }
+    /// The user wants to edit the object of @a finding in the main window.
+    sigc::signal<void, const LintFinding&>& signal_finding_activated() { return m_findingActivated; }
+
+    // implementation for abstract methods of interface class "ManagedWindow"
+    virtual Settings::Property<int>* windowSettingX() { return &Settings::singleton()->lintViewWindowX; }
+    virtual Settings::Property<int>* windowSettingY() { return &Settings::singleton()->lintViewWindowY; }
+    virtual Settings::Property<int>* windowSettingWidth() { return &Settings::singleton()->lintViewWindowW; }
+    virtual Settings::Property<int>* windowSettingHeight() { return &Settings::singleton()->lintViewWindowH; }
+
+protected:
+    std::vector<LintFinding> m_findings;
+    sigc::signal<void> m_check;
+    sigc::signal<void, const LintFinding&> m_findingActivated;
+
+    VBox m_vbox;
+    Gtk::ScrolledWindow m_scrolledWindow;
+    Gtk::TreeView m_treeView;
+    Gtk::Label m_statusLabel;
+    HButtonBox m_buttonBox;
+    Gtk::Button m_checkButton;
+    Gtk::Button m_closeButton;
+
+    class FindingsModel : public Gtk::TreeModel::ColumnRecord {
+    public:
+        FindingsModel() {
+            add(m_col_severity);
+            add(m_col_location);
+            add(m_col_problem);
+            add(m_col_index);
+        }
+
+        Gtk::TreeModelColumn<Glib::ustring> m_col_severity;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_location;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_problem;
+        Gtk::TreeModelColumn<int> m_col_index; ///< index in m_findings
+    } m_columns;
+
+    Glib::RefPtr<Gtk::ListStore> m_refListStore;
+
+    void on_check();
+    void on_row_activated(const Gtk::TreeModel::Path& path, Gtk::TreeViewColumn* column);
+};
+
+#endif // GIGEDIT_LINTVIEW_H
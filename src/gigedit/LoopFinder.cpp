@@ -0,0 +1,258 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "LoopFinder.h"
+#include "ParallelFor.h"
+#include "VectorOps.h"
+
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <stdlib.h>
+
+// shortest loop (in sample points) ever suggested
+#define MIN_LOOP_LENGTH 32
+
+// amount of sample points read from disk at once
+#define READ_CHUNK_FRAMES 16384
+
+/**
+ * Collects the loop boundary candidates within [lo, hi] of @a data (indices
+ * relative to @a data): rising zero crossings, or an equidistant grid if the
+ * signal has no zero crossings there. Only the @a max ones nearest to
+ * @a center are returned.
+ */
+static std::vector<int64_t> boundaryCandidates(const std::vector<float>& data,
+                                               int64_t lo, int64_t hi,
+                                               int64_t center, int max)
+{
+    std::vector<int64_t> result;
+    lo = std::max<int64_t>(lo, 1);
+    hi = std::min<int64_t>(hi, int64_t(data.size()) - 1);
+    for (int64_t i = lo; i <= hi; ++i)
+        if (data[i - 1] < 0.f && data[i] >= 0.f)
+            result.push_back(i);
+    if (result.empty() && hi >= lo) {
+        const int64_t step = std::max<int64_t>(1, (hi - lo) / max);
+        for (int64_t i = lo; i <= hi; i += step)
+            result.push_back(i);
+    }
+    if (result.size() > size_t(max)) {
+        std::sort(result.begin(), result.end(), [center](int64_t a, int64_t b) {
+            return llabs(a - center) < llabs(b - center);
+        });
+        result.resize(max);
+    }
+    return result;
+}
+
+/// Prefix sums of squares, for O(1) energy of arbitrary windows.
+static std::vector<double> energyPrefix(const std::vector<float>& data) {
+    std::vector<double> prefix(data.size() + 1, 0.0);
+    for (size_t i = 0; i < data.size(); ++i)
+        prefix[i + 1] = prefix[i] + double(data[i]) * double(data[i]);
+    return prefix;
+}
+
+std::vector<LoopCandidate> findLoopCandidates(
+    const std::vector<float>& head, gig::file_offset_t headPos,
+    const std::vector<float>& tail, gig::file_offset_t tailPos,
+    gig::file_offset_t roughStart, gig::file_offset_t roughLength,
+    const LoopSearchParams& params)
+{
+    std::vector<LoopCandidate> results;
+    const int64_t half = params.windowSize / 2;
+    const int64_t radius = params.searchRadius;
+    const int64_t roughEnd = roughStart + roughLength;
+
+    // candidate positions relative to head / tail, the comparison window
+    // around each must lie completely within the respective section
+    const int64_t headCenter = int64_t(roughStart) - int64_t(headPos);
+    const int64_t tailCenter = roughEnd - int64_t(tailPos);
+    std::vector<int64_t> starts = boundaryCandidates(
+        head, std::max(headCenter - radius, half),
+        std::min(headCenter + radius, int64_t(head.size()) - half),
+        headCenter, params.maxCandidatesPerSide
+    );
+    std::vector<int64_t> ends = boundaryCandidates(
+        tail, std::max(tailCenter - radius, half),
+        std::min(tailCenter + radius, int64_t(tail.size()) - half),
+        tailCenter, params.maxCandidatesPerSide
+    );
+    if (starts.empty() || ends.empty()) return results;
+
+    const std::vector<double> headEnergy = energyPrefix(head);
+    const std::vector<double> tailEnergy = energyPrefix(tail);
+    const size_t window = 2 * half;
+
+    for (size_t s = 0; s < starts.size(); ++s) {
+        const int64_t is = starts[s];
+        const gig::file_offset_t start = headPos + is;
+        const double eStart = headEnergy[is + half] - headEnergy[is - half];
+        for (size_t e = 0; e < ends.size(); ++e) {
+            const int64_t ie = ends[e];
+            const gig::file_offset_t end = tailPos + ie;
+            if (end < start + MIN_LOOP_LENGTH) continue;
+
+            // the waveform around loop end is followed by the waveform
+            // after loop start on playback, so both should be similar
+            const double eEnd = tailEnergy[ie + half] - tailEnergy[ie - half];
+            float score;
+            if (eStart <= 0.0 && eEnd <= 0.0) {
+                score = 1.f; // silence on both sides
+            } else if (eStart <= 0.0 || eEnd <= 0.0) {
+                score = 0.f;
+            } else {
+                const double dot = dotProduct(&head[is - half], &tail[ie - half], window);
+                const double norm = sqrt(eStart * eEnd);
+                // 1.0 if both sides have same level, smaller otherwise
+                const double levelMatch = 2.0 * norm / (eStart + eEnd);
+                score = float(dot / norm * levelMatch);
+            }
+
+            LoopCandidate c = { start, end - start, score };
+            if (results.size() < size_t(params.maxResults) * 4) {
+                results.push_back(c);
+            } else {
+                // replace the worst one kept so far
+                auto worst = std::min_element(results.begin(), results.end(),
+                    [](const LoopCandidate& a, const LoopCandidate& b) {
+                        return a.score < b.score;
+                    });
+                if (worst->score < score) *worst = c;
+            }
+        }
+    }
+
+    std::sort(results.begin(), results.end(),
+        [](const LoopCandidate& a, const LoopCandidate& b) {
+            return a.score > b.score;
+        });
+
+    // drop near identical suggestions
+    std::vector<LoopCandidate> distinct;
+    for (size_t i = 0; i < results.size() && distinct.size() < size_t(params.maxResults); ++i) {
+        bool similar = false;
+        for (size_t k = 0; k < distinct.size(); ++k) {
+            if (llabs(int64_t(results[i].start)  - int64_t(distinct[k].start))  < 8 &&
+                llabs(int64_t(results[i].length) - int64_t(distinct[k].length)) < 8)
+            {
+                similar = true;
+                break;
+            }
+        }
+        if (!similar) distinct.push_back(results[i]);
+    }
+    return distinct;
+}
+
+std::vector<float> readSampleMono(gig::Sample* sample, gig::file_offset_t pos,
+                                  gig::file_offset_t count, std::mutex* ioMutex)
+{
+    std::vector<float> result;
+    if (!sample || pos >= sample->SamplesTotal) return result;
+    count = std::min(count, sample->SamplesTotal - pos);
+    result.reserve(count);
+
+    const int channels = sample->Channels;
+    const int bytesPerValue = sample->BitDepth / 8;
+    std::vector<uint8_t> buffer(READ_CHUNK_FRAMES * sample->FrameSize);
+    gig::buffer_t decompressionBuffer;
+    if (sample->Compressed)
+        decompressionBuffer = gig::Sample::CreateDecompressionBuffer(READ_CHUNK_FRAMES);
+
+    // optionally serialized access to the gig file
+    auto lock = [ioMutex]() {
+        return (ioMutex) ? std::unique_lock<std::mutex>(*ioMutex)
+                         : std::unique_lock<std::mutex>();
+    };
+
+    try {
+        {
+            std::unique_lock<std::mutex> l = lock();
+            sample->SetPos(pos);
+        }
+        while (count) {
+            gig::file_offset_t n;
+            {
+                std::unique_lock<std::mutex> l = lock();
+                n = sample->Read(
+                    &buffer[0], std::min<gig::file_offset_t>(count, READ_CHUNK_FRAMES),
+                    sample->Compressed ? &decompressionBuffer : NULL
+                );
+            }
+            if (!n) break;
+            count -= n;
+
+            const uint8_t* p = &buffer[0];
+            for (gig::file_offset_t f = 0; f < n; ++f) {
+                float sum = 0.f;
+                for (int c = 0; c < channels; ++c, p += bytesPerValue) {
+                    if (bytesPerValue == 3) {
+                        const int32_t v = int32_t(uint32_t(p[0]) << 8 |
+                                                  uint32_t(p[1]) << 16 |
+                                                  uint32_t(p[2]) << 24) >> 8;
+                        sum += float(v) / 8388608.f;
+                    } else {
+                        int16_t v;
+                        memcpy(&v, p, sizeof(v));
+                        sum += float(v) / 32768.f;
+                    }
+                }
+                result.push_back(sum / channels);
+            }
+        }
+        {
+            std::unique_lock<std::mutex> l = lock();
+            sample->SetPos(0);
+        }
+    } catch (...) {
+        if (sample->Compressed)
+            gig::Sample::DestroyDecompressionBuffer(decompressionBuffer);
+        throw;
+    }
+    if (sample->Compressed)
+        gig::Sample::DestroyDecompressionBuffer(decompressionBuffer);
+    return result;
+}
+
+std::vector<LoopCandidate> findLoopCandidates(gig::Sample* sample,
+    gig::file_offset_t roughStart, gig::file_offset_t roughLength,
+    const LoopSearchParams& params, std::mutex* ioMutex)
+{
+    if (!sample || !sample->SamplesTotal || !sample->FrameSize)
+        return std::vector<LoopCandidate>();
+
+    // only read the sections around the rough loop start and end
+    const gig::file_offset_t margin = params.searchRadius + params.windowSize;
+    const gig::file_offset_t roughEnd = roughStart + roughLength;
+    const gig::file_offset_t headPos = (roughStart > margin) ? roughStart - margin : 0;
+    const gig::file_offset_t tailPos = (roughEnd > margin) ? roughEnd - margin : 0;
+
+    // lock the mutex per read (not around the whole function), so other
+    // threads may read while this one is busy correlating
+    std::vector<float> head = readSampleMono(sample, headPos, 2 * margin, ioMutex);
+    std::vector<float> tail = readSampleMono(sample, tailPos, 2 * margin, ioMutex);
+
+    return findLoopCandidates(head, headPos, tail, tailPos,
+                              roughStart, roughLength, params);
+}
+
+void findLoopCandidatesBatch(std::vector<LoopFinderJob>& jobs,
+    const LoopSearchParams& params, const std::atomic<bool>* cancel,
+    std::function<void(float)> progress)
+{
+    std::mutex ioMutex;
+    std::atomic<size_t> done(0);
+    parallelFor(jobs.size(), [&](size_t i) {
+        if (cancel && *cancel) return;
+        LoopFinderJob& job = jobs[i];
+        job.result = findLoopCandidates(job.sample, job.roughStart,
+                                        job.roughLength, params, &ioMutex);
+        if (progress) progress(float(++done) / float(jobs.size()));
+    });
+}
@@ -0,0 +1,110 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_LOOPFINDER_H
+#define GIGEDIT_LOOPFINDER_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <functional>
+
+/**
+ * A loop suggested by the loop finder. The loop covers the sample points
+ * [start, start + length), that is after the sample point at
+ * start + length - 1 playback continues at sample point start.
+ */
+struct LoopCandidate {
+    gig::file_offset_t start;
+    gig::file_offset_t length;
+    float score; ///< waveform match at the loop seam (1.0 = perfect match)
+};
+
+/**
+ * Tuning parameters for the loop search.
+ */
+struct LoopSearchParams {
+    int searchRadius; ///< max. distance (in sample points) of loop start and loop end from the rough loop boundaries
+    int windowSize; ///< amount of sample points compared around the loop seam
+    int maxCandidatesPerSide; ///< max. amount of start and end positions each to be considered (nearest ones to the rough boundaries)
+    int maxResults; ///< max. amount of loops returned
+
+    LoopSearchParams() :
+        searchRadius(4096), windowSize(512), maxCandidatesPerSide(256),
+        maxResults(8) {}
+};
+
+/**
+ * Searches for the best loops in the proximity of a rough loop.
+ *
+ * Operates on mono audio data of two sections of a sample: @a head is the
+ * section around the rough loop start, starting at sample point @a headPos,
+ * and @a tail is the section around the rough loop end, starting at sample
+ * point @a tailPos. Rising zero crossings within those sections are used as
+ * loop start and end candidates and all pairs of them are rated by the
+ * normalized cross-correlation of the waveform around loop end and the
+ * waveform around loop start, weighted by the match of their levels.
+ *
+ * @returns best loops found, sorted by descending score
+ */
+std::vector<LoopCandidate> findLoopCandidates(
+    const std::vector<float>& head, gig::file_offset_t headPos,
+    const std::vector<float>& tail, gig::file_offset_t tailPos,
+    gig::file_offset_t roughStart, gig::file_offset_t roughLength,
+    const LoopSearchParams& params = LoopSearchParams());
+
+/**
+ * Searches for the best loops in the proximity of the given rough loop of
+ * @a sample. Only the sample data around the rough loop boundaries is read.
+ *
+ * @param ioMutex - optional mutex locked while reading from the gig file
+ */
+std::vector<LoopCandidate> findLoopCandidates(gig::Sample* sample,
+    gig::file_offset_t roughStart, gig::file_offset_t roughLength,
+    const LoopSearchParams& params = LoopSearchParams(),
+    std::mutex* ioMutex = NULL);
+
+/**
+ * Reads @a count sample points of @a sample starting at sample point @a pos,
+ * down mixes them to mono and converts them to float in the range -1..1.
+ * Reading stops prematurely at the end of the sample.
+ *
+ * @param ioMutex - optional mutex locked while reading from the gig file
+ */
+std::vector<float> readSampleMono(gig::Sample* sample, gig::file_offset_t pos,
+                                  gig::file_offset_t count,
+                                  std::mutex* ioMutex = NULL);
+
+/**
+ * Loop finder task for one sample in a batch run.
+ */
+struct LoopFinderJob {
+    gig::Sample* sample;
+    gig::file_offset_t roughStart;
+    gig::file_offset_t roughLength;
+    std::vector<LoopCandidate> result; ///< filled by findLoopCandidatesBatch()
+};
+
+/**
+ * Runs the loop finder for all @a jobs on several worker threads. Reading
+ * from the gig file is serialized. Blocks until all jobs are processed.
+ *
+ * @param cancel - optional flag, remaining jobs are skipped if set to true
+ * @param progress - optional callback receiving the current progress (0..1)
+ */
+void findLoopCandidatesBatch(std::vector<LoopFinderJob>& jobs,
+    const LoopSearchParams& params = LoopSearchParams(),
+    const std::atomic<bool>* cancel = NULL,
+    std::function<void(float)> progress = std::function<void(float)>());
+
+#endif // GIGEDIT_LOOPFINDER_H
@@ -0,0 +1,124 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "LoopFinderDialog.h"
+#include "global.h"
+
+#if HAS_GTKMM_STOCK
+# include <gtkmm/stock.h>
+#endif
+
+LoopFinderDialog::LoopFinderDialog(Gtk::Window& parent, gig::Sample* sample,
+                                   gig::file_offset_t roughStart,
+                                   gig::file_offset_t roughLength)
+    : Gtk::Dialog(_("Find Loop"), parent, true), m_selected(-1),
+#if HAS_GTKMM_STOCK
+      m_cancelButton(Gtk::Stock::CANCEL),
+#else
+      m_cancelButton(_("_Cancel"), true),
+#endif
+      m_applyButton(_("_Apply Loop"), true)
+{
+    m_scrolledWindow.add(m_treeView);
+    m_scrolledWindow.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+
+#if USE_GTKMM_BOX
+    get_content_area()->pack_start(m_descriptionLabel, Gtk::PACK_SHRINK);
+    get_content_area()->pack_start(m_scrolledWindow);
+    get_content_area()->pack_start(m_buttonBox, Gtk::PACK_SHRINK);
+#else
+    get_vbox()->pack_start(m_descriptionLabel, Gtk::PACK_SHRINK);
+    get_vbox()->pack_start(m_scrolledWindow);
+    get_vbox()->pack_start(m_buttonBox, Gtk::PACK_SHRINK);
+#endif
+
+    m_refListModel = Gtk::ListStore::create(m_columns);
+    m_treeView.set_model(m_refListModel);
+    m_treeView.append_column(_("Loop Start"), m_columns.m_col_start);
+    m_treeView.append_column(_("Loop Size"), m_columns.m_col_length);
+    m_treeView.append_column(_("Match"), m_columns.m_col_score);
+    m_treeView.set_headers_visible(true);
+    m_treeView.get_selection()->set_mode(Gtk::SELECTION_SINGLE);
+    m_treeView.get_selection()->signal_changed().connect(
+        sigc::mem_fun(*this, &LoopFinderDialog::onSelectionChanged)
+    );
+    m_treeView.signal_row_activated().connect(
+        sigc::mem_fun(*this, &LoopFinderDialog::onRowActivated)
+    );
+
+    m_buttonBox.set_layout(Gtk::BUTTONBOX_END);
+#if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && GTKMM_MINOR_VERSION > 24)
+    m_buttonBox.set_margin(5);
+#else
+    m_buttonBox.set_border_width(5);
+#endif
+    m_buttonBox.pack_start(m_cancelButton, Gtk::PACK_SHRINK);
+    m_buttonBox.pack_start(m_applyButton, Gtk::PACK_SHRINK);
+    m_applyButton.set_sensitive(false);
+
+    m_cancelButton.signal_clicked().connect(
+        sigc::mem_fun(*this, &LoopFinderDialog::hide)
+    );
+    m_applyButton.signal_clicked().connect(
+        sigc::mem_fun(*this, &LoopFinderDialog::onApplyClicked)
+    );
+
+    try {
+        m_candidates = findLoopCandidates(sample, roughStart, roughLength);
+    } catch (RIFF::Exception e) {
+        m_candidates.clear();
+        m_descriptionLabel.set_text(_("Could not read sample data: ") + e.Message);
+    }
+
+    for (int i = 0; i < m_candidates.size(); ++i) {
+        Gtk::TreeModel::Row row = *(m_refListModel->append());
+        row[m_columns.m_col_index]  = i;
+        row[m_columns.m_col_start]  = ToString(m_candidates[i].start);
+        row[m_columns.m_col_length] = ToString(m_candidates[i].length);
+        row[m_columns.m_col_score]  =
+            ToString(int(m_candidates[i].score * 1000.f) / 10.f) + " %";
+    }
+    if (m_descriptionLabel.get_text().empty()) {
+        m_descriptionLabel.set_text(
+            m_candidates.empty() ?
+                _("No loop found near the current loop.") :
+                _("Loops found near the current loop, best match first:")
+        );
+    }
+    if (!m_candidates.empty())
+        m_treeView.get_selection()->select(m_refListModel->children().begin());
+
+#if HAS_GTKMM_SHOW_ALL_CHILDREN
+    show_all_children();
+#endif
+    resize(400, 300);
+}
+
+void LoopFinderDialog::onSelectionChanged() {
+    Gtk::TreeModel::iterator it = m_treeView.get_selection()->get_selected();
+    m_applyButton.set_sensitive(bool(it));
+}
+
+void LoopFinderDialog::onRowActivated(const Gtk::TreeModel::Path& path,
+                                      Gtk::TreeViewColumn* column)
+{
+    onApplyClicked();
+}
+
+void LoopFinderDialog::onApplyClicked() {
+    Gtk::TreeModel::iterator it = m_treeView.get_selection()->get_selected();
+    if (!it) return;
+    Gtk::TreeModel::Row row = *it;
+    m_selected = row[m_columns.m_col_index];
+    hide();
+}
+
+bool LoopFinderDialog::selectedLoop(LoopCandidate& loop) const {
+    if (m_selected < 0 || m_selected >= m_candidates.size()) return false;
+    loop = m_candidates[m_selected];
+    return true;
+}
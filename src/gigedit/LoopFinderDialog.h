@@ -0,0 +1,73 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_LOOPFINDERDIALOG_H
+#define GIGEDIT_LOOPFINDERDIALOG_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#include "compat.h"
+
+#include <gtkmm/buttonbox.h>
+#include <gtkmm/dialog.h>
+#include <gtkmm/treeview.h>
+#include <gtkmm/liststore.h>
+#include <gtkmm/scrolledwindow.h>
+
+#include "LoopFinder.h"
+
+/** @brief Modal dialog showing loop suggestions for one sample.
+ *
+ * Runs the loop finder around the given rough loop of a sample when created
+ * and lists the suggested loops ranked by their match at the loop seam. If
+ * the user picked one of them, then selectedLoop() returns true after run()
+ * returned.
+ */
+class LoopFinderDialog : public Gtk::Dialog {
+public:
+    LoopFinderDialog(Gtk::Window& parent, gig::Sample* sample,
+                     gig::file_offset_t roughStart, gig::file_offset_t roughLength);
+    bool selectedLoop(LoopCandidate& loop) const;
+
+protected:
+    std::vector<LoopCandidate> m_candidates;
+    int m_selected;
+
+    HButtonBox           m_buttonBox;
+    Gtk::ScrolledWindow  m_scrolledWindow;
+    Gtk::TreeView        m_treeView;
+    Gtk::Button          m_cancelButton;
+    Gtk::Button          m_applyButton;
+    Gtk::Label           m_descriptionLabel;
+
+    class ListModel : public Gtk::TreeModel::ColumnRecord {
+    public:
+        ListModel() {
+            add(m_col_index);
+            add(m_col_start);
+            add(m_col_length);
+            add(m_col_score);
+        }
+
+        Gtk::TreeModelColumn<int>           m_col_index;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_start;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_length;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_score;
+    } m_columns;
+
+    Glib::RefPtr<Gtk::ListStore> m_refListModel;
+
+    void onSelectionChanged();
+    void onRowActivated(const Gtk::TreeModel::Path& path, Gtk::TreeViewColumn* column);
+    void onApplyClicked();
+};
+
+#endif // GIGEDIT_LOOPFINDERDIALOG_H
@@ -0,0 +1,626 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "MappedImport.h"
+#include "ParallelFor.h"
+#include "global.h"
+
+#ifdef LIBSNDFILE_HEADER_FILE
+# include LIBSNDFILE_HEADER_FILE(sndfile.h)
+#else
+# include <sndfile.h>
+#endif
+
+#include <glibmm/fileutils.h>
+#include <glibmm/miscutils.h>
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <map>
+
+Glib::ustring note_str(int note);
+
+// file name extensions of all file types supported by libsndfile
+static const char* const supportedExtensions[] = {
+    "wav", "aiff", "aifc", "snd", "au", "paf", "iff", "svx", "sf", "voc",
+    "w64", "pvf", "xi", "htk", "caf", NULL
+};
+
+// velocity of dynamic markings, if used in file names instead of numbers
+static const struct { const char* name; int velocity; } dynamics[] = {
+    { "ppp", 16 }, { "pp", 33 }, { "p", 49 }, { "mp", 64 },
+    { "mf", 80 }, { "f", 96 }, { "ff", 112 }, { "fff", 127 }, { NULL, 0 }
+};
+
+static std::string toLower(std::string s) {
+    for (size_t i = 0; i < s.size(); ++i) s[i] = tolower(s[i]);
+    return s;
+}
+
+static bool isDigits(const std::string& s) {
+    if (s.empty()) return false;
+    for (size_t i = 0; i < s.size(); ++i)
+        if (!isdigit(s[i])) return false;
+    return true;
+}
+
+/// Value of decimal number @a s or -1 if @a s is no number (or out of range).
+static int parseNumber(const std::string& s) {
+    if (!isDigits(s) || s.size() > 3) return -1;
+    const int n = atoi(s.c_str());
+    return (n <= 127) ? n : -1;
+}
+
+/// Value of @a s if it starts with @a prefix followed by a number, -1 otherwise.
+static int parsePrefixedNumber(const std::string& s, const char* prefix) {
+    const size_t n = strlen(prefix);
+    if (s.size() <= n || s.compare(0, n, prefix)) return -1;
+    return parseNumber(s.substr(n));
+}
+
+static int parseDynamics(const std::string& s) {
+    for (int i = 0; dynamics[i].name; ++i)
+        if (s == dynamics[i].name) return dynamics[i].velocity;
+    return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// class 'MappedImportPattern'
+
+MappedImportPattern::MappedImportPattern(const std::string& pattern) {
+    size_t pos = 0;
+    while (pos < pattern.size()) {
+        Segment seg;
+        if (pattern[pos] == '{') {
+            const size_t end = pattern.find('}', pos);
+            if (end == std::string::npos) {
+                m_error = _("Missing '}' in pattern");
+                m_segments.clear();
+                return;
+            }
+            const std::string name = toLower(pattern.substr(pos + 1, end - pos - 1));
+            if (name == "note")
+                seg.type = NOTE;
+            else if (name == "velocity" || name == "vel")
+                seg.type = VELOCITY;
+            else if (name == "rr" || name == "roundrobin")
+                seg.type = ROUND_ROBIN;
+            else if (name == "*")
+                seg.type = ANY;
+            else {
+                m_error = _("Unknown placeholder in pattern: ") + pattern.substr(pos, end - pos + 1);
+                m_segments.clear();
+                return;
+            }
+            pos = end + 1;
+        } else {
+            const size_t end = pattern.find('{', pos);
+            seg.type = LITERAL;
+            seg.text = toLower(pattern.substr(pos, end - pos));
+            pos = (end == std::string::npos) ? pattern.size() : end;
+        }
+        // two subsequent placeholders cannot be told apart
+        if (seg.type != LITERAL && !m_segments.empty() &&
+            m_segments.back().type != LITERAL)
+        {
+            m_error = _("Placeholders in pattern must be separated by text");
+            m_segments.clear();
+            return;
+        }
+        m_segments.push_back(seg);
+    }
+}
+
+bool MappedImportPattern::parse(const std::string& name, int& note,
+                                int& velocity, int& roundRobin) const
+{
+    note = velocity = roundRobin = -1;
+    if (!m_error.empty()) return false;
+    if (m_segments.empty()) return parseTokens(name, note, velocity, roundRobin);
+    return match(toLower(name), 0, 0, note, velocity, roundRobin);
+}
+
+int MappedImportPattern::parseNote(const std::string& str) {
+    const std::string s = toLower(str);
+    if (isDigits(s)) return parseNumber(s);
+
+    static const int semitones[] = { 9, 11, 0, 2, 4, 5, 7 }; // a .. g
+    if (s.empty() || s[0] < 'a' || s[0] > 'g') return -1;
+    int note = semitones[s[0] - 'a'];
+    size_t pos = 1;
+    if (pos < s.size() && (s[pos] == '#' || s[pos] == 's')) {
+        ++note;
+        ++pos;
+    } else if (pos < s.size() && s[pos] == 'b') {
+        --note;
+        ++pos;
+    }
+    bool negative = false;
+    if (pos < s.size() && s[pos] == '-') {
+        negative = true;
+        ++pos;
+    }
+    if (pos + 1 != s.size() || !isdigit(s[pos])) return -1;
+    const int octave = (negative) ? -(s[pos] - '0') : s[pos] - '0';
+    note += (octave + 1) * 12; // C4 is MIDI note 60
+    return (note >= 0 && note <= 127) ? note : -1;
+}
+
+// backtracking, since placeholders match text of arbitrary length
+bool MappedImportPattern::match(const std::string& name, size_t pos, size_t iSegment,
+                                int& note, int& velocity, int& roundRobin) const
+{
+    if (iSegment == m_segments.size()) return pos == name.size();
+    const Segment& seg = m_segments[iSegment];
+    if (seg.type == LITERAL) {
+        if (name.compare(pos, seg.text.size(), seg.text)) return false;
+        return match(name, pos + seg.text.size(), iSegment + 1, note, velocity, roundRobin);
+    }
+    for (size_t end = (seg.type == ANY) ? pos : pos + 1; end <= name.size(); ++end) {
+        const std::string s = name.substr(pos, end - pos);
+        int value = 0;
+        switch (seg.type) {
+            case NOTE:        value = parseNote(s); break;
+            case VELOCITY:    value = parseNumber(s);
+                              if (value < 0) value = parseDynamics(s);
+                              break;
+            case ROUND_ROBIN: value = parseNumber(s); break;
+            default:          break;
+        }
+        if (value < 0) continue;
+        const int oldNote = note, oldVelocity = velocity, oldRoundRobin = roundRobin;
+        switch (seg.type) {
+            case NOTE:        note = value; break;
+            case VELOCITY:    velocity = value; break;
+            case ROUND_ROBIN: roundRobin = value; break;
+            default:          break;
+        }
+        if (match(name, end, iSegment + 1, note, velocity, roundRobin))
+            return true;
+        note = oldNote;
+        velocity = oldVelocity;
+        roundRobin = oldRoundRobin;
+    }
+    return false;
+}
+
+bool MappedImportPattern::parseTokens(const std::string& name, int& note,
+                                      int& velocity, int& roundRobin) const
+{
+    std::vector<std::string> tokens;
+    std::string token;
+    for (size_t i = 0; i <= name.size(); ++i) {
+        const char c = (i < name.size()) ? tolower(name[i]) : ' ';
+        if (c == '_' || c == '-' || c == '.' || c == ' ') {
+            // a '-' after a note letter belongs to the octave, like in "c-1"
+            if (c == '-' && i + 1 < name.size() && isdigit(name[i + 1]) &&
+                !isDigits(token) && parseNote(token + "0") >= 0)
+            {
+                token += c;
+                continue;
+            }
+            if (!token.empty()) tokens.push_back(token);
+            token.clear();
+        } else {
+            token += c;
+        }
+    }
+
+    std::vector<std::string> numbers;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        const std::string& t = tokens[i];
+        int value;
+        if (roundRobin < 0 && ((value = parsePrefixedNumber(t, "rr")) >= 0 ||
+                               (value = parsePrefixedNumber(t, "seq")) >= 0))
+        {
+            roundRobin = value;
+        } else if (velocity < 0 && ((value = parsePrefixedNumber(t, "vel")) >= 0 ||
+                                    (value = parsePrefixedNumber(t, "v")) >= 0 ||
+                                    (value = parseDynamics(t)) >= 0))
+        {
+            velocity = value;
+        } else if (note < 0 && !isDigits(t) && (value = parseNote(t)) >= 0) {
+            note = value;
+        } else if (isDigits(t)) {
+            numbers.push_back(t);
+        }
+    }
+    // fall back to plain numbers: first the note, then the velocity
+    for (size_t i = 0; i < numbers.size(); ++i) {
+        if (note < 0)
+            note = parseNumber(numbers[i]);
+        else if (velocity < 0)
+            velocity = parseNumber(numbers[i]);
+    }
+    return note >= 0;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// folder scan
+
+static bool isSupportedAudioFile(const std::string& filename, std::string& stem) {
+    const size_t dot = filename.rfind('.');
+    if (dot == std::string::npos || dot == 0) return false;
+    const std::string ext = toLower(filename.substr(dot + 1));
+    for (int i = 0; supportedExtensions[i]; ++i) {
+        if (ext == supportedExtensions[i]) {
+            stem = filename.substr(0, dot);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void listAudioFiles(const std::string& dir, bool recursive,
+                           std::vector<MappedImportFile>& files,
+                           const std::atomic<bool>* cancel)
+{
+    try {
+        Glib::Dir d(dir);
+        for (Glib::DirIterator it = d.begin(); it != d.end(); ++it) {
+            if (cancel && *cancel) return;
+            const std::string entry = *it;
+            if (entry.empty() || entry[0] == '.') continue; // hidden
+            const std::string path = Glib::build_filename(dir, entry);
+            if (Glib::file_test(path, Glib::FILE_TEST_IS_DIR)) {
+                // symbolic links might create cycles
+                if (recursive && !Glib::file_test(path, Glib::FILE_TEST_IS_SYMLINK))
+                    listAudioFiles(path, recursive, files, cancel);
+                continue;
+            }
+            std::string stem;
+            if (!isSupportedAudioFile(entry, stem)) continue;
+            MappedImportFile file;
+            file.path = path;
+            file.name = Glib::filename_display_name(stem);
+            files.push_back(file);
+        }
+    } catch (const Glib::FileError& e) {
+        throw std::string(e.what());
+    }
+}
+
+/// Reads the audio format, tuning and loop of @a file by libsndfile.
+static void readAudioFileInfo(MappedImportFile& file) {
+    SF_INFO info;
+    info.format = 0;
+    SNDFILE* hFile = sf_open(file.path.c_str(), SFM_READ, &info);
+    if (!hFile) {
+        file.error = _("could not open file");
+        return;
+    }
+    file.channels   = info.channels;
+    file.sampleRate = info.samplerate;
+    file.bitDepth   = bitDepthOfSoundFileFormat(info.format);
+    file.frames     = info.frames;
+    if (!file.bitDepth)
+        file.error = _("format not supported");
+    else if (file.channels < 1 || file.channels > 2)
+        file.error = _("only mono and stereo files are supported");
+
+    SF_INSTRUMENT instrument;
+    if (sf_command(hFile, SFC_GET_INSTRUMENT,
+                   &instrument, sizeof(instrument)) != SF_FALSE)
+    {
+        file.fineTune = instrument.detune;
+        if (instrument.loop_count && instrument.loops[0].mode != SF_LOOP_NONE) {
+            file.looped = true;
+            switch (instrument.loops[0].mode) {
+                case SF_LOOP_BACKWARD:
+                    file.loopType = gig::loop_type_backward;
+                    break;
+                case SF_LOOP_ALTERNATING:
+                    file.loopType = gig::loop_type_bidirectional;
+                    break;
+                default:
+                    file.loopType = gig::loop_type_normal;
+                    break;
+            }
+            file.loopStart     = instrument.loops[0].start;
+            file.loopEnd       = instrument.loops[0].end;
+            file.loopPlayCount = instrument.loops[0].count;
+        }
+    }
+    sf_close(hFile);
+}
+
+static bool pathLess(const MappedImportFile& a, const MappedImportFile& b) {
+    return a.path < b.path;
+}
+
+std::vector<MappedImportFile> scanMappedImportFolder(
+    const std::string& dir, bool recursive,
+    const std::atomic<bool>* cancel, std::function<void(float)> progress)
+{
+    std::vector<MappedImportFile> files;
+    listAudioFiles(dir, recursive, files, cancel);
+    if (cancel && *cancel) return std::vector<MappedImportFile>();
+    std::sort(files.begin(), files.end(), pathLess);
+
+    // opening the files is I/O bound, so it pays off for network drives
+    std::atomic<size_t> done(0);
+    parallelFor(files.size(), [&](size_t i) {
+        if (cancel && *cancel) return;
+        readAudioFileInfo(files[i]);
+        if (progress) progress(float(++done) / float(files.size()));
+    });
+    if (cancel && *cancel) return std::vector<MappedImportFile>();
+    return files;
+}
+
+void applyMappedImportPattern(std::vector<MappedImportFile>& files,
+                              const MappedImportPattern& pattern)
+{
+    for (size_t i = 0; i < files.size(); ++i) {
+        MappedImportFile& file = files[i];
+        pattern.parse(file.name, file.note, file.velocity, file.roundRobin);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+// struct 'MappedImportPlan'
+
+bool MappedImportPlan::isMapped(size_t file) const {
+    for (size_t r = 0; r < regions.size(); ++r)
+        if (std::find(regions[r].files.begin(), regions[r].files.end(),
+                      int(file)) != regions[r].files.end())
+            return true;
+    return false;
+}
+
+/// Amount of dimension bits required for @a zones zones.
+static int bitsForZones(size_t zones) {
+    int bits = 0;
+    while ((size_t(1) << bits) < zones) ++bits;
+    return bits;
+}
+
+MappedImportPlan planMappedImport(const std::vector<MappedImportFile>& files) {
+    MappedImportPlan plan;
+
+    // sort the files by note, the first file wins if numbers collide
+    std::map<int, std::map<std::pair<int,int>, size_t> > byNote;
+    int maxVelocity = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        const MappedImportFile& file = files[i];
+        if (!file.error.empty() || file.note < 0) {
+            plan.unmapped.push_back(i);
+            continue;
+        }
+        // a missing number is treated like the lowest one
+        const std::pair<int,int> key(std::max(file.velocity, 0),
+                                     std::max(file.roundRobin, 0));
+        std::map<std::pair<int,int>, size_t>& slots = byNote[file.note];
+        if (slots.count(key)) {
+            plan.duplicates.push_back(i);
+            continue;
+        }
+        slots[key] = i;
+        maxVelocity = std::max(maxVelocity, key.first);
+    }
+    if (byNote.empty()) {
+        plan.error = _("None of the files could be mapped to a note.");
+        return plan;
+    }
+    // small numbers are layer numbers like "v1" .. "v4", larger ones are
+    // the velocities the samples were recorded with
+    const bool layerNumbers = maxVelocity <= 16;
+
+    for (std::map<int, std::map<std::pair<int,int>, size_t> >::iterator it = byNote.begin();
+         it != byNote.end(); ++it)
+    {
+        MappedImportPlan::Region rgn;
+        rgn.note = it->first;
+        rgn.stereo = false;
+        const std::map<std::pair<int,int>, size_t>& slots = it->second;
+        for (std::map<std::pair<int,int>, size_t>::const_iterator s = slots.begin();
+             s != slots.end(); ++s)
+        {
+            if (std::find(rgn.velocities.begin(), rgn.velocities.end(),
+                          s->first.first) == rgn.velocities.end())
+                rgn.velocities.push_back(s->first.first);
+            if (std::find(rgn.roundRobins.begin(), rgn.roundRobins.end(),
+                          s->first.second) == rgn.roundRobins.end())
+                rgn.roundRobins.push_back(s->first.second);
+            if (files[s->second].channels == 2) rgn.stereo = true;
+        }
+        std::sort(rgn.velocities.begin(), rgn.velocities.end());
+        std::sort(rgn.roundRobins.begin(), rgn.roundRobins.end());
+
+        const size_t nVelocities = rgn.velocities.size();
+        for (size_t v = 0; v < nVelocities; ++v) {
+            int limit;
+            if (v + 1 == nVelocities)
+                limit = 127;
+            else if (layerNumbers)
+                limit = int((v + 1) * 128 / nVelocities) - 1;
+            else
+                limit = rgn.velocities[v];
+            // limits have to be strictly ascending
+            if (v > 0 && limit <= rgn.upperLimits[v - 1])
+                limit = rgn.upperLimits[v - 1] + 1;
+            rgn.upperLimits.push_back(limit);
+        }
+
+        const size_t nRoundRobins = rgn.roundRobins.size();
+        rgn.files.resize(nVelocities * nRoundRobins, -1);
+        for (std::map<std::pair<int,int>, size_t>::const_iterator s = slots.begin();
+             s != slots.end(); ++s)
+        {
+            const size_t v = std::find(rgn.velocities.begin(), rgn.velocities.end(),
+                                       s->first.first) - rgn.velocities.begin();
+            const size_t r = std::find(rgn.roundRobins.begin(), rgn.roundRobins.end(),
+                                       s->first.second) - rgn.roundRobins.begin();
+            rgn.files[v * nRoundRobins + r] = int(s->second);
+        }
+        // fill gaps of the round robin cycle with another file of the same layer
+        for (size_t v = 0; v < nVelocities; ++v) {
+            int fallback = -1;
+            for (size_t r = 0; r < nRoundRobins && fallback < 0; ++r)
+                fallback = rgn.files[v * nRoundRobins + r];
+            for (size_t r = 0; r < nRoundRobins; ++r)
+                if (rgn.files[v * nRoundRobins + r] < 0)
+                    rgn.files[v * nRoundRobins + r] = fallback;
+        }
+
+        const int bits = (rgn.stereo ? 1 : 0) + bitsForZones(nVelocities) +
+                         bitsForZones(nRoundRobins);
+        if (bits > 8 && plan.error.empty()) {
+            plan.error = _("Too many velocity layers and round robins for note ") +
+                         note_str(rgn.note) + _(" (a region supports 256 samples at most).");
+        }
+        plan.regions.push_back(rgn);
+    }
+
+    // key ranges reach half way to the neighbour notes
+    for (size_t r = 0; r < plan.regions.size(); ++r) {
+        MappedImportPlan::Region& rgn = plan.regions[r];
+        rgn.low = (r == 0) ? 0 : plan.regions[r - 1].high + 1;
+        rgn.high = (r + 1 == plan.regions.size())
+            ? 127 : (rgn.note + plan.regions[r + 1].note) / 2;
+    }
+    return plan;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// creating the gig objects
+
+SampleConversion setupMappedSample(gig::Sample* sample, const MappedImportFile& file,
+                                   const SampleConversion& conversion)
+{
+    // apply the requested target format, if any
+    const int bitdepth = (conversion.bitDepth) ? conversion.bitDepth : file.bitDepth;
+    const int samplerate =
+        (conversion.sampleRate) ? conversion.sampleRate : file.sampleRate;
+
+    sample->Channels = file.channels;
+    sample->BitDepth = bitdepth;
+    sample->FrameSize = bitdepth / 8/*1 byte are 8 bits*/ * file.channels;
+    sample->SamplesPerSecond = samplerate;
+    sample->AverageBytesPerSecond = sample->FrameSize * sample->SamplesPerSecond;
+    sample->BlockAlign = sample->FrameSize;
+    sample->SamplesTotal =
+        Resampler::outputFrames(file.frames, file.sampleRate, samplerate);
+    // the note from the file name wins over the file's instrument chunk
+    sample->MIDIUnityNote = file.note;
+    sample->FineTune = file.fineTune;
+    if (file.looped) {
+        sample->Loops = 1;
+        sample->LoopType = file.loopType;
+        // loop points scaled to the target sample rate
+        sample->LoopStart = convertFramePosition(
+            file.loopStart, file.sampleRate, samplerate
+        );
+        sample->LoopEnd = convertFramePosition(
+            file.loopEnd + 1, file.sampleRate, samplerate
+        ) - 1;
+        sample->LoopPlayCount = file.loopPlayCount;
+        sample->LoopSize = sample->LoopEnd - sample->LoopStart + 1;
+    }
+
+    // schedule resizing the sample (which will be done physically when
+    // File::Save() is called)
+    sample->Resize(sample->SamplesTotal);
+
+    SampleConversion result = conversion;
+    result.sampleRate = samplerate;
+    result.bitDepth   = bitdepth;
+    return result;
+}
+
+/// Assigns @a sample to @a d like DimRegionEdit::set_sample() does.
+static void assignSample(gig::DimensionRegion* d, gig::Sample* sample) {
+    d->pSample = sample;
+    d->UnityNote = sample->MIDIUnityNote;
+    d->FineTune = sample->FineTune;
+    const int loops = sample->Loops ? 1 : 0;
+    while (d->SampleLoops > loops)
+        d->DeleteSampleLoop(&d->pSampleLoops[0]);
+    while (d->SampleLoops < loops) {
+        DLS::sample_loop_t loop;
+        d->AddSampleLoop(&loop);
+    }
+    if (loops) {
+        d->pSampleLoops[0].Size = sizeof(DLS::sample_loop_t);
+        d->pSampleLoops[0].LoopType = sample->LoopType;
+        d->pSampleLoops[0].LoopStart = sample->LoopStart;
+        d->pSampleLoops[0].LoopLength = sample->LoopEnd - sample->LoopStart + 1;
+    }
+}
+
+gig::Instrument* buildMappedInstrument(gig::File* gig, const MappedImportPlan& plan,
+                                       const std::vector<gig::Sample*>& samples)
+{
+    gig::Instrument* instr = gig->AddInstrument();
+    for (size_t r = 0; r < plan.regions.size(); ++r) {
+        const MappedImportPlan::Region& plannedRgn = plan.regions[r];
+        const int nVelocities = int(plannedRgn.velocities.size());
+        const int nRoundRobins = int(plannedRgn.roundRobins.size());
+
+        gig::Region* rgn = instr->AddRegion();
+        rgn->SetKeyRange(plannedRgn.low, plannedRgn.high);
+        if (plannedRgn.stereo) {
+            gig::dimension_def_t def;
+            def.dimension = gig::dimension_samplechannel;
+            def.bits = 1;
+            def.zones = 2;
+            rgn->AddDimension(&def);
+        }
+        if (nVelocities > 1) {
+            gig::dimension_def_t def;
+            def.dimension = gig::dimension_velocity;
+            def.bits = bitsForZones(nVelocities);
+            def.zones = nVelocities;
+            rgn->AddDimension(&def);
+        }
+        if (nRoundRobins > 1) {
+            gig::dimension_def_t def;
+            def.dimension = gig::dimension_roundrobin;
+            def.bits = bitsForZones(nRoundRobins);
+            def.zones = nRoundRobins;
+            rgn->AddDimension(&def);
+        }
+
+        // bit position of each dimension within the dimension region index
+        int velocityShift = -1, velocityBits = 0, velocityDim = -1;
+        int roundRobinShift = -1, roundRobinBits = 0;
+        int shift = 0;
+        for (int i = 0; i < rgn->Dimensions; ++i) {
+            const gig::dimension_def_t& def = rgn->pDimensionDefinitions[i];
+            if (def.dimension == gig::dimension_velocity) {
+                velocityShift = shift;
+                velocityBits = def.bits;
+                velocityDim = i;
+            } else if (def.dimension == gig::dimension_roundrobin) {
+                roundRobinShift = shift;
+                roundRobinBits = def.bits;
+            }
+            shift += def.bits;
+        }
+
+        for (int i = 0; i < rgn->DimensionRegions; ++i) {
+            gig::DimensionRegion* d = rgn->pDimensionRegions[i];
+            if (!d) continue;
+            const int v = (velocityShift < 0)
+                ? 0 : (i >> velocityShift) & ((1 << velocityBits) - 1);
+            const int rr = (roundRobinShift < 0)
+                ? 0 : (i >> roundRobinShift) & ((1 << roundRobinBits) - 1);
+            // dimension regions of unused zones remain empty
+            if (v >= nVelocities || rr >= nRoundRobins) continue;
+            if (velocityDim >= 0) {
+                d->DimensionUpperLimits[velocityDim] = plannedRgn.upperLimits[v];
+                d->VelocityUpperLimit = plannedRgn.upperLimits[v];
+            }
+            const int file = plannedRgn.files[v * nRoundRobins + rr];
+            gig::Sample* sample = (file >= 0 && file < int(samples.size()))
+                ? samples[file] : NULL;
+            if (sample) assignSample(d, sample);
+        }
+    }
+    return instr;
+}
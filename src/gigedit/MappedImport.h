@@ -0,0 +1,168 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_MAPPEDIMPORT_H
+#define GIGEDIT_MAPPEDIMPORT_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#include "SampleConverter.h"
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+/** @brief Extracts note, velocity and round robin numbers from file names.
+ *
+ * A pattern consists of literal text and the placeholders @c {note},
+ * @c {velocity}, @c {rr} and @c {*}, which are matched against the file name
+ * without extension (case insensitive), e.g. @c "{*}_{note}_v{velocity}"
+ * matches "Piano_C4_v3". A note is either a note name with octave like
+ * "C4", "F#3" or "Db-1" (C4 being MIDI note 60) or a MIDI note number, the
+ * other placeholders match decimal numbers and @c {*} matches any text.
+ *
+ * An empty pattern detects the numbers automatically: the file name is split
+ * into tokens at '_', '-', '.' and spaces, and the first note name token is
+ * taken as note, a token like "v3", "vel3" or a dynamic marking like "mf" as
+ * velocity and a token like "rr2" as round robin number.
+ */
+class MappedImportPattern {
+public:
+    MappedImportPattern(const std::string& pattern = "");
+
+    /// Description of the pattern's syntax error, empty if the pattern is valid.
+    const std::string& error() const { return m_error; }
+
+    /**
+     * Parses @a name and returns false if it does not match the pattern. The
+     * numbers not found in @a name are set to -1.
+     */
+    bool parse(const std::string& name, int& note, int& velocity, int& roundRobin) const;
+
+    /// MIDI note of note name or number @a s, -1 if @a s is not a note.
+    static int parseNote(const std::string& s);
+
+private:
+    enum SegmentType { LITERAL, NOTE, VELOCITY, ROUND_ROBIN, ANY };
+    struct Segment {
+        SegmentType type;
+        std::string text; ///< lower case text of LITERAL segments
+    };
+    std::vector<Segment> m_segments;
+    std::string m_error;
+
+    bool match(const std::string& name, size_t pos, size_t iSegment,
+               int& note, int& velocity, int& roundRobin) const;
+    bool parseTokens(const std::string& name, int& note, int& velocity, int& roundRobin) const;
+};
+
+/**
+ * An audio file found by scanMappedImportFolder().
+ */
+struct MappedImportFile {
+    std::string path;
+    std::string name; ///< file name without extension
+    int note; ///< MIDI note parsed from the file name, -1 if none
+    int velocity; ///< velocity value or layer number parsed from the file name, -1 if none
+    int roundRobin; ///< round robin number parsed from the file name, -1 if none
+
+    // audio format as reported by libsndfile
+    int channels;
+    int sampleRate;
+    int bitDepth; ///< bit depth used in the gig file, see bitDepthOfSoundFileFormat()
+    int64_t frames;
+    int fineTune; ///< from the file's instrument chunk, if any
+    bool looped;
+    gig::loop_type_t loopType;
+    uint32_t loopStart; ///< first frame of the loop
+    uint32_t loopEnd; ///< last frame of the loop
+    uint32_t loopPlayCount;
+
+    std::string error; ///< why the file cannot be imported, empty if it can
+
+    MappedImportFile() :
+        note(-1), velocity(-1), roundRobin(-1), channels(0), sampleRate(0),
+        bitDepth(0), frames(0), fineTune(0), looped(false),
+        loopType(gig::loop_type_normal), loopStart(0), loopEnd(0),
+        loopPlayCount(0) {}
+};
+
+/**
+ * Searches directory @a dir (and its subdirectories if @a recursive is true)
+ * for audio files supported by libsndfile and reads their audio format. The
+ * files are opened on several threads and returned sorted by path.
+ *
+ * @param cancel - optional, the search is aborted as soon as it becomes true
+ * @param progress - optional, called with the fraction done so far
+ * @throws std::string if @a dir cannot be read
+ */
+std::vector<MappedImportFile> scanMappedImportFolder(
+    const std::string& dir, bool recursive,
+    const std::atomic<bool>* cancel = NULL,
+    std::function<void(float)> progress = std::function<void(float)>());
+
+/**
+ * Parses the names of @a files with @a pattern. Cheap enough to be repeated
+ * while the user is editing the pattern, the files do not have to be scanned
+ * again for that.
+ */
+void applyMappedImportPattern(std::vector<MappedImportFile>& files,
+                              const MappedImportPattern& pattern);
+
+/** @brief Regions and dimensions of an instrument built from mapped files.
+ *
+ * Each note found gets a region, whose key range reaches half way to the
+ * neighbour notes (the lowest and highest region are extended to the ends of
+ * the keyboard). Regions get a velocity dimension with one zone per distinct
+ * velocity of their files, a round robin dimension with one zone per distinct
+ * round robin number and a sample channel dimension if one of their files is
+ * stereo.
+ */
+struct MappedImportPlan {
+    struct Region {
+        int low;
+        int high;
+        int note;
+        std::vector<int> velocities; ///< distinct velocity numbers, ascending
+        std::vector<int> upperLimits; ///< upper velocity limit of each velocity zone
+        std::vector<int> roundRobins; ///< distinct round robin numbers, ascending
+        bool stereo;
+        std::vector<int> files; ///< file index of [velocity zone * roundRobins.size() + round robin zone], -1 if none
+    };
+    std::vector<Region> regions;
+    std::vector<size_t> unmapped; ///< files without note or with an error
+    std::vector<size_t> duplicates; ///< files with the same numbers as another file
+    std::string error; ///< why no instrument can be built, empty if it can
+
+    /// Whether the file is referenced by one of the regions.
+    bool isMapped(size_t file) const;
+};
+
+MappedImportPlan planMappedImport(const std::vector<MappedImportFile>& files);
+
+/**
+ * Applies the audio format, tuning and loop of @a file to the new @a sample
+ * and schedules its resize. Returns the format the audio file has to be
+ * converted to by importAudioFile() when the gig file is saved.
+ */
+SampleConversion setupMappedSample(gig::Sample* sample, const MappedImportFile& file,
+                                   const SampleConversion& conversion);
+
+/**
+ * Adds an instrument with the regions and dimensions of @a plan to @a gig.
+ * The dimension regions reference @a samples, one sample per file passed to
+ * planMappedImport() (NULL for files not mapped).
+ */
+gig::Instrument* buildMappedInstrument(gig::File* gig, const MappedImportPlan& plan,
+                                       const std::vector<gig::Sample*>& samples);
+
+#endif // GIGEDIT_MAPPEDIMPORT_H
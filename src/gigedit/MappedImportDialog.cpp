@@ -0,0 +1,297 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "MappedImportDialog.h"
+#include "JobScheduler.h"
+#include "global.h"
+
+#include <glibmm/miscutils.h>
+#if HAS_GTKMM_STOCK
+# include <gtkmm/stock.h>
+#endif
+
+Glib::ustring note_str(int note);
+
+/// Searches a folder for audio files on behalf of MappedImportDialog.
+class MappedImportScanJob : public Job {
+public:
+    MappedImportScanJob(const std::string& folder, bool recursive) :
+        Job(_("Scanning folder for audio files ..."), PRIORITY_HIGH),
+        folder(folder), recursive(recursive)
+    {
+        setOwnProgressDisplay(true);
+    }
+
+    const std::string folder;
+    const bool recursive;
+    std::vector<MappedImportFile> files; ///< result, valid once finished
+
+protected:
+    void run() {
+        files = scanMappedImportFolder(folder, recursive, cancelToken(),
+            [this](float fraction) { setProgress(fraction); }
+        );
+        checkCancelled();
+    }
+};
+
+MappedImportDialog::MappedImportDialog(Gtk::Window& parent, const std::string& folder)
+    : ManagedDialog(_("Create Instrument from Folder"), parent, true),
+      m_folder(folder), m_importRequested(false),
+      m_descriptionLabel(),
+      m_nameLabel(_("Instrument Name:")),
+      m_patternLabel(_("File Name Pattern:")),
+      m_recursiveCheckBox(_("Include Subfolders"), true),
+      m_summaryLabel("", Gtk::ALIGN_START),
+#if HAS_GTKMM_STOCK
+      m_cancelButton(Gtk::Stock::CANCEL),
+#else
+      m_cancelButton(_("_Cancel"), true),
+#endif
+      m_importButton(_("C_reate Instrument"), true)
+{
+    if (!Settings::singleton()->autoRestoreWindowDimension) {
+        set_default_size(600, 500);
+        set_position(Gtk::WIN_POS_MOUSE);
+    }
+
+    m_scrolledWindow.add(m_treeView);
+    m_scrolledWindow.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+
+    m_nameBox.set_spacing(6);
+    m_nameBox.pack_start(m_nameLabel, Gtk::PACK_SHRINK);
+    m_nameBox.pack_start(m_nameEntry);
+    m_patternBox.set_spacing(6);
+    m_patternBox.pack_start(m_patternLabel, Gtk::PACK_SHRINK);
+    m_patternBox.pack_start(m_patternEntry);
+    m_patternBox.pack_start(m_recursiveCheckBox, Gtk::PACK_SHRINK);
+
+#if USE_GTKMM_BOX
+    get_content_area()->pack_start(m_descriptionLabel, Gtk::PACK_SHRINK);
+    get_content_area()->pack_start(m_nameBox, Gtk::PACK_SHRINK);
+    get_content_area()->pack_start(m_patternBox, Gtk::PACK_SHRINK);
+    get_content_area()->pack_start(m_progressBar, Gtk::PACK_SHRINK);
+    get_content_area()->pack_start(m_scrolledWindow);
+    get_content_area()->pack_start(m_summaryLabel, Gtk::PACK_SHRINK);
+    get_content_area()->pack_start(m_buttonBox, Gtk::PACK_SHRINK);
+#else
+    get_vbox()->pack_start(m_descriptionLabel, Gtk::PACK_SHRINK);
+    get_vbox()->pack_start(m_nameBox, Gtk::PACK_SHRINK);
+    get_vbox()->pack_start(m_patternBox, Gtk::PACK_SHRINK);
+    get_vbox()->pack_start(m_progressBar, Gtk::PACK_SHRINK);
+    get_vbox()->pack_start(m_scrolledWindow);
+    get_vbox()->pack_start(m_summaryLabel, Gtk::PACK_SHRINK);
+    get_vbox()->pack_start(m_buttonBox, Gtk::PACK_SHRINK);
+#endif
+
+#if GTKMM_MAJOR_VERSION >= 3
+    m_descriptionLabel.set_line_wrap();
+#endif
+    m_descriptionLabel.set_text(_(
+        "Creates a new instrument from the audio files of the folder. Each note "
+        "gets a region, velocity layers and round robins found in the file "
+        "names become dimensions of the regions. The audio files are imported "
+        "when the gig file is saved."
+    ));
+
+    m_nameEntry.set_text(Glib::filename_display_basename(folder));
+    m_patternEntry.set_text(Settings::singleton()->mappedImportPattern.get_value());
+    m_patternEntry.set_tooltip_text(_(
+        "Leave empty for detecting note names (i.e. C4, F#3), velocities "
+        "(i.e. v3, vel100, mf) and round robins (i.e. rr2) automatically.\n\n"
+        "Otherwise text with the placeholders {note}, {velocity}, {rr} and "
+        "{*} (any text), i.e.\n"
+        "  {*}_{note}_v{velocity}\n"
+        "  {note}-{velocity}-{rr}\n\n"
+        "Notes are either note names or MIDI note numbers, C4 is note 60."
+    ));
+    m_recursiveCheckBox.set_active(Settings::singleton()->mappedImportRecursive);
+
+    m_refListStore = Gtk::ListStore::create(m_columns);
+    m_treeView.set_model(m_refListStore);
+    m_treeView.append_column(_("File"), m_columns.m_col_name);
+    m_treeView.append_column(_("Note"), m_columns.m_col_note);
+    m_treeView.append_column(_("Velocity"), m_columns.m_col_velocity);
+    m_treeView.append_column(_("Round Robin"), m_columns.m_col_round_robin);
+    m_treeView.append_column(_("Status"), m_columns.m_col_status);
+    m_treeView.set_headers_visible(true);
+    m_treeView.get_selection()->set_mode(Gtk::SELECTION_NONE);
+
+    m_buttonBox.set_layout(Gtk::BUTTONBOX_END);
+#if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && GTKMM_MINOR_VERSION > 24)
+    m_buttonBox.set_margin(5);
+#else
+    m_buttonBox.set_border_width(5);
+#endif
+    m_buttonBox.pack_start(m_cancelButton, Gtk::PACK_SHRINK);
+    m_buttonBox.pack_start(m_importButton, Gtk::PACK_SHRINK);
+    m_importButton.set_sensitive(false);
+
+    m_cancelButton.signal_clicked().connect(
+        sigc::mem_fun(*this, &MappedImportDialog::hide)
+    );
+    m_importButton.signal_clicked().connect(
+        sigc::mem_fun(*this, &MappedImportDialog::onImportClicked)
+    );
+    m_patternEntry.signal_changed().connect(
+        sigc::mem_fun(*this, &MappedImportDialog::onPatternChanged)
+    );
+    m_recursiveCheckBox.signal_toggled().connect(
+        sigc::mem_fun(*this, &MappedImportDialog::onRecursiveToggled)
+    );
+
+#if HAS_GTKMM_SHOW_ALL_CHILDREN
+    show_all_children();
+#endif
+
+    launchScan();
+}
+
+MappedImportDialog::~MappedImportDialog() {
+    stopScan();
+}
+
+void MappedImportDialog::launchScan() {
+    stopScan();
+    m_files.clear();
+    m_plan = MappedImportPlan();
+    m_refListStore->clear();
+    m_importButton.set_sensitive(false);
+    m_progressBar.set_fraction(0.f);
+    m_summaryLabel.set_text(_("Searching for audio files ..."));
+
+    m_scanJob.reset(new MappedImportScanJob(m_folder, m_recursiveCheckBox.get_active()));
+    // the job is not referenced by its own signals' slots, and the dialog's
+    // slots are disconnected automatically when the dialog is destroyed
+    m_scanJob->signal_progress().connect(sigc::bind(
+        sigc::mem_fun(*this, &MappedImportDialog::onScanProgress), m_scanJob.get()
+    ));
+    m_scanJob->signal_finished().connect(sigc::bind(
+        sigc::mem_fun(*this, &MappedImportDialog::onScanFinished), m_scanJob.get()
+    ));
+    m_scanJob->signal_error().connect(sigc::bind(
+        sigc::mem_fun(*this, &MappedImportDialog::onScanError), m_scanJob.get()
+    ));
+    JobScheduler::singleton()->submit(m_scanJob);
+}
+
+void MappedImportDialog::stopScan() {
+    if (m_scanJob) m_scanJob->cancel();
+    m_scanJob.reset();
+}
+
+void MappedImportDialog::onScanProgress(MappedImportScanJob* job) {
+    if (job != m_scanJob.get()) return; // outdated scan
+    m_progressBar.set_fraction(job->progress());
+}
+
+void MappedImportDialog::onScanFinished(MappedImportScanJob* job) {
+    if (job != m_scanJob.get()) return; // outdated scan
+    m_progressBar.set_fraction(1.f);
+    m_files = job->files;
+    m_scanJob.reset();
+    updatePreview();
+}
+
+void MappedImportDialog::onScanError(MappedImportScanJob* job) {
+    if (job != m_scanJob.get()) return; // outdated scan
+    m_progressBar.set_fraction(0.f);
+    m_summaryLabel.set_text(job->errorMessage());
+    m_scanJob.reset();
+}
+
+void MappedImportDialog::onPatternChanged() {
+    // still scanning, the preview is updated when the scan finished
+    if (m_scanJob) return;
+    updatePreview();
+}
+
+void MappedImportDialog::onRecursiveToggled() {
+    launchScan();
+}
+
+void MappedImportDialog::updatePreview() {
+    m_refListStore->clear();
+    m_importButton.set_sensitive(false);
+
+    const MappedImportPattern pattern(m_patternEntry.get_text());
+    if (!pattern.error().empty()) {
+        m_plan = MappedImportPlan();
+        m_summaryLabel.set_text(pattern.error());
+        return;
+    }
+    applyMappedImportPattern(m_files, pattern);
+    m_plan = planMappedImport(m_files);
+
+    // region of each mapped file
+    std::vector<int> regionOfFile(m_files.size(), -1);
+    for (size_t r = 0; r < m_plan.regions.size(); ++r) {
+        const MappedImportPlan::Region& rgn = m_plan.regions[r];
+        for (size_t i = 0; i < rgn.files.size(); ++i)
+            if (rgn.files[i] >= 0 && regionOfFile[rgn.files[i]] < 0)
+                regionOfFile[rgn.files[i]] = int(r);
+    }
+    std::vector<bool> isDuplicate(m_files.size(), false);
+    for (size_t i = 0; i < m_plan.duplicates.size(); ++i)
+        isDuplicate[m_plan.duplicates[i]] = true;
+
+    int mapped = 0;
+    for (size_t i = 0; i < m_files.size(); ++i) {
+        const MappedImportFile& file = m_files[i];
+        Gtk::TreeModel::Row row = *m_refListStore->append();
+        row[m_columns.m_col_name] = file.name;
+        row[m_columns.m_col_note] = (file.note >= 0) ? note_str(file.note) : "-";
+        row[m_columns.m_col_velocity] = (file.velocity >= 0) ? ToString(file.velocity) : "-";
+        row[m_columns.m_col_round_robin] = (file.roundRobin >= 0) ? ToString(file.roundRobin) : "-";
+        if (!file.error.empty()) {
+            row[m_columns.m_col_status] = file.error;
+        } else if (file.note < 0) {
+            row[m_columns.m_col_status] = _("no note found in file name");
+        } else if (isDuplicate[i]) {
+            row[m_columns.m_col_status] = _("skipped, same numbers as another file");
+        } else if (regionOfFile[i] >= 0) {
+            const MappedImportPlan::Region& rgn = m_plan.regions[regionOfFile[i]];
+            row[m_columns.m_col_status] = _("Region") + Glib::ustring(" ") +
+                note_str(rgn.low) + " - " + note_str(rgn.high);
+            ++mapped;
+        }
+    }
+
+    if (!m_plan.error.empty()) {
+        m_summaryLabel.set_text(m_plan.error);
+        return;
+    }
+    m_summaryLabel.set_text(
+        ToString(mapped) + " " + _("files mapped to") + " " +
+        ToString(m_plan.regions.size()) + " " + _("regions") + ", " +
+        ToString(m_files.size() - mapped) + " " + _("files skipped") + "."
+    );
+    m_importButton.set_sensitive(true);
+}
+
+void MappedImportDialog::onImportClicked() {
+    Settings::singleton()->mappedImportPattern = m_patternEntry.get_text();
+    Settings::singleton()->mappedImportRecursive = m_recursiveCheckBox.get_active();
+    m_importRequested = true;
+    hide();
+}
+
+bool MappedImportDialog::importRequested() const {
+    return m_importRequested;
+}
+
+const std::vector<MappedImportFile>& MappedImportDialog::files() const {
+    return m_files;
+}
+
+const MappedImportPlan& MappedImportDialog::plan() const {
+    return m_plan;
+}
+
+Glib::ustring MappedImportDialog::instrumentName() const {
+    return m_nameEntry.get_text();
+}
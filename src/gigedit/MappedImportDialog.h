@@ -0,0 +1,113 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_MAPPEDIMPORTDIALOG_H
+#define GIGEDIT_MAPPEDIMPORTDIALOG_H
+
+#include "compat.h"
+
+#include <gtkmm/buttonbox.h>
+#include <gtkmm/checkbutton.h>
+#include <gtkmm/dialog.h>
+#include <gtkmm/entry.h>
+#include <gtkmm/liststore.h>
+#include <gtkmm/progressbar.h>
+#include <gtkmm/scrolledwindow.h>
+#include <gtkmm/treeview.h>
+
+#include "wrapLabel.hh"
+#include "ManagedWindow.h"
+#include "MappedImport.h"
+
+#include <memory>
+
+class MappedImportScanJob;
+
+/** @brief Modal dialog which maps the audio files of a folder to an instrument.
+ *
+ * When shown, this dialog scans the folder for audio files as a background
+ * job and lists the note, velocity and round robin number parsed from each
+ * file's name, updating the list immediately while the user is editing the
+ * file name pattern.
+ *
+ * This dialog does not modify the gig file by itself. If the user clicked on
+ * "Create Instrument", then importRequested() returns true after run()
+ * returned and files() and plan() return what shall be imported by the caller.
+ */
+class MappedImportDialog : public ManagedDialog {
+public:
+    MappedImportDialog(Gtk::Window& parent, const std::string& folder);
+    ~MappedImportDialog();
+    bool importRequested() const;
+    const std::vector<MappedImportFile>& files() const;
+    const MappedImportPlan& plan() const;
+    Glib::ustring instrumentName() const;
+
+    // implementation for abstract methods of interface class "ManagedDialog"
+    virtual Settings::Property<int>* windowSettingX() { return &Settings::singleton()->mappedImportWindowX; }
+    virtual Settings::Property<int>* windowSettingY() { return &Settings::singleton()->mappedImportWindowY; }
+    virtual Settings::Property<int>* windowSettingWidth() { return &Settings::singleton()->mappedImportWindowW; }
+    virtual Settings::Property<int>* windowSettingHeight() { return &Settings::singleton()->mappedImportWindowH; }
+
+protected:
+    std::string m_folder;
+    bool m_importRequested;
+    std::vector<MappedImportFile> m_files;
+    MappedImportPlan m_plan;
+    std::shared_ptr<MappedImportScanJob> m_scanJob;
+
+#if GTKMM_MAJOR_VERSION < 3
+    view::WrapLabel      m_descriptionLabel;
+#else
+    Gtk::Label           m_descriptionLabel;
+#endif
+    HBox                 m_nameBox;
+    Gtk::Label           m_nameLabel;
+    Gtk::Entry           m_nameEntry;
+    HBox                 m_patternBox;
+    Gtk::Label           m_patternLabel;
+    Gtk::Entry           m_patternEntry;
+    Gtk::CheckButton     m_recursiveCheckBox;
+    Gtk::ProgressBar     m_progressBar;
+    Gtk::ScrolledWindow  m_scrolledWindow;
+    Gtk::TreeView        m_treeView;
+    Gtk::Label           m_summaryLabel;
+    HButtonBox           m_buttonBox;
+    Gtk::Button          m_cancelButton;
+    Gtk::Button          m_importButton;
+
+    class FilesModel : public Gtk::TreeModel::ColumnRecord {
+    public:
+        FilesModel() {
+            add(m_col_name);
+            add(m_col_note);
+            add(m_col_velocity);
+            add(m_col_round_robin);
+            add(m_col_status);
+        }
+
+        Gtk::TreeModelColumn<Glib::ustring> m_col_name;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_note;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_velocity;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_round_robin;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_status;
+    } m_columns;
+
+    Glib::RefPtr<Gtk::ListStore> m_refListStore;
+
+    void launchScan();
+    void stopScan();
+    void onScanProgress(MappedImportScanJob* job);
+    void onScanFinished(MappedImportScanJob* job);
+    void onScanError(MappedImportScanJob* job);
+    void onPatternChanged();
+    void onRecursiveToggled();
+    void updatePreview();
+    void onImportClicked();
+};
+
+#endif // GIGEDIT_MAPPEDIMPORTDIALOG_H
@@ -0,0 +1,234 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "NameIndex.h"
+
+#include <glibmm/ustring.h>
+
+#include <ctype.h>
+
+static uint32_t trigramAt(const std::string& s, size_t i) {
+    return (uint32_t(uint8_t(s[i])) << 16) |
+           (uint32_t(uint8_t(s[i+1])) << 8) |
+            uint32_t(uint8_t(s[i+2]));
+}
+
+static std::vector<std::string> tokenize(const std::string& s) {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < s.size()) {
+        while (i < s.size() && isspace((unsigned char)s[i])) ++i;
+        size_t j = i;
+        while (j < s.size() && !isspace((unsigned char)s[j])) ++j;
+        if (j > i) tokens.push_back(s.substr(i, j - i));
+        i = j;
+    }
+    return tokens;
+}
+
+NameIndex::NameIndex() :
+    m_removed(0), m_fuzzy(false), m_resultsValid(false)
+{
+}
+
+std::string NameIndex::fold(const std::string& s) {
+    return Glib::ustring(s).casefold().raw();
+}
+
+void NameIndex::clear() {
+    m_entries.clear();
+    m_removed = 0;
+    m_ids.clear();
+    m_trigrams.clear();
+    m_results.clear();
+    m_hit.clear();
+    m_resultsValid = false;
+}
+
+uint32_t NameIndex::add(const void* object, const std::string& folded) {
+    const uint32_t id = uint32_t(m_entries.size());
+    Entry e = { object, folded, false };
+    m_entries.push_back(e);
+    m_ids[object] = id;
+    for (size_t i = 0; i + 3 <= folded.size(); ++i) {
+        std::vector<uint32_t>& ids = m_trigrams[trigramAt(folded, i)];
+        // ids are added in ascending order, so postings stay sorted
+        if (ids.empty() || ids.back() != id) ids.push_back(id);
+    }
+    return id;
+}
+
+void NameIndex::addToResults(uint32_t id) {
+    if (!m_resultsValid || m_pattern.empty()) return;
+    const Entry& e = m_entries[id];
+    if (m_fuzzy && matchesExact(e)) {
+        // results would switch from fuzzy to exact matching
+        m_resultsValid = false;
+        return;
+    }
+    if (m_fuzzy ? !matchesFuzzy(e) : !matchesExact(e)) return;
+    m_results.push_back(id); // ids are ascending, so results stay sorted
+    if (m_hit.size() <= id) m_hit.resize(id + 1, false);
+    m_hit[id] = true;
+}
+
+void NameIndex::set(const void* object, const std::string& name) {
+    std::string folded = fold(name);
+    std::unordered_map<const void*, uint32_t>::iterator it = m_ids.find(object);
+    if (it != m_ids.end()) {
+        if (m_entries[it->second].folded == folded) return;
+        // renamed: the old entry is left as tombstone in the trigram postings
+        m_entries[it->second].removed = true;
+        ++m_removed;
+    }
+    addToResults(add(object, folded));
+    if (m_removed > 64 && m_removed > m_entries.size() / 2) compact();
+}
+
+void NameIndex::remove(const void* object) {
+    std::unordered_map<const void*, uint32_t>::iterator it = m_ids.find(object);
+    if (it == m_ids.end()) return;
+    m_entries[it->second].removed = true;
+    ++m_removed;
+    m_ids.erase(it);
+    if (m_removed > 64 && m_removed > m_entries.size() / 2) compact();
+}
+
+void NameIndex::compact() {
+    std::vector<Entry> entries;
+    entries.swap(m_entries);
+    m_removed = 0;
+    m_ids.clear();
+    m_trigrams.clear();
+    for (size_t i = 0; i < entries.size(); ++i)
+        if (!entries[i].removed) add(entries[i].object, entries[i].folded);
+    m_results.clear();
+    m_hit.clear();
+    m_resultsValid = false;
+}
+
+bool NameIndex::matchesExact(const Entry& e) const {
+    if (e.removed) return false;
+    for (size_t t = 0; t < m_tokens.size(); ++t)
+        if (e.folded.find(m_tokens[t]) == std::string::npos)
+            return false;
+    return true;
+}
+
+bool NameIndex::matchesFuzzy(const Entry& e) const {
+    if (e.removed) return false;
+    for (size_t t = 0; t < m_tokens.size(); ++t) {
+        const std::string& token = m_tokens[t];
+        size_t pos = 0;
+        for (size_t c = 0; c < token.size(); ++c, ++pos) {
+            pos = e.folded.find(token[c], pos);
+            if (pos == std::string::npos) return false;
+        }
+    }
+    return true;
+}
+
+void NameIndex::searchExact(std::vector<uint32_t>& ids) const {
+    // candidates are the entries of the rarest trigram of all tokens
+    const std::vector<uint32_t>* candidates = NULL;
+    for (size_t t = 0; t < m_tokens.size(); ++t) {
+        const std::string& token = m_tokens[t];
+        for (size_t i = 0; i + 3 <= token.size(); ++i) {
+            std::unordered_map<uint32_t, std::vector<uint32_t> >::const_iterator it =
+                m_trigrams.find(trigramAt(token, i));
+            if (it == m_trigrams.end()) return; // no name contains this token
+            if (!candidates || it->second.size() < candidates->size())
+                candidates = &it->second;
+        }
+    }
+    if (candidates) {
+        for (size_t i = 0; i < candidates->size(); ++i)
+            if (matchesExact(m_entries[(*candidates)[i]]))
+                ids.push_back((*candidates)[i]);
+    } else { // all tokens are shorter than a trigram
+        for (size_t i = 0; i < m_entries.size(); ++i)
+            if (matchesExact(m_entries[i]))
+                ids.push_back(uint32_t(i));
+    }
+}
+
+void NameIndex::searchFuzzy(std::vector<uint32_t>& ids) const {
+    for (size_t i = 0; i < m_entries.size(); ++i)
+        if (matchesFuzzy(m_entries[i]))
+            ids.push_back(uint32_t(i));
+}
+
+void NameIndex::setResults(const std::vector<uint32_t>& ids) {
+    for (size_t i = 0; i < m_results.size(); ++i)
+        if (m_results[i] < m_hit.size()) m_hit[m_results[i]] = false;
+    m_results = ids;
+    if (m_hit.size() < m_entries.size()) m_hit.resize(m_entries.size(), false);
+    for (size_t i = 0; i < m_results.size(); ++i)
+        m_hit[m_results[i]] = true;
+}
+
+void NameIndex::search(const std::string& pattern) {
+    std::vector<std::string> tokens = tokenize(fold(pattern));
+    std::string joined;
+    for (size_t t = 0; t < tokens.size(); ++t)
+        joined += (t ? " " : "") + tokens[t];
+
+    if (m_resultsValid && joined == m_pattern) return;
+
+    // every token of the previous pattern is contained in a token of the new
+    // one, so the new results are a subset of the previous ones
+    const bool narrowing = m_resultsValid && !m_pattern.empty() &&
+                           joined.compare(0, m_pattern.size(), m_pattern) == 0;
+    const std::vector<uint32_t> previous = m_results;
+    const bool wasFuzzy = m_fuzzy;
+
+    m_pattern = joined;
+    m_tokens = tokens;
+    m_fuzzy = false;
+    m_resultsValid = true;
+    std::vector<uint32_t> ids;
+    if (m_tokens.empty()) {
+        setResults(ids);
+        return;
+    }
+
+    if (narrowing && !wasFuzzy) {
+        for (size_t i = 0; i < previous.size(); ++i)
+            if (matchesExact(m_entries[previous[i]]))
+                ids.push_back(previous[i]);
+    } else if (!narrowing) {
+        searchExact(ids);
+    }
+    if (ids.empty()) {
+        // no exact match, so also none if the previous search was fuzzy
+        m_fuzzy = true;
+        if (narrowing && wasFuzzy) {
+            for (size_t i = 0; i < previous.size(); ++i)
+                if (matchesFuzzy(m_entries[previous[i]]))
+                    ids.push_back(previous[i]);
+        } else {
+            searchFuzzy(ids);
+        }
+    }
+    setResults(ids);
+}
+
+bool NameIndex::matches(const void* object) const {
+    if (m_pattern.empty()) return true;
+    std::unordered_map<const void*, uint32_t>::const_iterator it = m_ids.find(object);
+    if (it == m_ids.end()) return false;
+    return it->second < m_hit.size() && m_hit[it->second];
+}
+
+std::vector<const void*> NameIndex::results() const {
+    std::vector<const void*> objects;
+    objects.reserve(m_results.size());
+    for (size_t i = 0; i < m_results.size(); ++i)
+        if (!m_entries[m_results[i]].removed)
+            objects.push_back(m_entries[m_results[i]].object);
+    return objects;
+}
@@ -0,0 +1,88 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_NAMEINDEX_H
+#define GIGEDIT_NAMEINDEX_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/** @brief Search index over the names of arbitrary objects.
+ *
+ * Names are case folded once when they are added, and the byte trigrams of
+ * the folded names are indexed, so a search does not have to fold and scan
+ * every name. A search pattern consists of white space separated tokens, all
+ * of which must be contained in a name for the name to match. If no name
+ * matches that way, the search falls back to fuzzy matching, where the
+ * characters of each token must appear in the name in the same order (i.e.
+ * "pno" matches "Piano").
+ *
+ * A search whose pattern just extends the pattern of the previous search (the
+ * user typed more characters) only narrows the previous results. Objects
+ * added or renamed after a search are checked against its pattern right
+ * away, so the results stay valid without searching again.
+ */
+class NameIndex {
+public:
+    NameIndex();
+
+    void clear();
+    /// Adds @a object with UTF-8 @a name, or renames it if already indexed.
+    void set(const void* object, const std::string& name);
+    void remove(const void* object);
+    bool contains(const void* object) const { return m_ids.count(object); }
+    size_t size() const { return m_ids.size(); }
+
+    /// Updates the results for UTF-8 @a pattern, an empty pattern matches everything.
+    void search(const std::string& pattern);
+    /// Whether @a object matched the last search.
+    bool matches(const void* object) const;
+    /// False if the index was rebuilt since the last search, so search() has to be called again.
+    bool isUpToDate() const { return m_resultsValid; }
+    /// Whether the last search had a non-empty pattern.
+    bool isFiltering() const { return !m_pattern.empty(); }
+    /// Whether the last search had to fall back to fuzzy matching.
+    bool isFuzzy() const { return m_fuzzy; }
+    /// Objects that matched the last search (in the order they were added), empty if not filtering.
+    std::vector<const void*> results() const;
+
+    /// Case folding applied to names and patterns.
+    static std::string fold(const std::string& s);
+
+private:
+    struct Entry {
+        const void* object;
+        std::string folded;
+        bool removed;
+    };
+
+    std::vector<Entry> m_entries;
+    size_t m_removed;
+    std::unordered_map<const void*, uint32_t> m_ids;
+    std::unordered_map<uint32_t, std::vector<uint32_t> > m_trigrams;
+
+    // state of the last search
+    std::string m_pattern; ///< folded tokens joined by single spaces
+    std::vector<std::string> m_tokens;
+    bool m_fuzzy;
+    std::vector<uint32_t> m_results;
+    std::vector<bool> m_hit; ///< m_hit[id] if entry id is in m_results
+    bool m_resultsValid;
+
+    uint32_t add(const void* object, const std::string& folded);
+    void addToResults(uint32_t id);
+    void compact();
+    void setResults(const std::vector<uint32_t>& ids);
+    void searchExact(std::vector<uint32_t>& ids) const;
+    void searchFuzzy(std::vector<uint32_t>& ids) const;
+    bool matchesExact(const Entry& e) const;
+    bool matchesFuzzy(const Entry& e) const;
+};
+
+#endif // GIGEDIT_NAMEINDEX_H
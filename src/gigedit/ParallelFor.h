@@ -0,0 +1,74 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_PARALLELFOR_H
+#define GIGEDIT_PARALLELFOR_H
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <exception>
+
+/**
+ * Returns the amount of worker threads to be used for CPU bound background
+ * tasks by default (that is the amount of CPU cores, at least 1).
+ */
+inline int defaultWorkerThreadCount() {
+    const unsigned int n = std::thread::hardware_concurrency();
+    return (n) ? n : 1;
+}
+
+/** @brief Calls a function for a range of indices on several threads.
+ *
+ * Calls @a fn (i) for all @c i in the range [0, @a n) and distributes those
+ * calls dynamically over up to @a maxThreads worker threads (or over
+ * defaultWorkerThreadCount() threads if @a maxThreads is smaller than 1). This
+ * function blocks until all calls returned. Indices are handed out in
+ * ascending order, so callers should sort their work items by descending cost
+ * to get a good load balance.
+ *
+ * If one of the calls throws an exception, then no further indices are handed
+ * out and the first exception caught is rethrown to the caller of this
+ * function after all worker threads terminated.
+ */
+template<typename Fn>
+void parallelFor(size_t n, const Fn& fn, int maxThreads = -1) {
+    if (!n) return;
+    if (maxThreads < 1) maxThreads = defaultWorkerThreadCount();
+    size_t nThreads = (size_t(maxThreads) < n) ? maxThreads : n;
+
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto worker = [&]() {
+        while (!failed) {
+            const size_t i = next++;
+            if (i >= n) return;
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < nThreads; ++t)
+        threads.push_back(std::thread(worker));
+    worker(); // calling thread participates as well
+    for (size_t t = 0; t < threads.size(); ++t)
+        threads[t].join();
+
+    if (error) std::rethrow_exception(error);
+}
+
+#endif // GIGEDIT_PARALLELFOR_H
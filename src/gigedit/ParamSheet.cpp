@@ -0,0 +1,542 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "ParamSheet.h"
+#include "global.h"
+
+#include <glibmm/main.h>
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+
+Glib::ustring note_str(int note);
+Glib::ustring gig_to_utf8(const gig::String& gig_string);
+
+static const int HEADER_HEIGHT = 24;
+static const int ROW_HEIGHT = 20;
+static const int LABEL_WIDTH = 260;
+static const int COLUMN_WIDTH = 120;
+
+// ParamSheetView
+
+ParamSheetView::ParamSheetView(ParamTable& table) :
+    m_table(table), m_vadjust(NULL), m_hadjust(NULL),
+    m_anchorRow(-1), m_anchorColumn(-1), m_cursorRow(-1), m_cursorColumn(-1),
+    m_selecting(false)
+{
+#if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && GTKMM_MINOR_VERSION > 24)
+# warning GTKMM4 event registration code missing for ParamSheetView!
+    //add_events(Gdk::EventMask::BUTTON_PRESS_MASK);
+#else
+    add_events(Gdk::BUTTON_PRESS_MASK | Gdk::BUTTON_RELEASE_MASK |
+               Gdk::POINTER_MOTION_MASK | Gdk::SCROLL_MASK);
+#endif
+    set_size_request(LABEL_WIDTH + 2 * COLUMN_WIDTH, HEADER_HEIGHT + 5 * ROW_HEIGHT);
+}
+
+void ParamSheetView::set_adjustments(Gtk::Adjustment* vadjust, Gtk::Adjustment* hadjust) {
+    m_vadjust = vadjust;
+    m_hadjust = hadjust;
+    m_vadjust->signal_value_changed().connect(
+        sigc::mem_fun(*this, &ParamSheetView::queue_draw)
+    );
+    m_hadjust->signal_value_changed().connect(
+        sigc::mem_fun(*this, &ParamSheetView::queue_draw)
+    );
+    update_adjustments();
+}
+
+void ParamSheetView::update_adjustments() {
+    if (!m_vadjust || !m_hadjust) return;
+
+    // both adjustments count in units of whole rows and columns
+    const int visibleRows =
+        std::max(1, (get_height() - HEADER_HEIGHT) / ROW_HEIGHT);
+    const int visibleColumns =
+        std::max(1, (get_width() - LABEL_WIDTH) / COLUMN_WIDTH);
+
+    m_vadjust->set_upper(m_table.rowCount());
+    m_vadjust->set_page_size(visibleRows);
+    m_vadjust->set_page_increment(visibleRows);
+    m_vadjust->set_step_increment(1);
+    if (m_vadjust->get_value() > m_vadjust->get_upper() - visibleRows)
+        m_vadjust->set_value(std::max(0.0, m_vadjust->get_upper() - visibleRows));
+
+    m_hadjust->set_upper(m_table.columnCount());
+    m_hadjust->set_page_size(visibleColumns);
+    m_hadjust->set_page_increment(visibleColumns);
+    m_hadjust->set_step_increment(1);
+    if (m_hadjust->get_value() > m_hadjust->get_upper() - visibleColumns)
+        m_hadjust->set_value(std::max(0.0, m_hadjust->get_upper() - visibleColumns));
+}
+
+void ParamSheetView::table_rebuilt() {
+    m_anchorRow = m_anchorColumn = m_cursorRow = m_cursorColumn = -1;
+    m_selecting = false;
+    update_adjustments();
+    queue_draw();
+    m_selectionChanged.emit();
+}
+
+void ParamSheetView::get_selection(size_t& row1, size_t& row2,
+                                   size_t& col1, size_t& col2) const
+{
+    row1 = std::min(m_anchorRow, m_cursorRow);
+    row2 = std::max(m_anchorRow, m_cursorRow);
+    col1 = std::min(m_anchorColumn, m_cursorColumn);
+    col2 = std::max(m_anchorColumn, m_cursorColumn);
+}
+
+void ParamSheetView::on_size_allocate(Gtk::Allocation& allocation) {
+    Gtk::DrawingArea::on_size_allocate(allocation);
+    update_adjustments();
+}
+
+void ParamSheetView::cell_at(double x, double y, int& row, int& column) const {
+    const int firstRow = m_vadjust ? int(m_vadjust->get_value()) : 0;
+    const int firstColumn = m_hadjust ? int(m_hadjust->get_value()) : 0;
+    row = (y < HEADER_HEIGHT) ? -1 :
+        firstRow + int(y - HEADER_HEIGHT) / ROW_HEIGHT;
+    column = (x < LABEL_WIDTH) ? -1 :
+        firstColumn + int(x - LABEL_WIDTH) / COLUMN_WIDTH;
+}
+
+Glib::ustring ParamSheetView::cell_text(size_t row, size_t column) {
+    double value;
+    if (!m_table.value(row, column, value)) return "";
+    if (m_table.column(column).kind == ParamTable::KIND_BOOL)
+        return value ? "on" : "off";
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%g", value);
+    return buf;
+}
+
+Glib::ustring ParamSheetView::row_header_text(size_t row) const {
+    const ParamTable::Row& r = m_table.row(row);
+    return gig_to_utf8(m_table.instrumentName(r.instrument)) + "  " +
+        note_str(r.keyLow) + "-" + note_str(r.keyHigh) +
+        "  #" + ToString(r.index);
+}
+
+#if (GTKMM_MAJOR_VERSION == 2 && GTKMM_MINOR_VERSION < 90) || GTKMM_MAJOR_VERSION < 2
+bool ParamSheetView::on_expose_event(GdkEventExpose* e) {
+    const Cairo::RefPtr<Cairo::Context>& cr =
+        get_window()->create_cairo_context();
+#if 0
+}
+#endif
+#else
+bool ParamSheetView::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
+#endif
+    const int w = get_width();
+    const int h = get_height();
+
+    cr->save();
+    cr->set_line_width(1);
+    cr->set_source_rgb(1, 1, 1);
+    cr->paint();
+
+    const size_t rows = m_table.rowCount();
+    const size_t columns = m_table.columnCount();
+    const size_t firstRow = m_vadjust ? size_t(m_vadjust->get_value()) : 0;
+    const size_t firstColumn = m_hadjust ? size_t(m_hadjust->get_value()) : 0;
+    // only the cells within the widget are ever touched
+    const size_t lastRow = std::min(
+        rows, firstRow + std::max(0, h - HEADER_HEIGHT) / ROW_HEIGHT + 1
+    );
+    const size_t lastColumn = std::min(
+        columns, firstColumn + std::max(0, w - LABEL_WIDTH) / COLUMN_WIDTH + 1
+    );
+
+    size_t selRow1 = 1, selRow2 = 0, selCol1 = 1, selCol2 = 0;
+    if (has_selection()) get_selection(selRow1, selRow2, selCol1, selCol2);
+
+    Glib::RefPtr<Pango::Layout> layout = create_pango_layout("");
+
+    // draws text clipped to the given cell
+    auto drawText = [&](const Glib::ustring& text, int x, int y, int cellWidth) {
+        layout->set_text(text);
+        cr->save();
+        cr->rectangle(x, y, cellWidth - 1, ROW_HEIGHT);
+        cr->clip();
+        cr->set_source_rgb(0, 0, 0);
+        cr->move_to(x + 4, y + 2);
+#if (GTKMM_MAJOR_VERSION == 2 && GTKMM_MINOR_VERSION < 16) || GTKMM_MAJOR_VERSION < 2
+        pango_cairo_show_layout(cr->cobj(), layout->gobj());
+#else
+        layout->show_in_cairo_context(cr);
+#endif
+        cr->restore();
+    };
+
+    // cells
+    for (size_t r = firstRow; r < lastRow; ++r) {
+        const int y = HEADER_HEIGHT + int(r - firstRow) * ROW_HEIGHT;
+        for (size_t c = firstColumn; c < lastColumn; ++c) {
+            const int x = LABEL_WIDTH + int(c - firstColumn) * COLUMN_WIDTH;
+            if (r >= selRow1 && r <= selRow2 && c >= selCol1 && c <= selCol2) {
+                cr->set_source_rgb(0.75, 0.85, 1.0);
+                cr->rectangle(x, y, COLUMN_WIDTH, ROW_HEIGHT);
+                cr->fill();
+            }
+            drawText(cell_text(r, c), x, y, COLUMN_WIDTH);
+        }
+    }
+
+    // row headers
+    cr->set_source_rgb(0.9, 0.9, 0.9);
+    cr->rectangle(0, HEADER_HEIGHT, LABEL_WIDTH, h - HEADER_HEIGHT);
+    cr->fill();
+    for (size_t r = firstRow; r < lastRow; ++r) {
+        const int y = HEADER_HEIGHT + int(r - firstRow) * ROW_HEIGHT;
+        drawText(row_header_text(r), 0, y, LABEL_WIDTH);
+    }
+
+    // column headers
+    cr->set_source_rgb(0.9, 0.9, 0.9);
+    cr->rectangle(0, 0, w, HEADER_HEIGHT);
+    cr->fill();
+    for (size_t c = firstColumn; c < lastColumn; ++c) {
+        const int x = LABEL_WIDTH + int(c - firstColumn) * COLUMN_WIDTH;
+        Glib::ustring text = m_table.column(c).name;
+        if (m_table.sortColumn() == int(c))
+            text += m_table.sortAscending() ? " ▲" : " ▼";
+        drawText(text, x, 2, COLUMN_WIDTH);
+    }
+
+    // grid lines
+    cr->set_source_rgb(0.7, 0.7, 0.7);
+    for (size_t r = firstRow; r <= lastRow; ++r) {
+        const double y = HEADER_HEIGHT + int(r - firstRow) * ROW_HEIGHT - 0.5;
+        cr->move_to(0, y);
+        cr->line_to(w, y);
+    }
+    for (size_t c = firstColumn; c <= lastColumn; ++c) {
+        const double x = LABEL_WIDTH + int(c - firstColumn) * COLUMN_WIDTH - 0.5;
+        cr->move_to(x, 0);
+        cr->line_to(x, h);
+    }
+    cr->stroke();
+
+    cr->restore();
+    return true;
+}
+
+bool ParamSheetView::on_button_press_event(GdkEventButton* event) {
+    if (event->button != 1) return false;
+    grab_focus();
+
+    int row, column;
+    cell_at(event->x, event->y, row, column);
+
+    if (row < 0) { // click on column header sorts
+        if (column >= 0 && column < int(m_table.columnCount())) {
+            const bool ascending = (m_table.sortColumn() == column) ?
+                !m_table.sortAscending() : true;
+            m_table.sort(column, ascending);
+            m_anchorRow = m_anchorColumn = m_cursorRow = m_cursorColumn = -1;
+            queue_draw();
+            m_selectionChanged.emit();
+        }
+        return true;
+    }
+    if (row >= int(m_table.rowCount())) return true;
+
+    if (column < 0) { // click on row header
+        if (event->type == GDK_2BUTTON_PRESS) {
+            m_dimrgnActivated.emit(m_table.row(row).dimrgn);
+            return true;
+        }
+        if (!m_table.columnCount()) return true;
+        if (!(event->state & GDK_SHIFT_MASK) || !has_selection())
+            m_anchorRow = row;
+        m_anchorColumn = 0;
+        m_cursorRow = row;
+        m_cursorColumn = int(m_table.columnCount()) - 1;
+    } else if (column < int(m_table.columnCount())) {
+        if (!(event->state & GDK_SHIFT_MASK) || !has_selection()) {
+            m_anchorRow = row;
+            m_anchorColumn = column;
+        }
+        m_cursorRow = row;
+        m_cursorColumn = column;
+        m_selecting = true;
+    } else {
+        return true;
+    }
+    queue_draw();
+    m_selectionChanged.emit();
+    return true;
+}
+
+bool ParamSheetView::on_button_release_event(GdkEventButton* event) {
+    m_selecting = false;
+    return true;
+}
+
+bool ParamSheetView::on_motion_notify_event(GdkEventMotion* event) {
+    if (!m_selecting) return false;
+    int row, column;
+    cell_at(event->x, event->y, row, column);
+    row = std::max(0, std::min(row, int(m_table.rowCount()) - 1));
+    column = std::max(0, std::min(column, int(m_table.columnCount()) - 1));
+    if (row != m_cursorRow || column != m_cursorColumn) {
+        m_cursorRow = row;
+        m_cursorColumn = column;
+        queue_draw();
+        m_selectionChanged.emit();
+    }
+    return true;
+}
+
+bool ParamSheetView::on_scroll_event(GdkEventScroll* event) {
+    if (!m_vadjust || !m_hadjust) return false;
+    const bool shift = event->state & GDK_SHIFT_MASK;
+    Gtk::Adjustment* adjust = m_vadjust;
+    double delta = 0;
+    switch (event->direction) {
+        case GDK_SCROLL_UP:    delta = -3; if (shift) adjust = m_hadjust; break;
+        case GDK_SCROLL_DOWN:  delta = 3;  if (shift) adjust = m_hadjust; break;
+        case GDK_SCROLL_LEFT:  delta = -1; adjust = m_hadjust; break;
+        case GDK_SCROLL_RIGHT: delta = 1;  adjust = m_hadjust; break;
+        default: return false;
+    }
+    const double max = std::max(0.0, adjust->get_upper() - adjust->get_page_size());
+    adjust->set_value(std::max(0.0, std::min(max, adjust->get_value() + delta)));
+    return true;
+}
+
+// ParamSheet
+
+ParamSheet::ParamSheet() :
+    m_gig(NULL), m_instrument(NULL), m_rebuildScheduled(false),
+    m_scopeLabel(_("Show:")),
+    m_valueLabel(_("Value:")),
+    m_setButton(_("_Set Selected Cells"), true),
+    m_view(m_table),
+#if (GTKMM_MAJOR_VERSION == 2 && GTKMM_MINOR_VERSION < 90) || GTKMM_MAJOR_VERSION < 2
+    m_vadjust(0, 0, 1, 1, 10, 1),
+    m_hadjust(0, 0, 1, 1, 10, 1),
+    m_vscrollbar(m_vadjust),
+    m_hscrollbar(m_hadjust),
+#else
+    m_vadjust(Gtk::Adjustment::create(0, 0, 1, 1, 10, 1)),
+    m_hadjust(Gtk::Adjustment::create(0, 0, 1, 1, 10, 1)),
+# if USE_GTKMM_BOX
+    m_vscrollbar(m_vadjust, Gtk::Orientation::VERTICAL),
+    m_hscrollbar(m_hadjust, Gtk::Orientation::HORIZONTAL),
+# else
+    m_vscrollbar(m_vadjust, Gtk::ORIENTATION_VERTICAL),
+    m_hscrollbar(m_hadjust, Gtk::ORIENTATION_HORIZONTAL),
+# endif
+#endif
+    m_statusLabel("", Gtk::ALIGN_START)
+{
+    if (!Settings::singleton()->autoRestoreWindowDimension) {
+        set_default_size(900, 500);
+        set_position(Gtk::WIN_POS_CENTER);
+    }
+
+    set_title(_("Parameter Sheet"));
+#if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && GTKMM_MINOR_VERSION > 24)
+    set_margin(6);
+#else
+    set_border_width(6);
+#endif
+
+    add(m_vbox);
+    m_vbox.set_spacing(6);
+
+    const char* scopes[] = { _("Selected Instrument"), _("All Instruments"), 0 };
+    for (int i = 0; scopes[i]; i++) {
+#if (GTKMM_MAJOR_VERSION == 2 && GTKMM_MINOR_VERSION < 24) || GTKMM_MAJOR_VERSION < 2
+        m_scopeCombo.append_text(scopes[i]);
+#else
+        m_scopeCombo.append(scopes[i]);
+#endif
+    }
+    m_scopeCombo.set_active(0);
+
+    m_toolbar.set_spacing(6);
+    m_toolbar.pack_start(m_scopeLabel, Gtk::PACK_SHRINK);
+    m_toolbar.pack_start(m_scopeCombo, Gtk::PACK_SHRINK);
+    m_toolbar.pack_start(m_valueLabel, Gtk::PACK_SHRINK);
+    m_toolbar.pack_start(m_valueEntry, Gtk::PACK_SHRINK);
+    m_toolbar.pack_start(m_setButton, Gtk::PACK_SHRINK);
+    m_vbox.pack_start(m_toolbar, Gtk::PACK_SHRINK);
+
+    m_view.set_adjustments(
+#if (GTKMM_MAJOR_VERSION == 2 && GTKMM_MINOR_VERSION < 90) || GTKMM_MAJOR_VERSION < 2
+        &m_vadjust, &m_hadjust
+#else
+        m_vadjust.operator->(), m_hadjust.operator->()
+#endif
+    );
+    m_viewBox.pack_start(m_view);
+    m_viewBox.pack_start(m_vscrollbar, Gtk::PACK_SHRINK);
+    m_vbox.pack_start(m_viewBox);
+    m_vbox.pack_start(m_hscrollbar, Gtk::PACK_SHRINK);
+    m_vbox.pack_start(m_statusLabel, Gtk::PACK_SHRINK);
+
+    m_valueEntry.set_tooltip_text(_(
+        "Numeric value (or on/off) to be assigned to all selected cells."
+    ));
+    m_setButton.set_sensitive(false);
+
+    m_scopeCombo.signal_changed().connect(
+        sigc::mem_fun(*this, &ParamSheet::on_scope_changed)
+    );
+    m_setButton.signal_clicked().connect(
+        sigc::mem_fun(*this, &ParamSheet::on_set_clicked)
+    );
+    m_valueEntry.signal_activate().connect(
+        sigc::mem_fun(*this, &ParamSheet::on_set_clicked)
+    );
+    m_view.signal_selection_changed().connect(
+        sigc::mem_fun(*this, &ParamSheet::update_status)
+    );
+    signal_show().connect(
+        sigc::mem_fun(*this, &ParamSheet::on_shown)
+    );
+    signal_hide().connect(
+        sigc::mem_fun(*this, &ParamSheet::on_hidden)
+    );
+
+#if HAS_GTKMM_SHOW_ALL_CHILDREN
+    show_all_children();
+#endif
+}
+
+void ParamSheet::set_file(gig::File* gig, gig::Instrument* instrument) {
+    const bool allInstruments = m_scopeCombo.get_active_row_number() == 1;
+    if (gig == m_gig && (allInstruments || instrument == m_instrument)) {
+        m_instrument = instrument;
+        return;
+    }
+    m_gig = gig;
+    m_instrument = instrument;
+    if (!gig) {
+        // the file is about to be closed, so never touch it again
+        m_table.clear();
+        m_view.table_rebuilt();
+        return;
+    }
+    schedule_rebuild();
+}
+
+void ParamSheet::schedule_rebuild() {
+    if (m_rebuildScheduled || !get_visible()) return;
+    m_rebuildScheduled = true;
+    Glib::signal_idle().connect_once(
+        sigc::mem_fun(*this, &ParamSheet::rebuild)
+    );
+}
+
+void ParamSheet::rebuild() {
+    m_rebuildScheduled = false;
+    if (!get_visible()) return;
+    const bool allInstruments = m_scopeCombo.get_active_row_number() == 1;
+    if (allInstruments || m_instrument)
+        m_table.build(m_gig, allInstruments ? NULL : m_instrument);
+    else
+        m_table.clear();
+    m_view.table_rebuilt();
+}
+
+void ParamSheet::update_status() {
+    Glib::ustring text = ToString(m_table.rowCount()) + " " +
+        _("dimension regions");
+    if (m_view.has_selection()) {
+        size_t row1, row2, col1, col2;
+        m_view.get_selection(row1, row2, col1, col2);
+        text += ", " + ToString((row2 - row1 + 1) * (col2 - col1 + 1)) + " " +
+            _("cells selected");
+    }
+    m_statusLabel.set_text(text);
+    m_setButton.set_sensitive(m_view.has_selection() && !m_table.isStale());
+}
+
+void ParamSheet::on_scope_changed() {
+    schedule_rebuild();
+}
+
+void ParamSheet::on_set_clicked() {
+    if (!m_view.has_selection() || m_table.isStale()) return;
+
+    const Glib::ustring text = m_valueEntry.get_text().lowercase();
+    double value;
+    if (text == "on" || text == "true" || text == "yes") {
+        value = 1;
+    } else if (text == "off" || text == "false" || text == "no") {
+        value = 0;
+    } else {
+        char* end;
+        value = g_ascii_strtod(text.c_str(), &end);
+        if (end == text.c_str()) return;
+    }
+
+    size_t row1, row2, col1, col2;
+    m_view.get_selection(row1, row2, col1, col2);
+
+    // one patch per selected column, applied to all selected rows at once
+    CompiledMacro macro;
+    for (size_t c = col1; c <= col2; ++c) {
+        if (!m_table.accepts(c, value)) {
+            m_statusLabel.set_text(
+                Glib::ustring(_("Invalid value for")) + " " +
+                m_table.column(c).name
+            );
+            return;
+        }
+        uint8_t buf[8];
+        m_table.encode(c, value, buf);
+        macro.addPatch(m_table.column(c).offset, m_table.column(c).size, buf);
+    }
+    std::set<gig::DimensionRegion*> dimrgns;
+    for (size_t r = row1; r <= row2; ++r)
+        dimrgns.insert(m_table.row(r).dimrgn);
+
+    m_apply.emit(macro, dimrgns);
+}
+
+void ParamSheet::on_shown() {
+    schedule_rebuild();
+}
+
+void ParamSheet::on_hidden() {
+    // do not keep a snapshot of a huge file around while not being shown
+    m_table.clear();
+    m_view.table_rebuilt();
+}
+
+void ParamSheet::dimrgn_changed(gig::DimensionRegion* dimrgn) {
+    if (!m_table.rowCount() || m_table.isStale()) return;
+    if (m_table.update(dimrgn)) m_view.queue_draw();
+}
+
+void ParamSheet::region_changed(gig::Region* rgn) {
+    if (!m_table.rowCount()) return;
+    if (m_table.isStale()) {
+        schedule_rebuild();
+    } else if (m_table.updateRegion(rgn)) {
+        m_view.queue_draw();
+    } else {
+        // the dimension regions of the region were replaced
+        m_table.setStale(true);
+        schedule_rebuild();
+    }
+    update_status();
+}
+
+void ParamSheet::file_structure_to_be_changed() {
+    m_table.setStale(true);
+    update_status();
+}
+
+void ParamSheet::file_structure_changed() {
+    if (m_table.rowCount() || get_visible()) schedule_rebuild();
+}
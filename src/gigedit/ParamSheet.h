@@ -0,0 +1,159 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_PARAMSHEET_H
+#define GIGEDIT_PARAMSHEET_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#include "compat.h"
+
+#include <gtkmm/drawingarea.h>
+#include <gtkmm/adjustment.h>
+#include <gtkmm/scrollbar.h>
+#include <gtkmm/comboboxtext.h>
+#include <gtkmm/entry.h>
+#include <gtkmm/button.h>
+#include <gtkmm/label.h>
+
+#include "ManagedWindow.h"
+#include "ParamTable.h"
+#include "CompiledMacro.h"
+
+#include <set>
+
+/** @brief Virtualized grid showing a ParamTable.
+ *
+ * Only the cells currently visible are rendered, so the grid stays smooth
+ * regardless of the amount of rows. The rows and columns are scrolled by two
+ * adjustments in units of rows and columns, respectively. Clicking on a
+ * column's header sorts the rows by that column, and a rectangular block of
+ * cells can be selected by dragging or shift + click.
+ */
+class ParamSheetView : public Gtk::DrawingArea {
+public:
+    ParamSheetView(ParamTable& table);
+
+    void set_adjustments(Gtk::Adjustment* vadjust, Gtk::Adjustment* hadjust);
+
+    /// Call after the table was rebuilt, resets scroll position and selection.
+    void table_rebuilt();
+
+    /// Whether a block of cells is selected.
+    bool has_selection() const { return m_anchorRow >= 0; }
+    /// Rows (positions in sort order) and columns of the selected block.
+    void get_selection(size_t& row1, size_t& row2, size_t& col1, size_t& col2) const;
+
+    sigc::signal<void>& signal_selection_changed() { return m_selectionChanged; }
+    /// Emitted when the user double clicked on the header of a row.
+    sigc::signal<void, gig::DimensionRegion*>& signal_dimrgn_activated() { return m_dimrgnActivated; }
+
+protected:
+#if (GTKMM_MAJOR_VERSION == 2 && GTKMM_MINOR_VERSION < 90) || GTKMM_MAJOR_VERSION < 2
+    virtual bool on_expose_event(GdkEventExpose* e);
+#else
+    virtual bool on_draw(const Cairo::RefPtr<Cairo::Context>& cr);
+#endif
+    virtual bool on_button_press_event(GdkEventButton* event);
+    virtual bool on_button_release_event(GdkEventButton* event);
+    virtual bool on_motion_notify_event(GdkEventMotion* event);
+    virtual bool on_scroll_event(GdkEventScroll* event);
+    virtual void on_size_allocate(Gtk::Allocation& allocation);
+
+    ParamTable& m_table;
+    Gtk::Adjustment* m_vadjust;
+    Gtk::Adjustment* m_hadjust;
+    int m_anchorRow, m_anchorColumn; ///< cell where selecting started (-1: none)
+    int m_cursorRow, m_cursorColumn; ///< cell where selecting ended
+    bool m_selecting;
+    sigc::signal<void> m_selectionChanged;
+    sigc::signal<void, gig::DimensionRegion*> m_dimrgnActivated;
+
+    void update_adjustments();
+    /// Cell at widget coordinates, row or column is -1 on headers.
+    void cell_at(double x, double y, int& row, int& column) const;
+    Glib::ustring cell_text(size_t row, size_t column);
+    Glib::ustring row_header_text(size_t row) const;
+};
+
+/** @brief Spreadsheet of the parameters of all dimension regions.
+ *
+ * Shows one row per dimension region of the selected instrument (or of all
+ * instruments) and one column per parameter. The content is a columnar
+ * snapshot (see ParamTable), which is updated incrementally by the
+ * dimension region and region change notifications while the window is
+ * shown. A value entered by the user is applied to all selected cells at
+ * once by the same compiled patch path used for macros, see
+ * signal_apply().
+ */
+class ParamSheet : public ManagedWindow {
+public:
+    ParamSheet();
+
+    /// The file and instrument (i.e. currently selected one) to be shown.
+    void set_file(gig::File* gig, gig::Instrument* instrument);
+
+    // notifications by the main window
+    void dimrgn_changed(gig::DimensionRegion* dimrgn);
+    void region_changed(gig::Region* rgn);
+    void file_structure_to_be_changed();
+    void file_structure_changed();
+
+    /// The user wants @a macro to be applied to @a dimrgns.
+    sigc::signal<void, const CompiledMacro&, const std::set<gig::DimensionRegion*>&>& signal_apply() { return m_apply; }
+    /// The user wants to edit @a dimrgn in the main window.
+    sigc::signal<void, gig::DimensionRegion*>& signal_dimrgn_activated() { return m_view.signal_dimrgn_activated(); }
+
+    // implementation for abstract methods of interface class "ManagedWindow"
+    virtual Settings::Property<int>* windowSettingX() { return &Settings::singleton()->paramSheetWindowX; }
+    virtual Settings::Property<int>* windowSettingY() { return &Settings::singleton()->paramSheetWindowY; }
+    virtual Settings::Property<int>* windowSettingWidth() { return &Settings::singleton()->paramSheetWindowW; }
+    virtual Settings::Property<int>* windowSettingHeight() { return &Settings::singleton()->paramSheetWindowH; }
+
+protected:
+    gig::File* m_gig;
+    gig::Instrument* m_instrument;
+    ParamTable m_table;
+    bool m_rebuildScheduled;
+    sigc::signal<void, const CompiledMacro&, const std::set<gig::DimensionRegion*>&> m_apply;
+
+    VBox m_vbox;
+    HBox m_toolbar;
+    Gtk::Label m_scopeLabel;
+    Gtk::ComboBoxText m_scopeCombo;
+    Gtk::Label m_valueLabel;
+    Gtk::Entry m_valueEntry;
+    Gtk::Button m_setButton;
+    HBox m_viewBox;
+    ParamSheetView m_view;
+#if (GTKMM_MAJOR_VERSION == 2 && GTKMM_MINOR_VERSION < 90) || GTKMM_MAJOR_VERSION < 2
+    Gtk::Adjustment m_vadjust;
+    Gtk::Adjustment m_hadjust;
+    Gtk::VScrollbar m_vscrollbar;
+    Gtk::HScrollbar m_hscrollbar;
+#else
+    Glib::RefPtr<Gtk::Adjustment> m_vadjust;
+    Glib::RefPtr<Gtk::Adjustment> m_hadjust;
+    Gtk::Scrollbar m_vscrollbar;
+    Gtk::Scrollbar m_hscrollbar;
+#endif
+    Gtk::Label m_statusLabel;
+
+    void rebuild();
+    void schedule_rebuild();
+    void update_status();
+    void on_scope_changed();
+    void on_set_clicked();
+    void on_shown();
+    void on_hidden();
+};
+
+#endif // GIGEDIT_PARAMSHEET_H
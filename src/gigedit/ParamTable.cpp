@@ -0,0 +1,290 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "ParamTable.h"
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(Serialization.h)
+#else
+# include <Serialization.h>
+#endif
+
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+template<typename T>
+T readAs(const uint8_t* p) {
+    T value;
+    memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+template<typename T>
+void writeAs(uint8_t* dst, double value) {
+    // clamp, so that i.e. entering 300 for an 8 bit parameter does not wrap
+    if (std::numeric_limits<T>::is_integer) {
+        value = round(value);
+        value = std::max(value, double(std::numeric_limits<T>::min()));
+        value = std::min(value, double(std::numeric_limits<T>::max()));
+    }
+    const T v = T(value);
+    memcpy(dst, &v, sizeof(T));
+}
+
+void addColumns(Serialization::Archive& archive, const Serialization::Object& obj,
+                const std::string& prefix, const gig::DimensionRegion* layout,
+                std::vector<ParamTable::Column>& columns)
+{
+    for (size_t i = 0; i < obj.members().size(); ++i) {
+        const Serialization::Member& member = obj.members()[i];
+        const Serialization::DataType& type = member.type();
+        if (type.isPointer()) continue;
+
+        const Serialization::Object& memberObject = archive.objectByUID(member.uid());
+        if (!memberObject) continue;
+
+        if (type.isClass()) {
+            addColumns(archive, memberObject, prefix + member.name() + ".",
+                       layout, columns);
+            continue;
+        }
+
+        // the archive was created from 'layout', so its UIDs are the memory
+        // addresses of the respective fields of 'layout'
+        const uint8_t* addr = (const uint8_t*) member.uid().id;
+        const uint8_t* base = (const uint8_t*) layout;
+        if (addr < base || addr + type.size() > base + sizeof(gig::DimensionRegion))
+            continue;
+
+        ParamTable::Column column;
+        column.name = prefix + member.name();
+        column.offset = addr - base;
+        column.size = type.size();
+        const size_t n = column.size;
+        if (type.isBool() && n == sizeof(bool)) {
+            column.kind = ParamTable::KIND_BOOL;
+        } else if (type.isReal() && (n == sizeof(float) || n == sizeof(double))) {
+            column.kind = ParamTable::KIND_REAL;
+        } else if ((type.isInteger() || type.isEnum()) &&
+                   (n == 1 || n == 2 || n == 4 || n == 8)) {
+            column.kind = type.isSigned() ?
+                ParamTable::KIND_SIGNED : ParamTable::KIND_UNSIGNED;
+            if (type.isEnum()) column.enumType = type.customTypeName();
+        } else {
+            continue; // i.e. strings
+        }
+        columns.push_back(column);
+    }
+}
+
+} // namespace
+
+ParamTable::ParamTable() :
+    m_sortColumn(-1), m_sortAscending(true), m_stale(false)
+{
+}
+
+void ParamTable::clear() {
+    m_rows.clear();
+    m_order.clear();
+    m_values.clear();
+    m_rowOf.clear();
+    m_rowsOf.clear();
+    m_instrumentNames.clear();
+    m_sortColumn = -1;
+    m_sortAscending = true;
+    m_stale = false;
+}
+
+void ParamTable::buildColumns(gig::DimensionRegion* layout) {
+    m_columns.clear();
+    Serialization::Archive archive;
+    archive.serialize(layout);
+    const Serialization::Object& root = archive.rootObject();
+    if (root) addColumns(archive, root, "", layout, m_columns);
+}
+
+void ParamTable::build(gig::File* gig, gig::Instrument* instr) {
+    clear();
+    if (!gig) return;
+
+    int i = 0;
+    for (gig::Instrument* instrument = gig->GetFirstInstrument(); instrument;
+         instrument = gig->GetNextInstrument(), ++i)
+    {
+        m_instrumentNames.push_back(instrument->pInfo->Name);
+        if (instr && instrument != instr) continue;
+        for (gig::Region* rgn = instrument->GetFirstRegion(); rgn;
+             rgn = instrument->GetNextRegion())
+        {
+            std::vector<size_t>& rows = m_rowsOf[rgn];
+            for (int k = 0; k < int(rgn->DimensionRegions); ++k) {
+                Row row;
+                row.dimrgn = rgn->pDimensionRegions[k];
+                row.region = rgn;
+                row.instrument = i;
+                row.keyLow = rgn->KeyRange.low;
+                row.keyHigh = rgn->KeyRange.high;
+                row.index = k;
+                m_rowOf[row.dimrgn] = m_rows.size();
+                rows.push_back(m_rows.size());
+                m_rows.push_back(row);
+            }
+        }
+    }
+
+    // the layout of gig::DimensionRegion is the same for all of them
+    if (m_columns.empty() && !m_rows.empty())
+        buildColumns(m_rows[0].dimrgn);
+
+    m_order.resize(m_rows.size());
+    for (size_t r = 0; r < m_order.size(); ++r) m_order[r] = r;
+    m_values.resize(m_columns.size());
+}
+
+double ParamTable::read(size_t c, const gig::DimensionRegion* dimrgn) const {
+    const Column& column = m_columns[c];
+    const uint8_t* p = (const uint8_t*) dimrgn + column.offset;
+    switch (column.kind) {
+        case KIND_BOOL:
+            return readAs<bool>(p) ? 1.0 : 0.0;
+        case KIND_REAL:
+            return (column.size == sizeof(float)) ?
+                double(readAs<float>(p)) : readAs<double>(p);
+        case KIND_SIGNED:
+            switch (column.size) {
+                case 1: return readAs<int8_t>(p);
+                case 2: return readAs<int16_t>(p);
+                case 4: return readAs<int32_t>(p);
+                default: return double(readAs<int64_t>(p));
+            }
+        case KIND_UNSIGNED:
+            switch (column.size) {
+                case 1: return readAs<uint8_t>(p);
+                case 2: return readAs<uint16_t>(p);
+                case 4: return readAs<uint32_t>(p);
+                default: return double(readAs<uint64_t>(p));
+            }
+    }
+    return 0.0;
+}
+
+void ParamTable::encode(size_t c, double value, uint8_t* dst) const {
+    const Column& column = m_columns[c];
+    memset(dst, 0, 8);
+    switch (column.kind) {
+        case KIND_BOOL: {
+            const bool b = (value != 0.0);
+            memcpy(dst, &b, sizeof(bool));
+            break;
+        }
+        case KIND_REAL:
+            if (column.size == sizeof(float)) writeAs<float>(dst, value);
+            else writeAs<double>(dst, value);
+            break;
+        case KIND_SIGNED:
+            switch (column.size) {
+                case 1: writeAs<int8_t>(dst, value); break;
+                case 2: writeAs<int16_t>(dst, value); break;
+                case 4: writeAs<int32_t>(dst, value); break;
+                default: writeAs<int64_t>(dst, value); break;
+            }
+            break;
+        case KIND_UNSIGNED:
+            switch (column.size) {
+                case 1: writeAs<uint8_t>(dst, value); break;
+                case 2: writeAs<uint16_t>(dst, value); break;
+                case 4: writeAs<uint32_t>(dst, value); break;
+                default: writeAs<uint64_t>(dst, value); break;
+            }
+            break;
+    }
+}
+
+bool ParamTable::accepts(size_t c, double value) const {
+    const Column& column = m_columns[c];
+    if (column.enumType.empty()) return true;
+    return value >= 0 && value == floor(value) &&
+           gig::enumKey(column.enumType, size_t(value));
+}
+
+const std::vector<double>* ParamTable::columnValues(size_t c) {
+    std::vector<double>& values = m_values[c];
+    if (values.size() != m_rows.size()) {
+        if (m_stale) return NULL;
+        values.resize(m_rows.size());
+        for (size_t r = 0; r < m_rows.size(); ++r)
+            values[r] = read(c, m_rows[r].dimrgn);
+    }
+    return &values;
+}
+
+long ParamTable::rowOf(gig::DimensionRegion* dimrgn) const {
+    std::map<gig::DimensionRegion*, size_t>::const_iterator it = m_rowOf.find(dimrgn);
+    return (it != m_rowOf.end()) ? long(it->second) : -1;
+}
+
+int ParamTable::findColumn(const std::string& name) const {
+    for (size_t c = 0; c < m_columns.size(); ++c)
+        if (!strcasecmp(m_columns[c].name.c_str(), name.c_str()))
+            return int(c);
+    return -1;
+}
+
+bool ParamTable::value(size_t r, size_t c, double& value) {
+    const std::vector<double>* values = columnValues(c);
+    if (!values) return false;
+    value = (*values)[m_order[r]];
+    return true;
+}
+
+void ParamTable::sort(int c, bool ascending) {
+    if (c < 0 || c >= int(m_columns.size())) return;
+    const std::vector<double>* values = columnValues(c);
+    if (!values) return;
+    const std::vector<double>& v = *values;
+    if (ascending) {
+        std::stable_sort(m_order.begin(), m_order.end(),
+                         [&v](size_t a, size_t b) { return v[a] < v[b]; });
+    } else {
+        std::stable_sort(m_order.begin(), m_order.end(),
+                         [&v](size_t a, size_t b) { return v[a] > v[b]; });
+    }
+    m_sortColumn = c;
+    m_sortAscending = ascending;
+}
+
+bool ParamTable::update(gig::DimensionRegion* dimrgn) {
+    std::map<gig::DimensionRegion*, size_t>::const_iterator it = m_rowOf.find(dimrgn);
+    if (it == m_rowOf.end()) return false;
+    for (size_t c = 0; c < m_values.size(); ++c)
+        if (m_values[c].size() == m_rows.size())
+            m_values[c][it->second] = read(c, dimrgn);
+    return true;
+}
+
+bool ParamTable::updateRegion(gig::Region* rgn) {
+    std::map<gig::Region*, std::vector<size_t> >::const_iterator it = m_rowsOf.find(rgn);
+    if (it == m_rowsOf.end()) return true;
+    const std::vector<size_t>& rows = it->second;
+    if (rows.size() != rgn->DimensionRegions) return false;
+    for (size_t k = 0; k < rows.size(); ++k)
+        if (m_rows[rows[k]].dimrgn != rgn->pDimensionRegions[k]) return false;
+
+    for (size_t k = 0; k < rows.size(); ++k) {
+        Row& row = m_rows[rows[k]];
+        row.keyLow = rgn->KeyRange.low;
+        row.keyHigh = rgn->KeyRange.high;
+        update(row.dimrgn);
+    }
+    return true;
+}
@@ -0,0 +1,160 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_PARAMTABLE_H
+#define GIGEDIT_PARAMTABLE_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/** @brief Columnar snapshot of the parameters of many dimension regions.
+ *
+ * Each row of the table is one dimension region, each column one primitive
+ * parameter (number, bool or enum) of gig::DimensionRegion. The columns are
+ * derived once from the serialized layout of gig::DimensionRegion, so the
+ * table covers every parameter libgig serializes.
+ *
+ * The values of a column are read from the dimension regions only when the
+ * column is accessed for the first time, and are cached as one contiguous
+ * array per column afterwards. So sorting by a column, or showing a few cells
+ * of it, does not touch any other column. When a dimension region was
+ * modified, update() just refreshes the cached values of its row.
+ *
+ * The table never accesses a dimension region while being stale (see
+ * setStale()), so it can still be shown while dimension regions are deleted.
+ */
+class ParamTable {
+public:
+    enum Kind {
+        KIND_SIGNED,
+        KIND_UNSIGNED,
+        KIND_REAL,
+        KIND_BOOL
+    };
+
+    struct Column {
+        std::string name; ///< i.e. "EG1Release" or "DimensionUpperLimits.0"
+        size_t offset; ///< byte offset of the parameter within gig::DimensionRegion
+        size_t size; ///< size of the parameter in bytes
+        Kind kind;
+        std::string enumType; ///< type name of enum parameters, empty for other parameters
+    };
+
+    struct Row {
+        gig::DimensionRegion* dimrgn;
+        gig::Region* region;
+        int instrument; ///< index of the instrument within the gig file
+        uint16_t keyLow; ///< key range of the region
+        uint16_t keyHigh;
+        int index; ///< index of the dimension region within the region
+    };
+
+    ParamTable();
+
+    /**
+     * Takes a new snapshot with one row for each dimension region of
+     * instrument @a instr, or of all instruments of @a gig if @a instr is
+     * NULL. Clears the sort order.
+     */
+    void build(gig::File* gig, gig::Instrument* instr);
+    void clear();
+
+    size_t rowCount() const { return m_rows.size(); }
+    size_t columnCount() const { return m_columns.size(); }
+    const Column& column(size_t c) const { return m_columns[c]; }
+
+    /// Row shown at position @a r (in current sort order).
+    const Row& row(size_t r) const { return m_rows[m_order[r]]; }
+
+    /// Row with index @a i in the order the table was built (not sorted).
+    const Row& rowAt(size_t i) const { return m_rows[i]; }
+
+    /// Index of the row (in build order) of @a dimrgn, -1 if not in the table.
+    long rowOf(gig::DimensionRegion* dimrgn) const;
+
+    /// Index of the column named @a name (case insensitive), -1 if unknown.
+    int findColumn(const std::string& name) const;
+
+    /// Name of the instrument with index @a i in the gig file.
+    const std::string& instrumentName(int i) const { return m_instrumentNames[i]; }
+
+    /**
+     * Value of column @a c of the row shown at position @a r. Returns false
+     * if the value is not known, because the column was not read yet and the
+     * table is stale.
+     */
+    bool value(size_t r, size_t c, double& value);
+
+    /**
+     * All values of column @a c in build order (see rowAt()), read on first
+     * access. Returns NULL if the column was not read yet and the table is
+     * stale.
+     */
+    const std::vector<double>* columnValues(size_t c);
+
+    /// Sorts the rows by the values of column @a c (stable).
+    void sort(int c, bool ascending);
+    int sortColumn() const { return m_sortColumn; }
+    bool sortAscending() const { return m_sortAscending; }
+
+    /**
+     * Re-reads the cached values of dimension region @a dimrgn. Returns false
+     * if @a dimrgn is not part of the table.
+     */
+    bool update(gig::DimensionRegion* dimrgn);
+
+    /**
+     * Re-reads the cached values of all dimension regions of region @a rgn.
+     * Returns false if the dimension regions of @a rgn changed since the
+     * table was built, in which case the table has to be rebuilt.
+     */
+    bool updateRegion(gig::Region* rgn);
+
+    /// While stale, the table does not access any dimension region.
+    void setStale(bool stale) { m_stale = stale; }
+    bool isStale() const { return m_stale; }
+
+    /**
+     * Encodes @a value in the native memory representation of column @a c.
+     * @a dst must have room for 8 bytes.
+     */
+    void encode(size_t c, double value, uint8_t* dst) const;
+
+    /**
+     * Whether @a value is valid for column @a c, that is for enum parameters
+     * whether it is one of the enum's values. Any value is accepted by the
+     * other columns, encode() clamps it to the parameter's range instead.
+     */
+    bool accepts(size_t c, double value) const;
+
+    /// Reads the value of column @a c directly from dimension region @a dimrgn.
+    double read(size_t c, const gig::DimensionRegion* dimrgn) const;
+
+private:
+    std::vector<Column> m_columns;
+    std::vector<Row> m_rows;
+    std::vector<size_t> m_order; ///< row indexes in sort order
+    std::vector< std::vector<double> > m_values; ///< per column, empty if not read yet
+    std::map<gig::DimensionRegion*, size_t> m_rowOf;
+    std::map<gig::Region*, std::vector<size_t> > m_rowsOf; ///< rows of each region
+    std::vector<std::string> m_instrumentNames;
+    int m_sortColumn;
+    bool m_sortAscending;
+    bool m_stale;
+
+    void buildColumns(gig::DimensionRegion* layout);
+};
+
+#endif // GIGEDIT_PARAMTABLE_H
@@ -0,0 +1,205 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "PitchDetection.h"
+#include "ParallelFor.h"
+#include "VectorOps.h"
+
+#ifdef LIBSNDFILE_HEADER_FILE
+# include LIBSNDFILE_HEADER_FILE(sndfile.h)
+#else
+# include <sndfile.h>
+#endif
+
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+// amount of sample points (frames) read from the audio file at once
+#define READ_CHUNK_FRAMES 8192
+
+/**
+ * YIN estimate of one analysis frame starting at @a x, which must provide
+ * window + maxLag sample points.
+ *
+ * @param period - (output) refined period length in sample points
+ * @returns aperiodicity of the frame (0.0 = perfectly periodic), or a value
+ *          >= 1.0 if the frame is silent
+ */
+static float yinFrame(const float* x, int window, int minLag, int maxLag,
+                      float threshold, std::vector<float>& d, float& period)
+{
+    // energies of the shifted windows by a running sum
+    const double e0 = dotProduct(x, x, window);
+    if (e0 <= 1e-9 * window) return 1.f;
+
+    // difference function d(tau) = e(0) + e(tau) - 2 * r(tau), the
+    // autocorrelation r(tau) being the expensive part
+    d.assign(maxLag + 1, 0.f);
+    double eTau = e0;
+    for (int tau = 1; tau <= maxLag; ++tau) {
+        eTau += double(x[tau + window - 1]) * x[tau + window - 1] -
+                double(x[tau - 1]) * x[tau - 1];
+        const double r = dotProduct(x, x + tau, window);
+        d[tau] = float(std::max(0.0, e0 + eTau - 2.0 * r));
+    }
+
+    // cumulative mean normalized difference function
+    d[0] = 1.f;
+    double sum = 0.0;
+    for (int tau = 1; tau <= maxLag; ++tau) {
+        sum += d[tau];
+        d[tau] = (sum > 0.0) ? float(d[tau] * tau / sum) : 1.f;
+    }
+
+    // first dip below threshold (followed down to its local minimum),
+    // otherwise the global minimum
+    int best = -1;
+    for (int tau = minLag; tau <= maxLag; ++tau) {
+        if (d[tau] < threshold) {
+            while (tau + 1 <= maxLag && d[tau + 1] < d[tau]) ++tau;
+            best = tau;
+            break;
+        }
+    }
+    if (best < 0) {
+        best = minLag;
+        for (int tau = minLag + 1; tau <= maxLag; ++tau)
+            if (d[tau] < d[best]) best = tau;
+    }
+
+    // parabolic interpolation for sub sample precision
+    period = float(best);
+    if (best > 1 && best < maxLag) {
+        const float a = d[best - 1], b = d[best], c = d[best + 1];
+        const float denom = a - 2.f * b + c;
+        if (denom > 0.f) period += 0.5f * (a - c) / denom;
+    }
+    return d[best];
+}
+
+PitchEstimate detectPitch(const float* data, size_t n, double sampleRate,
+                          const PitchDetectionParams& params)
+{
+    PitchEstimate result;
+    if (!data || sampleRate <= 0.0) return result;
+
+    const int minLag = std::max(2, int(sampleRate / params.maxFrequency));
+    const int maxLag = int(sampleRate / params.minFrequency) + 1;
+    // the window has to cover at least one period of the lowest frequency
+    const int window = maxLag;
+    const size_t frameSize = size_t(window) + maxLag + 1;
+    if (n < frameSize) return result;
+
+    // spread the analysis frames evenly over the data
+    int frames = std::max(1, params.maxFrames);
+    frames = int(std::min<size_t>(frames, n / frameSize));
+    const size_t step = (frames > 1) ? (n - frameSize) / (frames - 1) : 0;
+
+    std::vector<float> d;
+    std::vector<float> periods;
+    double aperiodicity = 0.0;
+    for (int f = 0; f < frames; ++f) {
+        float period = 0.f;
+        const float a = yinFrame(data + f * step, window, minLag, maxLag,
+                                 params.threshold, d, period);
+        if (a >= 1.f || period <= 0.f) continue;
+        periods.push_back(period);
+        aperiodicity += a;
+    }
+    if (periods.empty()) return result;
+    aperiodicity /= periods.size();
+
+    // median is robust against single frames caught an octave off
+    std::vector<float> sorted = periods;
+    std::sort(sorted.begin(), sorted.end());
+    const float period = sorted[sorted.size() / 2];
+
+    // share of (all) frames agreeing with the median within a quarter tone
+    int agreeing = 0;
+    for (size_t i = 0; i < periods.size(); ++i)
+        if (fabs(12.0 * log2(periods[i] / period)) < 0.5) ++agreeing;
+
+    result.frequency = float(sampleRate / period);
+    result.confidence = float(
+        std::max(0.0, 1.0 - aperiodicity) * double(agreeing) / double(frames)
+    );
+    const double note = 69.0 + 12.0 * log2(result.frequency / 440.0);
+    if (note < 0.0 || note > 127.0) return result;
+    result.midiNote = int(floor(note + 0.5));
+    result.cents = int(floor((note - result.midiNote) * 100.0 + 0.5));
+    result.valid = true;
+    return result;
+}
+
+PitchEstimate detectPitchOfFile(const std::string& path,
+                                const PitchDetectionParams& params)
+{
+    SF_INFO info;
+    memset(&info, 0, sizeof(info));
+    SNDFILE* hFile = sf_open(path.c_str(), SFM_READ, &info);
+    if (!hFile) throw std::string(sf_strerror(NULL));
+    if (info.channels < 1 || info.samplerate < 1) {
+        sf_close(hFile);
+        return PitchEstimate();
+    }
+
+    // skip the attack, unless the audio is too short to afford it
+    sf_count_t skip = sf_count_t(params.skipSeconds * info.samplerate);
+    sf_count_t count = sf_count_t(params.analysisSeconds * info.samplerate);
+    if (skip + count > info.frames) {
+        skip = std::min(skip, info.frames / 4);
+        count = info.frames - skip;
+    }
+    if (skip && info.seekable) sf_seek(hFile, skip, SEEK_SET);
+
+    std::vector<float> mono;
+    mono.reserve(count);
+    std::vector<float> buffer(READ_CHUNK_FRAMES * info.channels);
+    while (count > 0) {
+        const sf_count_t n = sf_readf_float(
+            hFile, &buffer[0], std::min<sf_count_t>(count, READ_CHUNK_FRAMES)
+        );
+        if (n <= 0) break;
+        count -= n;
+        for (sf_count_t f = 0; f < n; ++f) {
+            float sum = 0.f;
+            for (int c = 0; c < info.channels; ++c)
+                sum += buffer[f * info.channels + c];
+            mono.push_back(sum / info.channels);
+        }
+    }
+    sf_close(hFile);
+
+    return detectPitch(mono.empty() ? NULL : &mono[0], mono.size(),
+                       info.samplerate, params);
+}
+
+void pitchToUnityNote(const PitchEstimate& pitch, uint32_t& unityNote, uint32_t& fineTune) {
+    // fine tune is only upwards, so e.g. -20 cents become note - 1 + 80 cents
+    int cents = pitch.midiNote * 100 + pitch.cents;
+    if (cents < 0) cents = 0;
+    unityNote = cents / 100;
+    fineTune  = uint32_t(double(cents % 100) / 100.0 * 4294967296.0);
+}
+
+void detectPitchBatch(std::vector<PitchDetectionJob>& jobs,
+    const PitchDetectionParams& params, const std::atomic<bool>* cancel,
+    std::function<void(float)> progress)
+{
+    std::atomic<size_t> done(0);
+    parallelFor(jobs.size(), [&](size_t i) {
+        if (cancel && *cancel) return;
+        PitchDetectionJob& job = jobs[i];
+        try {
+            job.result = detectPitchOfFile(job.path, params);
+        } catch (std::string what) {
+            job.error = what;
+        }
+        if (progress) progress(float(++done) / float(jobs.size()));
+    });
+}
@@ -0,0 +1,97 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_PITCHDETECTION_H
+#define GIGEDIT_PITCHDETECTION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <functional>
+
+/**
+ * Result of the pitch detection for one piece of audio.
+ */
+struct PitchEstimate {
+    bool valid; ///< false if no periodic signal was found
+    float frequency; ///< fundamental frequency in Hz
+    float confidence; ///< 0.0 (pure guess) .. 1.0 (clearly periodic, stable pitch)
+    int midiNote; ///< MIDI note nearest to frequency
+    int cents; ///< deviation of frequency from midiNote (-50 .. +50)
+
+    PitchEstimate() :
+        valid(false), frequency(0.f), confidence(0.f), midiNote(0), cents(0) {}
+};
+
+/**
+ * Tuning parameters for the pitch detection.
+ */
+struct PitchDetectionParams {
+    float minFrequency; ///< lowest fundamental frequency (in Hz) to be detected
+    float maxFrequency; ///< highest fundamental frequency (in Hz) to be detected
+    float threshold; ///< YIN threshold of the normalized difference function
+    int maxFrames; ///< max. amount of analysis frames spread over the audio
+    float skipSeconds; ///< duration of the attack skipped at the beginning
+    float analysisSeconds; ///< max. duration of audio analyzed after the skipped attack
+    float minConfidence; ///< estimates with lower confidence shall not be applied automatically
+
+    PitchDetectionParams() :
+        minFrequency(27.5f), maxFrequency(4200.f), threshold(0.15f),
+        maxFrames(8), skipSeconds(0.1f), analysisSeconds(1.5f),
+        minConfidence(0.5f) {}
+};
+
+/**
+ * Detects the fundamental frequency of the given mono audio data by the YIN
+ * algorithm. Several analysis frames spread over @a data are evaluated and
+ * the median of their estimates is returned. The confidence is derived from
+ * the periodicity of the frames and from how well they agree on the pitch.
+ */
+PitchEstimate detectPitch(const float* data, size_t n, double sampleRate,
+                          const PitchDetectionParams& params = PitchDetectionParams());
+
+/**
+ * Reads a section of the audio file @a path by libsndfile (skipping the
+ * attack), down mixes it to mono and detects its pitch.
+ *
+ * @throws std::string if the file could not be read
+ */
+PitchEstimate detectPitchOfFile(const std::string& path,
+                                const PitchDetectionParams& params = PitchDetectionParams());
+
+/**
+ * Converts a detected pitch to the unity note and fine tune fields of a
+ * gig::Sample. The fine tune of a sample is always upwards, as fraction of a
+ * semitone (0x80000000 = 50 cents).
+ */
+void pitchToUnityNote(const PitchEstimate& pitch, uint32_t& unityNote, uint32_t& fineTune);
+
+/**
+ * Pitch detection task for one audio file in a batch run.
+ */
+struct PitchDetectionJob {
+    std::string path;
+    PitchEstimate result; ///< filled by detectPitchBatch()
+    std::string error; ///< filled by detectPitchBatch() if the file could not be read
+};
+
+/**
+ * Runs the pitch detection for all @a jobs on several worker threads, each
+ * one reading its audio files independently. Blocks until all jobs are
+ * processed.
+ *
+ * @param cancel - optional flag, remaining jobs are skipped if set to true
+ * @param progress - optional callback receiving the current progress (0..1)
+ */
+void detectPitchBatch(std::vector<PitchDetectionJob>& jobs,
+    const PitchDetectionParams& params = PitchDetectionParams(),
+    const std::atomic<bool>* cancel = NULL,
+    std::function<void(float)> progress = std::function<void(float)>());
+
+#endif // GIGEDIT_PITCHDETECTION_H
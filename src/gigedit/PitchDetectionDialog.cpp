@@ -0,0 +1,97 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "PitchDetectionDialog.h"
+#include "global.h"
+
+#if HAS_GTKMM_STOCK
+# include <gtkmm/stock.h>
+#endif
+
+#include <math.h>
+
+Glib::ustring gig_to_utf8(const gig::String& gig_string);
+Glib::ustring note_str(int note);
+
+PitchDetectionDialog::PitchDetectionDialog(Gtk::Window& parent,
+                                           const std::vector<PitchDetectionJob>& jobs,
+                                           const std::vector<gig::Sample*>& samples,
+                                           const PitchDetectionParams& params)
+    : Gtk::Dialog(_("Detected Pitch"), parent, true),
+#if HAS_GTKMM_STOCK
+      m_closeButton(Gtk::Stock::CLOSE)
+#else
+      m_closeButton(_("_Close"), true)
+#endif
+{
+    m_scrolledWindow.add(m_treeView);
+    m_scrolledWindow.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+
+#if USE_GTKMM_BOX
+    get_content_area()->pack_start(m_descriptionLabel, Gtk::PACK_SHRINK);
+    get_content_area()->pack_start(m_scrolledWindow);
+    get_content_area()->pack_start(m_buttonBox, Gtk::PACK_SHRINK);
+#else
+    get_vbox()->pack_start(m_descriptionLabel, Gtk::PACK_SHRINK);
+    get_vbox()->pack_start(m_scrolledWindow);
+    get_vbox()->pack_start(m_buttonBox, Gtk::PACK_SHRINK);
+#endif
+
+    m_refListModel = Gtk::ListStore::create(m_columns);
+    m_treeView.set_model(m_refListModel);
+    m_treeView.append_column(_("Sample"), m_columns.m_col_name);
+    m_treeView.append_column(_("Pitch"), m_columns.m_col_note);
+    m_treeView.append_column(_("Frequency"), m_columns.m_col_frequency);
+    m_treeView.append_column(_("Confidence"), m_columns.m_col_confidence);
+    m_treeView.append_column(_("Applied"), m_columns.m_col_applied);
+    m_treeView.set_headers_visible(true);
+
+    m_buttonBox.set_layout(Gtk::BUTTONBOX_END);
+#if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && GTKMM_MINOR_VERSION > 24)
+    m_buttonBox.set_margin(5);
+#else
+    m_buttonBox.set_border_width(5);
+#endif
+    m_buttonBox.pack_start(m_closeButton, Gtk::PACK_SHRINK);
+    m_closeButton.signal_clicked().connect(
+        sigc::mem_fun(*this, &PitchDetectionDialog::hide)
+    );
+
+    int applied = 0;
+    for (int i = 0; i < jobs.size() && i < samples.size(); ++i) {
+        const PitchEstimate& pitch = jobs[i].result;
+        const bool ok = pitch.valid && pitch.confidence >= params.minConfidence;
+        if (ok) ++applied;
+
+        Gtk::TreeModel::Row row = *(m_refListModel->append());
+        row[m_columns.m_col_name] = gig_to_utf8(samples[i]->pInfo->Name);
+        if (!jobs[i].error.empty()) {
+            row[m_columns.m_col_note] = jobs[i].error;
+        } else if (!pitch.valid) {
+            row[m_columns.m_col_note] = _("no pitch found");
+        } else {
+            row[m_columns.m_col_note] = note_str(pitch.midiNote) + " " +
+                ((pitch.cents >= 0) ? "+" : "") + ToString(pitch.cents) + " " +
+                _("cents");
+            row[m_columns.m_col_frequency] =
+                ToString(floor(pitch.frequency * 100.f + 0.5f) / 100.f) + " Hz";
+        }
+        row[m_columns.m_col_confidence] =
+            ToString(int(pitch.confidence * 100.f + 0.5f)) + " %";
+        row[m_columns.m_col_applied] = ok;
+    }
+
+    m_descriptionLabel.set_text(
+        ToString(applied) + " " + _("of") + " " + ToString(jobs.size()) + " " +
+        _("added samples got their unity note and fine tune from the detected pitch.")
+    );
+
+#if HAS_GTKMM_SHOW_ALL_CHILDREN
+    show_all_children();
+#endif
+    resize(500, 350);
+}
@@ -0,0 +1,67 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_PITCHDETECTIONDIALOG_H
+#define GIGEDIT_PITCHDETECTIONDIALOG_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#include "compat.h"
+
+#include <gtkmm/buttonbox.h>
+#include <gtkmm/dialog.h>
+#include <gtkmm/treeview.h>
+#include <gtkmm/liststore.h>
+#include <gtkmm/scrolledwindow.h>
+
+#include "PitchDetection.h"
+
+/** @brief Import summary of the pitch detection.
+ *
+ * Lists the pitch detected for each added sample together with the
+ * confidence of the detection, and whether the result was applied to the
+ * sample's unity note and fine tune.
+ */
+class PitchDetectionDialog : public Gtk::Dialog {
+public:
+    PitchDetectionDialog(Gtk::Window& parent,
+                         const std::vector<PitchDetectionJob>& jobs,
+                         const std::vector<gig::Sample*>& samples,
+                         const PitchDetectionParams& params);
+
+protected:
+    HButtonBox           m_buttonBox;
+    Gtk::ScrolledWindow  m_scrolledWindow;
+    Gtk::TreeView        m_treeView;
+    Gtk::Button          m_closeButton;
+    Gtk::Label           m_descriptionLabel;
+
+    class ListModel : public Gtk::TreeModel::ColumnRecord {
+    public:
+        ListModel() {
+            add(m_col_name);
+            add(m_col_note);
+            add(m_col_frequency);
+            add(m_col_confidence);
+            add(m_col_applied);
+        }
+
+        Gtk::TreeModelColumn<Glib::ustring> m_col_name;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_note;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_frequency;
+        Gtk::TreeModelColumn<Glib::ustring> m_col_confidence;
+        Gtk::TreeModelColumn<bool>          m_col_applied;
+    } m_columns;
+
+    Glib::RefPtr<Gtk::ListStore> m_refListModel;
+};
+
+#endif // GIGEDIT_PITCHDETECTIONDIALOG_H
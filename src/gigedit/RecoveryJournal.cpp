@@ -0,0 +1,611 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "RecoveryJournal.h"
+#include "CompiledMacro.h"
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(Serialization.h)
+#else
+# include <Serialization.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+namespace {
+
+const char JOURNAL_MAGIC[] = "GIGEDIT-RECOVERY-1";
+
+enum RecordType {
+    RECORD_DIMRGN = 1,
+    RECORD_REGION = 2,
+    RECORD_INSTRUMENT = 3,
+    RECORD_STRUCTURE = 4
+};
+
+// the journal is only read back on the same machine, so all values are
+// simply written in native byte order
+template<typename T>
+void put(std::vector<uint8_t>& buf, T value) {
+    const uint8_t* p = (const uint8_t*) &value;
+    buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+void putBytes(std::vector<uint8_t>& buf, const std::vector<uint8_t>& bytes) {
+    put(buf, uint32_t(bytes.size()));
+    buf.insert(buf.end(), bytes.begin(), bytes.end());
+}
+
+void putString(std::vector<uint8_t>& buf, const std::string& s) {
+    put(buf, uint32_t(s.size()));
+    buf.insert(buf.end(), s.begin(), s.end());
+}
+
+/// Sequential reader of a record, which fails on reading beyond its end.
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : p(data), end(data + size), ok(true) {}
+
+    template<typename T>
+    T get() {
+        T value = T();
+        if (size_t(end - p) < sizeof(T)) {
+            ok = false;
+            return value;
+        }
+        memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return value;
+    }
+
+    std::vector<uint8_t> getBytes() {
+        const uint32_t n = get<uint32_t>();
+        if (!ok || size_t(end - p) < n) {
+            ok = false;
+            return std::vector<uint8_t>();
+        }
+        std::vector<uint8_t> bytes(p, p + n);
+        p += n;
+        return bytes;
+    }
+
+    std::string getString() {
+        const std::vector<uint8_t> bytes = getBytes();
+        return std::string(bytes.begin(), bytes.end());
+    }
+
+    bool good() const { return ok; }
+
+private:
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok;
+};
+
+uint32_t checksum(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/// Appends record @a body (type byte plus payload) framed by size and checksum.
+void appendRecord(std::vector<uint8_t>& out, const std::vector<uint8_t>& body) {
+    put(out, uint32_t(body.size()));
+    out.insert(out.end(), body.begin(), body.end());
+    put(out, checksum(&body[0], body.size()));
+}
+
+/// Identifies the version of the gig file a journal belongs to.
+struct FileStamp {
+    uint64_t size;
+    int64_t mtime;
+
+    bool read(const std::string& path) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) return false;
+        size = uint64_t(st.st_size);
+        mtime = int64_t(st.st_mtime);
+        return true;
+    }
+};
+
+/// Index based addresses of the objects of a gig file.
+struct FileIndex {
+    std::map<gig::Instrument*, int> instruments;
+    std::map<gig::Region*, std::pair<int,int> > regions;
+    std::map<gig::Sample*, int> samples;
+
+    FileIndex(gig::File* gig) {
+        int i = 0;
+        for (gig::Instrument* instr = gig->GetFirstInstrument(); instr;
+             instr = gig->GetNextInstrument(), ++i)
+        {
+            instruments[instr] = i;
+            int j = 0;
+            for (gig::Region* rgn = instr->GetFirstRegion(); rgn;
+                 rgn = instr->GetNextRegion(), ++j)
+            {
+                regions[rgn] = std::make_pair(i, j);
+            }
+        }
+        i = 0;
+        for (gig::Sample* s = gig->GetFirstSample(); s; s = gig->GetNextSample(), ++i)
+            samples[s] = i;
+    }
+};
+
+/// All instruments, regions and samples of @a gig in the order of their indexes.
+std::vector<const void*> structureOf(gig::File* gig) {
+    std::vector<const void*> objects;
+    for (gig::Instrument* instr = gig->GetFirstInstrument(); instr;
+         instr = gig->GetNextInstrument())
+    {
+        objects.push_back(instr);
+        for (gig::Region* rgn = instr->GetFirstRegion(); rgn;
+             rgn = instr->GetNextRegion())
+        {
+            objects.push_back(rgn);
+        }
+    }
+    objects.push_back(NULL);
+    for (gig::Sample* s = gig->GetFirstSample(); s; s = gig->GetNextSample())
+        objects.push_back(s);
+    return objects;
+}
+
+std::vector<gig::dimension_def_t> layoutOf(const gig::Region* rgn) {
+    return std::vector<gig::dimension_def_t>(
+        rgn->pDimensionDefinitions, rgn->pDimensionDefinitions + rgn->Dimensions
+    );
+}
+
+bool equalLayouts(const std::vector<gig::dimension_def_t>& a,
+                  const std::vector<gig::dimension_def_t>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (a[i].dimension != b[i].dimension || a[i].bits != b[i].bits ||
+            a[i].zones != b[i].zones) return false;
+    return true;
+}
+
+/// Objects of the gig file being recovered, looked up by their indexes.
+struct ReplayTarget {
+    std::vector<gig::Instrument*> instruments;
+    std::vector< std::vector<gig::Region*> > regions;
+    std::vector<gig::Sample*> samples;
+
+    ReplayTarget(gig::File* gig) {
+        for (gig::Instrument* instr = gig->GetFirstInstrument(); instr;
+             instr = gig->GetNextInstrument())
+        {
+            instruments.push_back(instr);
+            regions.push_back(std::vector<gig::Region*>());
+            for (gig::Region* rgn = instr->GetFirstRegion(); rgn;
+                 rgn = instr->GetNextRegion())
+            {
+                regions.back().push_back(rgn);
+            }
+        }
+        for (gig::Sample* s = gig->GetFirstSample(); s; s = gig->GetNextSample())
+            samples.push_back(s);
+    }
+
+    gig::Instrument* instrument(int i) const {
+        return (i >= 0 && i < int(instruments.size())) ? instruments[i] : NULL;
+    }
+
+    gig::Region* region(int i, int j) const {
+        if (!instrument(i) || j < 0 || j >= int(regions[i].size())) return NULL;
+        return regions[i][j];
+    }
+};
+
+// applies one record, returns false if the record is malformed
+bool applyRecord(const ReplayTarget& target, uint8_t type, Reader& r,
+                 RecoveryJournal::Recovered& recovered)
+{
+    switch (type) {
+        case RECORD_DIMRGN: {
+            const int i = r.get<int32_t>();
+            const int j = r.get<int32_t>();
+            const int k = r.get<int32_t>();
+            const int sample = r.get<int32_t>();
+            const uint32_t loops = r.get<uint32_t>();
+            std::vector<DLS::sample_loop_t> loop(loops);
+            for (uint32_t l = 0; l < loops && r.good(); ++l) {
+                loop[l].Size = r.get<uint32_t>();
+                loop[l].LoopType = r.get<uint32_t>();
+                loop[l].LoopStart = r.get<uint32_t>();
+                loop[l].LoopLength = r.get<uint32_t>();
+            }
+            const Serialization::RawData archive = r.getBytes();
+            if (!r.good()) return false;
+
+            gig::Region* rgn = target.region(i, j);
+            if (!rgn || k < 0 || k >= int(rgn->DimensionRegions)) return true;
+            gig::DimensionRegion* d = rgn->pDimensionRegions[k];
+            Serialization::Archive a;
+            a.decode(archive);
+            a.deserialize(d);
+            updateDerivedTables(d);
+            d->pSample = (sample >= 0 && sample < int(target.samples.size())) ?
+                         target.samples[sample] : NULL;
+            while (d->SampleLoops) d->DeleteSampleLoop(&d->pSampleLoops[0]);
+            for (size_t l = 0; l < loop.size(); ++l)
+                d->AddSampleLoop(&loop[l]);
+            recovered.regions.insert(rgn);
+            break;
+        }
+        case RECORD_REGION: {
+            const int i = r.get<int32_t>();
+            const int j = r.get<int32_t>();
+            const uint16_t low = r.get<uint16_t>();
+            const uint16_t high = r.get<uint16_t>();
+            const uint16_t keyGroup = r.get<uint16_t>();
+            const uint32_t n = r.get<uint32_t>();
+            std::vector<gig::dimension_def_t> layout;
+            for (uint32_t d = 0; d < n && r.good(); ++d) {
+                gig::dimension_def_t def = gig::dimension_def_t();
+                def.dimension = gig::dimension_t(r.get<uint8_t>());
+                def.bits = r.get<uint8_t>();
+                def.zones = r.get<uint8_t>();
+                layout.push_back(def);
+            }
+            if (!r.good()) return false;
+
+            gig::Region* rgn = target.region(i, j);
+            if (!rgn) return true;
+            if (rgn->KeyRange.low != low || rgn->KeyRange.high != high)
+                rgn->SetKeyRange(low, high);
+            rgn->KeyGroup = keyGroup;
+            if (!equalLayouts(layoutOf(rgn), layout)) {
+                while (rgn->Dimensions)
+                    rgn->DeleteDimension(&rgn->pDimensionDefinitions[rgn->Dimensions - 1]);
+                for (size_t d = 0; d < layout.size(); ++d)
+                    rgn->AddDimension(&layout[d]);
+                recovered.layoutChanged = true;
+            }
+            recovered.regions.insert(rgn);
+            break;
+        }
+        case RECORD_INSTRUMENT: {
+            const int i = r.get<int32_t>();
+            const std::string name = r.getString();
+            const bool isDrum = r.get<uint8_t>();
+            const uint16_t midiBank = r.get<uint16_t>();
+            const uint8_t midiBankCoarse = r.get<uint8_t>();
+            const uint8_t midiBankFine = r.get<uint8_t>();
+            const uint32_t midiProgram = r.get<uint32_t>();
+            const int32_t attenuation = r.get<int32_t>();
+            const uint16_t effectSend = r.get<uint16_t>();
+            const int16_t fineTune = r.get<int16_t>();
+            const uint16_t pitchbendRange = r.get<uint16_t>();
+            const bool pianoReleaseMode = r.get<uint8_t>();
+            const uint16_t dimKeyLow = r.get<uint16_t>();
+            const uint16_t dimKeyHigh = r.get<uint16_t>();
+            if (!r.good()) return false;
+
+            gig::Instrument* instr = target.instrument(i);
+            if (!instr) return true;
+            instr->pInfo->Name = name;
+            instr->IsDrum = isDrum;
+            instr->MIDIBank = midiBank;
+            instr->MIDIBankCoarse = midiBankCoarse;
+            instr->MIDIBankFine = midiBankFine;
+            instr->MIDIProgram = midiProgram;
+            instr->Attenuation = attenuation;
+            instr->EffectSend = effectSend;
+            instr->FineTune = fineTune;
+            instr->PitchbendRange = pitchbendRange;
+            instr->PianoReleaseMode = pianoReleaseMode;
+            instr->DimensionKeyRange.low = dimKeyLow;
+            instr->DimensionKeyRange.high = dimKeyHigh;
+            recovered.instruments.insert(instr);
+            break;
+        }
+        default:
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+RecoveryJournal::RecoveryJournal() :
+    m_gig(NULL), m_hasRecords(false), m_stopWriter(false)
+{
+}
+
+RecoveryJournal::~RecoveryJournal() {
+    // edits left unsaved are kept, since the caller did not discard them
+    stop(false);
+}
+
+std::string RecoveryJournal::pathFor(const std::string& gigFileName) {
+    return gigFileName + ".journal";
+}
+
+bool RecoveryJournal::exists(const std::string& gigFileName) {
+    struct stat st;
+    if (stat(pathFor(gigFileName).c_str(), &st) != 0) return false;
+    // a journal without edits consists of its header only
+    return size_t(st.st_size) > sizeof(JOURNAL_MAGIC) + sizeof(FileStamp);
+}
+
+bool RecoveryJournal::replay(gig::File* gig, const std::string& gigFileName,
+                             Recovered& recovered, std::string& error)
+{
+    FILE* f = fopen(pathFor(gigFileName).c_str(), "rb");
+    if (!f) {
+        error = "Could not open journal file";
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[65536];
+    for (size_t n; (n = fread(chunk, 1, sizeof(chunk), f)) > 0; )
+        data.insert(data.end(), chunk, chunk + n);
+    fclose(f);
+
+    FileStamp stamp, current;
+    if (data.size() < sizeof(JOURNAL_MAGIC) + sizeof(FileStamp) ||
+        memcmp(&data[0], JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0)
+    {
+        error = "Not a gigedit journal file";
+        return false;
+    }
+    memcpy(&stamp, &data[sizeof(JOURNAL_MAGIC)], sizeof(FileStamp));
+    if (!current.read(gigFileName) || stamp.size != current.size ||
+        stamp.mtime != current.mtime)
+    {
+        error = "The gig file was modified after the journal was written";
+        return false;
+    }
+
+    const ReplayTarget target(gig);
+    size_t pos = sizeof(JOURNAL_MAGIC) + sizeof(FileStamp);
+    while (true) {
+        // a truncated or damaged record is the last one written before the
+        // crash, so just stop there
+        uint32_t size;
+        if (data.size() - pos < sizeof(size)) break;
+        memcpy(&size, &data[pos], sizeof(size));
+        if (!size || data.size() - pos - sizeof(size) < size_t(size) + sizeof(uint32_t)) break;
+        const uint8_t* body = &data[pos + sizeof(size)];
+        uint32_t sum;
+        memcpy(&sum, body + size, sizeof(sum));
+        if (sum != checksum(body, size)) break;
+        pos += sizeof(size) + size + sizeof(sum);
+
+        if (body[0] == RECORD_STRUCTURE) {
+            recovered.structureChanged = true;
+            break;
+        }
+        Reader r(body + 1, size - 1);
+        if (!applyRecord(target, body[0], r, recovered)) break;
+        recovered.records++;
+    }
+    return true;
+}
+
+void RecoveryJournal::start(gig::File* gig) {
+    const std::string path = gig->GetFileName().empty() ?
+        std::string() : pathFor(gig->GetFileName());
+    if (m_gig == gig && m_path == path) return;
+    stop(false);
+    if (path.empty()) return;
+
+    FileStamp stamp;
+    if (!stamp.read(gig->GetFileName())) return;
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        fprintf(stderr, "Could not create recovery journal '%s'\n", path.c_str());
+        return;
+    }
+    if (fwrite(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC), 1, f) != 1 ||
+        fwrite(&stamp, sizeof(stamp), 1, f) != 1 || fflush(f) != 0)
+    {
+        fprintf(stderr, "Could not write recovery journal '%s'\n", path.c_str());
+        fclose(f);
+        remove(path.c_str());
+        return;
+    }
+
+    m_gig = gig;
+    m_path = path;
+    m_structure = structureOf(gig);
+    m_hasRecords = false;
+    m_stopWriter = false;
+    m_writer = std::thread(&RecoveryJournal::writerMain, this, f);
+}
+
+void RecoveryJournal::stop(bool discard) {
+    m_dirtyDimRgns.clear();
+    m_dirtyRegions.clear();
+    m_dirtyInstruments.clear();
+    m_structure.clear();
+    if (!m_gig) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopWriter = true;
+    }
+    m_cond.notify_one();
+    m_writer.join();
+
+    if (discard || !m_hasRecords) remove(m_path.c_str());
+    m_gig = NULL;
+    m_path.clear();
+}
+
+void RecoveryJournal::dimRegionChanged(gig::DimensionRegion* dimrgn) {
+    if (!m_gig || !dimrgn) return;
+    gig::Region* rgn = static_cast<gig::Region*>(dimrgn->GetParent());
+    m_dirtyDimRgns.insert(std::make_pair(rgn, dimrgn));
+}
+
+void RecoveryJournal::regionChanged(gig::Region* rgn) {
+    if (!m_gig || !rgn) return;
+    m_dirtyRegions.insert(rgn);
+    // region wide edits (i.e. macros, dimension changes) only report the
+    // region, not each of its dimension regions
+    for (int k = 0; k < int(rgn->DimensionRegions); ++k)
+        m_dirtyDimRgns.insert(std::make_pair(rgn, rgn->pDimensionRegions[k]));
+}
+
+void RecoveryJournal::instrumentChanged(gig::Instrument* instr) {
+    if (!m_gig || !instr) return;
+    m_dirtyInstruments.insert(instr);
+}
+
+void RecoveryJournal::structureChanged() {
+    if (!m_gig) return;
+    const std::vector<const void*> structure = structureOf(m_gig);
+    if (structure != m_structure) {
+        // the indexes of pending records already refer to the new structure
+        m_structure = structure;
+        std::vector<uint8_t> body, out;
+        put(body, uint8_t(RECORD_STRUCTURE));
+        appendRecord(out, body);
+        enqueue(out);
+    }
+    flush();
+}
+
+void RecoveryJournal::flush() {
+    if (!m_gig) return;
+    if (m_dirtyDimRgns.empty() && m_dirtyRegions.empty() &&
+        m_dirtyInstruments.empty()) return;
+
+    // resolving the objects by index also drops objects deleted meanwhile
+    const FileIndex index(m_gig);
+    std::vector<uint8_t> out;
+
+    // regions first, since their dimension layout defines which dimension
+    // regions exist
+    for (std::set<gig::Region*>::const_iterator it = m_dirtyRegions.begin();
+         it != m_dirtyRegions.end(); ++it)
+    {
+        std::map<gig::Region*, std::pair<int,int> >::const_iterator pos =
+            index.regions.find(*it);
+        if (pos == index.regions.end()) continue;
+        gig::Region* rgn = *it;
+        std::vector<uint8_t> body;
+        put(body, uint8_t(RECORD_REGION));
+        put(body, int32_t(pos->second.first));
+        put(body, int32_t(pos->second.second));
+        put(body, uint16_t(rgn->KeyRange.low));
+        put(body, uint16_t(rgn->KeyRange.high));
+        put(body, uint16_t(rgn->KeyGroup));
+        put(body, uint32_t(rgn->Dimensions));
+        for (uint32_t d = 0; d < rgn->Dimensions; ++d) {
+            put(body, uint8_t(rgn->pDimensionDefinitions[d].dimension));
+            put(body, uint8_t(rgn->pDimensionDefinitions[d].bits));
+            put(body, uint8_t(rgn->pDimensionDefinitions[d].zones));
+        }
+        appendRecord(out, body);
+    }
+
+    for (std::set< std::pair<gig::Region*, gig::DimensionRegion*> >::const_iterator it = m_dirtyDimRgns.begin();
+         it != m_dirtyDimRgns.end(); ++it)
+    {
+        std::map<gig::Region*, std::pair<int,int> >::const_iterator pos =
+            index.regions.find(it->first);
+        if (pos == index.regions.end()) continue;
+        gig::Region* rgn = it->first;
+        int k = 0;
+        while (k < int(rgn->DimensionRegions) && rgn->pDimensionRegions[k] != it->second) ++k;
+        if (k == int(rgn->DimensionRegions)) continue;
+        gig::DimensionRegion* d = it->second;
+
+        std::map<gig::Sample*, int>::const_iterator sample = index.samples.find(d->pSample);
+        Serialization::Archive archive;
+        archive.serialize(d);
+
+        std::vector<uint8_t> body;
+        put(body, uint8_t(RECORD_DIMRGN));
+        put(body, int32_t(pos->second.first));
+        put(body, int32_t(pos->second.second));
+        put(body, int32_t(k));
+        put(body, int32_t(sample != index.samples.end() ? sample->second : -1));
+        put(body, uint32_t(d->SampleLoops));
+        for (uint32_t l = 0; l < d->SampleLoops; ++l) {
+            put(body, uint32_t(d->pSampleLoops[l].Size));
+            put(body, uint32_t(d->pSampleLoops[l].LoopType));
+            put(body, uint32_t(d->pSampleLoops[l].LoopStart));
+            put(body, uint32_t(d->pSampleLoops[l].LoopLength));
+        }
+        putBytes(body, archive.rawData());
+        appendRecord(out, body);
+    }
+
+    for (std::set<gig::Instrument*>::const_iterator it = m_dirtyInstruments.begin();
+         it != m_dirtyInstruments.end(); ++it)
+    {
+        std::map<gig::Instrument*, int>::const_iterator pos = index.instruments.find(*it);
+        if (pos == index.instruments.end()) continue;
+        const gig::Instrument* instr = *it;
+        std::vector<uint8_t> body;
+        put(body, uint8_t(RECORD_INSTRUMENT));
+        put(body, int32_t(pos->second));
+        putString(body, instr->pInfo->Name);
+        put(body, uint8_t(instr->IsDrum));
+        put(body, uint16_t(instr->MIDIBank));
+        put(body, uint8_t(instr->MIDIBankCoarse));
+        put(body, uint8_t(instr->MIDIBankFine));
+        put(body, uint32_t(instr->MIDIProgram));
+        put(body, int32_t(instr->Attenuation));
+        put(body, uint16_t(instr->EffectSend));
+        put(body, int16_t(instr->FineTune));
+        put(body, uint16_t(instr->PitchbendRange));
+        put(body, uint8_t(instr->PianoReleaseMode));
+        put(body, uint16_t(instr->DimensionKeyRange.low));
+        put(body, uint16_t(instr->DimensionKeyRange.high));
+        appendRecord(out, body);
+    }
+
+    m_dirtyDimRgns.clear();
+    m_dirtyRegions.clear();
+    m_dirtyInstruments.clear();
+    enqueue(out);
+}
+
+void RecoveryJournal::enqueue(const Buffer& data) {
+    if (data.empty()) return;
+    m_hasRecords = true;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.insert(m_queue.end(), data.begin(), data.end());
+    }
+    m_cond.notify_one();
+}
+
+void RecoveryJournal::writerMain(FILE* f) {
+    Buffer data;
+    bool failed = false;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this] { return m_stopWriter || !m_queue.empty(); });
+            if (m_queue.empty()) break; // stopped, and everything written
+            data.swap(m_queue);
+            m_queue.clear();
+        }
+        // the records are only useful in order, so once a write failed all
+        // later ones are dropped as well
+        if (!failed && (fwrite(&data[0], data.size(), 1, f) != 1 || fflush(f) != 0)) {
+            fprintf(stderr, "Could not write recovery journal\n");
+            failed = true;
+        }
+    }
+    fclose(f);
+}
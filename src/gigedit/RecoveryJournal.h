@@ -0,0 +1,133 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_RECOVERYJOURNAL_H
+#define GIGEDIT_RECOVERYJOURNAL_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+/** @brief Crash recovery journal of the unsaved edits of a gig file.
+ *
+ * Saving a large gig file takes long, so the edits made since the last save
+ * are additionally appended to a small journal file next to the gig file.
+ * Edited objects are merely marked as dirty while editing; flush() then
+ * encodes their new state, addressed by instrument, region and dimension
+ * region index, and hands the bytes over to a writer thread which appends
+ * them to the journal file. So the GUI thread never waits for disk I/O.
+ *
+ * If gigedit (or the sampler hosting it) crashes, the journal survives and
+ * its edits can be applied to the gig file after it was loaded again by
+ * calling replay().
+ *
+ * Only articulation edits are journaled. Structural changes like added or
+ * deleted instruments, regions or samples are recorded as barrier by
+ * structureChanged(), at which replay() stops, since the indexes of any
+ * later record might refer to objects which do not exist in the gig file
+ * on disk. Other changes reported by structureChanged() (i.e. of sample
+ * references) do not shift any index, so they are journaled as usual.
+ */
+class RecoveryJournal {
+public:
+    /// Edits applied to a gig file by replay().
+    struct Recovered {
+        std::set<gig::Instrument*> instruments;
+        std::set<gig::Region*> regions; ///< including regions whose dimension regions changed
+        int records; ///< amount of records applied
+        bool layoutChanged; ///< whether the dimensions of a region were changed
+        bool structureChanged; ///< whether replay stopped at a structural change
+
+        Recovered() : records(0), layoutChanged(false), structureChanged(false) {}
+    };
+
+    RecoveryJournal();
+    ~RecoveryJournal();
+
+    /// Path of the journal file of the gig file @a gigFileName.
+    static std::string pathFor(const std::string& gigFileName);
+
+    /// Whether there is a journal with edits for the gig file @a gigFileName.
+    static bool exists(const std::string& gigFileName);
+
+    /**
+     * Applies the edits journaled for the gig file @a gigFileName to @a gig,
+     * which must have been loaded from that file.
+     *
+     * @returns false if the journal could not be read or does not belong to
+     *          the current version of the gig file (@a error is set then)
+     */
+    static bool replay(gig::File* gig, const std::string& gigFileName,
+                       Recovered& recovered, std::string& error);
+
+    /**
+     * Starts journaling the edits of @a gig, replacing any former journal of
+     * its file. Does nothing if the edits of @a gig are already journaled,
+     * and journaling stays off if @a gig was not saved to a file yet.
+     */
+    void start(gig::File* gig);
+
+    /**
+     * Stops journaling. The journal file is deleted if @a discard is true
+     * (i.e. after the gig file was saved, or the user dropped the edits) or
+     * if no edit was journaled at all.
+     */
+    void stop(bool discard);
+
+    bool isActive() const { return m_gig; }
+
+    void dimRegionChanged(gig::DimensionRegion* dimrgn);
+    /// Also journals all dimension regions of @a rgn.
+    void regionChanged(gig::Region* rgn);
+    void instrumentChanged(gig::Instrument* instr);
+
+    /**
+     * Records a structural change as barrier if instruments, regions or
+     * samples were added, deleted or reordered since the journal was
+     * started, see class description.
+     */
+    void structureChanged();
+
+    /// Encodes all dirty objects and queues them for being written.
+    void flush();
+
+private:
+    typedef std::vector<uint8_t> Buffer;
+
+    std::string m_path;
+    gig::File* m_gig;
+    bool m_hasRecords;
+
+    std::set< std::pair<gig::Region*, gig::DimensionRegion*> > m_dirtyDimRgns;
+    std::set<gig::Region*> m_dirtyRegions;
+    std::set<gig::Instrument*> m_dirtyInstruments;
+    std::vector<const void*> m_structure; ///< instruments, regions and samples in index order, as on disk
+
+    // shared with the writer thread
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    Buffer m_queue;
+    bool m_stopWriter;
+
+    void enqueue(const Buffer& data);
+    void writerMain(FILE* f);
+};
+
+#endif // GIGEDIT_RECOVERYJOURNAL_H
@@ -0,0 +1,375 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "SampleConverter.h"
+#include "VectorOps.h"
+#include "ParallelFor.h"
+#include "Trace.h"
+#include "global.h"
+
+#ifdef LIBSNDFILE_HEADER_FILE
+# include LIBSNDFILE_HEADER_FILE(sndfile.h)
+#else
+# include <sndfile.h>
+#endif
+
+#include <math.h>
+#include <algorithm>
+
+#ifndef M_PI
+# define M_PI 3.14159265358979323846
+#endif
+
+// amount of sample points (frames) read from the audio file at once
+#define READ_CHUNK_FRAMES 10000
+
+// filter length (in frames of the lower sample rate) of the resampler
+#define RESAMPLER_TAPS 128
+
+// upper limit for the amount of precomputed resampler filter phases
+#define RESAMPLER_MAX_PHASES 1024
+
+// Kaiser window shape of the resampler filter (~90 dB stop band attenuation)
+#define RESAMPLER_KAISER_BETA 8.6
+
+// resampler cutoff frequency, relative to the lower Nyquist frequency
+#define RESAMPLER_CUTOFF 0.955
+
+static int gcd(int a, int b) {
+    while (b) {
+        const int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/// Modified Bessel function of first kind and order 0 (for the Kaiser window).
+static double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// class 'Resampler'
+
+Resampler::Resampler(int inRate, int outRate, int channels) :
+    m_channels(channels), m_historyPos(0), m_inputFrames(0), m_outputFrames(0),
+    m_pos(0), m_phase(0)
+{
+    const int g = gcd(inRate, outRate);
+    m_up   = outRate / g;
+    m_down = inRate / g;
+    m_phases = std::min(m_up, RESAMPLER_MAX_PHASES);
+
+    // when decimating, the filter has to be longer (in input frames) for the
+    // same transition band width
+    const double ratio = double(outRate) / double(inRate);
+    const double cutoff = std::min(1.0, ratio) * RESAMPLER_CUTOFF;
+    m_taps = int(ceil(RESAMPLER_TAPS / std::min(1.0, ratio)));
+    m_taps = (m_taps + 7) & ~7; // multiple of the SIMD width
+
+    // windowed sinc, evaluated at the fractional output positions of each
+    // phase, each phase normalized to unity gain
+    const double half = m_taps / 2;
+    const double i0beta = besselI0(RESAMPLER_KAISER_BETA);
+    m_coeffs.resize(size_t(m_phases) * m_taps);
+    for (int p = 0; p < m_phases; ++p) {
+        float* c = &m_coeffs[size_t(p) * m_taps];
+        double sum = 0.0;
+        for (int j = 0; j < m_taps; ++j) {
+            const double u = double(p) / m_phases + half - 1 - j;
+            const double x = u / half;
+            double h = 0.0;
+            if (fabs(x) < 1.0) {
+                const double v = M_PI * cutoff * u;
+                h = cutoff * ((v != 0.0) ? sin(v) / v : 1.0) *
+                    besselI0(RESAMPLER_KAISER_BETA * sqrt(1.0 - x * x)) / i0beta;
+            }
+            c[j] = float(h);
+            sum += h;
+        }
+        if (sum != 0.0)
+            for (int j = 0; j < m_taps; ++j)
+                c[j] = float(c[j] / sum);
+    }
+
+    // the filter reaches taps/2 - 1 frames into the past, which are silence
+    // at the beginning
+    m_history.resize(channels);
+    for (int ch = 0; ch < channels; ++ch)
+        m_history[ch].assign(m_taps / 2 - 1, 0.f);
+    m_historyPos = -int64_t(m_taps / 2 - 1);
+}
+
+uint64_t Resampler::outputFrames(uint64_t frames, int inRate, int outRate) {
+    if (inRate == outRate) return frames;
+    const int g = gcd(inRate, outRate);
+    const uint64_t up = outRate / g, down = inRate / g;
+    return (frames * up + down - 1) / down;
+}
+
+void Resampler::process(const float* in, size_t frames, std::vector<float>& out) {
+    for (int ch = 0; ch < m_channels; ++ch) {
+        std::vector<float>& h = m_history[ch];
+        const size_t offset = h.size();
+        h.resize(offset + frames);
+        for (size_t f = 0; f < frames; ++f)
+            h[offset + f] = in[f * m_channels + ch];
+    }
+    m_inputFrames += frames;
+    produce(out, UINT64_MAX);
+}
+
+void Resampler::flush(std::vector<float>& out) {
+    const uint64_t total = outputFrames(m_inputFrames, m_down, m_up);
+    for (int ch = 0; ch < m_channels; ++ch)
+        m_history[ch].resize(m_history[ch].size() + m_taps / 2 + 1, 0.f);
+    produce(out, total);
+}
+
+void Resampler::produce(std::vector<float>& out, uint64_t limit) {
+    const int64_t end = m_historyPos + int64_t(m_history[0].size());
+    const int64_t reach = m_taps / 2;
+    while (m_outputFrames < limit && int64_t(m_pos) + reach < end) {
+        const int p = int(int64_t(m_phase) * m_phases / m_up);
+        const float* c = &m_coeffs[size_t(p) * m_taps];
+        const size_t first = size_t(int64_t(m_pos) - (reach - 1) - m_historyPos);
+        for (int ch = 0; ch < m_channels; ++ch)
+            out.push_back(dotProduct(&m_history[ch][first], c, m_taps));
+        ++m_outputFrames;
+        // advance by down / up input frames
+        m_phase += m_down;
+        m_pos   += m_phase / m_up;
+        m_phase %= m_up;
+    }
+
+    // drop input frames not needed anymore, in larger portions to keep the
+    // amount of memory moves low
+    const int64_t needed = int64_t(m_pos) - (reach - 1);
+    const int64_t obsolete = std::min(needed, end) - m_historyPos;
+    if (obsolete >= READ_CHUNK_FRAMES) {
+        for (int ch = 0; ch < m_channels; ++ch)
+            m_history[ch].erase(m_history[ch].begin(), m_history[ch].begin() + obsolete);
+        m_historyPos += obsolete;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+// class 'Quantizer'
+
+Quantizer::Quantizer(int bitDepth, bool dither) :
+    m_bytes(bitDepth / 8), m_dither(dither), m_seed(0x2545f491)
+{
+    m_scale = (bitDepth == 24) ? 8388608.f : 32768.f;
+    m_max = m_scale - 1.f;
+}
+
+/// Triangular distributed noise in the range -1 .. +1 (LSB).
+inline float Quantizer::noise() {
+    // two uniformly distributed values by xorshift32
+    float r[2];
+    for (int i = 0; i < 2; ++i) {
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+        r[i] = float(m_seed >> 8) * (1.f / 16777216.f);
+    }
+    return r[0] - r[1];
+}
+
+void Quantizer::process(const float* in, size_t samples, uint8_t* out) {
+    for (size_t i = 0; i < samples; ++i) {
+        float v = in[i] * m_scale;
+        if (m_dither) v += noise();
+        v = std::min(std::max(floorf(v + 0.5f), -m_scale), m_max);
+        const int32_t s = int32_t(v);
+        *out++ = uint8_t(s);
+        *out++ = uint8_t(s >> 8);
+        if (m_bytes == 3) *out++ = uint8_t(s >> 16);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+// import functions
+
+int bitDepthOfSoundFileFormat(int format) {
+    switch (format & 0xff) {
+        case SF_FORMAT_PCM_S8:
+        case SF_FORMAT_PCM_16:
+        case SF_FORMAT_PCM_U8:
+            return 16;
+        case SF_FORMAT_PCM_24:
+        case SF_FORMAT_PCM_32:
+        case SF_FORMAT_FLOAT:
+        case SF_FORMAT_DOUBLE:
+            return 24;
+    }
+    return 0; // unsupported subformat (yet?)
+}
+
+uint64_t convertFramePosition(uint64_t pos, int inRate, int outRate) {
+    if (inRate == outRate || inRate <= 0) return pos;
+    return (pos * uint64_t(outRate) + uint64_t(inRate) / 2) / uint64_t(inRate);
+}
+
+/**
+ * Writes @a frames frames from @a buffer at the current write position of
+ * @a sample, optionally serialized by @a ioMutex.
+ */
+static void writeFrames(gig::Sample* sample, void* buffer, gig::file_offset_t frames,
+                        std::mutex* ioMutex)
+{
+    if (ioMutex) {
+        std::lock_guard<std::mutex> lock(*ioMutex);
+        sample->Write(buffer, frames);
+    } else {
+        sample->Write(buffer, frames);
+    }
+}
+
+/// Copies the audio data without sample rate conversion and without dither.
+static void importFramesDirect(SNDFILE* hFile, const SF_INFO& info, int bitDepth,
+                               gig::Sample* sample, std::mutex* ioMutex)
+{
+    sf_count_t cnt = info.frames;
+    switch (bitDepth) {
+        case 16: {
+            std::vector<short> buffer(READ_CHUNK_FRAMES * info.channels);
+            while (cnt > 0) {
+                // libsndfile does the conversion for us (if needed)
+                const sf_count_t n = sf_readf_short(hFile, &buffer[0], READ_CHUNK_FRAMES);
+                if (n <= 0) break;
+                // write from buffer directly (physically) into .gig file
+                writeFrames(sample, &buffer[0], n, ioMutex);
+                cnt -= n;
+            }
+            break;
+        }
+        case 24: {
+            std::vector<int> srcbuf(READ_CHUNK_FRAMES * info.channels);
+            std::vector<uint8_t> dstbuf(READ_CHUNK_FRAMES * 3 * info.channels);
+            while (cnt > 0) {
+                // libsndfile returns 32 bits, convert to 24
+                const sf_count_t n = sf_readf_int(hFile, &srcbuf[0], READ_CHUNK_FRAMES);
+                if (n <= 0) break;
+                int j = 0;
+                for (int i = 0 ; i < n * info.channels ; i++) {
+                    dstbuf[j++] = srcbuf[i] >> 8;
+                    dstbuf[j++] = srcbuf[i] >> 16;
+                    dstbuf[j++] = srcbuf[i] >> 24;
+                }
+                // write from buffer directly (physically) into .gig file
+                writeFrames(sample, &dstbuf[0], n, ioMutex);
+                cnt -= n;
+            }
+            break;
+        }
+    }
+}
+
+/// Imports the audio data with sample rate conversion and / or dither.
+static void importFramesConverted(SNDFILE* hFile, const SF_INFO& info,
+                                  int sampleRate, int bitDepth, bool dither,
+                                  gig::Sample* sample, std::mutex* ioMutex)
+{
+    const bool resample = (sampleRate != info.samplerate);
+    Resampler resampler(info.samplerate, sampleRate, info.channels);
+    Quantizer quantizer(bitDepth, dither);
+    uint64_t remaining = Resampler::outputFrames(info.frames, info.samplerate, sampleRate);
+
+    std::vector<float> in(READ_CHUNK_FRAMES * info.channels);
+    std::vector<float> converted;
+    std::vector<uint8_t> out;
+    bool eof = false;
+    while (remaining) {
+        converted.clear();
+        const sf_count_t n = sf_readf_float(hFile, &in[0], READ_CHUNK_FRAMES);
+        if (n <= 0) eof = true;
+        if (!resample) {
+            if (!eof) converted.assign(in.begin(), in.begin() + n * info.channels);
+        } else if (eof) {
+            resampler.flush(converted);
+        } else {
+            resampler.process(&in[0], n, converted);
+        }
+        uint64_t frames = std::min<uint64_t>(converted.size() / info.channels, remaining);
+        if (frames) {
+            out.resize(frames * info.channels * (bitDepth / 8));
+            quantizer.process(&converted[0], frames * info.channels, &out[0]);
+            writeFrames(sample, &out[0], frames, ioMutex);
+            remaining -= frames;
+        }
+        if (eof) break;
+    }
+}
+
+void importAudioFile(const std::string& path, gig::Sample* sample,
+                     const SampleConversion& conversion, std::mutex* ioMutex)
+{
+    SF_INFO info;
+    info.format = 0;
+    SNDFILE* hFile = sf_open(path.c_str(), SFM_READ, &info);
+    if (!hFile) throw std::string(_("could not open file"));
+    sf_command(hFile, SFC_SET_SCALE_FLOAT_INT_READ, 0, SF_TRUE);
+    try {
+        // determine sample's bit depth
+        const int fileBitDepth = bitDepthOfSoundFileFormat(info.format);
+        if (!fileBitDepth)
+            throw std::string(_("format not supported"));
+        const int bitDepth =
+            (conversion.bitDepth) ? conversion.bitDepth : fileBitDepth;
+        const int sampleRate =
+            (conversion.sampleRate) ? conversion.sampleRate : info.samplerate;
+
+        // reset write position for sample
+        if (ioMutex) {
+            std::lock_guard<std::mutex> lock(*ioMutex);
+            sample->SetPos(0);
+        } else {
+            sample->SetPos(0);
+        }
+
+        // only go the float route if really necessary, the direct route is
+        // lossless for all source formats with not more than the target bits
+        if (sampleRate != info.samplerate || bitDepth < fileBitDepth) {
+            importFramesConverted(hFile, info, sampleRate, bitDepth,
+                                  conversion.dither, sample, ioMutex);
+        } else {
+            importFramesDirect(hFile, info, bitDepth, sample, ioMutex);
+        }
+    } catch (...) {
+        sf_close(hFile);
+        throw;
+    }
+    sf_close(hFile);
+}
+
+void importAudioFiles(std::vector<AudioFileImport>& imports) {
+    std::sort(imports.begin(), imports.end(),
+        [](const AudioFileImport& a, const AudioFileImport& b) {
+            return a.sample->SamplesTotal * a.sample->FrameSize >
+                   b.sample->SamplesTotal * b.sample->FrameSize;
+        });
+    std::mutex ioMutex;
+    parallelFor(imports.size(), [&](size_t i) {
+        GIGEDIT_TRACE_SCOPE("importAudioFile");
+        try {
+            importAudioFile(imports[i].path, imports[i].sample,
+                            imports[i].conversion, &ioMutex);
+        } catch (std::string what) {
+            imports[i].error = what;
+        } catch (RIFF::Exception e) {
+            imports[i].error = e.Message;
+        }
+    });
+}
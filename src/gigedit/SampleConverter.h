@@ -0,0 +1,141 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_SAMPLECONVERTER_H
+#define GIGEDIT_SAMPLECONVERTER_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <mutex>
+
+/**
+ * Target format of an audio file to be imported into a gig::Sample.
+ */
+struct SampleConversion {
+    int sampleRate; ///< target sample rate in Hz, or 0 for keeping the audio file's sample rate
+    int bitDepth; ///< target bit depth (16 or 24), or 0 for the bit depth matching the audio file's format best
+    bool dither; ///< whether TPDF dither shall be applied when the bit depth is reduced
+
+    SampleConversion() : sampleRate(0), bitDepth(0), dither(true) {}
+};
+
+/** @brief Streaming polyphase sample rate converter.
+ *
+ * Converts interleaved float audio from one sample rate to another by a
+ * Kaiser windowed sinc filter, whose coefficients are precomputed for each
+ * phase of the rational conversion ratio. Audio may be fed in arbitrary
+ * portions, only the few input frames covered by the filter are buffered.
+ */
+class Resampler {
+public:
+    Resampler(int inRate, int outRate, int channels);
+
+    /**
+     * Converts @a frames interleaved input frames and appends all output
+     * frames which can be calculated so far to @a out.
+     */
+    void process(const float* in, size_t frames, std::vector<float>& out);
+
+    /**
+     * Feeds silence to calculate the output frames still pending due to
+     * the filter delay, and appends them to @a out.
+     */
+    void flush(std::vector<float>& out);
+
+    /// Amount of output frames resulting from @a frames input frames.
+    static uint64_t outputFrames(uint64_t frames, int inRate, int outRate);
+
+private:
+    int m_channels;
+    int m_up; ///< interpolation factor (L)
+    int m_down; ///< decimation factor (M)
+    int m_taps; ///< filter length (in input frames)
+    int m_phases; ///< amount of precomputed filter phases
+    std::vector<float> m_coeffs; ///< m_phases * m_taps, each phase in convolution order
+    std::vector< std::vector<float> > m_history; ///< buffered input, per channel
+    int64_t m_historyPos; ///< input frame index of m_history[c][0] (negative at the beginning)
+    uint64_t m_inputFrames; ///< input frames received so far
+    uint64_t m_outputFrames; ///< output frames calculated so far
+    uint64_t m_pos; ///< input frame index of the next output frame
+    int m_phase; ///< fractional position of the next output frame (in 1/m_up)
+
+    void produce(std::vector<float>& out, uint64_t limit);
+};
+
+/** @brief Float to integer conversion with optional TPDF dither.
+ *
+ * Converts float audio (-1.0 .. 1.0) to 16 or 24 bit little endian PCM as
+ * used by gig::Sample. If dither is enabled, triangular distributed noise of
+ * +/- 1 LSB is added before rounding.
+ */
+class Quantizer {
+public:
+    Quantizer(int bitDepth, bool dither);
+    void process(const float* in, size_t samples, uint8_t* out);
+
+private:
+    int m_bytes;
+    float m_scale;
+    float m_max;
+    bool m_dither;
+    uint32_t m_seed;
+
+    inline float noise();
+};
+
+/**
+ * Returns the bit depth (16 or 24) to be used in a gig file for the given
+ * libsndfile format, or 0 if that format is not supported.
+ */
+int bitDepthOfSoundFileFormat(int format);
+
+/**
+ * Scales a sample point position from sample rate @a inRate to @a outRate.
+ */
+uint64_t convertFramePosition(uint64_t pos, int inRate, int outRate);
+
+/**
+ * Reads the audio file @a path and writes its audio data to @a sample, which
+ * must already have the target sample rate, bit depth and size applied. The
+ * audio data is converted on the fly, in portions of constant size.
+ *
+ * @param ioMutex - optional mutex locked while writing to the gig file
+ * @throws std::string if the file could not be read
+ */
+void importAudioFile(const std::string& path, gig::Sample* sample,
+                     const SampleConversion& conversion,
+                     std::mutex* ioMutex = NULL);
+
+/**
+ * An audio file to be imported into a gig::Sample by importAudioFiles().
+ */
+struct AudioFileImport {
+    std::string path; ///< audio file to be imported
+    gig::Sample* sample; ///< target sample, see importAudioFile()
+    SampleConversion conversion; ///< format conversion applied on import
+    std::string error; ///< empty if imported successfully, otherwise the cause of failure
+
+    AudioFileImport() : sample(NULL) {}
+};
+
+/**
+ * Imports all audio files of @a imports by importAudioFile(). Reading and
+ * converting the audio files is done on several threads, largest samples
+ * first, only writing to the gig file is serialized. @a imports is sorted
+ * accordingly. Failures are stored to the respective AudioFileImport::error
+ * instead of being thrown.
+ */
+void importAudioFiles(std::vector<AudioFileImport>& imports);
+
+#endif // GIGEDIT_SAMPLECONVERTER_H
@@ -54,6 +54,11 @@ static std::string groupName(Settings::Group_t group) {
         case Settings::MACRO_EDITOR: return "MacroEditor";
         case Settings::MACROS_SETUP: return "MacrosSetup";
         case Settings::MACROS: return "Macros";
+        case Settings::DUPLICATE_SAMPLES: return "DuplicateSamples";
+        case Settings::PARAM_SHEET: return "ParamSheet";
+        case Settings::DIMREGION_SEARCH: return "DimRegionSearch";
+        case Settings::LINT_VIEW: return "LintView";
+        case Settings::MAPPED_IMPORT: return "MappedImport";
     }
     return "Global";
 }
@@ -89,6 +94,14 @@ Settings::Settings() : Glib::ObjectBase(typeid(Settings)),
     saveWithTemporaryFile(*this, GLOBAL, "saveWithTemporaryFile", false),
     showTooltips(*this, GLOBAL, "showNewbieTooltips", true),
     instrumentDoubleClickOpensProps(*this, GLOBAL, "openInstrPropsByDoubleClick", true),
+    detectPitchOnImport(*this, GLOBAL, "detectPitchOnImport", false),
+    importSampleRate(*this, GLOBAL, "importSampleRate", 0),
+    importBitDepth(*this, GLOBAL, "importBitDepth", 0),
+    importDither(*this, GLOBAL, "importDither", true),
+    liveParameterEditing(*this, GLOBAL, "liveParameterEditing", false),
+    undoMemoryLimit(*this, GLOBAL, "undoMemoryLimit", 64),
+    mappedImportPattern(*this, GLOBAL, "mappedImportPattern", ""),
+    mappedImportRecursive(*this, GLOBAL, "mappedImportRecursive", true),
     mainWindowX(*this, MAIN_WINDOW, "x", -1),
     mainWindowY(*this, MAIN_WINDOW, "y", -1),
     mainWindowW(*this, MAIN_WINDOW, "w", -1),
@@ -138,6 +151,26 @@ Settings::Settings() : Glib::ObjectBase(typeid(Settings)),
     macrosSetupWindowY(*this, MACROS_SETUP, "y", -1),
     macrosSetupWindowW(*this, MACROS_SETUP, "w", -1),
     macrosSetupWindowH(*this, MACROS_SETUP, "h", -1),
+    duplicateSamplesWindowX(*this, DUPLICATE_SAMPLES, "x", -1),
+    duplicateSamplesWindowY(*this, DUPLICATE_SAMPLES, "y", -1),
+    duplicateSamplesWindowW(*this, DUPLICATE_SAMPLES, "w", -1),
+    duplicateSamplesWindowH(*this, DUPLICATE_SAMPLES, "h", -1),
+    paramSheetWindowX(*this, PARAM_SHEET, "x", -1),
+    paramSheetWindowY(*this, PARAM_SHEET, "y", -1),
+    paramSheetWindowW(*this, PARAM_SHEET, "w", -1),
+    paramSheetWindowH(*this, PARAM_SHEET, "h", -1),
+    dimRegionSearchWindowX(*this, DIMREGION_SEARCH, "x", -1),
+    dimRegionSearchWindowY(*this, DIMREGION_SEARCH, "y", -1),
+    dimRegionSearchWindowW(*this, DIMREGION_SEARCH, "w", -1),
+    dimRegionSearchWindowH(*this, DIMREGION_SEARCH, "h", -1),
+    lintViewWindowX(*this, LINT_VIEW, "x", -1),
+    lintViewWindowY(*this, LINT_VIEW, "y", -1),
+    lintViewWindowW(*this, LINT_VIEW, "w", -1),
+    lintViewWindowH(*this, LINT_VIEW, "h", -1),
+    mappedImportWindowX(*this, MAPPED_IMPORT, "x", -1),
+    mappedImportWindowY(*this, MAPPED_IMPORT, "y", -1),
+    mappedImportWindowW(*this, MAPPED_IMPORT, "w", -1),
+    mappedImportWindowH(*this, MAPPED_IMPORT, "h", -1),
     m_ignoreNotifies(false)
 {
     m_boolProps.push_back(&warnUserOnExtensions);
@@ -147,6 +180,13 @@ Settings::Settings() : Glib::ObjectBase(typeid(Settings)),
     m_boolProps.push_back(&saveWithTemporaryFile);
     m_boolProps.push_back(&showTooltips);
     m_boolProps.push_back(&instrumentDoubleClickOpensProps);
+    m_boolProps.push_back(&detectPitchOnImport);
+    m_boolProps.push_back(&importDither);
+    m_boolProps.push_back(&liveParameterEditing);
+    m_boolProps.push_back(&mappedImportRecursive);
+    m_intProps.push_back(&importSampleRate);
+    m_intProps.push_back(&importBitDepth);
+    m_intProps.push_back(&undoMemoryLimit);
     m_intProps.push_back(&mainWindowX);
     m_intProps.push_back(&mainWindowY);
     m_intProps.push_back(&mainWindowW);
@@ -196,6 +236,27 @@ Settings::Settings() : Glib::ObjectBase(typeid(Settings)),
     m_intProps.push_back(&macrosSetupWindowY);
     m_intProps.push_back(&macrosSetupWindowW);
     m_intProps.push_back(&macrosSetupWindowH);
+    m_intProps.push_back(&duplicateSamplesWindowX);
+    m_intProps.push_back(&duplicateSamplesWindowY);
+    m_intProps.push_back(&duplicateSamplesWindowW);
+    m_intProps.push_back(&duplicateSamplesWindowH);
+    m_intProps.push_back(&paramSheetWindowX);
+    m_intProps.push_back(&paramSheetWindowY);
+    m_intProps.push_back(&paramSheetWindowW);
+    m_intProps.push_back(&paramSheetWindowH);
+    m_intProps.push_back(&dimRegionSearchWindowX);
+    m_intProps.push_back(&dimRegionSearchWindowY);
+    m_intProps.push_back(&dimRegionSearchWindowW);
+    m_intProps.push_back(&dimRegionSearchWindowH);
+    m_intProps.push_back(&lintViewWindowX);
+    m_intProps.push_back(&lintViewWindowY);
+    m_intProps.push_back(&lintViewWindowW);
+    m_intProps.push_back(&lintViewWindowH);
+    m_intProps.push_back(&mappedImportWindowX);
+    m_intProps.push_back(&mappedImportWindowY);
+    m_intProps.push_back(&mappedImportWindowW);
+    m_intProps.push_back(&mappedImportWindowH);
+    m_stringProps.push_back(&mappedImportPattern);
 }
 
 void Settings::onPropertyChanged(Glib::PropertyBase* pProperty, RawValueType_t type, Group_t group) {
@@ -226,6 +287,12 @@ void Settings::onPropertyChanged(Glib::PropertyBase* pProperty, RawValueType_t t
             file.set_integer(groupName(prop->group()), prop->get_name(), prop->get_value());
             break;
         }
+        case STRING: {
+            Property<Glib::ustring>* prop = static_cast<Property<Glib::ustring>*>(pProperty);
+            //std::cout << "Saving string setting '" << prop->get_name() << "'\n" << std::flush;
+            file.set_string(groupName(prop->group()), prop->get_name(), prop->get_value());
+            break;
+        }
         case UNKNOWN:
             std::cerr << "BUG: Unknown setting raw type of property '" << pProperty->get_name() << "'\n" << std::flush;
             return;
@@ -286,6 +353,19 @@ void Settings::load() {
         }
     }
 
+    for (int i = 0; i < m_stringProps.size(); ++i) {
+        Property<Glib::ustring>* prop = static_cast<Property<Glib::ustring>*>(m_stringProps[i]);
+        try {
+            const std::string group = groupName(prop->group());
+            if (!file.has_group(group)) continue;
+            if (!file.has_key(group, prop->get_name())) continue;
+            const Glib::ustring value = file.get_string(group, prop->get_name());
+            prop->set_value(value);
+        } catch (...) {
+            continue;
+        }
+    }
+
     m_ignoreNotifies = false;
 }
 
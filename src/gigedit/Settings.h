@@ -30,6 +30,7 @@ public:
     enum RawValueType_t {
         BOOLEAN,
         INTEGER,
+        STRING,
         UNKNOWN
     };
 
@@ -51,6 +52,11 @@ public:
         MACRO_EDITOR,
         MACROS_SETUP,
         MACROS,
+        DUPLICATE_SAMPLES,
+        PARAM_SHEET,
+        DIMREGION_SEARCH,
+        LINT_VIEW,
+        MAPPED_IMPORT,
     };
 
     /**
@@ -112,6 +118,7 @@ public:
             const std::string name = typeid(T).name();
             if (name == "bool" || name == "b") return BOOLEAN;
             if (name == "int" || name == "i") return INTEGER;
+            if (typeid(T) == typeid(Glib::ustring)) return STRING;
             return UNKNOWN;
         }
 
@@ -130,6 +137,14 @@ public:
     Property<bool> saveWithTemporaryFile; ///< If enabled and the user selects "Save" from the main menu, then the file is first saved as separate temporary file and after the save operation completed the temporary file is moved over the original file.
     Property<bool> showTooltips; ///< Whether tooltips specifically intended for newbies should be displayed throughout the application (default: yes).
     Property<bool> instrumentDoubleClickOpensProps; ///< If enabled then double clicking on an instrument of the instruments list view will show the selected instrument's properties dialog.
+    Property<bool> detectPitchOnImport; ///< If enabled then the pitch of newly added samples without unity note information is detected from their audio data, to set their unity note and fine tune accordingly.
+    Property<int> importSampleRate; ///< Sample rate (in Hz) audio files shall be converted to when added as samples, 0 for keeping their sample rate.
+    Property<int> importBitDepth; ///< Bit depth (16 or 24) audio files shall be converted to when added as samples, 0 for keeping their bit depth.
+    Property<bool> importDither; ///< Whether dither shall be applied when the bit depth of added audio files is reduced.
+    Property<bool> liveParameterEditing; ///< If enabled then plain dimension region parameters are published to the sampler by single atomic writes, instead of suspending the affected regions while being edited.
+    Property<int> undoMemoryLimit; ///< Maximum amount of memory (in MB) the undo/redo history of a file may occupy.
+    Property<Glib::ustring> mappedImportPattern; ///< File name pattern for extracting note, velocity and round robin numbers when creating an instrument from a folder, empty for automatic detection.
+    Property<bool> mappedImportRecursive; ///< Whether subfolders are searched as well when creating an instrument from a folder.
 
     // settings of "MainWindow" group
     Property<int> mainWindowX;
@@ -204,6 +219,36 @@ public:
     Property<int> macrosSetupWindowW;
     Property<int> macrosSetupWindowH;
 
+    // settings of "DuplicateSamples" group
+    Property<int> duplicateSamplesWindowX;
+    Property<int> duplicateSamplesWindowY;
+    Property<int> duplicateSamplesWindowW;
+    Property<int> duplicateSamplesWindowH;
+
+    // settings of "ParamSheet" group
+    Property<int> paramSheetWindowX;
+    Property<int> paramSheetWindowY;
+    Property<int> paramSheetWindowW;
+    Property<int> paramSheetWindowH;
+
+    // settings of "DimRegionSearch" group
+    Property<int> dimRegionSearchWindowX;
+    Property<int> dimRegionSearchWindowY;
+    Property<int> dimRegionSearchWindowW;
+    Property<int> dimRegionSearchWindowH;
+
+    // settings of "LintView" group
+    Property<int> lintViewWindowX;
+    Property<int> lintViewWindowY;
+    Property<int> lintViewWindowW;
+    Property<int> lintViewWindowH;
+
+    // settings of "MappedImport" group
+    Property<int> mappedImportWindowX;
+    Property<int> mappedImportWindowY;
+    Property<int> mappedImportWindowW;
+    Property<int> mappedImportWindowH;
+
     static Settings* singleton();
     Settings();
     void load();
@@ -216,6 +261,7 @@ protected:
 private:
     std::vector<Glib::PropertyBase*> m_boolProps; ///< Pointers to all 'bool' type properties this Setting class manages.
     std::vector<Glib::PropertyBase*> m_intProps; ///< Pointers to all 'int' type properties this Setting class manages.
+    std::vector<Glib::PropertyBase*> m_stringProps; ///< Pointers to all 'Glib::ustring' type properties this Setting class manages.
     bool m_ignoreNotifies;
 };
 
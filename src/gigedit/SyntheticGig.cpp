@@ -0,0 +1,77 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "SyntheticGig.h"
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+#ifndef M_PI
+# define M_PI 3.14159265358979323846
+#endif
+
+void createSyntheticGig(const std::string& path, const SyntheticGigParams& params) {
+    const int regions = (params.regions < 1) ? 1 :
+                        (params.regions > 128) ? 128 : params.regions;
+
+    gig::File gig;
+    gig.pInfo->Name = "Synthetic Benchmark File";
+
+    std::vector<gig::Sample*> samples;
+    for (int i = 0; i < params.samples; ++i) {
+        gig::Sample* sample = gig.AddSample();
+        sample->pInfo->Name = "Sample " + std::to_string(i + 1);
+        sample->Channels = 1;
+        sample->BitDepth = 16;
+        sample->FrameSize = 2;
+        sample->SamplesPerSecond = 44100;
+        sample->AverageBytesPerSecond = sample->FrameSize * sample->SamplesPerSecond;
+        sample->BlockAlign = sample->FrameSize;
+        sample->SamplesTotal = params.sampleFrames;
+        sample->MIDIUnityNote = 36 + i % 60;
+        sample->Resize(params.sampleFrames);
+        samples.push_back(sample);
+    }
+
+    int iSample = 0;
+    for (int i = 0; i < params.instruments; ++i) {
+        gig::Instrument* instrument = gig.AddInstrument();
+        instrument->pInfo->Name = "Instrument " + std::to_string(i + 1);
+        for (int r = 0; r < regions; ++r) {
+            gig::Region* rgn = instrument->AddRegion();
+            rgn->SetKeyRange(r * 128 / regions, (r + 1) * 128 / regions - 1);
+            if (params.velocityBits > 0) {
+                gig::dimension_def_t dim;
+                dim.dimension = gig::dimension_velocity;
+                dim.bits = params.velocityBits;
+                dim.zones = 1 << dim.bits;
+                rgn->AddDimension(&dim);
+            }
+            for (int d = 0; d < rgn->DimensionRegions; ++d) {
+                gig::DimensionRegion* dimrgn = rgn->pDimensionRegions[d];
+                if (!dimrgn || samples.empty()) continue;
+                dimrgn->pSample = samples[iSample++ % samples.size()];
+            }
+        }
+    }
+
+    // write the headers first, which reserves the space for the sample data
+    gig.Save(path);
+
+    std::vector<int16_t> wave(params.sampleFrames);
+    for (int i = 0; i < params.sampleFrames; ++i)
+        wave[i] = int16_t(16000.0 * sin(2.0 * M_PI * 220.0 * i / 44100.0));
+    for (size_t i = 0; i < samples.size(); ++i)
+        if (!wave.empty()) samples[i]->Write(&wave[0], wave.size());
+}
@@ -0,0 +1,36 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_SYNTHETICGIG_H
+#define GIGEDIT_SYNTHETICGIG_H
+
+#include <string>
+
+/**
+ * Layout of a synthetic .gig file created by createSyntheticGig().
+ */
+struct SyntheticGigParams {
+    int instruments; ///< amount of instruments
+    int regions; ///< amount of regions per instrument (at most 128, spread evenly over the keyboard)
+    int velocityBits; ///< bits of the velocity dimension of each region, 0 for no dimension (1 dimension region per region)
+    int samples; ///< amount of samples (assigned to the dimension regions round robin)
+    int sampleFrames; ///< length of each sample (mono, 16 bit, 44.1 kHz)
+
+    SyntheticGigParams() :
+        instruments(1), regions(16), velocityBits(0), samples(16),
+        sampleFrames(44100) {}
+};
+
+/**
+ * Creates a .gig file at @a path with the layout given by @a params. All
+ * samples contain a sine wave.
+ *
+ * @throws RIFF::Exception on errors
+ */
+void createSyntheticGig(const std::string& path, const SyntheticGigParams& params);
+
+#endif // GIGEDIT_SYNTHETICGIG_H
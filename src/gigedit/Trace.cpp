@@ -0,0 +1,206 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "Trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+std::atomic<bool> g_traceEnabled(false);
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+/**
+ * Ring buffer of the spans of one thread. Only the owning thread writes
+ * events, and publishes them by incrementing @c count, so recording needs
+ * no lock. A buffer is handed over to the next new thread after its thread
+ * terminated, since threads like the Loader are started over and over again.
+ */
+struct TraceBuffer {
+    enum { CAPACITY = 16384 };
+
+    TraceEvent events[CAPACITY];
+    std::atomic<uint64_t> count; ///< total amount of events written so far
+    std::atomic<uint64_t> clearedAt; ///< value of @c count when clearTrace() was called
+    std::atomic<const char*> threadName;
+    int tid;
+    bool inUse; ///< protected by g_buffersMutex
+
+    TraceBuffer(int tid) : count(0), clearedAt(0), threadName(NULL), tid(tid), inUse(true) {}
+};
+
+std::mutex g_buffersMutex;
+std::vector<TraceBuffer*> g_buffers; // never freed, see TraceBuffer
+std::string g_traceFileAtExit;
+
+struct ThreadSlot {
+    TraceBuffer* buffer;
+    const char* name;
+
+    ThreadSlot() : buffer(NULL), name(NULL) {}
+
+    ~ThreadSlot() {
+        if (!buffer) return;
+        std::lock_guard<std::mutex> lock(g_buffersMutex);
+        buffer->inUse = false;
+    }
+};
+
+thread_local ThreadSlot t_slot;
+
+TraceBuffer* threadBuffer() {
+    if (t_slot.buffer) return t_slot.buffer;
+    std::lock_guard<std::mutex> lock(g_buffersMutex);
+    TraceBuffer* buffer = NULL;
+    for (size_t i = 0; i < g_buffers.size() && !buffer; ++i) {
+        if (!g_buffers[i]->inUse) {
+            buffer = g_buffers[i];
+            buffer->inUse = true;
+        }
+    }
+    if (!buffer) {
+        buffer = new TraceBuffer(int(g_buffers.size()) + 1);
+        g_buffers.push_back(buffer);
+    }
+    buffer->threadName = t_slot.name;
+    t_slot.buffer = buffer;
+    return buffer;
+}
+
+void writeJsonString(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; s && *s; ++s) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        if ((unsigned char)*s < 0x20) fputc(' ', f);
+        else fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+void writeTraceAtExit() {
+    if (g_traceFileAtExit.empty()) return;
+    if (writeChromeTrace(g_traceFileAtExit))
+        fprintf(stderr, "Trace written to '%s'\n", g_traceFileAtExit.c_str());
+    else
+        fprintf(stderr, "Could not write trace to '%s'\n", g_traceFileAtExit.c_str());
+}
+
+} // namespace
+
+void setTraceEnabled(bool enabled) {
+    g_traceEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void clearTrace() {
+    std::lock_guard<std::mutex> lock(g_buffersMutex);
+    for (size_t i = 0; i < g_buffers.size(); ++i)
+        g_buffers[i]->clearedAt = g_buffers[i]->count.load(std::memory_order_acquire);
+}
+
+uint64_t traceTime() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+void traceSpan(const char* name, uint64_t begin, uint64_t end) {
+    TraceBuffer* buffer = threadBuffer();
+    const uint64_t n = buffer->count.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer->events[n % TraceBuffer::CAPACITY];
+    event.name = name;
+    event.begin = begin;
+    event.end = end;
+    buffer->count.store(n + 1, std::memory_order_release);
+}
+
+void setTraceThreadName(const char* name) {
+    t_slot.name = name;
+    if (t_slot.buffer) t_slot.buffer->threadName = name;
+}
+
+bool writeChromeTrace(const std::string& path) {
+    struct Span {
+        int tid;
+        TraceEvent event;
+    };
+    std::vector<Span> spans;
+    std::vector< std::pair<int,const char*> > threads;
+    {
+        std::lock_guard<std::mutex> lock(g_buffersMutex);
+        for (size_t i = 0; i < g_buffers.size(); ++i) {
+            TraceBuffer* buffer = g_buffers[i];
+            const uint64_t end = buffer->count.load(std::memory_order_acquire);
+            uint64_t begin = buffer->clearedAt;
+            if (end - begin > TraceBuffer::CAPACITY)
+                begin = end - TraceBuffer::CAPACITY;
+            const size_t first = spans.size();
+            for (uint64_t k = begin; k < end; ++k) {
+                Span span = { buffer->tid, buffer->events[k % TraceBuffer::CAPACITY] };
+                spans.push_back(span);
+            }
+            // drop events the thread overwrote meanwhile, including the one
+            // it might be writing right now (event number "now")
+            const uint64_t now = buffer->count.load(std::memory_order_acquire);
+            if (now - begin >= TraceBuffer::CAPACITY) {
+                const uint64_t lost = std::min(now - begin - TraceBuffer::CAPACITY + 1, end - begin);
+                spans.erase(spans.begin() + first, spans.begin() + first + lost);
+            }
+            threads.push_back(std::make_pair(buffer->tid, buffer->threadName.load()));
+        }
+    }
+
+    uint64_t origin = UINT64_MAX;
+    for (size_t i = 0; i < spans.size(); ++i)
+        origin = std::min(origin, spans[i].event.begin);
+
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (size_t i = 0; i < threads.size(); ++i) {
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                first ? "" : ",\n", threads[i].first);
+        if (threads[i].second) {
+            writeJsonString(f, threads[i].second);
+        } else {
+            fprintf(f, "\"thread %d\"", threads[i].first);
+        }
+        fprintf(f, "}}");
+        first = false;
+    }
+    for (size_t i = 0; i < spans.size(); ++i) {
+        const TraceEvent& e = spans[i].event;
+        fprintf(f, "%s{\"name\":", first ? "" : ",\n");
+        writeJsonString(f, e.name);
+        fprintf(f, ",\"cat\":\"gigedit\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                spans[i].tid, double(e.begin - origin) / 1000.0,
+                double(e.end - e.begin) / 1000.0);
+        first = false;
+    }
+    fprintf(f, "\n]}\n");
+    const bool ok = !ferror(f);
+    return (fclose(f) == 0) && ok;
+}
+
+void initTraceFromEnvironment() {
+    const char* path = getenv("GIGEDIT_TRACE");
+    if (!path || !*path || !g_traceFileAtExit.empty()) return;
+    g_traceFileAtExit = path;
+    setTraceEnabled(true);
+    atexit(writeTraceAtExit);
+}
@@ -0,0 +1,100 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_TRACE_H
+#define GIGEDIT_TRACE_H
+
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+/** @file
+ * Built-in performance tracing.
+ *
+ * Time spans of interest are marked in the code with GIGEDIT_TRACE_SCOPE().
+ * While tracing is disabled (default) this costs just one relaxed atomic load
+ * per span. While enabled, each thread records its spans into its own
+ * preallocated ring buffer without any locking, so tracing does not change
+ * the timing of the traced code much. The recording can then be written as
+ * Chrome trace JSON file, which can be viewed with chrome://tracing or
+ * https://ui.perfetto.dev
+ *
+ * Tracing can be enabled by the "Tools" menu, or by setting the environment
+ * variable GIGEDIT_TRACE to a file name, in which case the recording is
+ * written to that file when gigedit exits.
+ */
+
+extern std::atomic<bool> g_traceEnabled;
+
+inline bool isTraceEnabled() {
+    return g_traceEnabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Starts or stops recording spans. Stopping keeps the spans recorded so far.
+ */
+void setTraceEnabled(bool enabled);
+
+/// Discards all spans recorded so far.
+void clearTrace();
+
+/// Current time of the trace clock in nanoseconds.
+uint64_t traceTime();
+
+/**
+ * Records a span of the calling thread. @a name must be a string literal (or
+ * otherwise stay valid until the recording is written).
+ */
+void traceSpan(const char* name, uint64_t begin, uint64_t end);
+
+/**
+ * Gives the calling thread a name which is shown for it by trace viewers.
+ * @a name must be a string literal.
+ */
+void setTraceThreadName(const char* name);
+
+/**
+ * Writes all spans recorded so far in Chrome's trace event JSON format to
+ * the file @a path.
+ *
+ * @returns false if the file could not be written
+ */
+bool writeChromeTrace(const std::string& path);
+
+/**
+ * Enables tracing if the environment variable GIGEDIT_TRACE is set, and
+ * arranges the recording to be written to the file it names on exit.
+ */
+void initTraceFromEnvironment();
+
+/** @brief Records the lifetime of a scope as trace span.
+ *
+ * Usually used by macro GIGEDIT_TRACE_SCOPE().
+ */
+class TraceScope {
+public:
+    TraceScope(const char* name) : m_name(name), m_active(isTraceEnabled()) {
+        if (m_active) m_begin = traceTime();
+    }
+
+    ~TraceScope() {
+        if (m_active) traceSpan(m_name, m_begin, traceTime());
+    }
+private:
+    const char* m_name;
+    bool m_active;
+    uint64_t m_begin;
+};
+
+#define GIGEDIT_TRACE_CONCAT_(a, b) a ## b
+#define GIGEDIT_TRACE_CONCAT(a, b) GIGEDIT_TRACE_CONCAT_(a, b)
+
+/// Records the time until the end of the current scope as span @a name.
+#define GIGEDIT_TRACE_SCOPE(name) \
+    TraceScope GIGEDIT_TRACE_CONCAT(gigeditTraceScope, __LINE__)(name)
+
+#endif // GIGEDIT_TRACE_H
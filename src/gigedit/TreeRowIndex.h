@@ -0,0 +1,114 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_TREEROWINDEX_H
+#define GIGEDIT_TREEROWINDEX_H
+
+#ifdef GTKMM_HEADER_FILE
+# include GTKMM_HEADER_FILE(gtkmm.h)
+#else
+# include <gtkmm.h>
+#endif
+
+#include <unordered_map>
+
+/** @brief Maps objects to the rows of a tree model listing them.
+ *
+ * Finding the row of an object by walking a Gtk::TreeModel is linear in the
+ * amount of rows, which gets noticeable with tens of thousands of samples or
+ * instruments. This index keeps a hash map from the object pointers stored in
+ * one column of the model to their rows instead, and follows the model's
+ * signals: rows are added to the index as soon as their object column is
+ * assigned, whereas removing rows invalidates the whole index, which is then
+ * rebuilt by the next lookup (rows are usually removed in bulk, i.e. by
+ * clear()).
+ *
+ * Relies on the model's iterators staying valid as long as their row exists,
+ * which is the case for Gtk::ListStore and Gtk::TreeStore.
+ */
+template<class T>
+class TreeRowIndex {
+public:
+    TreeRowIndex() : m_column(NULL), m_valid(false) {}
+
+    /// Starts indexing the objects of column @a column of @a model.
+    void attach(const Glib::RefPtr<Gtk::TreeModel>& model,
+                const Gtk::TreeModelColumn<T*>& column)
+    {
+        m_model = model;
+        m_column = &column;
+        m_valid = false;
+        model->signal_row_changed().connect(
+            sigc::mem_fun(*this, &TreeRowIndex::onRowChanged)
+        );
+        model->signal_row_deleted().connect(
+            sigc::mem_fun(*this, &TreeRowIndex::onRowDeleted)
+        );
+    }
+
+    /// Row listing @a object, an invalid iterator if there is none.
+    Gtk::TreeModel::iterator find(T* object) {
+        if (!object || !m_column) return Gtk::TreeModel::iterator();
+        if (!m_valid) rebuild();
+        typename Map::iterator it = m_rows.find(object);
+        if (it == m_rows.end()) return Gtk::TreeModel::iterator();
+        // the row might have been assigned another object meanwhile
+        Gtk::TreeModel::Row row = *it->second;
+        T* listed = row[*m_column];
+        if (listed != object) {
+            m_rows.erase(it);
+            return Gtk::TreeModel::iterator();
+        }
+        return it->second;
+    }
+
+    /// Position of the row of @a object among its siblings, -1 if not listed.
+    int position(T* object) {
+        Gtk::TreeModel::iterator it = find(object);
+        if (!it) return -1;
+        Gtk::TreeModel::Path path = m_model->get_path(it);
+        return path[path.size() - 1];
+    }
+
+private:
+    typedef std::unordered_map<T*, Gtk::TreeModel::iterator> Map;
+
+    Glib::RefPtr<Gtk::TreeModel> m_model;
+    const Gtk::TreeModelColumn<T*>* m_column;
+    bool m_valid;
+    Map m_rows;
+
+    void rebuild() {
+        m_rows.clear();
+        add(m_model->children());
+        m_valid = true;
+    }
+
+    void add(Gtk::TreeModel::Children rows) {
+        for (Gtk::TreeModel::iterator it = rows.begin(); it != rows.end(); ++it) {
+            Gtk::TreeModel::Row row = *it;
+            T* object = row[*m_column];
+            if (object) m_rows[object] = it;
+            if (!row.children().empty()) add(row.children());
+        }
+    }
+
+    void onRowChanged(const Gtk::TreeModel::Path& path,
+                      const Gtk::TreeModel::iterator& iter)
+    {
+        if (!m_valid || !iter) return;
+        Gtk::TreeModel::Row row = *iter;
+        T* object = row[*m_column];
+        if (object) m_rows[object] = iter;
+    }
+
+    void onRowDeleted(const Gtk::TreeModel::Path& path) {
+        m_valid = false;
+    }
+};
+
+#endif // GIGEDIT_TREEROWINDEX_H
@@ -0,0 +1,130 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_TREESEARCH_H
+#define GIGEDIT_TREESEARCH_H
+
+#ifdef GTKMM_HEADER_FILE
+# include GTKMM_HEADER_FILE(gtkmm.h)
+#else
+# include <gtkmm.h>
+#endif
+
+#include "NameIndex.h"
+
+#include <functional>
+#include <unordered_map>
+
+/** @brief Searches the names listed by a tree model.
+ *
+ * Keeps a NameIndex of the names in one column of a Gtk::TreeModel, keyed by
+ * the object each row represents. Like TreeRowIndex it follows the model's
+ * signals: assigned names are (re)indexed right away, whereas removing rows
+ * invalidates the index, which is rebuilt by the next search.
+ */
+class TreeSearch {
+public:
+    /// Returns the object represented by a row, NULL for rows not to be searched.
+    typedef std::function<const void*(const Gtk::TreeModel::Row&)> KeyFn;
+
+    TreeSearch() : m_column(NULL), m_valid(false) {}
+
+    void attach(const Glib::RefPtr<Gtk::TreeModel>& model,
+                const Gtk::TreeModelColumn<Glib::ustring>& nameColumn,
+                const KeyFn& keyOf)
+    {
+        m_model = model;
+        m_column = &nameColumn;
+        m_keyOf = keyOf;
+        m_valid = false;
+        model->signal_row_changed().connect(
+            sigc::mem_fun(*this, &TreeSearch::onRowChanged)
+        );
+        model->signal_row_deleted().connect(
+            sigc::mem_fun(*this, &TreeSearch::onRowDeleted)
+        );
+    }
+
+    /// Re-reads all names from the model.
+    void rebuild() {
+        m_index.clear();
+        m_rows.clear();
+        add(m_model->children());
+        m_valid = true;
+    }
+
+    /// Updates the results for @a pattern, @see NameIndex::search().
+    void search(const Glib::ustring& pattern) {
+        m_pattern = pattern;
+        if (!m_valid) rebuild();
+        m_index.search(pattern.raw());
+    }
+
+    bool isFiltering() const { return !m_pattern.empty() && m_index.isFiltering(); }
+
+    /// Whether the object of @a row matched the last search.
+    bool matches(const Gtk::TreeModel::Row& row) {
+        if (m_pattern.empty()) return true;
+        if (!m_valid || !m_index.isUpToDate()) search(m_pattern);
+        const void* key = m_keyOf(row);
+        return key ? m_index.matches(key) : !m_index.isFiltering();
+    }
+
+    /// Rows that matched the last search (in the order they were indexed).
+    std::vector<Gtk::TreeModel::iterator> matchingRows() {
+        if (!m_valid || !m_index.isUpToDate()) search(m_pattern);
+        std::vector<const void*> keys = m_index.results();
+        std::vector<Gtk::TreeModel::iterator> rows;
+        rows.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            std::unordered_map<const void*, Gtk::TreeModel::iterator>::iterator it =
+                m_rows.find(keys[i]);
+            if (it != m_rows.end()) rows.push_back(it->second);
+        }
+        return rows;
+    }
+
+private:
+    Glib::RefPtr<Gtk::TreeModel> m_model;
+    const Gtk::TreeModelColumn<Glib::ustring>* m_column;
+    KeyFn m_keyOf;
+    bool m_valid;
+    Glib::ustring m_pattern;
+    NameIndex m_index;
+    std::unordered_map<const void*, Gtk::TreeModel::iterator> m_rows;
+
+    void add(Gtk::TreeModel::Children rows) {
+        for (Gtk::TreeModel::iterator it = rows.begin(); it != rows.end(); ++it) {
+            Gtk::TreeModel::Row row = *it;
+            const void* key = m_keyOf(row);
+            if (key) {
+                Glib::ustring name = row[*m_column];
+                m_index.set(key, name.raw());
+                m_rows[key] = it;
+            }
+            if (!row.children().empty()) add(row.children());
+        }
+    }
+
+    void onRowChanged(const Gtk::TreeModel::Path& path,
+                      const Gtk::TreeModel::iterator& iter)
+    {
+        if (!m_valid || !iter) return;
+        Gtk::TreeModel::Row row = *iter;
+        const void* key = m_keyOf(row);
+        if (!key) return;
+        Glib::ustring name = row[*m_column];
+        m_index.set(key, name.raw());
+        m_rows[key] = iter;
+    }
+
+    void onRowDeleted(const Gtk::TreeModel::Path& path) {
+        m_valid = false;
+    }
+};
+
+#endif // GIGEDIT_TREESEARCH_H
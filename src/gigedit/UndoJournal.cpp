@@ -0,0 +1,761 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#include "UndoJournal.h"
+#include "CompiledMacro.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace {
+
+/// The "before" state of raw data, encoded as difference to its "after" state.
+struct RawDelta {
+    size_t prefix; ///< amount of leading bytes equal in both states
+    size_t suffix; ///< amount of trailing bytes equal in both states
+    Serialization::RawData middle; ///< the "before" bytes in between
+
+    size_t size() const { return sizeof(RawDelta) + middle.size(); }
+};
+
+RawDelta encodeDelta(const Serialization::RawData& before,
+                     const Serialization::RawData& after)
+{
+    RawDelta delta;
+    const size_t n = std::min(before.size(), after.size());
+    delta.prefix = 0;
+    while (delta.prefix < n && before[delta.prefix] == after[delta.prefix])
+        ++delta.prefix;
+    delta.suffix = 0;
+    while (delta.suffix < n - delta.prefix &&
+           before[before.size() - 1 - delta.suffix] == after[after.size() - 1 - delta.suffix])
+        ++delta.suffix;
+    delta.middle.assign(before.begin() + delta.prefix,
+                        before.end() - delta.suffix);
+    return delta;
+}
+
+Serialization::RawData decodeDelta(const RawDelta& delta,
+                                   const Serialization::RawData& after)
+{
+    Serialization::RawData before(after.begin(), after.begin() + delta.prefix);
+    before.insert(before.end(), delta.middle.begin(), delta.middle.end());
+    before.insert(before.end(), after.end() - delta.suffix, after.end());
+    return before;
+}
+
+/// Before and after value of one primitive field of a gig::DimensionRegion.
+struct FieldPatch {
+    uint32_t offset; ///< byte offset of the field within gig::DimensionRegion
+    uint32_t size; ///< size of the field in bytes
+    uint8_t before[8]; ///< old value (in native memory representation)
+    uint8_t after[8]; ///< new value (in native memory representation)
+};
+
+template<typename T>
+void encodeValue(uint8_t* dst, T value) {
+    memcpy(dst, &value, sizeof(T));
+}
+
+// encodes the archived value of a primitive member in native representation
+bool encodeField(Serialization::Archive& archive, const Serialization::Object& obj,
+                 const Serialization::DataType& type, uint8_t* dst)
+{
+    memset(dst, 0, 8);
+    if (type.isInteger() || type.isEnum()) {
+        const int64_t value = archive.valueAsInt(obj);
+        switch (type.size()) {
+            case 1: encodeValue(dst, int8_t(value)); return true;
+            case 2: encodeValue(dst, int16_t(value)); return true;
+            case 4: encodeValue(dst, int32_t(value)); return true;
+            case 8: encodeValue(dst, int64_t(value)); return true;
+        }
+    } else if (type.isReal()) {
+        const double value = archive.valueAsReal(obj);
+        if (type.size() == sizeof(float)) {
+            encodeValue(dst, float(value));
+            return true;
+        } else if (type.size() == sizeof(double)) {
+            encodeValue(dst, value);
+            return true;
+        }
+    } else if (type.isBool() && type.size() == sizeof(bool)) {
+        encodeValue(dst, bool(archive.valueAsBool(obj)));
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Compares two archives of the same dimension region @a dimrgn, taken before
+ * and after it was modified, and adds a patch for each primitive field which
+ * changed. Returns false if the difference cannot be expressed that way.
+ */
+bool diffObjects(Serialization::Archive& a, const Serialization::Object& objA,
+                 Serialization::Archive& b, const Serialization::Object& objB,
+                 const gig::DimensionRegion* dimrgn, std::vector<FieldPatch>& patches)
+{
+    if (objA.members().size() != objB.members().size()) return false;
+    for (size_t i = 0; i < objA.members().size(); ++i) {
+        const Serialization::Member& memberA = objA.members()[i];
+        const Serialization::Member memberB = objB.memberNamed(memberA.name());
+        if (!memberB || memberB.type() != memberA.type()) return false;
+
+        const Serialization::DataType& type = memberA.type();
+        // pointers are not restored by patches (see DimRgnState)
+        if (type.isPointer()) continue;
+
+        const Serialization::Object& a1 = a.objectByUID(memberA.uid());
+        const Serialization::Object& b1 = b.objectByUID(memberB.uid());
+        if (!a1 || !b1) return false;
+
+        if (type.isClass()) {
+            if (!diffObjects(a, a1, b, b1, dimrgn, patches)) return false;
+            continue;
+        }
+
+        // both archives were created from 'dimrgn', so the UIDs of their
+        // members are the memory addresses of the fields of 'dimrgn'
+        const uint8_t* addr = (const uint8_t*) memberA.uid().id;
+        const uint8_t* base = (const uint8_t*) dimrgn;
+        if (addr < base || addr + type.size() > base + sizeof(gig::DimensionRegion))
+            return false;
+
+        FieldPatch patch;
+        patch.offset = uint32_t(addr - base);
+        patch.size = uint32_t(type.size());
+        if (!encodeField(a, a1, type, patch.before) ||
+            !encodeField(b, b1, type, patch.after))
+        {
+            // i.e. strings
+            if (a.valueAsString(a1) != b.valueAsString(b1)) return false;
+            continue;
+        }
+        if (memcmp(patch.before, patch.after, patch.size))
+            patches.push_back(patch);
+    }
+    return true;
+}
+
+std::vector<DLS::sample_loop_t> loopsOf(const gig::DimensionRegion* d) {
+    return std::vector<DLS::sample_loop_t>(d->pSampleLoops, d->pSampleLoops + d->SampleLoops);
+}
+
+void setLoops(gig::DimensionRegion* d, const std::vector<DLS::sample_loop_t>& loops) {
+    while (d->SampleLoops) d->DeleteSampleLoop(&d->pSampleLoops[0]);
+    for (size_t i = 0; i < loops.size(); ++i) {
+        DLS::sample_loop_t loop = loops[i];
+        d->AddSampleLoop(&loop);
+    }
+}
+
+bool equalLoops(const std::vector<DLS::sample_loop_t>& a,
+                const std::vector<DLS::sample_loop_t>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (a[i].LoopType != b[i].LoopType || a[i].LoopStart != b[i].LoopStart ||
+            a[i].LoopLength != b[i].LoopLength) return false;
+    return true;
+}
+
+/// Complete state of a dimension region, which can be restored to any other one.
+struct DimRgnState {
+    Serialization::RawData archive;
+    gig::Sample* sample;
+    std::vector<DLS::sample_loop_t> loops;
+
+    size_t size() const {
+        return sizeof(DimRgnState) + archive.size() +
+               loops.size() * sizeof(DLS::sample_loop_t);
+    }
+
+    void restore(gig::DimensionRegion* d) const {
+        Serialization::Archive a;
+        a.decode(archive);
+        a.deserialize(d);
+        updateDerivedTables(d);
+        d->pSample = sample;
+        setLoops(d, loops);
+    }
+};
+
+/// Dimension layout of a region.
+struct RegionLayout {
+    std::vector<gig::dimension_def_t> dimensions;
+
+    RegionLayout() {}
+    RegionLayout(const gig::Region* rgn) :
+        dimensions(rgn->pDimensionDefinitions, rgn->pDimensionDefinitions + rgn->Dimensions) {}
+
+    bool operator==(const RegionLayout& other) const {
+        if (dimensions.size() != other.dimensions.size()) return false;
+        for (size_t i = 0; i < dimensions.size(); ++i)
+            if (dimensions[i].dimension != other.dimensions[i].dimension ||
+                dimensions[i].bits != other.dimensions[i].bits ||
+                dimensions[i].zones != other.dimensions[i].zones) return false;
+        return true;
+    }
+
+    bool operator!=(const RegionLayout& other) const { return !(*this == other); }
+
+    void restore(gig::Region* rgn) const {
+        if (RegionLayout(rgn) == *this) return;
+        while (rgn->Dimensions)
+            rgn->DeleteDimension(&rgn->pDimensionDefinitions[rgn->Dimensions - 1]);
+        for (size_t i = 0; i < dimensions.size(); ++i) {
+            gig::dimension_def_t def = dimensions[i];
+            rgn->AddDimension(&def);
+        }
+    }
+};
+
+gig::Region* regionOf(gig::DimensionRegion* dimrgn) {
+    return static_cast<gig::Region*>(dimrgn->GetParent());
+}
+
+int indexOf(gig::Region* rgn, gig::DimensionRegion* dimrgn) {
+    for (int i = 0; i < int(rgn->DimensionRegions); ++i)
+        if (rgn->pDimensionRegions[i] == dimrgn) return i;
+    return -1;
+}
+
+} // namespace
+
+struct UndoJournal::DimRgnSnapshot {
+    gig::DimensionRegion* dimrgn;
+    Serialization::Archive archive;
+    gig::Sample* sample;
+    std::vector<DLS::sample_loop_t> loops;
+    int nesting;
+
+    DimRgnSnapshot(gig::DimensionRegion* d) :
+        dimrgn(d), sample(d->pSample), loops(loopsOf(d)), nesting(1)
+    {
+        archive.serialize(d);
+    }
+};
+
+struct UndoJournal::RegionSnapshot {
+    gig::Region* region;
+    gig::range_t keyRange;
+    uint16_t keyGroup;
+    RegionLayout layout;
+    std::vector<DimRgnSnapshot*> dimrgns;
+    int nesting;
+
+    RegionSnapshot(gig::Region* rgn) :
+        region(rgn), keyRange(rgn->KeyRange), keyGroup(rgn->KeyGroup),
+        layout(rgn), nesting(1)
+    {
+        for (int i = 0; i < int(rgn->DimensionRegions); ++i)
+            dimrgns.push_back(new DimRgnSnapshot(rgn->pDimensionRegions[i]));
+    }
+
+    ~RegionSnapshot() {
+        for (size_t i = 0; i < dimrgns.size(); ++i) delete dimrgns[i];
+    }
+};
+
+struct UndoJournal::InstrumentState {
+    gig::String name;
+    bool isDrum;
+    uint16_t midiBank;
+    uint8_t midiBankCoarse;
+    uint8_t midiBankFine;
+    uint32_t midiProgram;
+    int32_t attenuation;
+    uint16_t effectSend;
+    int16_t fineTune;
+    uint16_t pitchbendRange;
+    bool pianoReleaseMode;
+    gig::range_t dimensionKeyRange;
+
+    InstrumentState(const gig::Instrument* instr) :
+        name(instr->pInfo->Name), isDrum(instr->IsDrum),
+        midiBank(instr->MIDIBank), midiBankCoarse(instr->MIDIBankCoarse),
+        midiBankFine(instr->MIDIBankFine), midiProgram(instr->MIDIProgram),
+        attenuation(instr->Attenuation), effectSend(instr->EffectSend),
+        fineTune(instr->FineTune), pitchbendRange(instr->PitchbendRange),
+        pianoReleaseMode(instr->PianoReleaseMode),
+        dimensionKeyRange(instr->DimensionKeyRange) {}
+
+    bool operator==(const InstrumentState& o) const {
+        return name == o.name && isDrum == o.isDrum && midiBank == o.midiBank &&
+               midiBankCoarse == o.midiBankCoarse && midiBankFine == o.midiBankFine &&
+               midiProgram == o.midiProgram && attenuation == o.attenuation &&
+               effectSend == o.effectSend && fineTune == o.fineTune &&
+               pitchbendRange == o.pitchbendRange &&
+               pianoReleaseMode == o.pianoReleaseMode &&
+               dimensionKeyRange.low == o.dimensionKeyRange.low &&
+               dimensionKeyRange.high == o.dimensionKeyRange.high;
+    }
+
+    void restore(gig::Instrument* instr) const {
+        instr->pInfo->Name = name;
+        instr->IsDrum = isDrum;
+        instr->MIDIBank = midiBank;
+        instr->MIDIBankCoarse = midiBankCoarse;
+        instr->MIDIBankFine = midiBankFine;
+        instr->MIDIProgram = midiProgram;
+        instr->Attenuation = attenuation;
+        instr->EffectSend = effectSend;
+        instr->FineTune = fineTune;
+        instr->PitchbendRange = pitchbendRange;
+        instr->PianoReleaseMode = pianoReleaseMode;
+        instr->DimensionKeyRange = dimensionKeyRange;
+    }
+};
+
+/// One recorded change of a single object.
+class UndoJournal::Change {
+public:
+    virtual ~Change() {}
+    virtual void undo() = 0;
+    virtual void redo() = 0;
+    /// Approximate amount of memory occupied by this change.
+    virtual size_t size() const = 0;
+    /// Region affected by this change (if any).
+    virtual gig::Region* region() const { return NULL; }
+};
+
+namespace {
+
+/**
+ * Change of one dimension region. Dimension regions are addressed by their
+ * region and index, since libgig recreates all dimension regions of a region
+ * whenever its dimensions are altered.
+ */
+class DimRgnChange : public UndoJournal::Change {
+public:
+    DimRgnChange(gig::Region* rgn, int index) : m_region(rgn), m_index(index),
+        m_sampleBefore(NULL), m_sampleAfter(NULL), m_loopsChanged(false) {}
+
+    // returns false if nothing changed at all
+    bool init(Serialization::Archive& before, gig::Sample* sampleBefore,
+              const std::vector<DLS::sample_loop_t>& loopsBefore,
+              gig::DimensionRegion* d)
+    {
+        Serialization::Archive after;
+        after.serialize(d);
+        m_sampleBefore = sampleBefore;
+        m_sampleAfter = d->pSample;
+        const std::vector<DLS::sample_loop_t> loopsAfter = loopsOf(d);
+        if (!equalLoops(loopsBefore, loopsAfter)) {
+            m_loopsChanged = true;
+            m_loopsBefore = loopsBefore;
+            m_loopsAfter = loopsAfter;
+        }
+        const bool patchable =
+            diffObjects(before, before.rootObject(), after, after.rootObject(),
+                        d, m_patches);
+        if (!patchable) {
+            m_patches.clear();
+            m_after = after.rawData();
+            m_before = encodeDelta(before.rawData(), m_after);
+        }
+        return !patchable || !m_patches.empty() || m_loopsChanged ||
+               m_sampleBefore != m_sampleAfter;
+    }
+
+    void undo() {
+        gig::DimensionRegion* d = dimRegion();
+        if (!d) return;
+        if (m_after.empty()) {
+            uint8_t* base = (uint8_t*) d;
+            for (size_t i = 0; i < m_patches.size(); ++i)
+                memcpy(base + m_patches[i].offset, m_patches[i].before, m_patches[i].size);
+            updateDerivedTables(d);
+        } else {
+            Serialization::Archive a;
+            a.decode(decodeDelta(m_before, m_after));
+            a.deserialize(d);
+            updateDerivedTables(d);
+        }
+        d->pSample = m_sampleBefore;
+        if (m_loopsChanged) setLoops(d, m_loopsBefore);
+    }
+
+    void redo() {
+        gig::DimensionRegion* d = dimRegion();
+        if (!d) return;
+        if (m_after.empty()) {
+            uint8_t* base = (uint8_t*) d;
+            for (size_t i = 0; i < m_patches.size(); ++i)
+                memcpy(base + m_patches[i].offset, m_patches[i].after, m_patches[i].size);
+            updateDerivedTables(d);
+        } else {
+            Serialization::Archive a;
+            a.decode(m_after);
+            a.deserialize(d);
+            updateDerivedTables(d);
+        }
+        d->pSample = m_sampleAfter;
+        if (m_loopsChanged) setLoops(d, m_loopsAfter);
+    }
+
+    size_t size() const {
+        return sizeof(DimRgnChange) + m_patches.size() * sizeof(FieldPatch) +
+               m_before.size() + m_after.size() +
+               (m_loopsBefore.size() + m_loopsAfter.size()) * sizeof(DLS::sample_loop_t);
+    }
+
+    gig::Region* region() const { return m_region; }
+
+private:
+    gig::Region* m_region;
+    int m_index;
+    std::vector<FieldPatch> m_patches;
+    RawDelta m_before; ///< only if the change could not be expressed by patches
+    Serialization::RawData m_after; ///< only if the change could not be expressed by patches
+    gig::Sample* m_sampleBefore;
+    gig::Sample* m_sampleAfter;
+    bool m_loopsChanged;
+    std::vector<DLS::sample_loop_t> m_loopsBefore;
+    std::vector<DLS::sample_loop_t> m_loopsAfter;
+
+    gig::DimensionRegion* dimRegion() const {
+        return (m_index < int(m_region->DimensionRegions)) ?
+            m_region->pDimensionRegions[m_index] : NULL;
+    }
+};
+
+/**
+ * Change of a region. If its dimensions were not altered, only its changed
+ * dimension regions are recorded, otherwise the complete state of all its
+ * dimension regions before and after the change.
+ */
+class RegionChange : public UndoJournal::Change {
+public:
+    RegionChange(gig::Region* rgn) : m_region(rgn), m_layoutChanged(false) {}
+
+    void undo() {
+        if (m_keyRangeBefore.low != m_region->KeyRange.low ||
+            m_keyRangeBefore.high != m_region->KeyRange.high)
+            m_region->SetKeyRange(m_keyRangeBefore.low, m_keyRangeBefore.high);
+        m_region->KeyGroup = m_keyGroupBefore;
+        if (m_layoutChanged) {
+            m_layoutBefore.restore(m_region);
+            for (size_t i = 0; i < m_statesBefore.size() && i < m_region->DimensionRegions; ++i)
+                m_statesBefore[i].restore(m_region->pDimensionRegions[i]);
+        } else {
+            for (size_t i = m_dimrgns.size(); i-- > 0; )
+                m_dimrgns[i].undo();
+        }
+    }
+
+    void redo() {
+        if (m_keyRangeAfter.low != m_region->KeyRange.low ||
+            m_keyRangeAfter.high != m_region->KeyRange.high)
+            m_region->SetKeyRange(m_keyRangeAfter.low, m_keyRangeAfter.high);
+        m_region->KeyGroup = m_keyGroupAfter;
+        if (m_layoutChanged) {
+            m_layoutAfter.restore(m_region);
+            for (size_t i = 0; i < m_statesAfter.size() && i < m_region->DimensionRegions; ++i)
+                m_statesAfter[i].restore(m_region->pDimensionRegions[i]);
+        } else {
+            for (size_t i = 0; i < m_dimrgns.size(); ++i)
+                m_dimrgns[i].redo();
+        }
+    }
+
+    size_t size() const {
+        size_t bytes = sizeof(RegionChange);
+        for (size_t i = 0; i < m_dimrgns.size(); ++i)
+            bytes += m_dimrgns[i].size();
+        for (size_t i = 0; i < m_statesBefore.size(); ++i)
+            bytes += m_statesBefore[i].size();
+        for (size_t i = 0; i < m_statesAfter.size(); ++i)
+            bytes += m_statesAfter[i].size();
+        return bytes;
+    }
+
+    gig::Region* region() const { return m_region; }
+
+    gig::Region* m_region;
+    gig::range_t m_keyRangeBefore;
+    gig::range_t m_keyRangeAfter;
+    uint16_t m_keyGroupBefore;
+    uint16_t m_keyGroupAfter;
+    bool m_layoutChanged;
+    RegionLayout m_layoutBefore; ///< only if the layout changed
+    RegionLayout m_layoutAfter; ///< only if the layout changed
+    std::vector<DimRgnChange> m_dimrgns; ///< only if the layout did not change
+    std::vector<DimRgnState> m_statesBefore; ///< only if the layout changed
+    std::vector<DimRgnState> m_statesAfter; ///< only if the layout changed
+};
+
+} // namespace
+
+class UndoJournal::InstrumentChange : public UndoJournal::Change {
+public:
+    InstrumentChange(gig::Instrument* instr, const InstrumentState& before,
+                     const InstrumentState& after) :
+        m_instrument(instr), m_before(before), m_after(after) {}
+
+    void undo() { m_before.restore(m_instrument); }
+    void redo() { m_after.restore(m_instrument); }
+
+    size_t size() const {
+        return sizeof(InstrumentChange) + m_before.name.size() + m_after.name.size();
+    }
+
+private:
+    gig::Instrument* m_instrument;
+    InstrumentState m_before;
+    InstrumentState m_after;
+};
+
+UndoJournal::UndoJournal() :
+    m_current(NULL), m_trackedInstrument(NULL), m_trackedState(NULL),
+    m_memoryLimit(64 * 1024 * 1024), m_memoryUsage(0), m_recording(true)
+{
+}
+
+UndoJournal::~UndoJournal() {
+    clear();
+}
+
+void UndoJournal::setMemoryLimit(size_t bytes) {
+    m_memoryLimit = bytes;
+    enforceMemoryLimit();
+}
+
+void UndoJournal::dimRegionToBeChanged(gig::DimensionRegion* dimrgn) {
+    if (!m_recording || !dimrgn) return;
+    // already covered by the snapshot of its region
+    if (m_regionSnapshots.count(regionOf(dimrgn))) return;
+    std::map<gig::DimensionRegion*, DimRgnSnapshot*>::iterator it =
+        m_dimRgnSnapshots.find(dimrgn);
+    if (it != m_dimRgnSnapshots.end())
+        it->second->nesting++;
+    else
+        m_dimRgnSnapshots[dimrgn] = new DimRgnSnapshot(dimrgn);
+}
+
+void UndoJournal::dimRegionChanged(gig::DimensionRegion* dimrgn) {
+    std::map<gig::DimensionRegion*, DimRgnSnapshot*>::iterator it =
+        m_dimRgnSnapshots.find(dimrgn);
+    if (it == m_dimRgnSnapshots.end()) return;
+    DimRgnSnapshot* snapshot = it->second;
+    if (--snapshot->nesting > 0) return;
+    m_dimRgnSnapshots.erase(it);
+
+    gig::Region* rgn = regionOf(dimrgn);
+    const int index = indexOf(rgn, dimrgn);
+    if (index >= 0) {
+        DimRgnChange* change = new DimRgnChange(rgn, index);
+        if (change->init(snapshot->archive, snapshot->sample, snapshot->loops, dimrgn))
+            record(change);
+        else
+            delete change;
+    }
+    delete snapshot;
+}
+
+void UndoJournal::regionToBeChanged(gig::Region* rgn) {
+    if (!m_recording || !rgn) return;
+    std::map<gig::Region*, RegionSnapshot*>::iterator it =
+        m_regionSnapshots.find(rgn);
+    if (it != m_regionSnapshots.end())
+        it->second->nesting++;
+    else
+        m_regionSnapshots[rgn] = new RegionSnapshot(rgn);
+}
+
+void UndoJournal::regionChanged(gig::Region* rgn) {
+    std::map<gig::Region*, RegionSnapshot*>::iterator it =
+        m_regionSnapshots.find(rgn);
+    if (it == m_regionSnapshots.end()) return;
+    RegionSnapshot* snapshot = it->second;
+    if (--snapshot->nesting > 0) return;
+    m_regionSnapshots.erase(it);
+
+    RegionChange* change = new RegionChange(rgn);
+    change->m_keyRangeBefore = snapshot->keyRange;
+    change->m_keyRangeAfter = rgn->KeyRange;
+    change->m_keyGroupBefore = snapshot->keyGroup;
+    change->m_keyGroupAfter = rgn->KeyGroup;
+    bool changed = snapshot->keyRange.low != rgn->KeyRange.low ||
+                   snapshot->keyRange.high != rgn->KeyRange.high ||
+                   snapshot->keyGroup != rgn->KeyGroup;
+
+    // dimension regions are only compared field by field if they still are
+    // the very same objects, otherwise their complete state is kept
+    bool sameDimRgns = (snapshot->layout == RegionLayout(rgn)) &&
+                       (snapshot->dimrgns.size() == rgn->DimensionRegions);
+    for (size_t i = 0; sameDimRgns && i < snapshot->dimrgns.size(); ++i)
+        if (snapshot->dimrgns[i]->dimrgn != rgn->pDimensionRegions[i])
+            sameDimRgns = false;
+
+    if (sameDimRgns) {
+        for (size_t i = 0; i < snapshot->dimrgns.size(); ++i) {
+            DimRgnSnapshot* s = snapshot->dimrgns[i];
+            DimRgnChange dimrgnChange(rgn, int(i));
+            if (dimrgnChange.init(s->archive, s->sample, s->loops, s->dimrgn))
+                change->m_dimrgns.push_back(dimrgnChange);
+        }
+        changed = changed || !change->m_dimrgns.empty();
+    } else {
+        change->m_layoutChanged = true;
+        change->m_layoutBefore = snapshot->layout;
+        change->m_layoutAfter = RegionLayout(rgn);
+        for (size_t i = 0; i < snapshot->dimrgns.size(); ++i) {
+            DimRgnSnapshot* s = snapshot->dimrgns[i];
+            DimRgnState state;
+            state.archive = s->archive.rawData();
+            state.sample = s->sample;
+            state.loops = s->loops;
+            change->m_statesBefore.push_back(state);
+        }
+        for (int i = 0; i < int(rgn->DimensionRegions); ++i) {
+            gig::DimensionRegion* d = rgn->pDimensionRegions[i];
+            Serialization::Archive archive;
+            archive.serialize(d);
+            DimRgnState state;
+            state.archive = archive.rawData();
+            state.sample = d->pSample;
+            state.loops = loopsOf(d);
+            change->m_statesAfter.push_back(state);
+        }
+        changed = true;
+    }
+
+    if (changed)
+        record(change);
+    else
+        delete change;
+    delete snapshot;
+}
+
+void UndoJournal::trackInstrument(gig::Instrument* instr) {
+    if (m_trackedState) delete m_trackedState;
+    m_trackedState = (instr) ? new InstrumentState(instr) : NULL;
+    m_trackedInstrument = instr;
+}
+
+void UndoJournal::instrumentChanged(gig::Instrument* instr) {
+    if (!m_recording || !instr || instr != m_trackedInstrument) {
+        trackInstrument(instr);
+        return;
+    }
+    InstrumentState state(instr);
+    if (state == *m_trackedState) return;
+    record(new InstrumentChange(instr, *m_trackedState, state));
+    *m_trackedState = state;
+}
+
+void UndoJournal::record(Change* change) {
+    clearRedo();
+    if (!m_current) m_current = new Step;
+    const size_t size = change->size();
+    m_current->changes.push_back(change);
+    m_current->size += size;
+    m_memoryUsage += size;
+}
+
+void UndoJournal::endStep() {
+    if (!m_current) return;
+    m_undo.push_back(m_current);
+    m_current = NULL;
+    enforceMemoryLimit();
+}
+
+void UndoJournal::enforceMemoryLimit() {
+    // discard the oldest steps first, but always keep the newest step, so
+    // the last edit can be undone even if it exceeds the limit on its own
+    while (m_memoryUsage > m_memoryLimit && m_undo.size() > 1) {
+        Step* step = m_undo.front();
+        m_undo.pop_front();
+        m_memoryUsage -= step->size;
+        deleteStep(step);
+    }
+    while (m_memoryUsage > m_memoryLimit && m_redo.size() > (m_undo.empty() ? 1 : 0)) {
+        Step* step = m_redo.front();
+        m_redo.erase(m_redo.begin());
+        m_memoryUsage -= step->size;
+        deleteStep(step);
+    }
+}
+
+void UndoJournal::clearRedo() {
+    for (size_t i = 0; i < m_redo.size(); ++i) {
+        m_memoryUsage -= m_redo[i]->size;
+        deleteStep(m_redo[i]);
+    }
+    m_redo.clear();
+}
+
+void UndoJournal::deleteStep(Step* step) {
+    for (size_t i = 0; i < step->changes.size(); ++i)
+        delete step->changes[i];
+    delete step;
+}
+
+void UndoJournal::clear() {
+    endStep();
+    clearRedo();
+    for (size_t i = 0; i < m_undo.size(); ++i)
+        deleteStep(m_undo[i]);
+    m_undo.clear();
+    for (std::map<gig::DimensionRegion*, DimRgnSnapshot*>::iterator it = m_dimRgnSnapshots.begin();
+         it != m_dimRgnSnapshots.end(); ++it) delete it->second;
+    m_dimRgnSnapshots.clear();
+    for (std::map<gig::Region*, RegionSnapshot*>::iterator it = m_regionSnapshots.begin();
+         it != m_regionSnapshots.end(); ++it) delete it->second;
+    m_regionSnapshots.clear();
+    trackInstrument(NULL);
+    m_memoryUsage = 0;
+}
+
+bool UndoJournal::canUndo() const {
+    return m_current || !m_undo.empty();
+}
+
+bool UndoJournal::canRedo() const {
+    return !m_redo.empty();
+}
+
+static std::set<gig::Region*> regionsOf(const std::vector<UndoJournal::Change*>& changes) {
+    std::set<gig::Region*> regions;
+    for (size_t i = 0; i < changes.size(); ++i)
+        if (changes[i]->region()) regions.insert(changes[i]->region());
+    return regions;
+}
+
+std::set<gig::Region*> UndoJournal::regionsToUndo() const {
+    if (m_current) return regionsOf(m_current->changes);
+    if (m_undo.empty()) return std::set<gig::Region*>();
+    return regionsOf(m_undo.back()->changes);
+}
+
+std::set<gig::Region*> UndoJournal::regionsToRedo() const {
+    if (m_redo.empty()) return std::set<gig::Region*>();
+    return regionsOf(m_redo.back()->changes);
+}
+
+void UndoJournal::undo() {
+    endStep();
+    if (m_undo.empty()) return;
+    Step* step = m_undo.back();
+    m_undo.pop_back();
+    for (size_t i = step->changes.size(); i-- > 0; )
+        step->changes[i]->undo();
+    m_redo.push_back(step);
+    // the tracked instrument might have been restored as well
+    trackInstrument(m_trackedInstrument);
+}
+
+void UndoJournal::redo() {
+    if (m_redo.empty()) return;
+    Step* step = m_redo.back();
+    m_redo.pop_back();
+    for (size_t i = 0; i < step->changes.size(); ++i)
+        step->changes[i]->redo();
+    m_undo.push_back(step);
+    trackInstrument(m_trackedInstrument);
+}
@@ -0,0 +1,123 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_UNDOJOURNAL_H
+#define GIGEDIT_UNDOJOURNAL_H
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+# include LIBGIG_HEADER_FILE(Serialization.h)
+#else
+# include <gig.h>
+# include <Serialization.h>
+#endif
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/** @brief Undo/redo history of the edits of a gig file.
+ *
+ * The journal is fed with the same "to be changed" / "changed" notification
+ * pairs which are sent to the sampler. On a "to be changed" notification it
+ * takes a snapshot of the object (by Serialization::Archive), and on the
+ * matching "changed" notification it compares the snapshot with the object's
+ * new state and just keeps the difference: the before and after values of
+ * the primitive fields that actually changed, at their offsets within the
+ * object. Only if that is not possible (i.e. because strings changed or the
+ * dimensions of a region were altered) the full serialized state is kept,
+ * with the "before" state delta encoded against the "after" state.
+ *
+ * All changes recorded until endStep() is called form one undo step. Old
+ * steps are discarded as soon as the history exceeds its memory limit, except
+ * for the newest step.
+ *
+ * Changes which cannot be reverted (i.e. deleted samples, instruments or
+ * regions) must be reported by calling clear(), since the history would
+ * refer to objects which no longer exist.
+ */
+class UndoJournal {
+public:
+    UndoJournal();
+    ~UndoJournal();
+
+    /// Maximum amount of memory (in bytes) the history may occupy.
+    void setMemoryLimit(size_t bytes);
+    size_t memoryLimit() const { return m_memoryLimit; }
+
+    /// Approximate amount of memory (in bytes) currently occupied by the history.
+    size_t memoryUsage() const { return m_memoryUsage; }
+
+    /// Whether changes are currently recorded (enabled by default).
+    void setRecording(bool enabled) { m_recording = enabled; }
+
+    void dimRegionToBeChanged(gig::DimensionRegion* dimrgn);
+    void dimRegionChanged(gig::DimensionRegion* dimrgn);
+    void regionToBeChanged(gig::Region* rgn);
+    void regionChanged(gig::Region* rgn);
+
+    /**
+     * Instruments are not announced before being changed, so the journal
+     * remembers the instrument's current state instead, which is then used
+     * as "before" state by the next call of instrumentChanged().
+     */
+    void trackInstrument(gig::Instrument* instr);
+    void instrumentChanged(gig::Instrument* instr);
+
+    /// Closes the current undo step (if it recorded any change at all).
+    void endStep();
+
+    /// Discards the entire history.
+    void clear();
+
+    bool canUndo() const;
+    bool canRedo() const;
+
+    /// Regions modified by the next undo() call.
+    std::set<gig::Region*> regionsToUndo() const;
+    /// Regions modified by the next redo() call.
+    std::set<gig::Region*> regionsToRedo() const;
+
+    void undo();
+    void redo();
+
+    class Change;
+
+private:
+    struct Step {
+        std::vector<Change*> changes;
+        size_t size;
+
+        Step() : size(0) {}
+    };
+
+    struct DimRgnSnapshot;
+    struct RegionSnapshot;
+    struct InstrumentState;
+    class InstrumentChange;
+
+    std::deque<Step*> m_undo;
+    std::vector<Step*> m_redo;
+    Step* m_current;
+    std::map<gig::DimensionRegion*, DimRgnSnapshot*> m_dimRgnSnapshots;
+    std::map<gig::Region*, RegionSnapshot*> m_regionSnapshots;
+    gig::Instrument* m_trackedInstrument;
+    InstrumentState* m_trackedState;
+    size_t m_memoryLimit;
+    size_t m_memoryUsage;
+    bool m_recording;
+
+    void record(Change* change);
+    void enforceMemoryLimit();
+    void clearRedo();
+    static void deleteStep(Step* step);
+};
+
+#endif // GIGEDIT_UNDOJOURNAL_H
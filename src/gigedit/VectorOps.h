@@ -0,0 +1,44 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+#ifndef GIGEDIT_VECTOROPS_H
+#define GIGEDIT_VECTOROPS_H
+
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * Dot product of two float vectors, the hot spot of the audio analysis and
+ * conversion code.
+ */
+inline float dotProduct(const float* x, const float* y, size_t n) {
+    size_t i = 0;
+    float sum = 0.f;
+#if defined(__GNUC__)
+    // portable SIMD by GCC/clang vector extensions, two independent
+    // accumulators to hide the latency of the additions
+    typedef float v4sf __attribute__((vector_size(16)));
+    v4sf acc0 = { 0.f, 0.f, 0.f, 0.f };
+    v4sf acc1 = { 0.f, 0.f, 0.f, 0.f };
+    for (; i + 8 <= n; i += 8) {
+        v4sf x0, x1, y0, y1;
+        memcpy(&x0, x + i,     sizeof(v4sf));
+        memcpy(&x1, x + i + 4, sizeof(v4sf));
+        memcpy(&y0, y + i,     sizeof(v4sf));
+        memcpy(&y1, y + i + 4, sizeof(v4sf));
+        acc0 += x0 * y0;
+        acc1 += x1 * y1;
+    }
+    acc0 += acc1;
+    sum = acc0[0] + acc0[1] + acc0[2] + acc0[3];
+#endif
+    for (; i < n; ++i)
+        sum += x[i] * y[i];
+    return sum;
+}
+
+#endif // GIGEDIT_VECTOROPS_H
@@ -0,0 +1,338 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+// Performance benchmark of gigedit's file level operations on synthetic .gig
+// files. Not built by default, use "make bench" to build and run it. Results
+// are printed as JSON to stdout, progress information to stderr.
+
+#include "global.h"
+#include "SyntheticGig.h"
+#include "FileOperations.h"
+#include "CompiledMacro.h"
+#include "SampleConverter.h"
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+#ifdef LIBSNDFILE_HEADER_FILE
+# include LIBSNDFILE_HEADER_FILE(sndfile.h)
+#else
+# include <sndfile.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+struct BenchConfig {
+    std::string name;
+    SyntheticGigParams params;
+};
+
+struct BenchResult {
+    std::string config;
+    std::string operation;
+    std::vector<double> ms; ///< duration of each repetition in milliseconds
+};
+
+static int g_warmups = 2;
+static int g_repeats = 10;
+
+/**
+ * Calls @a setup and @a fn (g_warmups + g_repeats) times, and records the
+ * duration of the last g_repeats calls of @a fn.
+ */
+static BenchResult measure(const std::string& config, const std::string& operation,
+                           const std::function<void()>& setup,
+                           const std::function<void()>& fn)
+{
+    BenchResult result;
+    result.config = config;
+    result.operation = operation;
+    fprintf(stderr, "  %s ...\n", operation.c_str());
+    for (int i = 0; i < g_warmups + g_repeats; ++i) {
+        if (setup) setup();
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+        if (i >= g_warmups) result.ms.push_back(ms);
+    }
+    return result;
+}
+
+static void printResults(const std::vector<BenchResult>& results,
+                         const std::vector<BenchConfig>& configs)
+{
+    printf("{\n  \"benchmark\": \"gigedit\",\n  \"version\": \"%s\",\n", VERSION);
+    printf("  \"warmups\": %d,\n  \"repeats\": %d,\n", g_warmups, g_repeats);
+    printf("  \"configs\": [\n");
+    for (size_t i = 0; i < configs.size(); ++i) {
+        const SyntheticGigParams& p = configs[i].params;
+        printf("    { \"name\": \"%s\", \"instruments\": %d, \"regions\": %d, "
+               "\"velocity_bits\": %d, \"samples\": %d, \"sample_frames\": %d }%s\n",
+               configs[i].name.c_str(), p.instruments, p.regions, p.velocityBits,
+               p.samples, p.sampleFrames, (i + 1 < configs.size()) ? "," : "");
+    }
+    printf("  ],\n  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        std::vector<double> v = results[i].ms;
+        std::sort(v.begin(), v.end());
+        double sum = 0;
+        for (size_t k = 0; k < v.size(); ++k) sum += v[k];
+        const double mean = v.empty() ? 0 : sum / v.size();
+        double var = 0;
+        for (size_t k = 0; k < v.size(); ++k) var += (v[k] - mean) * (v[k] - mean);
+        const double stddev = (v.size() > 1) ? sqrt(var / (v.size() - 1)) : 0;
+        const double median = v.empty() ? 0 : (v.size() % 2) ?
+            v[v.size() / 2] : (v[v.size() / 2 - 1] + v[v.size() / 2]) / 2;
+        printf("    { \"config\": \"%s\", \"operation\": \"%s\", \"min_ms\": %.3f, "
+               "\"median_ms\": %.3f, \"mean_ms\": %.3f, \"stddev_ms\": %.3f, "
+               "\"max_ms\": %.3f }%s\n",
+               results[i].config.c_str(), results[i].operation.c_str(),
+               v.empty() ? 0 : v.front(), median, mean, stddev,
+               v.empty() ? 0 : v.back(), (i + 1 < results.size()) ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+/// Loads a .gig file by loadGigFile(), like the main window does.
+static gig::File* loadGig(const std::string& path, RIFF::File*& riff) {
+    riff = new RIFF::File(path);
+    return loadGigFile(riff, NULL);
+}
+
+static void unloadGig(gig::File*& gig, RIFF::File*& riff) {
+    if (gig) delete gig;
+    if (riff) delete riff;
+    gig = NULL;
+    riff = NULL;
+}
+
+static gig::DimensionRegion* firstDimRegion(gig::File* gig) {
+    gig::Instrument* instr = gig->GetFirstInstrument();
+    gig::Region* rgn = instr ? instr->GetFirstRegion() : NULL;
+    return rgn ? rgn->pDimensionRegions[0] : NULL;
+}
+
+static void writeWav(const std::string& path, int frames) {
+    SF_INFO info;
+    memset(&info, 0, sizeof(info));
+    info.samplerate = 44100;
+    info.channels = 1;
+    info.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+    SNDFILE* f = sf_open(path.c_str(), SFM_WRITE, &info);
+    if (!f) throw RIFF::Exception("Could not create " + path);
+    std::vector<short> wave(frames);
+    for (int i = 0; i < frames; ++i)
+        wave[i] = short(12000.0 * sin(2.0 * M_PI * 440.0 * i / 44100.0));
+    if (frames) sf_writef_short(f, &wave[0], frames);
+    sf_close(f);
+}
+
+static void runConfig(const BenchConfig& config, const std::string& dir,
+                      std::vector<BenchResult>& results)
+{
+    fprintf(stderr, "%s:\n", config.name.c_str());
+    const std::string path = dir + "/" + config.name + ".gig";
+    createSyntheticGig(path, config.params);
+
+    RIFF::File* riff = NULL;
+    gig::File* gig = NULL;
+
+    // opening the file and loading all instruments, like the main window's
+    // Loader job
+    results.push_back(measure(config.name, "load",
+        [&] { unloadGig(gig, riff); },
+        [&] { gig = loadGig(path, riff); }
+    ));
+
+    // like MainWindow::updateSampleRefCountMap()
+    results.push_back(measure(config.name, "sample_ref_count", NULL, [&] {
+        countSampleReferences(gig);
+    }));
+
+    // collecting the dimension regions of all regions with all dimension
+    // zones selected, like DimRegionChooser::get_dimregions() does for each
+    // region if "all regions" is selected
+    std::vector<gig::Region*> regions;
+    std::map<gig::dimension_t, std::set<int> > dimzones;
+    std::set<gig::DimensionRegion*> allDimRegions;
+    for (gig::Instrument* instr = gig->GetFirstInstrument(); instr;
+         instr = gig->GetNextInstrument())
+    {
+        for (gig::Region* rgn = instr->GetFirstRegion(); rgn;
+             rgn = instr->GetNextRegion())
+        {
+            regions.push_back(rgn);
+            for (int d = 0; d < rgn->Dimensions; ++d)
+                for (int z = 0; z < rgn->pDimensionDefinitions[d].zones; ++z)
+                    dimzones[rgn->pDimensionDefinitions[d].dimension].insert(z);
+            for (int i = 0; i < rgn->DimensionRegions; ++i)
+                if (rgn->pDimensionRegions[i])
+                    allDimRegions.insert(rgn->pDimensionRegions[i]);
+        }
+    }
+    results.push_back(measure(config.name, "get_dimregions", NULL, [&] {
+        std::set<gig::DimensionRegion*> dimregs;
+        for (size_t i = 0; i < regions.size(); ++i)
+            selectDimRegions(regions[i], true, dimzones, dimregs);
+    }));
+
+    findUnusedSamples(gig); // warm up libgig's lazy loading of sample lists
+    results.push_back(measure(config.name, "find_unused_samples", NULL, [&] {
+        findUnusedSamples(gig);
+    }));
+
+    // applying a macro to all dimension regions, like
+    // MainWindow::applyMacro(), once compiled and once by deserialization
+    Serialization::Archive macro;
+    macro.serialize(firstDimRegion(gig));
+    results.push_back(measure(config.name, "apply_macro_compiled", NULL, [&] {
+        CompiledMacro compiled;
+        compiled.compile(macro, firstDimRegion(gig));
+        applyMacroToDimRegions(allDimRegions, compiled, &macro);
+    }));
+    results.push_back(measure(config.name, "apply_macro_deserialize", NULL, [&] {
+        applyMacroToDimRegions(allDimRegions, CompiledMacro(), &macro);
+    }));
+
+    // importing audio files into all samples, like
+    // MainWindow::__import_queued_samples()
+    const std::string wav = dir + "/" + config.name + ".wav";
+    writeWav(wav, config.params.sampleFrames);
+    std::vector<AudioFileImport> imports;
+    for (gig::Sample* s = gig->GetFirstSample(); s; s = gig->GetNextSample()) {
+        AudioFileImport import;
+        import.path = wav;
+        import.sample = s;
+        imports.push_back(import);
+    }
+    riff->SetMode(RIFF::stream_mode_read_write);
+    results.push_back(measure(config.name, "import_samples", NULL, [&] {
+        importAudioFiles(imports);
+        for (size_t i = 0; i < imports.size(); ++i)
+            if (!imports[i].error.empty()) throw imports[i].error;
+    }));
+
+    unloadGig(gig, riff);
+    unlink(wav.c_str());
+    unlink(path.c_str());
+}
+
+static void printUsage() {
+    fprintf(stderr,
+        "Usage: gigedit-bench [OPTIONS]\n"
+        "\n"
+        "  --warmups N       untimed runs before measuring (default: 2)\n"
+        "  --repeats N       timed runs per operation (default: 10)\n"
+        "  --instruments N   only run a single configuration with N instruments ...\n"
+        "  --regions N       ... N regions per instrument (max. 128) ...\n"
+        "  --velocity-bits N ... a velocity dimension with N bits per region ...\n"
+        "  --samples N       ... N samples ...\n"
+        "  --frames N        ... and N sample points per sample\n"
+        "  --dir PATH        directory for the generated files (default: $TMPDIR)\n"
+    );
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<BenchConfig> configs;
+    BenchConfig custom;
+    custom.name = "custom";
+    bool useCustom = false;
+    const char* tmp = getenv("TMPDIR");
+    std::string baseDir = (tmp && *tmp) ? tmp : "/tmp";
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage();
+            return (arg == "-h" || arg == "--help") ? 0 : 2;
+        }
+        const char* value = argv[++i];
+        if (arg == "--warmups") g_warmups = atoi(value);
+        else if (arg == "--repeats") g_repeats = atoi(value);
+        else if (arg == "--dir") baseDir = value;
+        else {
+            useCustom = true;
+            if (arg == "--instruments") custom.params.instruments = atoi(value);
+            else if (arg == "--regions") custom.params.regions = atoi(value);
+            else if (arg == "--velocity-bits") custom.params.velocityBits = atoi(value);
+            else if (arg == "--samples") custom.params.samples = atoi(value);
+            else if (arg == "--frames") custom.params.sampleFrames = atoi(value);
+            else {
+                printUsage();
+                return 2;
+            }
+        }
+    }
+
+    if (useCustom) {
+        configs.push_back(custom);
+    } else {
+        BenchConfig c;
+        c.name = "small";
+        c.params.instruments = 2;
+        c.params.regions = 16;
+        c.params.velocityBits = 0;
+        c.params.samples = 32;
+        c.params.sampleFrames = 4096;
+        configs.push_back(c);
+        c.name = "medium";
+        c.params.instruments = 8;
+        c.params.regions = 64;
+        c.params.velocityBits = 3;
+        c.params.samples = 128;
+        c.params.sampleFrames = 44100;
+        configs.push_back(c);
+        c.name = "large";
+        c.params.instruments = 32;
+        c.params.regions = 128;
+        c.params.velocityBits = 5;
+        c.params.samples = 256;
+        c.params.sampleFrames = 44100;
+        configs.push_back(c);
+    }
+
+    std::string dirTemplate = baseDir + "/gigedit-bench-XXXXXX";
+    std::vector<char> buf(dirTemplate.begin(), dirTemplate.end());
+    buf.push_back(0);
+    if (!mkdtemp(&buf[0])) {
+        fprintf(stderr, "Could not create temporary directory in %s\n", baseDir.c_str());
+        return 1;
+    }
+    const std::string dir = &buf[0];
+
+    std::vector<BenchResult> results;
+    int ret = 0;
+    try {
+        for (size_t i = 0; i < configs.size(); ++i)
+            runConfig(configs[i], dir, results);
+    } catch (RIFF::Exception e) {
+        fprintf(stderr, "Error: %s\n", e.Message.c_str());
+        ret = 1;
+    } catch (std::string e) {
+        fprintf(stderr, "Error: %s\n", e.c_str());
+        ret = 1;
+    }
+    rmdir(dir.c_str());
+
+    printResults(results, configs);
+    return ret;
+}
@@ -20,8 +20,10 @@
 #include "global.h"
 #include "compat.h"
 #include "Settings.h"
+#include "Trace.h"
 #include <gtkmm/box.h>
 #include "dimregionchooser.h"
+#include "FileOperations.h"
 #include <cairomm/context.h>
 #include <cairomm/surface.h>
 #include <gdkmm/cursor.h>
@@ -39,45 +41,6 @@
 
 #include "gfx/builtinpix.h"
 
-//TODO: this function and dimensionCaseOf() from global.h are duplicates, eliminate either one of them!
-static DimensionCase caseOfDimRegion(gig::DimensionRegion* dr, bool* isValidZone) {
-    DimensionCase dimCase;
-    if (!dr) {
-        *isValidZone = false;
-        return dimCase;
-    }
-
-    gig::Region* rgn = (gig::Region*) dr->GetParent();
-
-    // find the dimension region index of the passed dimension region
-    int drIndex;
-    for (drIndex = 0; drIndex < 256; ++drIndex)
-        if (rgn->pDimensionRegions[drIndex] == dr)
-            break;
-
-    // not found in region, something's horribly wrong
-    if (drIndex == 256) {
-        fprintf(stderr, "DimRegionChooser: ERROR: index of dim region not found!\n");
-        *isValidZone = false;
-        return DimensionCase();
-    }
-
-    for (int d = 0, baseBits = 0; d < rgn->Dimensions; ++d) {
-        const int bits = rgn->pDimensionDefinitions[d].bits;
-        dimCase[rgn->pDimensionDefinitions[d].dimension] =
-            (drIndex >> baseBits) & ((1 << bits) - 1);
-        baseBits += bits;
-        // there are also DimensionRegion objects of unused zones, skip them
-        if (dimCase[rgn->pDimensionDefinitions[d].dimension] >= rgn->pDimensionDefinitions[d].zones) {
-            *isValidZone = false;
-            return DimensionCase();
-        }
-    }
-
-    *isValidZone = true;
-    return dimCase;
-}
-
 DimRegionChooser::DimRegionChooser(Gtk::Window& window) :
     red("#ff476e"),
     blue("#4796ff"),
@@ -435,6 +398,7 @@ bool DimRegionChooser::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
     double clipx1, clipx2, clipy1, clipy2;
     cr->get_clip_extents(clipx1, clipy1, clipx2, clipy2);
 #endif
+    GIGEDIT_TRACE_SCOPE("DimRegionChooser::on_draw");
 
     if (!region) return true;
 
@@ -810,41 +774,7 @@ void DimRegionChooser::refresh_all() {
 void DimRegionChooser::get_dimregions(const gig::Region* region, bool stereo,
                                       std::set<gig::DimensionRegion*>& dimregs) const
 {
-    for (int iDimRgn = 0; iDimRgn < 256; ++iDimRgn) {
-        gig::DimensionRegion* dimRgn = region->pDimensionRegions[iDimRgn];
-        if (!dimRgn) continue;
-        bool isValidZone;
-        std::map<gig::dimension_t,int> dimCase = caseOfDimRegion(dimRgn, &isValidZone);
-        if (!isValidZone) continue;
-        for (std::map<gig::dimension_t,int>::const_iterator it = dimCase.begin();
-             it != dimCase.end(); ++it)
-        {
-            if (stereo && it->first == gig::dimension_samplechannel) continue; // is selected
-
-            std::map<gig::dimension_t, std::set<int> >::const_iterator itSelectedDimension =
-                this->dimzones.find(it->first);
-            if (itSelectedDimension != this->dimzones.end()) {
-                if (itSelectedDimension->second.count(it->second))
-                    continue; // is selected
-                // special case: no selection of dimzone yet; assume zone 0
-                // being selected in this case
-                //
-                // (this is more or less a workaround for a bug, that is when
-                // no explicit dimregion case had been selected [ever] by user
-                // by clicking on some dimregionchooser zone yet, then the
-                // individual dimension entries of this->dimzones are empty)
-                if (itSelectedDimension->second.empty() && it->second == 0)
-                    continue; // is selected
-            }
-
-            goto notSelected;
-        }
-
-        dimregs.insert(dimRgn);
-
-        notSelected:
-        ;
-    }
+    selectDimRegions(region, stereo, this->dimzones, dimregs);
 }
 
 void DimRegionChooser::update_after_resize()
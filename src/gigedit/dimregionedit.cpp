@@ -29,6 +29,7 @@
 #endif
 
 #include "Settings.h"
+#include "Trace.h"
 
 VelocityCurve::VelocityCurve(double (gig::DimensionRegion::*getter)(uint8_t)) :
     getter(getter), dimreg(0) {
@@ -42,6 +43,7 @@ bool VelocityCurve::on_expose_event(GdkEventExpose* e) {
 #else
 bool VelocityCurve::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
 #endif
+    GIGEDIT_TRACE_SCOPE("VelocityCurve::on_draw");
     if (dimreg) {
         int w = get_width();
         int h = get_height();
@@ -84,6 +86,7 @@ bool CrossfadeCurve::on_expose_event(GdkEventExpose* e) {
 #else
 bool CrossfadeCurve::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
 #endif
+    GIGEDIT_TRACE_SCOPE("CrossfadeCurve::on_draw");
     if (dimreg) {
         cr->translate(1.5, 0);
 
@@ -160,6 +163,7 @@ bool LFOGraph::on_expose_event(GdkEventExpose* e) {
 #else
 bool LFOGraph::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
 #endif
+    GIGEDIT_TRACE_SCOPE("LFOGraph::on_draw");
     if (dimreg) {
         const int w = get_width();
         const int h = get_height();
@@ -439,10 +443,15 @@ DimRegionEdit::DimRegionEdit() :
     eSampleLoopInfinite(_("Infinite loop")),
     eSampleLoopPlayCount(_("Playback count"), 1),
     buttonSelectSample(UNICODE_LEFT_ARROW + "  " + _("Select Sample")),
+    buttonFindLoop(_("Find Loop ...")),
     editScriptSlotsButton(_("Edit Slots ...")),
     dimregion(NULL),
-    update_model(0)
+    update_model(0),
+    updatingPage(-1)
 {
+    for (int i = 0; i < tableSize; ++i)
+        pageOutdated[i] = true;
+
     // make synthesis parameter page tabs scrollable
     // (workaround for GTK3: default theme uses huge tabs which breaks layout)
     set_scrollable();
@@ -597,6 +606,9 @@ DimRegionEdit::DimRegionEdit() :
     buttonSelectSample.signal_clicked().connect(
         sigc::mem_fun(*this, &DimRegionEdit::onButtonSelectSamplePressed)
     );
+    buttonFindLoop.signal_clicked().connect(
+        sigc::mem_fun(*this, &DimRegionEdit::onButtonFindLoopPressed)
+    );
 
     for (int i = 0; i < tableSize; i++) {
 #if USE_GTKMM_GRID
@@ -643,6 +655,10 @@ DimRegionEdit::DimRegionEdit() :
     eSampleLoopLength.set_tip(
         _("Duration (in sample points) of the area to be looped")
     );
+    buttonFindLoop.set_tooltip_text(
+        _("Searches for loops near the current loop whose end matches "
+          "seamlessly with their start.")
+    );
     eSampleLoopType.set_tip(
         _("Direction in which the loop area in the sample should be played back")
     );
@@ -737,6 +753,7 @@ DimRegionEdit::DimRegionEdit() :
     addProp(eSampleLoopEnabled);
     addProp(eSampleLoopStart);
     addProp(eSampleLoopLength);
+    addRightHandSide(buttonFindLoop);
     {
         const char* choices[] = { _("normal"), _("bidirectional"), _("backward"), 0 };
         static const uint32_t values[] = {
@@ -1339,6 +1356,10 @@ DimRegionEdit::DimRegionEdit() :
     append_page(*table[8], _("Misc"));
     append_page(*table[9], _("Script"));
 
+    signal_switch_page().connect(
+        sigc::mem_fun(*this, &DimRegionEdit::on_page_switched)
+    );
+
     Settings::singleton()->showTooltips.get_proxy().signal_changed().connect(
         sigc::mem_fun(*this, &DimRegionEdit::on_show_tooltips_changed)
     );
@@ -1455,6 +1476,7 @@ void DimRegionEdit::on_show_tooltips_changed() {
     const bool b = Settings::singleton()->showTooltips;
 
     buttonSelectSample.set_has_tooltip(b);
+    buttonFindLoop.set_has_tooltip(b);
     buttonNullSampleReference->set_has_tooltip(b);
     wSample->set_has_tooltip(b);
 
@@ -1542,114 +1564,155 @@ void DimRegionEdit::set_dim_region(gig::DimensionRegion* d)
     set_sensitive(d);
     if (!d) return;
 
+    // only the currently visible page is updated right now, the other pages
+    // are updated when the user switches to them
+    for (int i = 0; i < tableSize; ++i)
+        pageOutdated[i] = true;
+    update_page(get_current_page());
+}
+
+void DimRegionEdit::on_page_switched(void* page, guint page_num)
+{
+    update_page(page_num);
+}
+
+int DimRegionEdit::page_of(const Gtk::Widget& widget) const
+{
+    for (const Gtk::Widget* w = &widget; w; w = w->get_parent())
+        for (int i = 0; i < tableSize; ++i)
+            if (w == table[i]) return i;
+    return -1;
+}
+
+bool DimRegionEdit::is_updated(const Gtk::Widget& widget) const
+{
+    if (updatingPage < 0) return true;
+    const int page = page_of(widget);
+    return page < 0 || page == updatingPage;
+}
+
+void DimRegionEdit::update_page(int page)
+{
+    if (!dimregion || page < 0 || page >= tableSize || !pageOutdated[page])
+        return;
+    pageOutdated[page] = false;
+    updatingPage = page;
+    update_widgets(dimregion);
+    updatingPage = -1;
+}
+
+void DimRegionEdit::update_widgets(gig::DimensionRegion* d)
+{
     update_model++;
-    eEG1PreAttack.set_value(d->EG1PreAttack);
-    eEG1Attack.set_value(d->EG1Attack);
-    eEG1Decay1.set_value(d->EG1Decay1);
-    eEG1Decay2.set_value(d->EG1Decay2);
-    eEG1InfiniteSustain.set_value(d->EG1InfiniteSustain);
-    eEG1Sustain.set_value(d->EG1Sustain);
-    eEG1Release.set_value(d->EG1Release);
-    eEG1Hold.set_value(d->EG1Hold);
-    eEG1Controller.set_value(d->EG1Controller);
-    eEG1ControllerInvert.set_value(d->EG1ControllerInvert);
-    eEG1ControllerAttackInfluence.set_value(d->EG1ControllerAttackInfluence);
-    eEG1ControllerDecayInfluence.set_value(d->EG1ControllerDecayInfluence);
-    eEG1ControllerReleaseInfluence.set_value(d->EG1ControllerReleaseInfluence);
-    eEG1StateOptions.checkBoxAttack.set_value(d->EG1Options.AttackCancel);
-    eEG1StateOptions.checkBoxAttackHold.set_value(d->EG1Options.AttackHoldCancel);
-    eEG1StateOptions.checkBoxDecay1.set_value(d->EG1Options.Decay1Cancel);
-    eEG1StateOptions.checkBoxDecay2.set_value(d->EG1Options.Decay2Cancel);
-    eEG1StateOptions.checkBoxRelease.set_value(d->EG1Options.ReleaseCancel);
-    eLFO1Wave.set_value(d->LFO1WaveForm);
-    eLFO1Frequency.set_value(d->LFO1Frequency);
-    eLFO1Phase.set_value(d->LFO1Phase);
-    eLFO1InternalDepth.set_value(d->LFO1InternalDepth);
-    eLFO1ControlDepth.set_value(d->LFO1ControlDepth);
-    eLFO1Controller.set_value(d->LFO1Controller);
-    eLFO1FlipPhase.set_value(d->LFO1FlipPhase);
-    eLFO1Sync.set_value(d->LFO1Sync);
-    eEG2PreAttack.set_value(d->EG2PreAttack);
-    eEG2Attack.set_value(d->EG2Attack);
-    eEG2Decay1.set_value(d->EG2Decay1);
-    eEG2Decay2.set_value(d->EG2Decay2);
-    eEG2InfiniteSustain.set_value(d->EG2InfiniteSustain);
-    eEG2Sustain.set_value(d->EG2Sustain);
-    eEG2Release.set_value(d->EG2Release);
-    eEG2Controller.set_value(d->EG2Controller);
-    eEG2ControllerInvert.set_value(d->EG2ControllerInvert);
-    eEG2ControllerAttackInfluence.set_value(d->EG2ControllerAttackInfluence);
-    eEG2ControllerDecayInfluence.set_value(d->EG2ControllerDecayInfluence);
-    eEG2ControllerReleaseInfluence.set_value(d->EG2ControllerReleaseInfluence);
-    eEG2StateOptions.checkBoxAttack.set_value(d->EG2Options.AttackCancel);
-    eEG2StateOptions.checkBoxAttackHold.set_value(d->EG2Options.AttackHoldCancel);
-    eEG2StateOptions.checkBoxDecay1.set_value(d->EG2Options.Decay1Cancel);
-    eEG2StateOptions.checkBoxDecay2.set_value(d->EG2Options.Decay2Cancel);
-    eEG2StateOptions.checkBoxRelease.set_value(d->EG2Options.ReleaseCancel);
-    eLFO2Wave.set_value(d->LFO2WaveForm);
-    eLFO2Frequency.set_value(d->LFO2Frequency);
-    eLFO2Phase.set_value(d->LFO2Phase);
-    eLFO2InternalDepth.set_value(d->LFO2InternalDepth);
-    eLFO2ControlDepth.set_value(d->LFO2ControlDepth);
-    eLFO2Controller.set_value(d->LFO2Controller);
-    eLFO2FlipPhase.set_value(d->LFO2FlipPhase);
-    eLFO2Sync.set_value(d->LFO2Sync);
-    eEG3Attack.set_value(d->EG3Attack);
-    eEG3Depth.set_value(d->EG3Depth);
-    eLFO3Wave.set_value(d->LFO3WaveForm);
-    eLFO3Frequency.set_value(d->LFO3Frequency);
-    eLFO3Phase.set_value(d->LFO3Phase);
-    eLFO3InternalDepth.set_value(d->LFO3InternalDepth);
-    eLFO3ControlDepth.set_value(d->LFO3ControlDepth);
-    eLFO3Controller.set_value(d->LFO3Controller);
-    eLFO3FlipPhase.set_value(d->LFO3FlipPhase);
-    eLFO3Sync.set_value(d->LFO3Sync);
+    update(eEG1PreAttack, d->EG1PreAttack);
+    update(eEG1Attack, d->EG1Attack);
+    update(eEG1Decay1, d->EG1Decay1);
+    update(eEG1Decay2, d->EG1Decay2);
+    update(eEG1InfiniteSustain, d->EG1InfiniteSustain);
+    update(eEG1Sustain, d->EG1Sustain);
+    update(eEG1Release, d->EG1Release);
+    update(eEG1Hold, d->EG1Hold);
+    update(eEG1Controller, d->EG1Controller);
+    update(eEG1ControllerInvert, d->EG1ControllerInvert);
+    update(eEG1ControllerAttackInfluence, d->EG1ControllerAttackInfluence);
+    update(eEG1ControllerDecayInfluence, d->EG1ControllerDecayInfluence);
+    update(eEG1ControllerReleaseInfluence, d->EG1ControllerReleaseInfluence);
+    update(eEG1StateOptions.checkBoxAttack, d->EG1Options.AttackCancel);
+    update(eEG1StateOptions.checkBoxAttackHold, d->EG1Options.AttackHoldCancel);
+    update(eEG1StateOptions.checkBoxDecay1, d->EG1Options.Decay1Cancel);
+    update(eEG1StateOptions.checkBoxDecay2, d->EG1Options.Decay2Cancel);
+    update(eEG1StateOptions.checkBoxRelease, d->EG1Options.ReleaseCancel);
+    update(eLFO1Wave, d->LFO1WaveForm);
+    update(eLFO1Frequency, d->LFO1Frequency);
+    update(eLFO1Phase, d->LFO1Phase);
+    update(eLFO1InternalDepth, d->LFO1InternalDepth);
+    update(eLFO1ControlDepth, d->LFO1ControlDepth);
+    update(eLFO1Controller, d->LFO1Controller);
+    update(eLFO1FlipPhase, d->LFO1FlipPhase);
+    update(eLFO1Sync, d->LFO1Sync);
+    update(eEG2PreAttack, d->EG2PreAttack);
+    update(eEG2Attack, d->EG2Attack);
+    update(eEG2Decay1, d->EG2Decay1);
+    update(eEG2Decay2, d->EG2Decay2);
+    update(eEG2InfiniteSustain, d->EG2InfiniteSustain);
+    update(eEG2Sustain, d->EG2Sustain);
+    update(eEG2Release, d->EG2Release);
+    update(eEG2Controller, d->EG2Controller);
+    update(eEG2ControllerInvert, d->EG2ControllerInvert);
+    update(eEG2ControllerAttackInfluence, d->EG2ControllerAttackInfluence);
+    update(eEG2ControllerDecayInfluence, d->EG2ControllerDecayInfluence);
+    update(eEG2ControllerReleaseInfluence, d->EG2ControllerReleaseInfluence);
+    update(eEG2StateOptions.checkBoxAttack, d->EG2Options.AttackCancel);
+    update(eEG2StateOptions.checkBoxAttackHold, d->EG2Options.AttackHoldCancel);
+    update(eEG2StateOptions.checkBoxDecay1, d->EG2Options.Decay1Cancel);
+    update(eEG2StateOptions.checkBoxDecay2, d->EG2Options.Decay2Cancel);
+    update(eEG2StateOptions.checkBoxRelease, d->EG2Options.ReleaseCancel);
+    update(eLFO2Wave, d->LFO2WaveForm);
+    update(eLFO2Frequency, d->LFO2Frequency);
+    update(eLFO2Phase, d->LFO2Phase);
+    update(eLFO2InternalDepth, d->LFO2InternalDepth);
+    update(eLFO2ControlDepth, d->LFO2ControlDepth);
+    update(eLFO2Controller, d->LFO2Controller);
+    update(eLFO2FlipPhase, d->LFO2FlipPhase);
+    update(eLFO2Sync, d->LFO2Sync);
+    update(eEG3Attack, d->EG3Attack);
+    update(eEG3Depth, d->EG3Depth);
+    update(eLFO3Wave, d->LFO3WaveForm);
+    update(eLFO3Frequency, d->LFO3Frequency);
+    update(eLFO3Phase, d->LFO3Phase);
+    update(eLFO3InternalDepth, d->LFO3InternalDepth);
+    update(eLFO3ControlDepth, d->LFO3ControlDepth);
+    update(eLFO3Controller, d->LFO3Controller);
+    update(eLFO3FlipPhase, d->LFO3FlipPhase);
+    update(eLFO3Sync, d->LFO3Sync);
+    // always updated, since it controls the sensitivity of widgets on
+    // several pages (see VCFEnabled_toggled())
     eVCFEnabled.set_value(d->VCFEnabled);
-    eVCFType.set_value(d->VCFType);
-    eVCFCutoffController.set_value(d->VCFCutoffController);
-    eVCFCutoffControllerInvert.set_value(d->VCFCutoffControllerInvert);
-    eVCFCutoff.set_value(d->VCFCutoff);
-    eVCFVelocityCurve.set_value(d->VCFVelocityCurve);
-    eVCFVelocityScale.set_value(d->VCFVelocityScale);
-    eVCFVelocityDynamicRange.set_value(d->VCFVelocityDynamicRange);
-    eVCFResonance.set_value(d->VCFResonance);
-    eVCFResonanceDynamic.set_value(d->VCFResonanceDynamic);
-    eVCFResonanceController.set_value(d->VCFResonanceController);
-    eVCFKeyboardTracking.set_value(d->VCFKeyboardTracking);
-    eVCFKeyboardTrackingBreakpoint.set_value(d->VCFKeyboardTrackingBreakpoint);
-    eVelocityResponseCurve.set_value(d->VelocityResponseCurve);
-    eVelocityResponseDepth.set_value(d->VelocityResponseDepth);
-    eVelocityResponseCurveScaling.set_value(d->VelocityResponseCurveScaling);
-    eReleaseVelocityResponseCurve.set_value(d->ReleaseVelocityResponseCurve);
-    eReleaseVelocityResponseDepth.set_value(d->ReleaseVelocityResponseDepth);
-    eReleaseTriggerDecay.set_value(d->ReleaseTriggerDecay);
-    eCrossfade_in_start.set_value(d->Crossfade.in_start);
-    eCrossfade_in_end.set_value(d->Crossfade.in_end);
-    eCrossfade_out_start.set_value(d->Crossfade.out_start);
-    eCrossfade_out_end.set_value(d->Crossfade.out_end);
-    ePitchTrack.set_value(d->PitchTrack);
-    eSustainReleaseTrigger.set_value(d->SustainReleaseTrigger);
-    eNoNoteOffReleaseTrigger.set_value(d->NoNoteOffReleaseTrigger);
-    eDimensionBypass.set_value(d->DimensionBypass);
-    ePan.set_value(d->Pan);
-    eSelfMask.set_value(d->SelfMask);
-    eAttenuationController.set_value(d->AttenuationController);
-    eInvertAttenuationController.set_value(d->InvertAttenuationController);
-    eAttenuationControllerThreshold.set_value(d->AttenuationControllerThreshold);
-    eChannelOffset.set_value(d->ChannelOffset);
-    eSustainDefeat.set_value(d->SustainDefeat);
-    eMSDecode.set_value(d->MSDecode);
-    eSampleStartOffset.set_value(d->SampleStartOffset);
-    eUnityNote.set_value(d->UnityNote);
+    update(eVCFType, d->VCFType);
+    update(eVCFCutoffController, d->VCFCutoffController);
+    update(eVCFCutoffControllerInvert, d->VCFCutoffControllerInvert);
+    update(eVCFCutoff, d->VCFCutoff);
+    update(eVCFVelocityCurve, d->VCFVelocityCurve);
+    update(eVCFVelocityScale, d->VCFVelocityScale);
+    update(eVCFVelocityDynamicRange, d->VCFVelocityDynamicRange);
+    update(eVCFResonance, d->VCFResonance);
+    update(eVCFResonanceDynamic, d->VCFResonanceDynamic);
+    update(eVCFResonanceController, d->VCFResonanceController);
+    update(eVCFKeyboardTracking, d->VCFKeyboardTracking);
+    update(eVCFKeyboardTrackingBreakpoint, d->VCFKeyboardTrackingBreakpoint);
+    update(eVelocityResponseCurve, d->VelocityResponseCurve);
+    update(eVelocityResponseDepth, d->VelocityResponseDepth);
+    update(eVelocityResponseCurveScaling, d->VelocityResponseCurveScaling);
+    update(eReleaseVelocityResponseCurve, d->ReleaseVelocityResponseCurve);
+    update(eReleaseVelocityResponseDepth, d->ReleaseVelocityResponseDepth);
+    update(eReleaseTriggerDecay, d->ReleaseTriggerDecay);
+    update(eCrossfade_in_start, d->Crossfade.in_start);
+    update(eCrossfade_in_end, d->Crossfade.in_end);
+    update(eCrossfade_out_start, d->Crossfade.out_start);
+    update(eCrossfade_out_end, d->Crossfade.out_end);
+    update(ePitchTrack, d->PitchTrack);
+    update(eSustainReleaseTrigger, d->SustainReleaseTrigger);
+    update(eNoNoteOffReleaseTrigger, d->NoNoteOffReleaseTrigger);
+    update(eDimensionBypass, d->DimensionBypass);
+    update(ePan, d->Pan);
+    update(eSelfMask, d->SelfMask);
+    update(eAttenuationController, d->AttenuationController);
+    update(eInvertAttenuationController, d->InvertAttenuationController);
+    update(eAttenuationControllerThreshold, d->AttenuationControllerThreshold);
+    update(eChannelOffset, d->ChannelOffset);
+    update(eSustainDefeat, d->SustainDefeat);
+    update(eMSDecode, d->MSDecode);
+    update(eSampleStartOffset, d->SampleStartOffset);
+    update(eUnityNote, d->UnityNote);
     // show sample group name
-    {
+    if (is_updated(eSampleGroup.widget)) {
         Glib::ustring s = "---";
         if (d->pSample && d->pSample->GetGroup())
             s = d->pSample->GetGroup()->Name;
         eSampleGroup.text.set_text(s);
     }
     // assemble sample format info string
-    {
+    if (is_updated(eSampleFormatInfo.widget)) {
         Glib::ustring s;
         if (d->pSample) {
             switch (d->pSample->Channels) {
@@ -1668,7 +1731,7 @@ void DimRegionEdit::set_dim_region(gig::DimensionRegion* d)
         eSampleFormatInfo.text.set_text(s);
     }
     // generate sample's memory address pointer string
-    {
+    if (is_updated(eSampleID.widget)) {
         Glib::ustring s;
         if (d->pSample) {
             char buf[64] = {};
@@ -1680,7 +1743,7 @@ void DimRegionEdit::set_dim_region(gig::DimensionRegion* d)
         eSampleID.text.set_text(s);
     }
     // generate raw wave form data CRC-32 checksum string
-    {
+    if (is_updated(eChecksum.widget)) {
         Glib::ustring s = "---";
         if (d->pSample) {
             char buf[64] = {};
@@ -1690,29 +1753,33 @@ void DimRegionEdit::set_dim_region(gig::DimensionRegion* d)
         eChecksum.text.set_text(s);
     }
     buttonSelectSample.set_sensitive(d && d->pSample);
-    eFineTune.set_value(d->FineTune);
-    eGain.set_value(d->Gain);
-    eSampleLoopEnabled.set_value(d->SampleLoops);
-    eSampleLoopType.set_value(
+    update(eFineTune, d->FineTune);
+    update(eGain, d->Gain);
+    update(eSampleLoopEnabled, d->SampleLoops);
+    update(eSampleLoopType,
         d->SampleLoops ? d->pSampleLoops[0].LoopType : 0);
-    eSampleLoopStart.set_value(
+    update(eSampleLoopStart,
         d->SampleLoops ? d->pSampleLoops[0].LoopStart : 0);
-    eSampleLoopLength.set_value(
+    update(eSampleLoopLength,
         d->SampleLoops ? d->pSampleLoops[0].LoopLength : 0);
-    eSampleLoopInfinite.set_value(
+    update(eSampleLoopInfinite,
         d->pSample && d->pSample->LoopPlayCount == 0);
-    eSampleLoopPlayCount.set_value(
+    update(eSampleLoopPlayCount,
         d->pSample ? d->pSample->LoopPlayCount : 0);
     update_model--;
 
-    wSample->set_text(d->pSample ? gig_to_utf8(d->pSample->pInfo->Name) :
-                      _("NULL"));
+    if (is_updated(*wSample)) {
+        wSample->set_text(d->pSample ? gig_to_utf8(d->pSample->pInfo->Name) :
+                          _("NULL"));
+        update_loop_elements();
+    }
 
-    scriptVars.setInstrument(
-        (gig::Instrument*) d->GetParent()->GetParent()
-    );
+    if (is_updated(scriptVars)) {
+        scriptVars.setInstrument(
+            (gig::Instrument*) d->GetParent()->GetParent()
+        );
+    }
 
-    update_loop_elements();
     VCFEnabled_toggled();
 }
 
@@ -1893,6 +1960,7 @@ void DimRegionEdit::update_loop_elements()
     eSampleLoopLength.set_sensitive(active);
     eSampleLoopType.set_sensitive(active);
     eSampleLoopInfinite.set_sensitive(active && dimregion && dimregion->pSample);
+    buttonFindLoop.set_sensitive(active && dimregion && dimregion->pSample);
     // sample loop shall never be longer than the actual sample size
     loop_start_changed();
     loop_length_changed();
@@ -2032,6 +2100,10 @@ sigc::signal<void, gig::DimensionRegion*>& DimRegionEdit::signal_dimreg_to_be_ch
     return dimreg_to_be_changed_signal;
 }
 
+sigc::signal<void, gig::DimensionRegion*>& DimRegionEdit::signal_live_dimreg_to_be_changed() {
+    return live_dimreg_to_be_changed_signal;
+}
+
 sigc::signal<void, gig::DimensionRegion*>& DimRegionEdit::signal_dimreg_changed() {
     return dimreg_changed_signal;
 }
@@ -2040,6 +2112,15 @@ sigc::signal<void, gig::Sample*/*old*/, gig::Sample*/*new*/>& DimRegionEdit::sig
     return sample_ref_changed_signal;
 }
 
+sigc::signal<void, gig::Sample*>& DimRegionEdit::signal_sample_changed() {
+    return sample_changed_signal;
+}
+
+
+bool DimRegionEdit::live_parameter_editing() const
+{
+    return Settings::singleton()->liveParameterEditing;
+}
 
 void DimRegionEdit::set_UnityNote(gig::DimensionRegion& d, uint8_t value)
 {
@@ -2143,14 +2224,20 @@ void DimRegionEdit::set_LoopLength(gig::DimensionRegion& d, uint32_t value)
 void DimRegionEdit::set_LoopInfinite(gig::DimensionRegion& d, bool value)
 {
     if (d.pSample) {
+        const uint32_t count = d.pSample->LoopPlayCount;
         if (value) d.pSample->LoopPlayCount = 0;
         else if (d.pSample->LoopPlayCount == 0) d.pSample->LoopPlayCount = 1;
+        if (d.pSample->LoopPlayCount != count)
+            sample_changed_signal.emit(d.pSample);
     }
 }
 
 void DimRegionEdit::set_LoopPlayCount(gig::DimensionRegion& d, uint32_t value)
 {
-    if (d.pSample) d.pSample->LoopPlayCount = value;
+    if (d.pSample && d.pSample->LoopPlayCount != value) {
+        d.pSample->LoopPlayCount = value;
+        sample_changed_signal.emit(d.pSample);
+    }
 }
 
 void DimRegionEdit::nullOutSampleReference() {
@@ -2207,3 +2294,31 @@ void DimRegionEdit::onButtonSelectSamplePressed() {
 sigc::signal<void, gig::Sample*>& DimRegionEdit::signal_select_sample() {
     return select_sample_signal;
 }
+
+void DimRegionEdit::onButtonFindLoopPressed() {
+    if (!dimregion || !dimregion->pSample || !dimregion->SampleLoops) return;
+    find_loop_signal.emit(dimregion);
+}
+
+sigc::signal<void, gig::DimensionRegion*>& DimRegionEdit::signal_find_loop() {
+    return find_loop_signal;
+}
+
+/**
+ * Changes the loop of all dimension regions currently being edited, just as
+ * if the user entered the new values into the loop start and loop size
+ * fields.
+ */
+void DimRegionEdit::set_loop(uint32_t start, uint32_t length) {
+    // the setters limit each value by the other one, so change the value
+    // first which would not be clipped by the other one's old value
+    if (dimregion && dimregion->SampleLoops &&
+        start > dimregion->pSampleLoops[0].LoopStart)
+    {
+        eSampleLoopLength.set_value(length);
+        eSampleLoopStart.set_value(start);
+    } else {
+        eSampleLoopStart.set_value(start);
+        eSampleLoopLength.set_value(length);
+    }
+}
@@ -51,6 +51,7 @@
 #include "paramedit.h"
 #include "global.h"
 #include "ScriptPatchVars.h"
+#include "AtomicStore.h"
 #include "wrapLabel.hh"
 
 class VelocityCurve : public Gtk::DrawingArea {
@@ -206,8 +207,12 @@ public:
     Gtk::Button* buttonNullSampleReference;
     sigc::signal<void, gig::DimensionRegion*>& signal_dimreg_to_be_changed();
     sigc::signal<void, gig::DimensionRegion*>& signal_dimreg_changed();
+    sigc::signal<void, gig::DimensionRegion*>& signal_live_dimreg_to_be_changed();
     sigc::signal<void, gig::Sample*/*old*/, gig::Sample*/*new*/>& signal_sample_ref_changed();
+    sigc::signal<void, gig::Sample*>& signal_sample_changed(); ///< a field of the referenced sample itself was modified
     sigc::signal<void, gig::Sample*>& signal_select_sample();
+    sigc::signal<void, gig::DimensionRegion*>& signal_find_loop();
+    void set_loop(uint32_t start, uint32_t length);
 
     std::set<gig::DimensionRegion*> dimregs;
 
@@ -217,9 +222,14 @@ public:
 protected:
     sigc::signal<void, gig::DimensionRegion*> dimreg_to_be_changed_signal;
     sigc::signal<void, gig::DimensionRegion*> dimreg_changed_signal;
+    // emitted before a value is published in live parameter editing mode,
+    // where the sampler is not informed in advance
+    sigc::signal<void, gig::DimensionRegion*> live_dimreg_to_be_changed_signal;
     sigc::signal<void, gig::Sample*/*old*/, gig::Sample*/*new*/> sample_ref_changed_signal;
+    sigc::signal<void, gig::Sample*> sample_changed_signal;
     sigc::signal<void> instrument_changed;
     sigc::signal<void, gig::Sample*> select_sample_signal;
+    sigc::signal<void, gig::DimensionRegion*> find_loop_signal;
 
     /**
      * Ensures that the 2 signals DimRegionEdit::dimreg_to_be_changed_signal and
@@ -363,6 +373,7 @@ protected:
     Gtk::Label* lLFO2;
 
     Gtk::Button buttonSelectSample;
+    Gtk::Button buttonFindLoop;
 
     Gtk::HBox scriptVarsDescrBox;
 #if GTKMM_MAJOR_VERSION < 3
@@ -408,8 +419,25 @@ protected:
     void loop_infinite_toggled();
     void nullOutSampleReference();
     void on_show_tooltips_changed();
+    void on_page_switched(void* page, guint page_num);
+
+    int page_of(const Gtk::Widget& widget) const;
+    bool is_updated(const Gtk::Widget& widget) const;
+    void update_page(int page);
+    void update_widgets(gig::DimensionRegion* d);
+
+    static Gtk::Widget& widget_of(LabelWidget& w) { return w.widget; }
+    static Gtk::Widget& widget_of(Gtk::Widget& w) { return w; }
+
+    // set a widget's value, if the widget is on the page currently updated
+    template<typename W, typename T>
+    void update(W& widget, const T& value) {
+        if (is_updated(widget_of(widget))) widget.set_value(value);
+    }
 
     int update_model;
+    bool pageOutdated[tableSize]; ///< Page not yet updated for the current dimension region.
+    int updatingPage; ///< Page currently updated by update_page(), or -1.
 
     // connect a widget to a setter function in DimRegionEdit
     template<typename C, typename T>
@@ -422,15 +450,17 @@ protected:
     // connect a widget to a member variable in gig::DimensionRegion
     template<typename C, typename T>
     void connect(C& widget, T gig::DimensionRegion::* member) {
-        connect<C, T>(widget,
-                      sigc::bind(sigc::mem_fun(&DimRegionEdit::set_member<T>), member));
+        widget.signal_value_changed().connect(
+            sigc::compose(sigc::bind(sigc::mem_fun(*this, &DimRegionEdit::set_many_members<T>), member),
+                          sigc::mem_fun(widget, &C::get_value)));
     }
 
     // connect a widget to a member of a struct member in gig::DimensionRegion
     template<typename C, typename T, typename S>
     void connect(C& widget, S gig::DimensionRegion::* member, T S::* member2) {
-        connect<C, T>(widget,
-                      sigc::bind(sigc::mem_fun(&DimRegionEdit::set_sub_member<T, S>), member, member2));
+        widget.signal_value_changed().connect(
+            sigc::compose(sigc::bind(sigc::mem_fun(*this, &DimRegionEdit::set_many_sub_members<T, S>), member, member2),
+                          sigc::mem_fun(widget, &C::get_value)));
     }
 
     // connect a widget to a setter function in gig::DimensionRegion
@@ -459,12 +489,51 @@ protected:
             for (std::set<gig::DimensionRegion*>::iterator i = dimregs.begin() ;
                  i != dimregs.end() ; ++i)
             {
-                DimRegionChangeGuard(this, *i);
+                DimRegionChangeGuard guard(this, *i);
                 setter(*this, **i, value);
             }
         }
     }
 
+    // Like set_many(), but for a plain member variable. In live parameter
+    // editing mode the value is published to the sampler by one atomic write
+    // per dimregion instead, so the sampler does not have to suspend the
+    // dimregions (and thus interrupt playback) while the value is changed.
+    template<typename T>
+    void set_many_members(T value, T gig::DimensionRegion::* member) {
+        if (!live_parameter_editing()) {
+            set_many<T>(value, sigc::bind(sigc::mem_fun(&DimRegionEdit::set_member<T>), member));
+            return;
+        }
+        if (update_model) return;
+        for (std::set<gig::DimensionRegion*>::iterator i = dimregs.begin() ;
+             i != dimregs.end() ; ++i)
+        {
+            live_dimreg_to_be_changed_signal.emit(*i);
+            atomicStore((*i)->*member, value);
+            dimreg_changed_signal.emit(*i);
+        }
+    }
+
+    // like set_many_members(), for a member of a struct member variable
+    template<typename T, typename S>
+    void set_many_sub_members(T value, S gig::DimensionRegion::* member, T S::* member2) {
+        if (!live_parameter_editing()) {
+            set_many<T>(value, sigc::bind(sigc::mem_fun(&DimRegionEdit::set_sub_member<T, S>), member, member2));
+            return;
+        }
+        if (update_model) return;
+        for (std::set<gig::DimensionRegion*>::iterator i = dimregs.begin() ;
+             i != dimregs.end() ; ++i)
+        {
+            live_dimreg_to_be_changed_signal.emit(*i);
+            atomicStore((*i)->*member.*member2, value);
+            dimreg_changed_signal.emit(*i);
+        }
+    }
+
+    bool live_parameter_editing() const;
+
     // set a value of a member variable in the given dimregion
     template<typename T>
     void set_member(gig::DimensionRegion& d, T value,
@@ -496,6 +565,7 @@ protected:
     void set_LoopPlayCount(gig::DimensionRegion& d, uint32_t value);
 
     void onButtonSelectSamplePressed();
+    void onButtonFindLoopPressed();
 };
 
 #endif
@@ -29,6 +29,7 @@
 #include <mutex>
 #include <condition_variable>
 #endif
+#include <list>
 #if GTKMM_MAJOR_VERSION < 3
 #include <gdkmm/region.h>
 #endif
@@ -47,6 +48,8 @@
 #endif
 
 #include "mainwindow.h"
+#include "BatchMode.h"
+#include "Trace.h"
 
 #include "global.h"
 
@@ -65,83 +68,137 @@ extern bool g_fireMainThreadCallback;
 
 namespace {
 
-// State for a gigedit thread.
-//
-// This class is only used when gigedit is run as a plugin and makes
-// sure that there's only one Gtk::Main event loop. The event loop is
-// started in a separate thread. The plugin thread just dispatches an
-// event to the main loop to open a window and then goes to sleep
-// until the window is closed.
-//
-class GigEditState : public sigc::trackable {
+// simple mutex abstraction
+class Mutex {
+private:
+#ifdef GLIB_THREADS
+    Glib::Threads::Mutex mutex;
+#else
+    std::mutex mutex;
+#endif
 public:
-    GigEditState(GigEdit* parent) :
-        window(0), parent(parent), instrument(0) { }
-    void run(gig::Instrument* pInstrument);
-
-    MainWindow* window;
+    void lock() { mutex.lock(); }
+    void unlock() { mutex.unlock(); }
+};
 
+// simple condition variable abstraction
+class Cond {
 private:
-
-    // simple condition variable abstraction
-    class Cond {
-    private:
-        bool pred;
+    bool pred;
 #ifdef GLIB_THREADS
-        Glib::Threads::Mutex mutex;
-        Glib::Threads::Cond cond;
+    Glib::Threads::Mutex mutex;
+    Glib::Threads::Cond cond;
 #else
-        std::mutex mutex;
-        std::condition_variable cond;
-#endif        
-    public:
-        Cond() : pred(false) { }
-        void signal() {
+    std::mutex mutex;
+    std::condition_variable cond;
+#endif
+public:
+    Cond(bool pred = false) : pred(pred) { }
+    void signal() {
 #ifdef GLIB_THREADS
-            Glib::Threads::Mutex::Lock lock(mutex);
-            pred = true;
-            cond.signal();
+        Glib::Threads::Mutex::Lock lock(mutex);
+        pred = true;
+        cond.broadcast();
 #else
-            std::lock_guard<std::mutex> lock(mutex);
-            pred = true;
-            cond.notify_one();
+        std::lock_guard<std::mutex> lock(mutex);
+        pred = true;
+        cond.notify_all();
 #endif
-        }
-        void wait() {
+    }
+    void reset() {
 #ifdef GLIB_THREADS
-            Glib::Threads::Mutex::Lock lock(mutex);
-            while (!pred) cond.wait(mutex);
+        Glib::Threads::Mutex::Lock lock(mutex);
 #else
-            std::unique_lock<std::mutex> lock(mutex);
-            while (!pred) cond.wait(lock);
-#endif      
-        }
-    };
-
-#ifdef OLD_THREADS
-    static Glib::StaticMutex mutex;
-#elif defined(GLIB_THREADS)
-    static Glib::Threads::Mutex mutex;
+        std::lock_guard<std::mutex> lock(mutex);
+#endif
+        pred = false;
+    }
+    void wait() {
+#ifdef GLIB_THREADS
+        Glib::Threads::Mutex::Lock lock(mutex);
+        while (!pred) cond.wait(mutex);
 #else
-    static std::mutex mutex;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!pred) cond.wait(lock);
 #endif
-    static Glib::Dispatcher* dispatcher;
-    static GigEditState* current;
+    }
+};
 
-    static void main_loop_run(Cond* intialized);
-    static void open_window_static();
+// Editor session of one GigEdit instance.
+//
+// This class is only used when gigedit is run as a plugin. Any thread
+// may open and close the session's window, which just queues a request
+// to the GUI thread (see EditorHost) and returns immediately. All
+// signals of the session's window are routed to the session's GigEdit
+// instance, and thus to the plugin instance which owns it.
+//
+class GigEditState : public sigc::trackable {
+public:
+    GigEditState(GigEdit* parent) :
+        window(0), parent(parent), opened(false), pendingOpens(0),
+        closed(true) { }
+    void open(gig::Instrument* pInstrument);
+    void close();
+    void wait_until_closed();
+    bool is_open() const;
+
+    // only called by the GUI thread
+    void open_window(gig::Instrument* instrument);
+    void close_window();
+
+    MainWindow* window; // only accessed by the GUI thread
 
+private:
     GigEdit* parent;
-    Cond open;
-    Cond close;
-    Cond initialized;
-    gig::Instrument* instrument;
+    mutable Mutex mutex; // protects opened, pendingOpens and the state of closed
+    bool opened;
+    int pendingOpens; // open requests not yet handled by the GUI thread
+    Cond closed;
 
-    void open_window();
-    void close_window();
+    void on_window_hidden();
+};
+
+// Host of all editor sessions.
+//
+// This class makes sure that there's only one Gtk::Main event loop. The
+// event loop is started in a separate thread (the GUI thread) when the
+// first session is opened, and serves the windows of any number of
+// sessions. Open and close requests of the sessions are queued and
+// handled by the GUI thread, so no other thread has to wait for it.
+//
+class EditorHost {
+public:
+    enum request_type_t {
+        REQUEST_OPEN,
+        REQUEST_CLOSE
+    };
+
+    static EditorHost& instance();
+    void post(request_type_t type, GigEditState* session,
+              gig::Instrument* instrument = NULL);
+    void remove(GigEditState* session);
+    static bool is_gui_thread();
+
+private:
+    struct Request {
+        request_type_t type;
+        GigEditState* session;
+        gig::Instrument* instrument;
+    };
+
+    EditorHost() : dispatcher(0), started(false) { }
+    void start();
+    void on_requests();
+    void main_loop_run();
 #if defined(__APPLE__)
     static void runInCFMainLoop(void* info);
 #endif
+
+    Mutex mutex; // protects all members below
+    std::list<Request> requests;
+    Glib::Dispatcher* dispatcher;
+    bool started;
+    Cond initialized;
 };
 
 #ifdef WIN32
@@ -161,6 +218,7 @@ void init_app() {
         std::cout << "Initializing 3rd party services needed by gigedit.\n"
                   << std::flush;
         setlocale(LC_ALL, "");
+        initTraceFromEnvironment();
 
 #ifdef __APPLE__
         // Look for pango.modules, gdk-pixbuf.loaders and locale files
@@ -372,6 +430,9 @@ void connect_signals(GigEdit* gigedit, MainWindow* mainwindow) {
     mainwindow->signal_sample_changed().connect(
         gigedit->signal_sample_changed().make_slot()
     );
+    mainwindow->signal_sample_data_changed().connect(
+        gigedit->signal_sample_data_changed().make_slot()
+    );
     mainwindow->signal_sample_ref_changed().connect(
         gigedit->signal_sample_ref_changed().make_slot()
     );
@@ -395,12 +456,30 @@ void connect_signals(GigEdit* gigedit, MainWindow* mainwindow) {
 } // namespace
 
 GigEdit::GigEdit() {
-    state = NULL;
+    state = new GigEditState(this);
+}
+
+GigEdit::~GigEdit() {
+    GigEditState* state = static_cast<GigEditState*>(this->state);
+    if (state->is_open()) {
+        if (EditorHost::is_gui_thread()) {
+            state->close_window();
+        } else {
+            state->close();
+            state->wait_until_closed();
+        }
+    }
+    EditorHost::instance().remove(state);
+    delete state;
 }
 
 int GigEdit::run(int argc, char* argv[]) {
     init_app();
 
+    // command line bulk operations, no GUI (and no display) required
+    if (isBatchModeRequested(argc, argv))
+        return runBatchMode(argc, argv);
+
 #if GTKMM_MAJOR_VERSION < 3 || (GTKMM_MAJOR_VERSION == 3 && (GTKMM_MINOR_VERSION < 89 || (GTKMM_MINOR_VERSION == 89 && GTKMM_MICRO_VERSION < 4))) // GTKMM < 3.89.4
     Gtk::Main kit(argc, argv);
 #else
@@ -422,27 +501,39 @@ int GigEdit::run(int argc, char* argv[]) {
 }
 
 int GigEdit::run(gig::Instrument* pInstrument) {
-    init_app();
-
-    GigEditState state(this);
-    this->state = &state;
-    state.run(pInstrument);
-    this->state = NULL;
+    open(pInstrument);
+    static_cast<GigEditState*>(state)->wait_until_closed();
     return 0;
 }
 
+void GigEdit::open(gig::Instrument* pInstrument) {
+    static_cast<GigEditState*>(state)->open(pInstrument);
+}
+
+void GigEdit::close() {
+    static_cast<GigEditState*>(state)->close();
+}
+
+bool GigEdit::is_open() const {
+    return static_cast<GigEditState*>(state)->is_open();
+}
+
 void GigEdit::on_note_on_event(int key, int velocity) {
-    if (!this->state) return;
     GigEditState* state = static_cast<GigEditState*>(this->state);
+    if (!state->window) return;
     state->window->signal_note_on().emit(key, velocity);
 }
 
 void GigEdit::on_note_off_event(int key, int velocity) {
-    if (!this->state) return;
     GigEditState* state = static_cast<GigEditState*>(this->state);
+    if (!state->window) return;
     state->window->signal_note_off().emit(key, velocity);
 }
 
+sigc::signal<void>& GigEdit::signal_closed() {
+    return closed_signal;
+}
+
 sigc::signal<void, gig::File*>& GigEdit::signal_file_structure_to_be_changed() {
     return file_structure_to_be_changed_signal;
 }
@@ -479,6 +570,10 @@ sigc::signal<void, gig::Sample*>& GigEdit::signal_sample_changed() {
     return sample_changed_signal;
 }
 
+sigc::signal<void, gig::Sample*, SampleChange>& GigEdit::signal_sample_data_changed() {
+    return sample_data_changed_signal;
+}
+
 sigc::signal<void, gig::Sample*/*old*/, gig::Sample*/*new*/>& GigEdit::signal_sample_ref_changed() {
     return sample_ref_changed_signal;
 }
@@ -495,43 +590,131 @@ sigc::signal<void, gig::Instrument*>& GigEdit::signal_switch_sampler_instrument(
     return switch_sampler_instrument_signal;
 }
 
-#ifdef OLD_THREADS
-Glib::StaticMutex GigEditState::mutex = GLIBMM_STATIC_MUTEX_INIT;
-#elif defined(GLIB_THREADS)
-Glib::Threads::Mutex GigEditState::mutex;
-#else
-std::mutex GigEditState::mutex;
-#endif
-Glib::Dispatcher* GigEditState::dispatcher = 0;
-GigEditState* GigEditState::current = 0;
+thread_local bool t_isGuiThread = false;
+
+EditorHost& EditorHost::instance() {
+    static EditorHost host;
+    return host;
+}
+
+bool EditorHost::is_gui_thread() {
+    return t_isGuiThread;
+}
+
+void EditorHost::post(request_type_t type, GigEditState* session,
+                      gig::Instrument* instrument)
+{
+    Request request = { type, session, instrument };
+    mutex.lock();
+    start();
+    requests.push_back(request);
+    mutex.unlock();
+    dispatcher->emit();
+}
+
+void EditorHost::remove(GigEditState* session) {
+    mutex.lock();
+    for (std::list<Request>::iterator it = requests.begin();
+         it != requests.end(); )
+    {
+        if (it->session == session) it = requests.erase(it);
+        else ++it;
+    }
+    mutex.unlock();
+}
+
+void EditorHost::on_requests() {
+    while (true) {
+        mutex.lock();
+        if (requests.empty()) {
+            mutex.unlock();
+            break;
+        }
+        Request request = requests.front();
+        requests.pop_front();
+        mutex.unlock();
+
+        if (request.type == REQUEST_OPEN)
+            request.session->open_window(request.instrument);
+        else
+            request.session->close_window();
+    }
+}
+
+void GigEditState::open(gig::Instrument* pInstrument) {
+    mutex.lock();
+    if (!opened) {
+        opened = true;
+        closed.reset();
+    }
+    ++pendingOpens;
+    mutex.unlock();
+    EditorHost::instance().post(EditorHost::REQUEST_OPEN, this, pInstrument);
+}
+
+void GigEditState::close() {
+    if (!is_open()) return;
+    EditorHost::instance().post(EditorHost::REQUEST_CLOSE, this);
+}
 
-void GigEditState::open_window_static() {
-    GigEditState* c = GigEditState::current;
-    c->open.signal();
-    c->open_window();
+bool GigEditState::is_open() const {
+    mutex.lock();
+    const bool result = opened;
+    mutex.unlock();
+    return result;
 }
 
-void GigEditState::open_window() {
+void GigEditState::wait_until_closed() {
+    closed.wait();
+    // on_window_hidden() signals while still holding the lock, so wait for
+    // it to be released before the caller might delete this session
+    mutex.lock();
+    mutex.unlock();
+}
+
+void GigEditState::open_window(gig::Instrument* instrument) {
+    mutex.lock();
+    --pendingOpens;
+    mutex.unlock();
+    if (window) { // session's window is already open
+        window->present();
+        return;
+    }
     window = new MainWindow();
 
     connect_signals(parent, window);
     if (instrument) window->load_instrument(instrument);
 
     window->signal_hide().connect(sigc::mem_fun(*this,
-                                                &GigEditState::close_window));
+                                                &GigEditState::on_window_hidden));
     window->present();
 }
 
 void GigEditState::close_window() {
+    if (window) window->hide();
+}
+
+void GigEditState::on_window_hidden() {
     delete window;
-    close.signal();
+    window = NULL;
+    parent->signal_closed().emit();
+    // if open() was called meanwhile, its request is still queued and will
+    // show the window again, so the session is not closed then
+    mutex.lock();
+    if (!pendingOpens) {
+        opened = false;
+        closed.signal();
+    }
+    mutex.unlock();
 }
 
 #if defined(WIN32) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 2))
 // make sure stack is 16-byte aligned for SSE instructions
 __attribute__((force_align_arg_pointer))
 #endif
-void GigEditState::main_loop_run(Cond* initialized) {
+void EditorHost::main_loop_run() {
+    t_isGuiThread = true;
+
     int argc = 1;
     const char* argv_c[] = { "gigedit" };
     char** argv = const_cast<char**>(argv_c);
@@ -541,8 +724,8 @@ void GigEditState::main_loop_run(Cond* initialized) {
     init_app_after_gtk_init();
 
     dispatcher = new Glib::Dispatcher();
-    dispatcher->connect(sigc::ptr_fun(&GigEditState::open_window_static));
-    initialized->signal();
+    dispatcher->connect(sigc::mem_fun(*this, &EditorHost::on_requests));
+    initialized.signal();
 
 #if GTKMM_MAJOR_VERSION < 3 || (GTKMM_MAJOR_VERSION == 3 && (GTKMM_MINOR_VERSION < 89 || (GTKMM_MINOR_VERSION == 89 && GTKMM_MICRO_VERSION < 4))) // GTKMM < 3.89.4
     main_loop.run();
@@ -553,94 +736,82 @@ void GigEditState::main_loop_run(Cond* initialized) {
 
 #if defined(__APPLE__)
 
-void GigEditState::runInCFMainLoop(void* info) {
+void EditorHost::runInCFMainLoop(void* info) {
     printf("runInCFMainLoop() entered\n"); fflush(stdout);
-    GigEditState* state = static_cast<GigEditState*>(info);
-    state->main_loop_run(
-        &state->initialized
-    );
+    EditorHost* host = static_cast<EditorHost*>(info);
+    host->main_loop_run();
     printf("runInCFMainLoop() left\n"); fflush(stdout);
 }
 
 #endif // __APPLE__
 
-void GigEditState::run(gig::Instrument* pInstrument) {
-    mutex.lock(); // lock access to static variables
-
-    static bool main_loop_started = false;
-    instrument = pInstrument;
-    if (!main_loop_started) {
+// called with mutex being locked
+void EditorHost::start() {
+    if (started) return;
+    init_app();
 #if defined(__APPLE__) && HAVE_LINUXSAMPLER
-        // spawn GUI on main thread :
-        //     On OS X the Gtk GUI can only be launched on a process's "main"
-        //     thread. When trying to launch the Gtk GUI on any other thread,
-        //     there will only be a white box, because the GUI would not receive
-        //     any events, since it would listen to the wrong system event loop.
-        //     So far we haven't investigated whether there is any kind of
-        //     circumvention to allow doing that also on other OS X threads.
-        {
-            // In case the sampler was launched as standalone sampler (not as
-            // plugin), use the following global callback variable hack ...
-            if (g_mainThreadCallbackSupported) {
-                printf("Setting callback ...\n"); fflush(stdout);
-                g_mainThreadCallback = runInCFMainLoop;
-                g_mainThreadCallbackInfo = this;
-                g_fireMainThreadCallback = true;
-                printf("Callback variables set.\n"); fflush(stdout);
-            } else { // Sampler was launched as (i.e. AU / VST) plugin ...
-                // When the sampler was launched as plugin, we have no idea
-                // whether any sampler thread is the process's "main" thread.
-                // So that's why we are trying to use Apple's API for trying to
-                // launch our callback function on the process's main thread.
-                // However this will only work, if the plugin host application
-                // established a CF event loop, that is if the application is
-                // using Cocoa for its GUI. For other host applications the
-                // callback will never be executed and thus gigedit would not
-                // popup.
-                
-                // should be pretty much the same as the Objective-C solution below with macHelperRunCFuncOnMainThread()
-                /*CFRunLoopSourceContext sourceContext = CFRunLoopSourceContext();
-                sourceContext.info = this;
-                sourceContext.perform = runInCFMainLoop;
-                printf("CFRunLoopSourceCreate\n"); fflush(stdout);
-                CFRunLoopSourceRef source = CFRunLoopSourceCreate(
-                    kCFAllocatorDefault, // allocator
-                    1, // priority
-                    &sourceContext
-                );
-                printf("CFRunLoopAddSource\n"); fflush(stdout);
-                CFRunLoopAddSource(CFRunLoopGetMain(), source, kCFRunLoopDefaultMode);
-                CFRelease(source);*/
-                
-                // use Apple's Objective-C API to call our callback function
-                // 'runInCFMainLoop()' on the process's "main" thread
-                macHelperRunCFuncOnMainThread(runInCFMainLoop, this);
-            }
+    // spawn GUI on main thread :
+    //     On OS X the Gtk GUI can only be launched on a process's "main"
+    //     thread. When trying to launch the Gtk GUI on any other thread,
+    //     there will only be a white box, because the GUI would not receive
+    //     any events, since it would listen to the wrong system event loop.
+    //     So far we haven't investigated whether there is any kind of
+    //     circumvention to allow doing that also on other OS X threads.
+    {
+        // In case the sampler was launched as standalone sampler (not as
+        // plugin), use the following global callback variable hack ...
+        if (g_mainThreadCallbackSupported) {
+            printf("Setting callback ...\n"); fflush(stdout);
+            g_mainThreadCallback = runInCFMainLoop;
+            g_mainThreadCallbackInfo = this;
+            g_fireMainThreadCallback = true;
+            printf("Callback variables set.\n"); fflush(stdout);
+        } else { // Sampler was launched as (i.e. AU / VST) plugin ...
+            // When the sampler was launched as plugin, we have no idea
+            // whether any sampler thread is the process's "main" thread.
+            // So that's why we are trying to use Apple's API for trying to
+            // launch our callback function on the process's main thread.
+            // However this will only work, if the plugin host application
+            // established a CF event loop, that is if the application is
+            // using Cocoa for its GUI. For other host applications the
+            // callback will never be executed and thus gigedit would not
+            // popup.
+            
+            // should be pretty much the same as the Objective-C solution below with macHelperRunCFuncOnMainThread()
+            /*CFRunLoopSourceContext sourceContext = CFRunLoopSourceContext();
+            sourceContext.info = this;
+            sourceContext.perform = runInCFMainLoop;
+            printf("CFRunLoopSourceCreate\n"); fflush(stdout);
+            CFRunLoopSourceRef source = CFRunLoopSourceCreate(
+                kCFAllocatorDefault, // allocator
+                1, // priority
+                &sourceContext
+            );
+            printf("CFRunLoopAddSource\n"); fflush(stdout);
+            CFRunLoopAddSource(CFRunLoopGetMain(), source, kCFRunLoopDefaultMode);
+            CFRelease(source);*/
+            
+            // use Apple's Objective-C API to call our callback function
+            // 'runInCFMainLoop()' on the process's "main" thread
+            macHelperRunCFuncOnMainThread(runInCFMainLoop, this);
         }
+    }
 #else
   #ifdef OLD_THREADS
-        Glib::Thread::create(
-            sigc::bind(sigc::ptr_fun(&GigEditState::main_loop_run),
-                       &initialized),
-            false);
+    Glib::Thread::create(
+        sigc::mem_fun(*this, &EditorHost::main_loop_run),
+        false);
   #elif defined(GLIB_THREADS)
-        Glib::Threads::Thread::create(
-            sigc::bind(sigc::ptr_fun(&GigEditState::main_loop_run),
-                       &initialized));
+    Glib::Threads::Thread::create(
+        sigc::mem_fun(*this, &EditorHost::main_loop_run));
   #else
-        new std::thread([this]() { main_loop_run(&initialized); });
+    new std::thread([this]() { main_loop_run(); });
   #endif
 #endif
-        printf("Waiting for GUI being initialized (on main thread) ....\n"); fflush(stdout);
-        initialized.wait();
-        printf("GUI is now initialized. Everything done.\n"); fflush(stdout);
-        main_loop_started = true;
-    }
-    current = this;
-    dispatcher->emit();
-    open.wait(); // wait until the GUI thread has read current
-    mutex.unlock();
-    close.wait(); // sleep until window is closed
+    printf("Waiting for GUI being initialized (on main thread) ....\n"); fflush(stdout);
+    initialized.wait();
+    printf("GUI is now initialized. Everything done.\n"); fflush(stdout);
+    started = true;
 }
 
 #if defined(WIN32)
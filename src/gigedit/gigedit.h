@@ -34,13 +34,46 @@
 # include <sigc++/signal.h>
 #endif
 
+/**
+ * Describes how a gig::Sample was modified by the editor, so the sampler only
+ * needs to refresh its cached audio data if that actually changed.
+ */
+struct SampleChange {
+    bool pcmChanged; ///< false: only sample header information (i.e. loop points) changed, true: audio data changed as well
+
+    SampleChange(bool pcmChanged = false) : pcmChanged(pcmChanged) {}
+};
+
 class GigEdit {
 public:
     GigEdit();
+    ~GigEdit();
 
     int run(int argc, char* argv[]);
+    /// Same as open(), but blocks the calling thread until the window was closed.
     int run(gig::Instrument* pInstrument);
 
+    /**
+     * Opens an editor window for @a pInstrument and returns immediately,
+     * that is without waiting for the window to be shown. All windows
+     * are served by one GUI thread, which is started on first use. If
+     * the window of this instance is already open, it is just raised.
+     * Can be called from any thread.
+     */
+    void open(gig::Instrument* pInstrument);
+
+    /**
+     * Requests the editor window of this instance to be closed and returns
+     * immediately. Can be called from any thread.
+     */
+    void close();
+
+    /// Whether the editor window of this instance is currently open.
+    bool is_open() const;
+
+    /// Emitted (by the GUI thread) after the editor window was closed.
+    sigc::signal<void>& signal_closed();
+
     sigc::signal<void, gig::File*>& signal_file_structure_to_be_changed();
     sigc::signal<void, gig::File*>& signal_file_structure_changed();
     sigc::signal<void, std::list<gig::Sample*> >& signal_samples_to_be_removed();
@@ -50,6 +83,7 @@ public:
     sigc::signal<void, gig::DimensionRegion*>& signal_dimreg_to_be_changed();
     sigc::signal<void, gig::DimensionRegion*>& signal_dimreg_changed();
     sigc::signal<void, gig::Sample*>& signal_sample_changed();
+    sigc::signal<void, gig::Sample*, SampleChange>& signal_sample_data_changed();
     sigc::signal<void, gig::Sample*/*old*/, gig::Sample*/*new*/>& signal_sample_ref_changed();
     sigc::signal<void, int/*key*/, int/*velocity*/>& signal_keyboard_key_hit();
     sigc::signal<void, int/*key*/, int/*velocity*/>& signal_keyboard_key_released();
@@ -71,10 +105,12 @@ private:
     sigc::signal<void, gig::DimensionRegion*> dimreg_to_be_changed_signal;
     sigc::signal<void, gig::DimensionRegion*> dimreg_changed_signal;
     sigc::signal<void, gig::Sample*> sample_changed_signal;
+    sigc::signal<void, gig::Sample*, SampleChange> sample_data_changed_signal;
     sigc::signal<void, gig::Sample*/*old*/, gig::Sample*/*new*/> sample_ref_changed_signal;
     sigc::signal<void, int/*key*/, int/*velocity*/> keyboard_key_hit_signal;
     sigc::signal<void, int/*key*/, int/*velocity*/> keyboard_key_released_signal;
     sigc::signal<void, gig::Instrument*> switch_sampler_instrument_signal;
+    sigc::signal<void> closed_signal;
     void* state;
 };
 
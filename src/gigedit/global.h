@@ -148,16 +148,6 @@ inline static bool endsWith(const std::string& haystack, const std::string& need
     return (caseSensitive) ? (sub == needle) : (!strcasecmp(sub.c_str(), needle.c_str()));
 }
 
-inline int getIndexOf(gig::Instrument* instrument) {
-    gig::File* file = (gig::File*) instrument->GetParent();
-    for (int i = 0; true ; ++i) {
-        gig::Instrument* instr = file->GetInstrument(i);
-        if (!instr) break;
-        if (instr == instrument) return i;
-    }
-    return -1;
-}
-
 inline int getDimensionIndex(gig::dimension_t type, gig::Region* rgn) {
     for (uint i = 0; i < rgn->Dimensions; ++i)
         if (rgn->pDimensionDefinitions[i].dimension == type)
@@ -225,7 +215,7 @@ public:
     }
 };
 
-//TODO: this function and caseOfDimRegion() from dimregionchooser.h are duplicates, eliminate either one of them!
+//TODO: this function and caseOfDimRegion() from FileOperations.cpp are duplicates, eliminate either one of them!
 inline DimensionCase dimensionCaseOf(gig::DimensionRegion* dr) {
     DimensionCase dimCase;
     int idr = getDimensionRegionIndex(dr);
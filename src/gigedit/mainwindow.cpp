@@ -60,6 +60,14 @@
 #include "scripteditor.h"
 #include "scriptslots.h"
 #include "ReferencesView.h"
+#include "DuplicateSamplesDialog.h"
+#include "MappedImportDialog.h"
+#include "LoopFinderDialog.h"
+#include "PitchDetectionDialog.h"
+#include "InPlaceSave.h"
+#include "CompiledMacro.h"
+#include "FileOperations.h"
+#include "Trace.h"
 #include "../../gfx/status_attached.xpm"
 #include "../../gfx/status_detached.xpm"
 #include "gfx/builtinpix.h"
@@ -86,11 +94,15 @@ MainWindow::MainWindow() :
     labelNoSample(_(" No Sample")),
     labelMissingSample(_(" Missing some Sample(s)")),
     labelLooped(_(" Looped")),
-    labelSomeLoops(_(" Some Loop(s)"))
+    labelSomeLoops(_(" Some Loop(s)")),
+    m_jobProgressView(*this)
 {
     loadBuiltInPix();
+    setTraceThreadName("GUI");
 
     this->file = NULL;
+    m_undoStepScheduled = false;
+    m_recoveryFlushScheduled = false;
 
 //    set_border_width(5);
 
@@ -319,6 +331,12 @@ MainWindow::MainWindow() :
 #endif
 
 #if USE_GLIB_ACTION
+    m_actionUndo = m_actionGroup->add_action(
+        "Undo", sigc::mem_fun(*this, &MainWindow::on_action_undo)
+    );
+    m_actionRedo = m_actionGroup->add_action(
+        "Redo", sigc::mem_fun(*this, &MainWindow::on_action_redo)
+    );
     m_actionCopyDimRgn = m_actionGroup->add_action(
         "CopyDimRgn", sigc::mem_fun(*this, &MainWindow::copy_selected_dimrgn)
     );
@@ -359,6 +377,12 @@ MainWindow::MainWindow() :
         "SelectAddNextDimRgnZone", sigc::mem_fun(*this, &MainWindow::select_add_next_dim_rgn_zone)
     );
 #else
+    actionGroup->add(Gtk::Action::create("Undo", Gtk::Stock::UNDO),
+                     sigc::mem_fun(*this, &MainWindow::on_action_undo));
+
+    actionGroup->add(Gtk::Action::create("Redo", Gtk::Stock::REDO),
+                     sigc::mem_fun(*this, &MainWindow::on_action_redo));
+
     actionGroup->add(Gtk::Action::create("CopyDimRgn",
                                          _("Copy selected dimension region")),
                      Gtk::AccelKey(GDK_KEY_c, Gdk::MOD1_MASK),
@@ -463,7 +487,12 @@ MainWindow::MainWindow() :
     );
     m_actionToggleSaveWithTempFile =
         m_actionGroup->add_action_bool("SaveWithTemporaryFile", sigc::mem_fun(*this, &MainWindow::on_save_with_temporary_file), Settings::singleton()->saveWithTemporaryFile);
+    m_actionToggleDetectPitchOnImport =
+        m_actionGroup->add_action_bool("DetectPitchOnImport", sigc::mem_fun(*this, &MainWindow::on_detect_pitch_on_import), Settings::singleton()->detectPitchOnImport);
+    m_actionToggleLiveParameterEditing =
+        m_actionGroup->add_action_bool("LiveParameterEditing", sigc::mem_fun(*this, &MainWindow::on_live_parameter_editing), Settings::singleton()->liveParameterEditing);
     m_actionGroup->add_action("RefreshAll", sigc::mem_fun(*this, &MainWindow::on_action_refresh_all));
+    m_actionGroup->add_action("ParamSheet", sigc::mem_fun(*this, &MainWindow::on_action_view_param_sheet));
 #else
     actionGroup->add(Gtk::Action::create("MenuMacro", _("_Macro")));
 
@@ -505,10 +534,28 @@ MainWindow::MainWindow() :
                      sigc::mem_fun(
                          *this, &MainWindow::on_save_with_temporary_file));
 
+    toggle_action =
+        Gtk::ToggleAction::create("DetectPitchOnImport", _("_Detect Pitch of Added Samples"));
+    toggle_action->set_active(Settings::singleton()->detectPitchOnImport);
+    actionGroup->add(toggle_action,
+                     sigc::mem_fun(
+                         *this, &MainWindow::on_detect_pitch_on_import));
+
+    toggle_action =
+        Gtk::ToggleAction::create("LiveParameterEditing", _("Edit _Parameters without Interrupting Playback"));
+    toggle_action->set_active(Settings::singleton()->liveParameterEditing);
+    actionGroup->add(toggle_action,
+                     sigc::mem_fun(
+                         *this, &MainWindow::on_live_parameter_editing));
+
     actionGroup->add(
         Gtk::Action::create("RefreshAll", _("_Refresh All")),
         sigc::mem_fun(*this, &MainWindow::on_action_refresh_all)
     );                 
+    actionGroup->add(
+        Gtk::Action::create("ParamSheet", _("_Parameter Sheet...")),
+        sigc::mem_fun(*this, &MainWindow::on_action_view_param_sheet)
+    );
 #endif
 
 #if USE_GLIB_ACTION
@@ -518,6 +565,9 @@ MainWindow::MainWindow() :
     m_actionGroup->add_action(
         "AddInstrument", sigc::mem_fun(*this, &MainWindow::on_action_add_instrument)
     );
+    m_actionGroup->add_action(
+        "AddInstrumentFromFolder", sigc::mem_fun(*this, &MainWindow::on_action_add_instrument_from_folder)
+    );
     m_actionGroup->add_action(
         "DupInstrument", sigc::mem_fun(*this, &MainWindow::on_action_duplicate_instrument)
     );
@@ -541,6 +591,10 @@ MainWindow::MainWindow() :
         Gtk::Action::create("AddInstrument", _("Add _Instrument")),
         sigc::mem_fun(*this, &MainWindow::on_action_add_instrument)
     );
+    actionGroup->add(
+        Gtk::Action::create("AddInstrumentFromFolder", _("Add Instrument from _Folder ...")),
+        sigc::mem_fun(*this, &MainWindow::on_action_add_instrument_from_folder)
+    );
     actionGroup->add(
         Gtk::Action::create("DupInstrument", _("_Duplicate Instrument")),
         sigc::mem_fun(*this, &MainWindow::on_action_duplicate_instrument)
@@ -609,6 +663,22 @@ MainWindow::MainWindow() :
     m_actionGroup->add_action(
         "MergeFiles", sigc::mem_fun(*this, &MainWindow::on_action_merge_files)
     );
+    m_actionGroup->add_action(
+        "FindDuplicateSamples", sigc::mem_fun(*this, &MainWindow::on_action_find_duplicate_samples)
+    );
+    m_actionGroup->add_action(
+        "FindDimensionRegions", sigc::mem_fun(*this, &MainWindow::on_action_find_dimension_regions)
+    );
+    m_actionGroup->add_action(
+        "CheckFile", sigc::mem_fun(*this, &MainWindow::on_action_check_file)
+    );
+    m_actionToggleRecordTrace = m_actionGroup->add_action_bool(
+        "RecordTrace", sigc::mem_fun(*this, &MainWindow::on_action_record_trace),
+        isTraceEnabled()
+    );
+    m_actionGroup->add_action(
+        "SaveTrace", sigc::mem_fun(*this, &MainWindow::on_action_save_trace)
+    );
 #else
     actionGroup->add(Gtk::Action::create("MenuTools", _("_Tools")));
 
@@ -621,6 +691,33 @@ MainWindow::MainWindow() :
         Gtk::Action::create("MergeFiles", _("_Merge Files...")),
         sigc::mem_fun(*this, &MainWindow::on_action_merge_files)
     );
+
+    actionGroup->add(
+        Gtk::Action::create("FindDuplicateSamples", _("Find _Duplicate Samples...")),
+        sigc::mem_fun(*this, &MainWindow::on_action_find_duplicate_samples)
+    );
+
+    actionGroup->add(
+        Gtk::Action::create("FindDimensionRegions", _("_Find Dimension Regions...")),
+        sigc::mem_fun(*this, &MainWindow::on_action_find_dimension_regions)
+    );
+
+    actionGroup->add(
+        Gtk::Action::create("CheckFile", _("C_heck File...")),
+        sigc::mem_fun(*this, &MainWindow::on_action_check_file)
+    );
+
+    toggle_action =
+        Gtk::ToggleAction::create("RecordTrace", _("_Record Performance Trace"));
+    toggle_action->set_active(isTraceEnabled());
+    actionGroup->add(toggle_action,
+                     sigc::mem_fun(
+                         *this, &MainWindow::on_action_record_trace));
+
+    actionGroup->add(
+        Gtk::Action::create("SaveTrace", _("_Save Performance Trace...")),
+        sigc::mem_fun(*this, &MainWindow::on_action_save_trace)
+    );
 #endif
 
     // sample right-click popup actions
@@ -649,6 +746,9 @@ MainWindow::MainWindow() :
     m_actionGroup->add_action(
         "ReplaceAllSamplesInAllGroups", sigc::mem_fun(*this, &MainWindow::on_action_replace_all_samples_in_all_groups)
     );
+    m_actionGroup->add_action(
+        "FindSampleLoops", sigc::mem_fun(*this, &MainWindow::on_action_find_sample_loops)
+    );
 #else
     actionGroup->add(
         Gtk::Action::create("SampleProperties", Gtk::Stock::PROPERTIES),
@@ -684,6 +784,10 @@ MainWindow::MainWindow() :
                             _("Replace All Samples in All Groups...")),
         sigc::mem_fun(*this, &MainWindow::on_action_replace_all_samples_in_all_groups)
     );
+    actionGroup->add(
+        Gtk::Action::create("FindSampleLoops", _("Find _Loops...")),
+        sigc::mem_fun(*this, &MainWindow::on_action_find_sample_loops)
+    );
 #endif
     
     // script right-click popup actions
@@ -764,6 +868,16 @@ MainWindow::MainWindow() :
         "    <menu id='MenuEdit'>"
         "      <attribute name='label' translatable='yes'>Edit</attribute>"
         "      <section>"
+        "        <item id='Undo'>"
+        "          <attribute name='label' translatable='yes'>Undo</attribute>"
+        "          <attribute name='action'>AppMenu.Undo</attribute>"
+        "        </item>"
+        "        <item id='Redo'>"
+        "          <attribute name='label' translatable='yes'>Redo</attribute>"
+        "          <attribute name='action'>AppMenu.Redo</attribute>"
+        "        </item>"
+        "      </section>"
+        "      <section>"
         "        <item id='CopyDimRgn'>"
         "          <attribute name='label' translatable='yes'>Copy Dimension Region</attribute>"
         "          <attribute name='action'>AppMenu.CopyDimRgn</attribute>"
@@ -866,6 +980,10 @@ MainWindow::MainWindow() :
         "          <attribute name='label' translatable='yes'>Replace all Samples in all Groups</attribute>"
         "          <attribute name='action'>AppMenu.ReplaceAllSamplesInAllGroups</attribute>"
         "        </item>"
+        "        <item id='FindSampleLoops'>"
+        "          <attribute name='label' translatable='yes'>Find Loops ...</attribute>"
+        "          <attribute name='action'>AppMenu.FindSampleLoops</attribute>"
+        "        </item>"
         "      </section>"
         "      <section>"
         "        <item id='RemoveSample'>"
@@ -902,6 +1020,10 @@ MainWindow::MainWindow() :
         "          <attribute name='label' translatable='yes'>Add Instrument</attribute>"
         "          <attribute name='action'>AppMenu.AddInstrument</attribute>"
         "        </item>"
+        "        <item id='AddInstrumentFromFolder'>"
+        "          <attribute name='label' translatable='yes'>Add Instrument from Folder ...</attribute>"
+        "          <attribute name='action'>AppMenu.AddInstrumentFromFolder</attribute>"
+        "        </item>"
         "        <item id='DupInstrument'>"
         "          <attribute name='label' translatable='yes'>Duplicate Instrument</attribute>"
         "          <attribute name='action'>AppMenu.DupInstrument</attribute>"
@@ -970,6 +1092,10 @@ MainWindow::MainWindow() :
         "          <attribute name='label' translatable='yes'>Refresh All</attribute>"
         "          <attribute name='action'>AppMenu.RefreshAll</attribute>"
         "        </item>"
+        "        <item id='ParamSheet'>"
+        "          <attribute name='label' translatable='yes'>Parameter Sheet...</attribute>"
+        "          <attribute name='action'>AppMenu.ParamSheet</attribute>"
+        "        </item>"
         "      </section>"
         "    </menu>"
         "    <menu id='MenuTools'>"
@@ -983,6 +1109,28 @@ MainWindow::MainWindow() :
         "          <attribute name='label' translatable='yes'>Merge Files ...</attribute>"
         "          <attribute name='action'>AppMenu.MergeFiles</attribute>"
         "        </item>"
+        "        <item id='FindDuplicateSamples'>"
+        "          <attribute name='label' translatable='yes'>Find Duplicate Samples ...</attribute>"
+        "          <attribute name='action'>AppMenu.FindDuplicateSamples</attribute>"
+        "        </item>"
+        "        <item id='FindDimensionRegions'>"
+        "          <attribute name='label' translatable='yes'>Find Dimension Regions ...</attribute>"
+        "          <attribute name='action'>AppMenu.FindDimensionRegions</attribute>"
+        "        </item>"
+        "        <item id='CheckFile'>"
+        "          <attribute name='label' translatable='yes'>Check File ...</attribute>"
+        "          <attribute name='action'>AppMenu.CheckFile</attribute>"
+        "        </item>"
+        "      </section>"
+        "      <section>"
+        "        <item id='RecordTrace'>"
+        "          <attribute name='label' translatable='yes'>Record Performance Trace</attribute>"
+        "          <attribute name='action'>AppMenu.RecordTrace</attribute>"
+        "        </item>"
+        "        <item id='SaveTrace'>"
+        "          <attribute name='label' translatable='yes'>Save Performance Trace ...</attribute>"
+        "          <attribute name='action'>AppMenu.SaveTrace</attribute>"
+        "        </item>"
         "      </section>"
         "    </menu>"
         "    <menu id='MenuSettings'>"
@@ -1004,6 +1152,14 @@ MainWindow::MainWindow() :
         "          <attribute name='label' translatable='yes'>Save with temporary file</attribute>"
         "          <attribute name='action'>AppMenu.SaveWithTemporaryFile</attribute>"
         "        </item>"
+        "        <item id='DetectPitchOnImport'>"
+        "          <attribute name='label' translatable='yes'>Detect Pitch of Added Samples</attribute>"
+        "          <attribute name='action'>AppMenu.DetectPitchOnImport</attribute>"
+        "        </item>"
+        "        <item id='LiveParameterEditing'>"
+        "          <attribute name='label' translatable='yes'>Edit Parameters without Interrupting Playback</attribute>"
+        "          <attribute name='action'>AppMenu.LiveParameterEditing</attribute>"
+        "        </item>"
         "      </section>"
         "    </menu>"
         "    <menu id='MenuHelp'>"
@@ -1035,6 +1191,10 @@ MainWindow::MainWindow() :
         "        <attribute name='label' translatable='yes'>Add Instrument</attribute>"
         "        <attribute name='action'>AppMenu.AddInstrument</attribute>"
         "      </item>"
+        "      <item id='AddInstrumentFromFolder'>"
+        "        <attribute name='label' translatable='yes'>Add Instrument from Folder ...</attribute>"
+        "        <attribute name='action'>AppMenu.AddInstrumentFromFolder</attribute>"
+        "      </item>"
         "      <item id='DupInstrument'>"
         "        <attribute name='label' translatable='yes'>Duplicate Instrument</attribute>"
         "        <attribute name='action'>AppMenu.DupInstrument</attribute>"
@@ -1081,6 +1241,10 @@ MainWindow::MainWindow() :
         "        <attribute name='label' translatable='yes'>Replace all Samples ...</attribute>"
         "        <attribute name='action'>AppMenu.ReplaceAllSamplesInAllGroups</attribute>"
         "      </item>"
+        "      <item id='FindSampleLoops'>"
+        "        <attribute name='label' translatable='yes'>Find Loops ...</attribute>"
+        "        <attribute name='action'>AppMenu.FindSampleLoops</attribute>"
+        "      </item>"
         "    </section>"
         "    <section>"
         "      <item id='RemoveSample'>"
@@ -1137,6 +1301,9 @@ MainWindow::MainWindow() :
         "      <menuitem action='Quit'/>"
         "    </menu>"
         "    <menu action='MenuEdit'>"
+        "      <menuitem action='Undo'/>"
+        "      <menuitem action='Redo'/>"
+        "      <separator/>"
         "      <menuitem action='CopyDimRgn'/>"
         "      <menuitem action='AdjustClipboard'/>"
         "      <menuitem action='PasteDimRgn'/>"
@@ -1167,6 +1334,7 @@ MainWindow::MainWindow() :
         "      <menuitem action='ShowSampleRefs'/>"
         "      <menuitem action='ReplaceSample' />"
         "      <menuitem action='ReplaceAllSamplesInAllGroups' />"
+        "      <menuitem action='FindSampleLoops' />"
         "      <separator/>"
         "      <menuitem action='RemoveSample'/>"
         "      <menuitem action='RemoveUnusedSamples'/>"
@@ -1180,6 +1348,7 @@ MainWindow::MainWindow() :
         "      <menuitem action='ScriptSlots'/>"
         "      <menu action='AssignScripts'/>"
         "      <menuitem action='AddInstrument'/>"
+        "      <menuitem action='AddInstrumentFromFolder'/>"
         "      <menuitem action='DupInstrument'/>"
         "      <menuitem action='MoveInstrument'/>"
         "      <menuitem action='CombInstruments'/>"
@@ -1200,16 +1369,25 @@ MainWindow::MainWindow() :
         "      <menuitem action='OpenInstrPropsByDoubleClick'/>"
         "      <separator/>"
         "      <menuitem action='RefreshAll'/>"
+        "      <menuitem action='ParamSheet'/>"
         "    </menu>"
         "    <menu action='MenuTools'>"
         "      <menuitem action='CombineInstruments'/>"
         "      <menuitem action='MergeFiles'/>"
+        "      <menuitem action='FindDuplicateSamples'/>"
+        "      <menuitem action='FindDimensionRegions'/>"
+        "      <menuitem action='CheckFile'/>"
+        "      <separator/>"
+        "      <menuitem action='RecordTrace'/>"
+        "      <menuitem action='SaveTrace'/>"
         "    </menu>"
         "    <menu action='MenuSettings'>"
         "      <menuitem action='WarnUserOnExtensions'/>"
         "      <menuitem action='SyncSamplerInstrumentSelection'/>"
         "      <menuitem action='MoveRootNoteWithRegionMoved'/>"
         "      <menuitem action='SaveWithTemporaryFile'/>"
+        "      <menuitem action='DetectPitchOnImport'/>"
+        "      <menuitem action='LiveParameterEditing'/>"
         "    </menu>"
         "    <menu action='MenuHelp'>"
         "      <menuitem action='About'/>"
@@ -1220,6 +1398,7 @@ MainWindow::MainWindow() :
         "    <menuitem action='MidiRules'/>"
         "    <menuitem action='ScriptSlots'/>"
         "    <menuitem action='AddInstrument'/>"
+        "    <menuitem action='AddInstrumentFromFolder'/>"
         "    <menuitem action='DupInstrument'/>"
         "    <menuitem action='MoveInstrument'/>"
         "    <menuitem action='CombInstruments'/>"
@@ -1233,6 +1412,7 @@ MainWindow::MainWindow() :
         "    <menuitem action='ShowSampleRefs'/>"
         "    <menuitem action='ReplaceSample' />"
         "    <menuitem action='ReplaceAllSamplesInAllGroups' />"
+        "    <menuitem action='FindSampleLoops' />"
         "    <separator/>"
         "    <menuitem action='RemoveSample'/>"
         "    <menuitem action='RemoveUnusedSamples'/>"
@@ -1301,6 +1481,16 @@ MainWindow::MainWindow() :
             uiManager->get_widget("/MenuBar/MenuSettings/MoveRootNoteWithRegionMoved"));
         item->set_tooltip_text(_("If checked, and when a region is moved by dragging it around on the virtual keyboard, the keyboard position dependent pitch will move exactly with the amount of semi tones the region was moved around."));
     }
+    {
+        Gtk::MenuItem* item = dynamic_cast<Gtk::MenuItem*>(
+            uiManager->get_widget("/MenuBar/MenuSettings/DetectPitchOnImport"));
+        item->set_tooltip_text(_("If checked, the pitch of samples added from audio files without root note information is detected from their audio data, and their unity note and fine tune are set accordingly."));
+    }
+    {
+        Gtk::MenuItem* item = dynamic_cast<Gtk::MenuItem*>(
+            uiManager->get_widget("/MenuBar/MenuSettings/LiveParameterEditing"));
+        item->set_tooltip_text(_("If checked, simple parameters of dimension regions are changed in the sampler by one atomic write each, instead of suspending the affected regions while they are edited. So playback does not stall while tweaking parameters (only in live-mode)."));
+    }
     {
         Gtk::MenuItem* item = dynamic_cast<Gtk::MenuItem*>(
             uiManager->get_widget("/MenuBar/MenuSample/RemoveUnusedSamples"));
@@ -1325,6 +1515,11 @@ MainWindow::MainWindow() :
             uiManager->get_widget("/MenuBar/MenuView/OpenInstrPropsByDoubleClick"));
         item->set_tooltip_text(_("If checked, double clicking an instrument opens its properties dialog."));
     }
+    {
+        Gtk::MenuItem* item = dynamic_cast<Gtk::MenuItem*>(
+            uiManager->get_widget("/MenuBar/MenuInstrument/AddInstrumentFromFolder"));
+        item->set_tooltip_text(_("Create a new instrument from the audio files of a folder, mapping them to notes, velocity layers and round robins by their file names."));
+    }
     {
         Gtk::MenuItem* item = dynamic_cast<Gtk::MenuItem*>(
             uiManager->get_widget("/MenuBar/MenuTools/CombineInstruments"));
@@ -1335,6 +1530,31 @@ MainWindow::MainWindow() :
             uiManager->get_widget("/MenuBar/MenuTools/MergeFiles"));
         item->set_tooltip_text(_("Add instruments and samples of other .gig files to this .gig file."));
     }
+    {
+        Gtk::MenuItem* item = dynamic_cast<Gtk::MenuItem*>(
+            uiManager->get_widget("/MenuBar/MenuTools/FindDuplicateSamples"));
+        item->set_tooltip_text(_("Find samples with identical audio data in this .gig file and merge them."));
+    }
+    {
+        Gtk::MenuItem* item = dynamic_cast<Gtk::MenuItem*>(
+            uiManager->get_widget("/MenuBar/MenuTools/FindDimensionRegions"));
+        item->set_tooltip_text(_("Find the dimension regions of all instruments matching a filter expression, i.e. to edit them together."));
+    }
+    {
+        Gtk::MenuItem* item = dynamic_cast<Gtk::MenuItem*>(
+            uiManager->get_widget("/MenuBar/MenuTools/CheckFile"));
+        item->set_tooltip_text(_("Check this .gig file for problems like broken loops, missing samples, overlapping regions or incomplete velocity zones."));
+    }
+    {
+        Gtk::MenuItem* item = dynamic_cast<Gtk::MenuItem*>(
+            uiManager->get_widget("/MenuBar/MenuTools/RecordTrace"));
+        item->set_tooltip_text(_("If checked, the duration of loading, saving, importing samples, redrawing and other time consuming operations is recorded for performance analysis."));
+    }
+    {
+        Gtk::MenuItem* item = dynamic_cast<Gtk::MenuItem*>(
+            uiManager->get_widget("/MenuBar/MenuTools/SaveTrace"));
+        item->set_tooltip_text(_("Save the recorded performance trace as Chrome trace JSON file, which can be viewed with chrome://tracing or Perfetto."));
+    }
 #endif
 
 #if USE_GTKMM_BUILDER
@@ -1384,6 +1604,16 @@ MainWindow::MainWindow() :
 
     // Create the Tree model:
     m_refTreeModel = Gtk::ListStore::create(m_Columns);
+    m_instrumentRows.attach(m_refTreeModel, m_Columns.m_col_instr);
+    // attached before the filter is created, so that renamed instruments are
+    // re-indexed before the filter asks instrument_row_visible() about them
+    m_instrumentSearch.attach(
+        m_refTreeModel, m_Columns.m_col_name,
+        [this](const Gtk::TreeModel::Row& row) -> const void* {
+            gig::Instrument* instrument = row[m_Columns.m_col_instr];
+            return instrument;
+        }
+    );
     m_refTreeModelFilter = Gtk::TreeModelFilter::create(m_refTreeModel);
     m_refTreeModelFilter->set_visible_func(
         sigc::mem_fun(*this, &MainWindow::instrument_row_visible)
@@ -1426,6 +1656,16 @@ MainWindow::MainWindow() :
     // create samples treeview (including its data model)
     m_refSamplesTreeModel = SamplesTreeStore::create(m_SamplesModel);
     m_TreeViewSamples.set_model(m_refSamplesTreeModel);
+    m_sampleRows.attach(m_refSamplesTreeModel, m_SamplesModel.m_col_sample);
+    m_sampleSearch.attach(
+        m_refSamplesTreeModel, m_SamplesModel.m_col_name,
+        [this](const Gtk::TreeModel::Row& row) -> const void* {
+            gig::Sample* sample = row[m_SamplesModel.m_col_sample];
+            if (sample) return sample;
+            gig::Group* group = row[m_SamplesModel.m_col_group];
+            return group;
+        }
+    );
     m_TreeViewSamples.get_selection()->set_mode(Gtk::SELECTION_MULTIPLE);
     m_TreeViewSamples.set_tooltip_text(_("To actually use a sample, drag it from this list view to \"Sample\" -> \"Sample:\" on the region's settings pane on the right.\n\nRight click here for more actions on samples."));
     // m_TreeViewSamples.set_reorderable();
@@ -1464,6 +1704,15 @@ MainWindow::MainWindow() :
     // create scripts treeview (including its data model)
     m_refScriptsTreeModel = ScriptsTreeStore::create(m_ScriptsModel);
     m_TreeViewScripts.set_model(m_refScriptsTreeModel);
+    m_scriptSearch.attach(
+        m_refScriptsTreeModel, m_ScriptsModel.m_col_name,
+        [this](const Gtk::TreeModel::Row& row) -> const void* {
+            gig::Script* script = row[m_ScriptsModel.m_col_script];
+            if (script) return script;
+            gig::ScriptGroup* group = row[m_ScriptsModel.m_col_group];
+            return group;
+        }
+    );
     m_TreeViewScripts.set_tooltip_text(_(
         "Use CTRL + double click for editing a script."
         "\n\n"
@@ -1516,21 +1765,27 @@ MainWindow::MainWindow() :
         sigc::mem_fun(*this, &MainWindow::on_sample_label_drop_drag_data_received)
     );
     dimreg_edit.signal_dimreg_changed().connect(
+        sigc::hide(sigc::mem_fun(*this, &MainWindow::file_articulation_changed)));
+    // sample fields (i.e. the loop play count) are stored in the sample's smpl
+    // chunk in the wave pool, not in the instrument chunks
+    dimreg_edit.signal_sample_changed().connect(
         sigc::hide(sigc::mem_fun(*this, &MainWindow::file_changed)));
     m_RegionChooser.signal_instrument_changed().connect(
-        sigc::mem_fun(*this, &MainWindow::file_changed));
+        sigc::mem_fun(*this, &MainWindow::file_articulation_changed));
     m_RegionChooser.signal_instrument_changed().connect(
         sigc::mem_fun(*this, &MainWindow::region_changed));
     m_DimRegionChooser.signal_region_changed().connect(
-        sigc::mem_fun(*this, &MainWindow::file_changed));
+        sigc::mem_fun(*this, &MainWindow::file_articulation_changed));
     instrumentProps.signal_changed().connect(
-        sigc::mem_fun(*this, &MainWindow::file_changed));
+        sigc::mem_fun(*this, &MainWindow::file_articulation_changed));
     sampleProps.signal_changed().connect(
         sigc::mem_fun(*this, &MainWindow::file_changed));
+    sampleProps.signal_changed().connect(
+        sigc::mem_fun(*this, &MainWindow::on_sample_props_changed));
     fileProps.signal_changed().connect(
         sigc::mem_fun(*this, &MainWindow::file_changed));
     midiRules.signal_changed().connect(
-        sigc::mem_fun(*this, &MainWindow::file_changed));
+        sigc::mem_fun(*this, &MainWindow::file_articulation_changed));
 
     dimreg_edit.signal_dimreg_to_be_changed().connect(
         dimreg_to_be_changed_signal.make_slot());
@@ -1545,9 +1800,149 @@ MainWindow::MainWindow() :
         sigc::mem_fun(*this, &MainWindow::on_samples_to_be_removed)
     );
 
+    // record all modifications for undo/redo
+    m_undoJournal.setMemoryLimit(
+        size_t(std::max(0, int(Settings::singleton()->undoMemoryLimit))) * 1024 * 1024
+    );
+    dimreg_edit.signal_live_dimreg_to_be_changed().connect(
+        sigc::mem_fun(m_undoJournal, &UndoJournal::dimRegionToBeChanged)
+    );
+    dimreg_to_be_changed_signal.connect(
+        sigc::mem_fun(m_undoJournal, &UndoJournal::dimRegionToBeChanged)
+    );
+    dimreg_changed_signal.connect(
+        [this](gig::DimensionRegion* dimrgn) {
+            m_undoJournal.dimRegionChanged(dimrgn);
+            schedule_undo_step();
+        }
+    );
+    region_to_be_changed_signal.connect(
+        sigc::mem_fun(m_undoJournal, &UndoJournal::regionToBeChanged)
+    );
+    region_changed_signal.connect(
+        [this](gig::Region* region) {
+            m_undoJournal.regionChanged(region);
+            schedule_undo_step();
+        }
+    );
+    instrumentProps.signal_changed().connect(
+        [this]() {
+            m_undoJournal.instrumentChanged(instrumentProps.get_instrument());
+            schedule_undo_step();
+        }
+    );
+    // journal all modifications for crash recovery
+    dimreg_changed_signal.connect(
+        [this](gig::DimensionRegion* dimrgn) {
+            m_recoveryJournal.dimRegionChanged(dimrgn);
+            schedule_recovery_flush();
+        }
+    );
+    region_changed_signal.connect(
+        [this](gig::Region* region) {
+            m_recoveryJournal.regionChanged(region);
+            schedule_recovery_flush();
+        }
+    );
+    instrumentProps.signal_changed().connect(
+        [this]() {
+            m_recoveryJournal.instrumentChanged(instrumentProps.get_instrument());
+            schedule_recovery_flush();
+        }
+    );
+    // write out pending records while the objects still exist
+    file_structure_to_be_changed_signal.connect(
+        sigc::hide(sigc::mem_fun(m_recoveryJournal, &RecoveryJournal::flush))
+    );
+    samples_to_be_removed_signal.connect(
+        sigc::hide(sigc::mem_fun(m_recoveryJournal, &RecoveryJournal::flush))
+    );
+
+    // deleted instruments, regions and samples cannot be restored, so the
+    // history must not refer to them anymore (instruments are handled by
+    // on_action_remove_instrument())
+    m_RegionChooser.signal_region_to_be_deleted().connect(
+        sigc::hide(sigc::mem_fun(*this, &MainWindow::clear_undo_history))
+    );
+    samples_to_be_removed_signal.connect(
+        sigc::hide(sigc::mem_fun(*this, &MainWindow::clear_undo_history))
+    );
+
+    // keep the parameter sheet's snapshot up to date
+    dimreg_changed_signal.connect(
+        sigc::mem_fun(m_paramSheet, &ParamSheet::dimrgn_changed)
+    );
+    region_changed_signal.connect(
+        sigc::mem_fun(m_paramSheet, &ParamSheet::region_changed)
+    );
+    file_structure_to_be_changed_signal.connect(
+        sigc::hide(sigc::mem_fun(m_paramSheet, &ParamSheet::file_structure_to_be_changed))
+    );
+    file_structure_changed_signal.connect(
+        sigc::hide(sigc::mem_fun(m_paramSheet, &ParamSheet::file_structure_changed))
+    );
+    m_paramSheet.signal_apply().connect(
+        sigc::mem_fun(*this, &MainWindow::on_param_sheet_apply)
+    );
+    m_paramSheet.signal_dimrgn_activated().connect(
+        sigc::hide_return(sigc::mem_fun(*this, &MainWindow::select_dimension_region))
+    );
+
+    // keep the search index up to date
+    dimreg_changed_signal.connect(
+        sigc::mem_fun(m_dimRegionSearch, &DimRegionSearch::dimrgn_changed)
+    );
+    region_changed_signal.connect(
+        sigc::mem_fun(m_dimRegionSearch, &DimRegionSearch::region_changed)
+    );
+    sample_changed_signal.connect(
+        sigc::hide(sigc::mem_fun(m_dimRegionSearch, &DimRegionSearch::samples_changed))
+    );
+    sample_ref_changed_signal.connect(
+        sigc::hide(sigc::hide(sigc::mem_fun(m_dimRegionSearch, &DimRegionSearch::samples_changed)))
+    );
+    samples_removed_signal.connect(
+        sigc::mem_fun(m_dimRegionSearch, &DimRegionSearch::samples_changed)
+    );
+    file_structure_to_be_changed_signal.connect(
+        sigc::hide(sigc::mem_fun(m_dimRegionSearch, &DimRegionSearch::file_structure_to_be_changed))
+    );
+    file_structure_changed_signal.connect(
+        sigc::hide(sigc::mem_fun(m_dimRegionSearch, &DimRegionSearch::file_structure_changed))
+    );
+    m_dimRegionSearch.signal_select_edit_set().connect(
+        sigc::mem_fun(*this, &MainWindow::select_edit_set)
+    );
+    m_dimRegionSearch.signal_dimrgn_activated().connect(
+        sigc::mem_fun(*this, &MainWindow::select_dimension_region)
+    );
+
+    // findings of the file check refer to the state when it was run
+    dimreg_changed_signal.connect(
+        sigc::hide(sigc::mem_fun(m_lintView, &LintView::set_outdated))
+    );
+    region_changed_signal.connect(
+        sigc::hide(sigc::mem_fun(m_lintView, &LintView::set_outdated))
+    );
+    samples_removed_signal.connect(
+        sigc::mem_fun(m_lintView, &LintView::set_outdated)
+    );
+    file_structure_changed_signal.connect(
+        sigc::hide(sigc::mem_fun(m_lintView, &LintView::set_outdated))
+    );
+    m_lintView.signal_check().connect(
+        sigc::hide_return(sigc::mem_fun(*this, &MainWindow::check_file))
+    );
+    m_lintView.signal_finding_activated().connect(
+        sigc::mem_fun(*this, &MainWindow::on_lint_finding_activated)
+    );
+
     dimreg_edit.signal_select_sample().connect(
         sigc::mem_fun(*this, &MainWindow::select_sample)
     );
+    dimreg_edit.signal_find_loop().connect(
+        sigc::mem_fun(*this, &MainWindow::show_loop_finder)
+    );
 
     dimreg_edit.editScriptSlotsButton.signal_clicked().connect(
         sigc::mem_fun(*this, &MainWindow::show_script_slots)
@@ -1619,12 +2014,19 @@ MainWindow::MainWindow() :
     dimreg_stereo.signal_toggled().connect(
         sigc::mem_fun(*this, &MainWindow::update_dimregs));
 
-    m_searchText.signal_changed().connect(
-        sigc::mem_fun(*m_refTreeModelFilter.operator->(), &Gtk::TreeModelFilter::refilter)
+    m_searchPage = 1;
+    m_searchTextConnection = m_searchText.signal_changed().connect(
+        sigc::mem_fun(*this, &MainWindow::on_search_text_changed)
     );
+    m_searchText.set_tooltip_text(_(
+        "Filters the instruments list, or selects the matching samples or "
+        "scripts. All words have to be part of a name; if no name contains "
+        "them, names containing their letters in the same order are matched."
+    ));
 
     file = 0;
     file_is_changed = false;
+    file_structure_is_changed = false;
 
 #if HAS_GTKMM_SHOW_ALL_CHILDREN
     show_all_children();
@@ -1726,6 +2128,17 @@ MainWindow::MainWindow() :
 
 MainWindow::~MainWindow()
 {
+    // a partially loaded file is of no use anymore, whereas a partially saved
+    // file would be corrupt
+    if (loader) loader->cancel();
+    if (loader) JobScheduler::singleton()->wait(loader);
+    if (saver) JobScheduler::singleton()->wait(saver);
+    if (m_loopSearch) m_loopSearch->cancel();
+    if (m_loopSearch) JobScheduler::singleton()->wait(m_loopSearch);
+    m_pitchDetectionJobs.clear(); // no follow-up detection
+    m_pitchDetectionSamples.clear();
+    if (m_pitchDetector) m_pitchDetector->cancel();
+    if (m_pitchDetector) JobScheduler::singleton()->wait(m_pitchDetector);
 }
 
 void MainWindow::bringToFront() {
@@ -1840,20 +2253,74 @@ void MainWindow::onMacrosSetupChanged(const std::vector<Serialization::Archive>&
 
 //NOTE: the actual signal's first argument for argument 'page' is on some gtkmm version GtkNotebookPage* and on some Gtk::Widget*. Since we don't need that argument, it is simply void* here for now.
 void MainWindow::on_notebook_tab_switched(void* page, guint page_num) {
-    bool isInstrumentsPage = (page_num == 1);
-    // so far we only support filtering for the instruments list, so hide the
-    // filter text entry field if another tab is selected
-    m_searchField.set_visible(isInstrumentsPage);
+    // each list has its own search pattern
+    if (page_num >= 3) return;
+    m_searchPage = page_num;
+    m_searchTextConnection.block();
+    m_searchText.set_text(m_searchPatterns[page_num]);
+    m_searchTextConnection.unblock();
+}
+
+void MainWindow::on_search_text_changed() {
+    const Glib::ustring pattern = m_searchText.get_text();
+    m_searchPatterns[m_searchPage] = pattern;
+    switch (m_searchPage) {
+        case 0:
+            select_search_results(m_sampleSearch, m_TreeViewSamples, pattern);
+            break;
+        case 1:
+            m_instrumentSearch.search(pattern);
+            m_refTreeModelFilter->refilter();
+            break;
+        case 2:
+            select_search_results(m_scriptSearch, m_TreeViewScripts, pattern);
+            break;
+    }
+}
+
+/**
+ * Selects the rows of @a view matching @a pattern. Unlike the instruments list,
+ * the samples and scripts lists are not filtered, since their rows are
+ * addressed by paths of the unfiltered model in many places.
+ */
+void MainWindow::select_search_results(TreeSearch& search, Gtk::TreeView& view,
+                                       const Glib::ustring& pattern)
+{
+    search.search(pattern);
+    Glib::RefPtr<Gtk::TreeSelection> sel = view.get_selection();
+    sel->unselect_all();
+    if (!search.isFiltering()) return;
+    std::vector<Gtk::TreeModel::iterator> rows = search.matchingRows();
+    if (rows.empty()) return;
+    if (sel->get_mode() != Gtk::SELECTION_MULTIPLE) rows.resize(1);
+
+    Glib::RefPtr<Gtk::TreeModel> model = view.get_model();
+    Gtk::TreeModel::iterator lastParent;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        // rows of collapsed groups cannot be selected
+        Gtk::TreeModel::iterator parent = rows[i]->parent();
+        if (parent && parent != lastParent) {
+            view.expand_row(model->get_path(parent), false);
+            lastParent = parent;
+        }
+        sel->select(rows[i]);
+    }
+    view.scroll_to_row(model->get_path(rows[0]));
 }
 
 bool MainWindow::on_delete_event(GdkEventAny* event)
 {
-    return !file_is_shared && file_is_changed && !close_confirmation_dialog();
+    if (!file_is_shared && file_is_changed && !close_confirmation_dialog())
+        return true;
+    // the user dropped any unsaved changes
+    if (!file_is_shared) m_recoveryJournal.stop(true);
+    return false;
 }
 
 void MainWindow::on_action_quit()
 {
     if (!file_is_shared && file_is_changed && !close_confirmation_dialog()) return;
+    if (!file_is_shared) m_recoveryJournal.stop(true);
     hide();
 }
 
@@ -1955,6 +2422,7 @@ void MainWindow::on_sel_change()
 
     m_RegionChooser.set_instrument(instr);
     dimreg_edit.scriptVars.setInstrument(instr, true/*force update*/);
+    m_paramSheet.set_file(file, instr);
 
     if (Settings::singleton()->syncSamplerInstrumentSelection) {
         switch_sampler_instrument_signal.emit(get_instrument());
@@ -1962,13 +2430,14 @@ void MainWindow::on_sel_change()
 }
 
 
-LoaderSaverBase::LoaderSaverBase(const Glib::ustring filename, gig::File* gig) :
-    filename(filename), gig(gig),
-#ifdef GLIB_THREADS
-    thread(0),
-#endif
-    progress(0.f)
+LoaderSaverBase::LoaderSaverBase(const Glib::ustring& title,
+                                 const Glib::ustring filename, gig::File* gig,
+                                 bool cancellable) :
+    Job(title, Job::PRIORITY_HIGH, cancellable),
+    filename(filename), gig(gig)
 {
+    // the file must neither be edited nor closed meanwhile
+    setModal(true);
 }
 
 void loader_progress_callback(gig::progress_t* progress)
@@ -1979,120 +2448,86 @@ void loader_progress_callback(gig::progress_t* progress)
 
 void LoaderSaverBase::progress_callback(float fraction)
 {
-    {
-#ifdef GLIB_THREADS
-        Glib::Threads::Mutex::Lock lock(progressMutex);
-#else
-        std::lock_guard<std::mutex> lock(progressMutex);
-#endif
-        progress = fraction;
-    }
-    progress_dispatcher();
+    setProgress(fraction);
+    // unwinds libgig just like a RIFF::Exception would
+    checkCancelled();
 }
 
-#if defined(WIN32) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 2))
-// make sure stack is 16-byte aligned for SSE instructions
-__attribute__((force_align_arg_pointer))
-#endif
-void LoaderSaverBase::thread_function()
+void LoaderSaverBase::run()
 {
-#ifdef GLIB_THREADS
-    printf("thread_function self=%p\n",
-           static_cast<void*>(Glib::Threads::Thread::self()));
-#else
-    std::cout << "thread_function self=" << std::this_thread::get_id() << "\n";
-#endif
     printf("Start %s\n", filename.c_str());
-    try {
-        gig::progress_t progress;
-        progress.callback = loader_progress_callback;
-        progress.custom = this;
-
-        thread_function_sub(progress);
-        printf("End\n");
-        finished_dispatcher();
-    } catch (RIFF::Exception e) {
-        error_message = e.Message;
-        error_dispatcher.emit();
-    } catch (...) {
-        error_message = _("Unknown exception occurred");
-        error_dispatcher.emit();
-    }
-}
-
-void LoaderSaverBase::launch()
-{
-#ifdef GLIB_THREADS
-#ifdef OLD_THREADS
-    thread = Glib::Thread::create(sigc::mem_fun(*this, &LoaderSaverBase::thread_function), true);
-#else
-    thread = Glib::Threads::Thread::create(sigc::mem_fun(*this, &LoaderSaverBase::thread_function));
-#endif
-    printf("launch thread=%p\n", static_cast<void*>(thread));
-#else
-    thread = std::thread([this](){ thread_function(); });
-    std::cout << "launch thread=" << thread.get_id() << "\n";
-#endif
-}
-
-float LoaderSaverBase::get_progress()
-{
-#ifdef GLIB_THREADS
-    Glib::Threads::Mutex::Lock lock(progressMutex);
-#else
-    std::lock_guard<std::mutex> lock(progressMutex);
-#endif
-    return progress;
-}
-
-Glib::Dispatcher& LoaderSaverBase::signal_progress()
-{
-    return progress_dispatcher;
-}
-
-Glib::Dispatcher& LoaderSaverBase::signal_finished()
-{
-    return finished_dispatcher;
-}
-
-Glib::Dispatcher& LoaderSaverBase::signal_error()
-{
-    return error_dispatcher;
-}
+    gig::progress_t progress;
+    progress.callback = loader_progress_callback;
+    progress.custom = this;
 
-void LoaderSaverBase::join() {
-#ifdef GLIB_THREADS
-    thread->join();
-#else
-    thread.join();
-#endif
+    thread_function_sub(progress);
+    printf("End\n");
 }
 
 
 Loader::Loader(const char* filename) :
-    LoaderSaverBase(filename, 0)
+    LoaderSaverBase(
+        _("Loading") +  Glib::ustring(" '") +
+        Glib::filename_display_basename(filename) + "' ...",
+        filename, 0, true
+    )
 {
 }
 
 void Loader::thread_function_sub(gig::progress_t& progress)
 {
+    GIGEDIT_TRACE_SCOPE("Loader::thread_function");
     RIFF::File* riff = new RIFF::File(filename);
-    gig = new gig::File(riff);
+    try {
+        // let the main window show the instrument list already, while libgig
+        // is still loading all instruments with their regions and dimension
+        // regions
+        gig = loadGigFile(riff,
+            [this](const std::vector<std::string>& names) {
+                instrumentNames = names;
+                notify([this]() { headers_loaded_signal.emit(); });
+                checkCancelled();
+            },
+            &progress
+        );
+    } catch (Job::Cancelled) {
+        // the gig::File was already deleted by loadGigFile()
+        delete riff;
+        throw;
+    }
+}
 
-    gig->GetInstrument(0, &progress);
+sigc::signal<void>& Loader::signal_headers_loaded()
+{
+    return headers_loaded_signal;
 }
 
 
 Saver::Saver(gig::File* file, Glib::ustring filename) :
-    LoaderSaverBase(filename, file)
+    LoaderSaverBase(
+        _("Saving") +  Glib::ustring(" '") +
+        Glib::filename_display_basename(
+            filename.empty() ? Glib::ustring(file->GetFileName()) : filename
+        ) + "' ...",
+        filename, file, false /*a partially written file would be corrupt*/
+    ),
+    articulationOnly(false)
 {
 }
 
 void Saver::thread_function_sub(gig::progress_t& progress)
 {
+    GIGEDIT_TRACE_SCOPE("Saver::thread_function");
     // if no filename was provided, that means "save", if filename was provided means "save as"
     if (filename.empty()) {
         if (!Settings::singleton()->saveWithTemporaryFile) {
+            // if just articulation was changed, try to overwrite only the
+            // instrument chunks in the existing file (falls back to a full
+            // save if the chunk layout changed)
+            if (articulationOnly && saveArticulationInPlace(gig) >= 0) {
+                progress_callback(1.0f);
+                return;
+            }
             // save directly over the existing .gig file
             // (requires less disk space than solution below
             // but may be slower)
@@ -2101,24 +2536,7 @@ void Saver::thread_function_sub(gig::progress_t& progress)
             // save the file as separate temporary file first,
             // then move the saved file over the old file
             // (may result in performance speedup during save)
-            gig::String tmpname = filename + ".TMP";
-            gig->Save(tmpname, &progress);
-#if defined(WIN32)
-            if (!DeleteFile(filename.c_str())) {
-                throw RIFF::Exception("Could not replace original file with temporary file (unable to remove original file).");
-            }
-#else // POSIX ...
-            if (unlink(filename.c_str())) {
-                throw RIFF::Exception("Could not replace original file with temporary file (unable to remove original file): " + gig::String(strerror(errno)));
-            }
-#endif
-            if (rename(tmpname.c_str(), filename.c_str())) {
-#if defined(WIN32)
-                throw RIFF::Exception("Could not replace original file with temporary file (unable to rename temp file).");
-#else
-                throw RIFF::Exception("Could not replace original file with temporary file (unable to rename temp file): " + gig::String(strerror(errno)));
-#endif
-            }
+            saveWithTemporaryFile(gig, articulationOnly, &progress);
         }
     } else {
         gig->Save(filename, &progress);
@@ -2126,25 +2544,16 @@ void Saver::thread_function_sub(gig::progress_t& progress)
 }
 
 
-ProgressDialog::ProgressDialog(const Glib::ustring& title, Gtk::Window& parent)
-    : Gtk::Dialog(title, parent, true)
-{
-#if USE_GTKMM_BOX
-    get_content_area()->pack_start(progressBar);
-#else
-    get_vbox()->pack_start(progressBar);
-#endif
-#if HAS_GTKMM_SHOW_ALL_CHILDREN
-    show_all_children();
-#endif
-    resize(600,50);
-}
-
 // Clear all GUI elements / controls. This method is typically called
 // before a new .gig file is to be created or to be loaded.
 void MainWindow::__clear() {
     // forget all samples that ought to be imported
     m_SampleImportQueue.clear();
+    m_pitchDetectionJobs.clear();
+    m_pitchDetectionSamples.clear();
+    // unsaved changes of a file used by the sampler still exist after this
+    // editor was closed, whereas otherwise the user chose to drop them
+    m_recoveryJournal.stop(!file_is_shared);
     // clear the samples and instruments tree views
     m_refTreeModel->clear();
     m_refSamplesTreeModel->clear();
@@ -2155,6 +2564,9 @@ void MainWindow::__clear() {
         remove_instrument_from_menu(0);
     }
 #endif
+    m_paramSheet.set_file(NULL, NULL);
+    m_dimRegionSearch.set_file(NULL);
+    m_lintView.clear();
     // free libgig's gig::File instance
     if (file && !file_is_shared) delete file;
     file = NULL;
@@ -2162,6 +2574,7 @@ void MainWindow::__clear() {
 }
 
 void MainWindow::__refreshEntireGUI() {
+    GIGEDIT_TRACE_SCOPE("MainWindow::__refreshEntireGUI");
     // clear the samples and instruments tree views
     m_refTreeModel->clear();
     m_refSamplesTreeModel->clear();
@@ -2299,22 +2712,16 @@ void MainWindow::load_file(const char* name)
 {
     __clear();
 
-    progress_dialog = new ProgressDialog( //FIXME: memory leak!
-        _("Loading") +  Glib::ustring(" '") +
-        Glib::filename_display_basename(name) + "' ...",
-        *this
-    );
-#if HAS_GTKMM_SHOW_ALL_CHILDREN
-    progress_dialog->show_all();
-#endif
-    loader = new Loader(name); //FIXME: memory leak!
-    loader->signal_progress().connect(
-        sigc::mem_fun(*this, &MainWindow::on_loader_progress));
+    loader.reset(new Loader(name));
+    loader->signal_headers_loaded().connect(
+        sigc::mem_fun(*this, &MainWindow::on_loader_headers_loaded));
     loader->signal_finished().connect(
         sigc::mem_fun(*this, &MainWindow::on_loader_finished));
     loader->signal_error().connect(
         sigc::mem_fun(*this, &MainWindow::on_loader_error));
-    loader->launch();
+    loader->signal_cancelled().connect(
+        sigc::mem_fun(*this, &MainWindow::on_loader_cancelled));
+    JobScheduler::singleton()->submit(loader);
 }
 
 void MainWindow::load_instrument(gig::Instrument* instr) {
@@ -2330,39 +2737,42 @@ void MainWindow::load_instrument(gig::Instrument* instr) {
     gig::File* pFile = (gig::File*) instr->GetParent();
     load_gig(pFile, 0 /*file name*/, true /*shared instrument*/);
     // automatically select the given instrument
-    int i = 0;
-    for (gig::Instrument* instrument = pFile->GetFirstInstrument(); instrument;
-         instrument = pFile->GetNextInstrument(), ++i)
-    {
-        if (instrument == instr) {
-            // select item in "instruments" tree view
-            m_TreeView.get_selection()->select(Gtk::TreePath(ToString(i)));
-            // make sure the selected item in the "instruments" tree view is
-            // visible (scroll to it)
-            m_TreeView.scroll_to_row(Gtk::TreePath(ToString(i)));
+    const int i = m_instrumentRows.position(instr);
+    if (i >= 0) {
+        // select item in "instruments" tree view
+        m_TreeView.get_selection()->select(Gtk::TreePath(ToString(i)));
+        // make sure the selected item in the "instruments" tree view is
+        // visible (scroll to it)
+        m_TreeView.scroll_to_row(Gtk::TreePath(ToString(i)));
 #if !USE_GTKMM_BUILDER
-            // select item in instrument menu
-            {
-                const std::vector<Gtk::Widget*> children =
-                    instrument_menu->get_children();
-                static_cast<Gtk::RadioMenuItem*>(children[i])->set_active();
-            }
-#endif
-            // update region chooser and dimension region chooser
-            m_RegionChooser.set_instrument(instr);
-            break;
+        // select item in instrument menu
+        {
+            const std::vector<Gtk::Widget*> children =
+                instrument_menu->get_children();
+            static_cast<Gtk::RadioMenuItem*>(children[i])->set_active();
         }
+#endif
+        // update region chooser and dimension region chooser
+        m_RegionChooser.set_instrument(instr);
     }
 }
 
-void MainWindow::on_loader_progress()
+void MainWindow::on_loader_headers_loaded()
 {
-    progress_dialog->set_fraction(loader->get_progress());
+    // show the instrument names right away, load_gig() completes these rows
+    // once the instruments are actually loaded
+    instrument_name_connection.block();
+    for (size_t i = 0; i < loader->instrumentNames.size(); ++i) {
+        Gtk::TreeModel::Row row = *m_refTreeModel->append();
+        row[m_Columns.m_col_nr] = int(i);
+        row[m_Columns.m_col_name] = gig_to_utf8(loader->instrumentNames[i]);
+        row[m_Columns.m_col_instr] = NULL;
+    }
+    instrument_name_connection.unblock();
 }
 
 void MainWindow::on_loader_finished()
 {
-    loader->join();
     printf("Loader finished!\n");
 #ifdef GLIB_THREADS
     printf("on_loader_finished self=%p\n",
@@ -2371,17 +2781,91 @@ void MainWindow::on_loader_finished()
     std::cout << "on_loader_finished self=" <<
         std::this_thread::get_id() << "\n";
 #endif
+    RecoveryJournal::Recovered recovered;
+    const bool recovered_edits =
+        recover_unsaved_edits(loader->gig, loader->filename, recovered);
     load_gig(loader->gig, loader->filename.c_str());
-    progress_dialog->hide();
+    if (recovered_edits) journal_recovered_edits(recovered);
+    // check the file once the GUI is drawn, see on_idle_check_file()
+    Glib::signal_idle().connect_once(
+        sigc::mem_fun(*this, &MainWindow::on_idle_check_file),
+        Glib::PRIORITY_LOW
+    );
 }
 
-void MainWindow::on_loader_error()
+bool MainWindow::recover_unsaved_edits(gig::File* gig, const std::string& filename,
+                                       RecoveryJournal::Recovered& recovered)
 {
-    loader->join();
-    Glib::ustring txt = _("Could not load file: ") + loader->error_message;
+    if (!RecoveryJournal::exists(filename)) return false;
+
+    Gtk::MessageDialog dialog(
+        *this, _("Recover unsaved changes?"), false, Gtk::MESSAGE_QUESTION,
+        Gtk::BUTTONS_NONE
+    );
+    dialog.set_secondary_text(
+        _("This file was not closed properly while it had unsaved changes. "
+          "Those changes can be restored from its recovery journal.")
+    );
+    dialog.add_button(_("_Discard Changes"), Gtk::RESPONSE_NO);
+    dialog.add_button(_("_Recover"), Gtk::RESPONSE_YES);
+    dialog.set_default_response(Gtk::RESPONSE_YES);
+    const int response = dialog.run();
+    dialog.hide();
+    if (response != Gtk::RESPONSE_YES) return false;
+
+    std::string error;
+    if (!RecoveryJournal::replay(gig, filename, recovered, error)) {
+        Glib::ustring txt = _("Could not recover unsaved changes: ") + error;
+        Gtk::MessageDialog msg(*this, txt, false, Gtk::MESSAGE_ERROR);
+        msg.run();
+        return false;
+    }
+    if (recovered.structureChanged) {
+        Gtk::MessageDialog msg(
+            *this, _("Only part of the unsaved changes could be recovered."),
+            false, Gtk::MESSAGE_WARNING
+        );
+        msg.set_secondary_text(
+            _("Changes made after instruments, regions or samples were added "
+              "or removed cannot be recovered.")
+        );
+        msg.run();
+    }
+    return recovered.records > 0;
+}
+
+void MainWindow::journal_recovered_edits(const RecoveryJournal::Recovered& recovered)
+{
+    // load_gig() replaced the replayed journal by a new one
+    for (std::set<gig::Region*>::const_iterator it = recovered.regions.begin();
+         it != recovered.regions.end(); ++it)
+    {
+        m_recoveryJournal.regionChanged(*it);
+        for (int i = 0; i < int((*it)->DimensionRegions); ++i)
+            m_recoveryJournal.dimRegionChanged((*it)->pDimensionRegions[i]);
+    }
+    for (std::set<gig::Instrument*>::const_iterator it = recovered.instruments.begin();
+         it != recovered.instruments.end(); ++it)
+    {
+        m_recoveryJournal.instrumentChanged(*it);
+    }
+    m_recoveryJournal.flush();
+
+    if (recovered.layoutChanged) file_structure_is_changed = true;
+    file_articulation_changed();
+}
+
+void MainWindow::on_loader_error()
+{
+    m_refTreeModel->clear(); // instrument names shown while loading
+    Glib::ustring txt = _("Could not load file: ") + loader->errorMessage();
     Gtk::MessageDialog msg(*this, txt, false, Gtk::MESSAGE_ERROR);
     msg.run();
-    progress_dialog->hide();
+}
+
+void MainWindow::on_loader_cancelled()
+{
+    m_refTreeModel->clear(); // instrument names shown while loading
 }
 
 void MainWindow::on_action_file_save()
@@ -2410,9 +2894,100 @@ bool MainWindow::check_if_savable()
             return false;
         }
     }
+
+    // other problems do not prevent saving, but the user should know them
+    std::vector<LintFinding> findings = check_file();
+    int errors = 0;
+    for (size_t i = 0; i < findings.size(); ++i)
+        if (findings[i].isError()) ++errors;
+    if (errors) {
+        Gtk::MessageDialog dialog(
+            *this, ToString(errors) + " " + _("problems found in this file, "
+            "which probably cause it not to play correctly."),
+            false, Gtk::MESSAGE_WARNING, Gtk::BUTTONS_NONE
+        );
+        dialog.set_secondary_text(_("Save anyway?"));
+#if HAS_GTKMM_STOCK
+        dialog.add_button(Gtk::Stock::CANCEL, Gtk::RESPONSE_CANCEL);
+#else
+        dialog.add_button(_("_Cancel"), Gtk::RESPONSE_CANCEL);
+#endif
+        dialog.add_button(_("_Save Anyway"), Gtk::RESPONSE_YES);
+        dialog.set_default_response(Gtk::RESPONSE_CANCEL);
+        if (dialog.run() != Gtk::RESPONSE_YES) {
+            dialog.hide();
+            m_lintView.show();
+            m_lintView.present();
+            return false;
+        }
+    }
     return true;
 }
 
+/**
+ * Checks the current file for problems by lintGigFile() and shows the results
+ * in the file check window.
+ */
+std::vector<LintFinding> MainWindow::check_file() {
+    GIGEDIT_TRACE_SCOPE("MainWindow::check_file");
+    std::vector<LintFinding> findings;
+    if (!file) {
+        m_lintView.clear();
+        return findings;
+    }
+    // samples not imported yet have no audio data to check the loops against
+    std::set<gig::Sample*> notImported;
+    for (std::map<gig::Sample*, SampleImportItem>::iterator it = m_SampleImportQueue.begin();
+         it != m_SampleImportQueue.end(); ++it)
+    {
+        notImported.insert(it->first);
+    }
+    findings = lintGigFile(file, notImported);
+    m_lintView.set_findings(findings);
+    return findings;
+}
+
+void MainWindow::on_idle_check_file() {
+    std::vector<LintFinding> findings = check_file();
+    for (size_t i = 0; i < findings.size(); ++i) {
+        if (findings[i].isError()) {
+            m_lintView.show();
+            m_lintView.present();
+            return;
+        }
+    }
+}
+
+void MainWindow::on_action_check_file() {
+    check_file();
+    m_lintView.show();
+    m_lintView.present();
+}
+
+void MainWindow::on_lint_finding_activated(const LintFinding& finding) {
+    // the file might have been modified since it was checked, so only follow
+    // pointers still part of the file
+    if (finding.instrument) {
+        gig::Instrument* instr = file ? file->GetFirstInstrument() : NULL;
+        while (instr && instr != finding.instrument) instr = file->GetNextInstrument();
+        if (!instr) return;
+        gig::Region* rgn = instr->GetFirstRegion();
+        while (rgn && rgn != finding.region) rgn = instr->GetNextRegion();
+        if (rgn && finding.dimrgn) {
+            for (int i = 0; i < int(rgn->DimensionRegions); ++i) {
+                if (rgn->pDimensionRegions[i] == finding.dimrgn) {
+                    select_dimension_region(finding.dimrgn);
+                    return;
+                }
+            }
+        }
+        select_instrument(instr);
+        if (rgn) m_RegionChooser.set_region(rgn);
+    } else if (finding.sample) {
+        select_sample(finding.sample); // only selects samples still listed
+    }
+}
+
 bool MainWindow::file_save()
 {
     if (!check_if_savable()) return false;
@@ -2421,49 +2996,43 @@ bool MainWindow::file_save()
     std::cout << "Saving file\n" << std::flush;
     file_structure_to_be_changed_signal.emit(this->file);
 
-    progress_dialog = new ProgressDialog( //FIXME: memory leak!
-        _("Saving") +  Glib::ustring(" '") +
-        Glib::filename_display_basename(this->filename) + "' ...",
-        *this
-    );
-#if HAS_GTKMM_SHOW_ALL_CHILDREN
-    progress_dialog->show_all();
-#endif
-    saver = new Saver(this->file); //FIXME: memory leak!
-    saver->signal_progress().connect(
-        sigc::mem_fun(*this, &MainWindow::on_saver_progress));
-    saver->signal_finished().connect(
-        sigc::mem_fun(*this, &MainWindow::on_saver_finished));
-    saver->signal_error().connect(
-        sigc::mem_fun(*this, &MainWindow::on_saver_error));
-    saver->launch();
+    std::shared_ptr<Saver> job(new Saver(this->file));
+    job->articulationOnly =
+        !file_structure_is_changed && m_SampleImportQueue.empty();
+    launch_saver(job);
 
     return true;
 }
 
-void MainWindow::on_saver_progress()
+void MainWindow::launch_saver(const std::shared_ptr<Saver>& job)
 {
-    progress_dialog->set_fraction(saver->get_progress());
+    saver = job;
+    saver->signal_finished().connect(
+        sigc::mem_fun(*this, &MainWindow::on_saver_finished));
+    saver->signal_error().connect(
+        sigc::mem_fun(*this, &MainWindow::on_saver_error));
+    JobScheduler::singleton()->submit(saver);
 }
 
 void MainWindow::on_saver_error()
 {
-    saver->join();
     file_structure_changed_signal.emit(this->file);
-    Glib::ustring txt = _("Could not save file: ") + saver->error_message;
+    Glib::ustring txt = _("Could not save file: ") + saver->errorMessage();
     Gtk::MessageDialog msg(*this, txt, false, Gtk::MESSAGE_ERROR);
     msg.run();
 }
 
 void MainWindow::on_saver_finished()
 {
-    saver->join();
+    // all changes are on disk now, __refreshEntireGUI() starts a new journal
+    m_recoveryJournal.stop(true);
     this->file = saver->gig;
     this->filename = saver->filename;
     current_gig_dir = Glib::path_get_dirname(filename);
     set_title(Glib::filename_display_basename(filename));
     file_has_name = true;
     file_is_changed = false;
+    file_structure_is_changed = false;
     std::cout << "Saving file done. Importing queued samples now ...\n" << std::flush;
     __import_queued_samples();
     std::cout << "Importing queued samples done.\n" << std::flush;
@@ -2471,7 +3040,6 @@ void MainWindow::on_saver_finished()
     file_structure_changed_signal.emit(this->file);
 
     __refreshEntireGUI();
-    progress_dialog->hide();
 }
 
 void MainWindow::on_action_file_save_as()
@@ -2556,23 +3124,7 @@ bool MainWindow::file_save_as()
         }
         printf("filename=%s\n", filename.c_str());
 
-        progress_dialog = new ProgressDialog( //FIXME: memory leak!
-            _("Saving") +  Glib::ustring(" '") +
-            Glib::filename_display_basename(filename) + "' ...",
-            *this
-        );
-#if HAS_GTKMM_SHOW_ALL_CHILDREN
-        progress_dialog->show_all();
-#endif
-
-        saver = new Saver(file, filename); //FIXME: memory leak!
-        saver->signal_progress().connect(
-            sigc::mem_fun(*this, &MainWindow::on_saver_progress));
-        saver->signal_finished().connect(
-            sigc::mem_fun(*this, &MainWindow::on_saver_finished));
-        saver->signal_error().connect(
-            sigc::mem_fun(*this, &MainWindow::on_saver_error));
-        saver->launch();
+        launch_saver(std::shared_ptr<Saver>(new Saver(file, filename)));
 
         return true;
     }
@@ -2581,91 +3133,38 @@ bool MainWindow::file_save_as()
 
 // actually write the sample(s)' data to the gig file
 void MainWindow::__import_queued_samples() {
+    GIGEDIT_TRACE_SCOPE("MainWindow::__import_queued_samples");
     std::cout << "Starting sample import\n" << std::flush;
     Glib::ustring error_files;
     printf("Samples to import: %d\n", int(m_SampleImportQueue.size()));
+
+    // reading and converting the audio files is done on several threads,
+    // only writing to the gig file is serialized
+    std::vector<AudioFileImport> imports;
     for (std::map<gig::Sample*, SampleImportItem>::iterator iter = m_SampleImportQueue.begin();
-         iter != m_SampleImportQueue.end(); ) {
-        printf("Importing sample %s\n",iter->second.sample_path.c_str());
-        SF_INFO info;
-        info.format = 0;
-        SNDFILE* hFile = sf_open(iter->second.sample_path.c_str(), SFM_READ, &info);
-        sf_command(hFile, SFC_SET_SCALE_FLOAT_INT_READ, 0, SF_TRUE);
-        try {
-            if (!hFile) throw std::string(_("could not open file"));
-            // determine sample's bit depth
-            int bitdepth;
-            switch (info.format & 0xff) {
-                case SF_FORMAT_PCM_S8:
-                case SF_FORMAT_PCM_16:
-                case SF_FORMAT_PCM_U8:
-                    bitdepth = 16;
-                    break;
-                case SF_FORMAT_PCM_24:
-                case SF_FORMAT_PCM_32:
-                case SF_FORMAT_FLOAT:
-                case SF_FORMAT_DOUBLE:
-                    bitdepth = 24;
-                    break;
-                default:
-                    sf_close(hFile); // close sound file
-                    throw std::string(_("format not supported")); // unsupported subformat (yet?)
-            }
+         iter != m_SampleImportQueue.end(); ++iter)
+    {
+        printf("Importing sample %s\n", iter->second.sample_path.c_str());
+        AudioFileImport import;
+        import.path       = iter->second.sample_path;
+        import.sample     = iter->second.gig_sample;
+        import.conversion = iter->second.conversion;
+        imports.push_back(import);
+    }
+    importAudioFiles(imports);
 
-            // reset write position for sample
-            iter->first->SetPos(0);
-
-            const int bufsize = 10000;
-            switch (bitdepth) {
-                case 16: {
-                    short* buffer = new short[bufsize * info.channels];
-                    sf_count_t cnt = info.frames;
-                    while (cnt) {
-                        // libsndfile does the conversion for us (if needed)
-                        int n = sf_readf_short(hFile, buffer, bufsize);
-                        // write from buffer directly (physically) into .gig file
-                        iter->first->Write(buffer, n);
-                        cnt -= n;
-                    }
-                    delete[] buffer;
-                    break;
-                }
-                case 24: {
-                    int* srcbuf = new int[bufsize * info.channels];
-                    uint8_t* dstbuf = new uint8_t[bufsize * 3 * info.channels];
-                    sf_count_t cnt = info.frames;
-                    while (cnt) {
-                        // libsndfile returns 32 bits, convert to 24
-                        int n = sf_readf_int(hFile, srcbuf, bufsize);
-                        int j = 0;
-                        for (int i = 0 ; i < n * info.channels ; i++) {
-                            dstbuf[j++] = srcbuf[i] >> 8;
-                            dstbuf[j++] = srcbuf[i] >> 16;
-                            dstbuf[j++] = srcbuf[i] >> 24;
-                        }
-                        // write from buffer directly (physically) into .gig file
-                        iter->first->Write(dstbuf, n);
-                        cnt -= n;
-                    }
-                    delete[] srcbuf;
-                    delete[] dstbuf;
-                    break;
-                }
-            }
-            // cleanup
-            sf_close(hFile);
+    for (size_t i = 0; i < imports.size(); ++i) {
+        if (imports[i].error.empty()) {
             // let the sampler re-cache the sample if needed
-            sample_changed_signal.emit(iter->first);
+            sample_changed_signal.emit(imports[i].sample);
+            sample_data_changed_signal.emit(imports[i].sample, SampleChange(true));
             // on success we remove the sample from the import queue,
             // otherwise keep it, maybe it works the next time ?
-            std::map<gig::Sample*, SampleImportItem>::iterator cur = iter;
-            ++iter;
-            m_SampleImportQueue.erase(cur);
-        } catch (std::string what) {
+            m_SampleImportQueue.erase(imports[i].sample);
+        } else {
             // remember the files that made trouble (and their cause)
             if (!error_files.empty()) error_files += "\n";
-            error_files += iter->second.sample_path += " (" + what + ")";
-            ++iter;
+            error_files += imports[i].path + " (" + imports[i].error + ")";
         }
     }
     // show error message box when some sample(s) could not be imported
@@ -3426,6 +3925,14 @@ void SampleProps::update_name()
 
 void MainWindow::file_changed()
 {
+    if (file) file_structure_is_changed = true;
+    m_recoveryJournal.structureChanged();
+    file_articulation_changed();
+}
+
+void MainWindow::file_articulation_changed()
+{
+    schedule_recovery_flush();
     if (file && !file_is_changed) {
         set_title("*" + get_title());
         file_is_changed = true;
@@ -3437,20 +3944,7 @@ void MainWindow::updateSampleRefCountMap(gig::File* gig) {
     
     if (!gig) return;
 
-    for (gig::Instrument* instrument = gig->GetFirstInstrument(); instrument;
-         instrument = gig->GetNextInstrument())
-    {
-        for (gig::Region* rgn = instrument->GetFirstRegion(); rgn;
-             rgn = instrument->GetNextRegion())
-        {
-            for (int i = 0; i < 256; ++i) {
-                if (!rgn->pDimensionRegions[i]) continue;
-                if (rgn->pDimensionRegions[i]->pSample) {
-                    sample_ref_count[rgn->pDimensionRegions[i]->pSample]++;
-                }
-            }
-        }
-    }
+    sample_ref_count = countSampleReferences(gig);
 }
 
 bool MainWindow::onQueryTreeViewTooltip(int x, int y, bool keyboardTip, const Glib::RefPtr<Gtk::Tooltip>& tooltip) {
@@ -3504,6 +3998,7 @@ static Glib::ustring scriptTooltipFor(gig::Instrument* instrument, int index) {
 
 void MainWindow::load_gig(gig::File* gig, const char* filename, bool isSharedInstrument)
 {
+    GIGEDIT_TRACE_SCOPE("MainWindow::load_gig");
     file = 0;
     set_file_is_shared(isSharedInstrument);
 
@@ -3514,17 +4009,29 @@ void MainWindow::load_gig(gig::File* gig, const char* filename, bool isSharedIns
     set_title(Glib::filename_display_basename(this->filename));
     file_has_name = filename;
     file_is_changed = false;
+    file_structure_is_changed = false;
+
+    clear_undo_history();
+
+    // recovery is only offered by load_file(), so in shared mode the journal
+    // of a former session is left alone
+    if (!isSharedInstrument || !RecoveryJournal::exists(gig->GetFileName()))
+        m_recoveryJournal.start(gig);
 
     fileProps.set_file(gig);
+    m_paramSheet.set_file(gig, NULL);
+    m_dimRegionSearch.set_file(gig);
 
     instrument_name_connection.block();
+    // reuse the rows already shown by on_loader_headers_loaded(), if any
+    Gtk::TreeModel::iterator iter = m_refTreeModel->children().begin();
     int index = 0;
     for (gig::Instrument* instrument = gig->GetFirstInstrument() ; instrument ;
-         instrument = gig->GetNextInstrument(), ++index) {
+         instrument = gig->GetNextInstrument(), ++index, ++iter) {
         Glib::ustring name(gig_to_utf8(instrument->pInfo->Name));
         const int iScriptSlots = instrument->ScriptSlotCount();
 
-        Gtk::TreeModel::iterator iter = m_refTreeModel->append();
+        if (!iter) iter = m_refTreeModel->append();
         Gtk::TreeModel::Row row = *iter;
         row[m_Columns.m_col_nr] = index;
         row[m_Columns.m_col_name] = name;
@@ -3536,6 +4043,7 @@ void MainWindow::load_gig(gig::File* gig, const char* filename, bool isSharedIns
         add_instrument_to_menu(name);
 #endif
     }
+    while (iter) iter = m_refTreeModel->erase(iter);
     instrument_name_connection.unblock();
 #if !USE_GTKMM_BUILDER
     uiManager->get_widget("/MenuBar/MenuInstrument/AllInstruments")->show();
@@ -3589,6 +4097,11 @@ void MainWindow::load_gig(gig::File* gig, const char* filename, bool isSharedIns
     m_TreeViewSamples.expand_all();
     m_TreeViewScripts.expand_all();
 
+    // index all names now, so the first search keystroke is not delayed
+    m_instrumentSearch.rebuild();
+    m_sampleSearch.rebuild();
+    m_scriptSearch.rebuild();
+
     file = gig;
 
     // select the first instrument
@@ -3617,6 +4130,7 @@ bool MainWindow::instr_props_set_instrument()
         gig::Instrument* instrument = row[m_Columns.m_col_instr];
 
         instrumentProps.set_instrument(instrument);
+        m_undoJournal.trackInstrument(instrument);
 
         // make sure instrument tree is updated when user changes the
         // instrument name in instrument properties window
@@ -3743,16 +4257,12 @@ void MainWindow::onScriptSlotsModified(gig::Instrument* pInstrument) {
     if (!pInstrument) return;
     const int iScriptSlots = pInstrument->ScriptSlotCount();
 
-    //NOTE: This is a big mess! Sometimes GTK requires m_TreeView.get_model(), here we need m_refTreeModelFilter->get_model(), otherwise accessing children below causes an error!
-    //Glib::RefPtr<Gtk::TreeModel> model = m_TreeView.get_model();
-    Glib::RefPtr<Gtk::TreeModel> model = m_refTreeModelFilter->get_model();
-
-    for (int i = 0; i < model->children().size(); ++i) {
-        Gtk::TreeModel::Row row = model->children()[i];
-        if (row[m_Columns.m_col_instr] != pInstrument) continue;
+    Gtk::TreeModel::iterator it = m_instrumentRows.find(pInstrument);
+    if (it) {
+        Gtk::TreeModel::Row row = *it;
         row[m_Columns.m_col_scripts] = iScriptSlots ? ToString(iScriptSlots) : "";
-        row[m_Columns.m_col_tooltip] = scriptTooltipFor(pInstrument, i);
-        break;
+        row[m_Columns.m_col_tooltip] =
+            scriptTooltipFor(pInstrument, m_instrumentRows.position(pInstrument));
     }
 
     // causes the sampler to reload the instrument with the new script
@@ -3878,6 +4388,89 @@ void MainWindow::on_save_with_temporary_file() {
 #endif
 }
 
+void MainWindow::on_detect_pitch_on_import() {
+#if USE_GLIB_ACTION
+    bool active = false;
+    m_actionToggleDetectPitchOnImport->get_state(active);
+    // for some reason toggle state does not change automatically
+    active = !active;
+    m_actionToggleDetectPitchOnImport->change_state(active);
+    Settings::singleton()->detectPitchOnImport = active;
+#else
+    Gtk::CheckMenuItem* item =
+        dynamic_cast<Gtk::CheckMenuItem*>(uiManager->get_widget("/MenuBar/MenuSettings/DetectPitchOnImport"));
+    if (!item) {
+        std::cerr << "/MenuBar/MenuSettings/DetectPitchOnImport == NULL\n";
+        return;
+    }
+    Settings::singleton()->detectPitchOnImport = item->get_active();
+#endif
+}
+
+void MainWindow::on_live_parameter_editing() {
+#if USE_GLIB_ACTION
+    bool active = false;
+    m_actionToggleLiveParameterEditing->get_state(active);
+    // for some reason toggle state does not change automatically
+    active = !active;
+    m_actionToggleLiveParameterEditing->change_state(active);
+    Settings::singleton()->liveParameterEditing = active;
+#else
+    Gtk::CheckMenuItem* item =
+        dynamic_cast<Gtk::CheckMenuItem*>(uiManager->get_widget("/MenuBar/MenuSettings/LiveParameterEditing"));
+    if (!item) {
+        std::cerr << "/MenuBar/MenuSettings/LiveParameterEditing == NULL\n";
+        return;
+    }
+    Settings::singleton()->liveParameterEditing = item->get_active();
+#endif
+}
+
+void MainWindow::on_action_record_trace() {
+#if USE_GLIB_ACTION
+    bool active = false;
+    m_actionToggleRecordTrace->get_state(active);
+    // for some reason toggle state does not change automatically
+    active = !active;
+    m_actionToggleRecordTrace->change_state(active);
+#else
+    Gtk::CheckMenuItem* item =
+        dynamic_cast<Gtk::CheckMenuItem*>(uiManager->get_widget("/MenuBar/MenuTools/RecordTrace"));
+    if (!item) {
+        std::cerr << "/MenuBar/MenuTools/RecordTrace == NULL\n";
+        return;
+    }
+    const bool active = item->get_active();
+#endif
+    // start a new recording each time
+    if (active) clearTrace();
+    setTraceEnabled(active);
+}
+
+void MainWindow::on_action_save_trace() {
+    Gtk::FileChooserDialog dialog(*this, _("Save Performance Trace"), Gtk::FILE_CHOOSER_ACTION_SAVE);
+#if HAS_GTKMM_STOCK
+    dialog.add_button(Gtk::Stock::CANCEL, Gtk::RESPONSE_CANCEL);
+    dialog.add_button(Gtk::Stock::SAVE, Gtk::RESPONSE_OK);
+#else
+    dialog.add_button(_("_Cancel"), Gtk::RESPONSE_CANCEL);
+    dialog.add_button(_("_Save"), Gtk::RESPONSE_OK);
+#endif
+    dialog.set_default_response(Gtk::RESPONSE_OK);
+    dialog.set_do_overwrite_confirmation();
+    dialog.set_current_name("gigedit-trace.json");
+    if (dialog.run() != Gtk::RESPONSE_OK) return;
+    dialog.hide();
+
+    std::string filename = dialog.get_filename();
+    if (!Glib::str_has_suffix(filename, ".json")) filename += ".json";
+    if (!writeChromeTrace(filename)) {
+        Glib::ustring txt = _("Could not write file ") + filename;
+        Gtk::MessageDialog msg(*this, txt, false, Gtk::MESSAGE_ERROR);
+        msg.run();
+    }
+}
+
 bool MainWindow::is_copy_samples_unity_note_enabled() const {
 #if USE_GLIB_ACTION
     bool active = false;
@@ -3978,7 +4571,7 @@ void MainWindow::on_action_move_instr() {
     gig::Instrument* instr = get_instrument();
     if (!instr) return;
 
-    int currentIndex = getIndexOf(instr);
+    int currentIndex = m_instrumentRows.position(instr);
 
     Gtk::Dialog dialog(_("Move Instrument"), true /*modal*/);
 #if (GTKMM_MAJOR_VERSION == 2 && GTKMM_MINOR_VERSION < 90) || GTKMM_MAJOR_VERSION < 2
@@ -4036,31 +4629,27 @@ void MainWindow::on_action_move_instr() {
 
 void MainWindow::select_instrument(gig::Instrument* instrument) {
     if (!instrument) return;
-
-    //NOTE: This is a big mess! Sometimes GTK requires m_refTreeModelFilter->get_model(), here we need m_TreeView.get_model(), otherwise treeview selection below causes an error!
-    Glib::RefPtr<Gtk::TreeModel> model = m_TreeView.get_model();
-    //Glib::RefPtr<Gtk::TreeModel> model = m_refTreeModelFilter->get_model();
-
-    for (int i = 0; i < model->children().size(); ++i) {
-        Gtk::TreeModel::Row row = model->children()[i];
-        if (row[m_Columns.m_col_instr] == instrument) {
-            // select and show the respective instrument in the list view
-            show_intruments_tab();
-            m_TreeView.get_selection()->unselect_all();
-            
-#if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && GTKMM_MINOR_VERSION > 24)
-            auto iterSel = model->children()[i].get_iter();
-            m_TreeView.get_selection()->select(iterSel);
-#else
-            m_TreeView.get_selection()->select(model->children()[i]);
-#endif
-            std::vector<Gtk::TreeModel::Path> rows =
-                m_TreeView.get_selection()->get_selected_rows();
-            if (!rows.empty())
-                m_TreeView.scroll_to_row(rows[0]);
-            on_sel_change(); // the regular instrument selection change callback
-        }
-    }
+    show_instrument_row(instrument);
+}
+
+/// Selects and scrolls to @a instrument in the instruments list view, returns false if it is not shown there.
+bool MainWindow::show_instrument_row(gig::Instrument* instrument) {
+    // the list view shows the filtered model, so instruments hidden by the
+    // search filter cannot be selected
+    Gtk::TreeModel::iterator iter = m_instrumentRows.find(instrument);
+    if (iter) iter = m_refTreeModelFilter->convert_child_iter_to_iter(iter);
+    if (!iter) return false;
+
+    // select and show the respective instrument in the list view
+    show_intruments_tab();
+    m_TreeView.get_selection()->unselect_all();
+    m_TreeView.get_selection()->select(iter);
+    std::vector<Gtk::TreeModel::Path> rows =
+        m_TreeView.get_selection()->get_selected_rows();
+    if (!rows.empty())
+        m_TreeView.scroll_to_row(rows[0]);
+    on_sel_change(); // the regular instrument selection change callback
+    return true;
 }
 
 /// Returns true if requested dimension region was successfully selected and scrolled to in the list view, false on error.
@@ -4068,66 +4657,29 @@ bool MainWindow::select_dimension_region(gig::DimensionRegion* dimRgn) {
     gig::Region* pRegion = (gig::Region*) dimRgn->GetParent();
     gig::Instrument* pInstrument = (gig::Instrument*) pRegion->GetParent();
 
-    //NOTE: This is a big mess! Sometimes GTK requires m_refTreeModelFilter->get_model(), here we need m_TreeView.get_model(), otherwise treeview selection below causes an error!
-    Glib::RefPtr<Gtk::TreeModel> model = m_TreeView.get_model();
-    //Glib::RefPtr<Gtk::TreeModel> model = m_refTreeModelFilter->get_model();
-
-    for (int i = 0; i < model->children().size(); ++i) {
-        Gtk::TreeModel::Row row = model->children()[i];
-        if (row[m_Columns.m_col_instr] == pInstrument) {
-            // select and show the respective instrument in the list view
-            show_intruments_tab();
-            m_TreeView.get_selection()->unselect_all();
-#if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && GTKMM_MINOR_VERSION > 24)
-            auto iterSel = model->children()[i].get_iter();
-            m_TreeView.get_selection()->select(iterSel);
-#else
-            m_TreeView.get_selection()->select(model->children()[i]);
-#endif
-            std::vector<Gtk::TreeModel::Path> rows =
-                m_TreeView.get_selection()->get_selected_rows();
-            if (!rows.empty())
-                m_TreeView.scroll_to_row(rows[0]);
-            on_sel_change(); // the regular instrument selection change callback
+    if (!show_instrument_row(pInstrument)) return false;
 
-            // select respective region in the region selector
-            m_RegionChooser.set_region(pRegion);
+    // select respective region in the region selector
+    m_RegionChooser.set_region(pRegion);
 
-            // select and show the respective dimension region in the editor
-            //update_dimregs();
-            if (!m_DimRegionChooser.select_dimregion(dimRgn)) return false;
-            //dimreg_edit.set_dim_region(dimRgn);
+    // select and show the respective dimension region in the editor
+    //update_dimregs();
+    if (!m_DimRegionChooser.select_dimregion(dimRgn)) return false;
+    //dimreg_edit.set_dim_region(dimRgn);
 
-            return true;
-        }
-    }
-
-    return false;
+    return true;
 }
 
 void MainWindow::select_sample(gig::Sample* sample) {
-    Glib::RefPtr<Gtk::TreeModel> model = m_TreeViewSamples.get_model();
-    for (int g = 0; g < model->children().size(); ++g) {
-        Gtk::TreeModel::Row rowGroup = model->children()[g];
-        for (int s = 0; s < rowGroup.children().size(); ++s) {
-            Gtk::TreeModel::Row rowSample = rowGroup.children()[s];
-            if (rowSample[m_SamplesModel.m_col_sample] == sample) {
-                show_samples_tab();
-                m_TreeViewSamples.get_selection()->unselect_all();
-#if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && GTKMM_MINOR_VERSION > 24)
-                auto iterSel = rowGroup.children()[s].get_iter();
-                m_TreeViewSamples.get_selection()->select(iterSel);
-#else
-                m_TreeViewSamples.get_selection()->select(rowGroup.children()[s]);
-#endif
-                std::vector<Gtk::TreeModel::Path> rows =
-                    m_TreeViewSamples.get_selection()->get_selected_rows();
-                if (rows.empty()) return;
-                m_TreeViewSamples.scroll_to_row(rows[0]);
-                return;
-            }
-        }
-    }
+    Gtk::TreeModel::iterator iter = m_sampleRows.find(sample);
+    if (!iter) return;
+    show_samples_tab();
+    m_TreeViewSamples.get_selection()->unselect_all();
+    m_TreeViewSamples.get_selection()->select(iter);
+    std::vector<Gtk::TreeModel::Path> rows =
+        m_TreeViewSamples.get_selection()->get_selected_rows();
+    if (rows.empty()) return;
+    m_TreeViewSamples.scroll_to_row(rows[0]);
 }
 
 #if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && (GTKMM_MINOR_VERSION > 91 || (GTKMM_MINOR_VERSION == 91 && GTKMM_MICRO_VERSION >= 2))) // GTKMM >= 3.91.2
@@ -4400,6 +4952,88 @@ void MainWindow::on_action_add_instrument() {
     add_instrument(instrument);
 }
 
+void MainWindow::on_action_add_instrument_from_folder() {
+    if (!file) return;
+
+    Gtk::FileChooserDialog dialog(*this, _("Select Folder"),
+                                  Gtk::FILE_CHOOSER_ACTION_SELECT_FOLDER);
+#if HAS_GTKMM_STOCK
+    dialog.add_button(Gtk::Stock::CANCEL, Gtk::RESPONSE_CANCEL);
+#else
+    dialog.add_button(_("_Cancel"), Gtk::RESPONSE_CANCEL);
+#endif
+    dialog.add_button(_("Select"), Gtk::RESPONSE_OK);
+    if (current_sample_dir != "") {
+        dialog.set_current_folder(current_sample_dir);
+    }
+    if (dialog.run() != Gtk::RESPONSE_OK) return;
+    dialog.hide();
+    const std::string folder = dialog.get_filename();
+    current_sample_dir = folder;
+
+    MappedImportDialog d(*this, folder);
+#if HAS_GTKMM_SHOW_ALL_CHILDREN
+    d.show_all();
+#else
+    d.show();
+#endif
+    d.run();
+    if (d.importRequested())
+        add_mapped_instrument(d.instrumentName(), d.files(), d.plan());
+}
+
+/**
+ * Creates an instrument from audio files mapped by planMappedImport(), with
+ * one new sample per mapped file in a new sample group. All changes are made
+ * as one structural change, so the sampler and the GUI are updated only once
+ * no matter how many samples are added. The audio data is imported when the
+ * file is saved, converted as selected for adding samples the last time.
+ */
+void MainWindow::add_mapped_instrument(const Glib::ustring& name,
+                                       const std::vector<MappedImportFile>& files,
+                                       const MappedImportPlan& plan)
+{
+    if (!file || !plan.error.empty()) return;
+    GIGEDIT_TRACE_SCOPE("MainWindow::add_mapped_instrument");
+
+    SampleConversion conversion;
+    conversion.sampleRate = Settings::singleton()->importSampleRate;
+    conversion.bitDepth   = Settings::singleton()->importBitDepth;
+    conversion.dither     = Settings::singleton()->importDither;
+
+    file_structure_to_be_changed_signal.emit(this->file);
+
+    gig::Group* group = file->AddGroup();
+    group->Name = gig_from_utf8(name);
+    std::vector<gig::Sample*> samples(files.size(), NULL);
+    for (size_t r = 0; r < plan.regions.size(); ++r) {
+        const std::vector<int>& mapped = plan.regions[r].files;
+        for (size_t i = 0; i < mapped.size(); ++i) {
+            if (mapped[i] < 0 || samples[mapped[i]]) continue;
+            const MappedImportFile& mappedFile = files[mapped[i]];
+            gig::Sample* sample = file->AddSample();
+            sample->pInfo->Name = gig_from_utf8(mappedFile.name);
+            // schedule that physical resize and sample import
+            // (data copying), performed when "Save" is requested
+            SampleImportItem sched_item;
+            sched_item.gig_sample  = sample;
+            sched_item.sample_path = mappedFile.path;
+            sched_item.conversion  = setupMappedSample(sample, mappedFile, conversion);
+            m_SampleImportQueue[sample] = sched_item;
+            group->AddSample(sample);
+            samples[mapped[i]] = sample;
+        }
+    }
+    gig::Instrument* instrument = buildMappedInstrument(file, plan, samples);
+    instrument->pInfo->Name = gig_from_utf8(name);
+
+    file_structure_changed_signal.emit(this->file);
+
+    file_changed();
+    __refreshEntireGUI();
+    select_instrument(instrument);
+}
+
 void MainWindow::on_action_duplicate_instrument() {
     if (!file) return;
 
@@ -4440,6 +5074,9 @@ void MainWindow::on_action_remove_instrument() {
 
     Glib::RefPtr<Gtk::TreeSelection> sel = m_TreeView.get_selection();
     std::vector<Gtk::TreeModel::Path> rows = sel->get_selected_rows();
+    // let views and journals drop the regions of the deleted instruments
+    file_structure_to_be_changed_signal.emit(this->file);
+    clear_undo_history();
     for (int r = rows.size() - 1; r >= 0; --r) {
         Gtk::TreeModel::iterator it = m_refTreeModel->get_iter(rows[r]);
         if (!it) continue;
@@ -4495,6 +5132,7 @@ void MainWindow::on_action_remove_instrument() {
             msg.run();
         }
     }
+    file_structure_changed_signal.emit(this->file);
 }
 
 void MainWindow::on_action_sample_properties() {
@@ -4573,6 +5211,10 @@ void MainWindow::editScript(gig::Script* script) {
     editor->signal_script_changed.connect([this](gig::Script* script) {
         // signal to sampler (which will reload the script due to this)
         signal_script_changed.emit(script);
+        // the script source lives in the script pool chunks, which the
+        // in-place articulation save does not write, so treat it as a
+        // structural change to enforce a full save
+        file_changed();
         // force script 'patch' variables editor ("Script" tab) to be refreshed
         gig::Instrument* instr = get_instrument();
         dimreg_edit.scriptVars.setInstrument(instr, true/*force update*/);
@@ -4723,10 +5365,70 @@ void MainWindow::add_or_replace_sample(bool replace) {
     if (current_sample_dir != "") {
         dialog.set_current_folder(current_sample_dir);
     }
+
+    // optional conversion of the audio files' format on import
+    static const int sampleRates[] = { 0, 22050, 44100, 48000, 88200, 96000 };
+    static const int bitDepths[] = { 0, 16, 24 };
+    HBox conversionArea;
+    Gtk::Label conversionLabel(_("Convert to: "));
+    Gtk::ComboBoxText sampleRateCombo;
+    Gtk::ComboBoxText bitDepthCombo;
+    Gtk::CheckButton ditherCheckBox(_("Dither"));
+    for (int i = 0; i < sizeof(sampleRates) / sizeof(int); ++i) {
+        const Glib::ustring txt = (sampleRates[i])
+            ? ToString(sampleRates[i]) + " Hz" : _("Original Sample Rate");
+#if (GTKMM_MAJOR_VERSION == 2 && GTKMM_MINOR_VERSION < 24) || GTKMM_MAJOR_VERSION < 2
+        sampleRateCombo.append_text(txt);
+#else
+        sampleRateCombo.append(txt);
+#endif
+        if (sampleRates[i] == Settings::singleton()->importSampleRate)
+            sampleRateCombo.set_active(i);
+    }
+    for (int i = 0; i < sizeof(bitDepths) / sizeof(int); ++i) {
+        const Glib::ustring txt = (bitDepths[i])
+            ? ToString(bitDepths[i]) + " " + _("Bit") : _("Original Bit Depth");
+#if (GTKMM_MAJOR_VERSION == 2 && GTKMM_MINOR_VERSION < 24) || GTKMM_MAJOR_VERSION < 2
+        bitDepthCombo.append_text(txt);
+#else
+        bitDepthCombo.append(txt);
+#endif
+        if (bitDepths[i] == Settings::singleton()->importBitDepth)
+            bitDepthCombo.set_active(i);
+    }
+    if (sampleRateCombo.get_active_row_number() < 0) sampleRateCombo.set_active(0);
+    if (bitDepthCombo.get_active_row_number() < 0) bitDepthCombo.set_active(0);
+    ditherCheckBox.set_active(Settings::singleton()->importDither);
+    ditherCheckBox.set_tooltip_text(_("Adds a tiny amount of noise when the bit depth is reduced, which avoids distortion of quiet signals."));
+    conversionArea.pack_start(conversionLabel, Gtk::PACK_SHRINK);
+    conversionArea.pack_start(sampleRateCombo, Gtk::PACK_SHRINK);
+    conversionArea.pack_start(bitDepthCombo, Gtk::PACK_SHRINK);
+    conversionArea.pack_start(ditherCheckBox, Gtk::PACK_SHRINK);
+#if USE_GTKMM_BOX
+    dialog.get_content_area()->pack_start(conversionArea, Gtk::PACK_SHRINK);
+#else
+    dialog.get_vbox()->pack_start(conversionArea, Gtk::PACK_SHRINK);
+#endif
+#if HAS_GTKMM_SHOW_ALL_CHILDREN
+    conversionArea.show_all();
+#else
+    conversionArea.show();
+#endif
+
     if (dialog.run() == Gtk::RESPONSE_OK) {
         dialog.hide();
         current_sample_dir = dialog.get_current_folder();
         Glib::ustring error_files;
+        SampleConversion conversion;
+        conversion.sampleRate = sampleRates[sampleRateCombo.get_active_row_number()];
+        conversion.bitDepth   = bitDepths[bitDepthCombo.get_active_row_number()];
+        conversion.dither     = ditherCheckBox.get_active();
+        Settings::singleton()->importSampleRate = conversion.sampleRate;
+        Settings::singleton()->importBitDepth   = conversion.bitDepth;
+        Settings::singleton()->importDither     = conversion.dither;
+        // samples added while a detection is still running are queued for
+        // a follow-up detection
+        const bool detectPitch = Settings::singleton()->detectPitchOnImport;
         std::vector<std::string> filenames = dialog.get_filenames();
         for (std::vector<std::string>::iterator iter = filenames.begin();
              iter != filenames.end(); ++iter) {
@@ -4737,23 +5439,15 @@ void MainWindow::add_or_replace_sample(bool replace) {
             SNDFILE* hFile = sf_open((*iter).c_str(), SFM_READ, &info);
             try {
                 if (!hFile) throw std::string(_("could not open file"));
-                int bitdepth;
-                switch (info.format & 0xff) {
-                    case SF_FORMAT_PCM_S8:
-                    case SF_FORMAT_PCM_16:
-                    case SF_FORMAT_PCM_U8:
-                        bitdepth = 16;
-                        break;
-                    case SF_FORMAT_PCM_24:
-                    case SF_FORMAT_PCM_32:
-                    case SF_FORMAT_FLOAT:
-                    case SF_FORMAT_DOUBLE:
-                        bitdepth = 24;
-                        break;
-                    default:
-                        sf_close(hFile); // close sound file
-                        throw std::string(_("format not supported")); // unsupported subformat (yet?)
+                int bitdepth = bitDepthOfSoundFileFormat(info.format);
+                if (!bitdepth) {
+                    sf_close(hFile); // close sound file
+                    throw std::string(_("format not supported")); // unsupported subformat (yet?)
                 }
+                // apply the requested target format, if any
+                if (conversion.bitDepth) bitdepth = conversion.bitDepth;
+                const int samplerate =
+                    (conversion.sampleRate) ? conversion.sampleRate : info.samplerate;
                 // add a new sample to the .gig file (if adding is requested actually)
                 if (!replace) sample = file->AddSample();
                 // file name without path
@@ -4769,10 +5463,11 @@ void MainWindow::add_or_replace_sample(bool replace) {
                 sample->Channels = info.channels;
                 sample->BitDepth = bitdepth;
                 sample->FrameSize = bitdepth / 8/*1 byte are 8 bits*/ * info.channels;
-                sample->SamplesPerSecond = info.samplerate;
+                sample->SamplesPerSecond = samplerate;
                 sample->AverageBytesPerSecond = sample->FrameSize * sample->SamplesPerSecond;
                 sample->BlockAlign = sample->FrameSize;
-                sample->SamplesTotal = info.frames;
+                sample->SamplesTotal =
+                    Resampler::outputFrames(info.frames, info.samplerate, samplerate);
 
                 SF_INSTRUMENT instrument;
                 if (sf_command(hFile, SFC_GET_INSTRUMENT,
@@ -4795,16 +5490,27 @@ void MainWindow::add_or_replace_sample(bool replace) {
                             sample->LoopType = gig::loop_type_bidirectional;
                             break;
                         }
-                        sample->LoopStart = instrument.loops[0].start;
-                        sample->LoopEnd = instrument.loops[0].end;
+                        // loop points scaled to the target sample rate
+                        sample->LoopStart = convertFramePosition(
+                            instrument.loops[0].start, info.samplerate, samplerate
+                        );
+                        sample->LoopEnd = convertFramePosition(
+                            instrument.loops[0].end + 1, info.samplerate, samplerate
+                        ) - 1;
                         sample->LoopPlayCount = instrument.loops[0].count;
                         sample->LoopSize = sample->LoopEnd - sample->LoopStart + 1;
                     }
+                } else if (detectPitch) {
+                    // no root note info in the file, so detect it later on
+                    PitchDetectionJob job;
+                    job.path = *iter;
+                    m_pitchDetectionJobs.push_back(job);
+                    m_pitchDetectionSamples.push_back(sample);
                 }
 
                 // schedule resizing the sample (which will be done
                 // physically when File::Save() is called)
-                sample->Resize(info.frames);
+                sample->Resize(sample->SamplesTotal);
                 // make sure sample is part of the selected group
                 if (!replace) group->AddSample(sample);
                 // schedule that physical resize and sample import
@@ -4812,6 +5518,9 @@ void MainWindow::add_or_replace_sample(bool replace) {
                 SampleImportItem sched_item;
                 sched_item.gig_sample  = sample;
                 sched_item.sample_path = *iter;
+                sched_item.conversion  = conversion;
+                sched_item.conversion.sampleRate = samplerate;
+                sched_item.conversion.bitDepth   = bitdepth;
                 m_SampleImportQueue[sample] = sched_item;
                 // add sample to the tree view
                 if (replace) {
@@ -4843,7 +5552,85 @@ void MainWindow::add_or_replace_sample(bool replace) {
             Gtk::MessageDialog msg(*this, txt, false, Gtk::MESSAGE_ERROR);
             msg.run();
         }
+        if (detectPitch) detect_pitch_of_added_samples();
+    }
+}
+
+PitchDetector::PitchDetector(const std::vector<PitchDetectionJob>& jobs,
+                             const std::vector<gig::Sample*>& samples) :
+    Job(_("Detecting Pitch") + Glib::ustring(" ..."), Job::PRIORITY_HIGH),
+    jobs(jobs), samples(samples)
+{
+    // the samples the results are applied to must not be deleted meanwhile
+    setModal(true);
+}
+
+void PitchDetector::run() {
+    // errors are reported per job
+    detectPitchBatch(jobs, PitchDetectionParams(), cancelToken(),
+        [this](float fraction) { setProgress(fraction); }
+    );
+    checkCancelled();
+}
+
+/**
+ * Detects the pitch of the audio files queued by add_or_replace_sample() on
+ * background threads. The unity note and fine tune of the respective samples
+ * are updated when done. If a detection is still running, the queued files are
+ * detected after it finished.
+ */
+void MainWindow::detect_pitch_of_added_samples() {
+    if (m_pitchDetectionJobs.empty() || m_pitchDetector) return;
+
+    // progress is shown by the job progress view, cancelling discards all
+    // results
+    m_pitchDetector.reset(
+        new PitchDetector(m_pitchDetectionJobs, m_pitchDetectionSamples)
+    );
+    m_pitchDetectionJobs.clear();
+    m_pitchDetectionSamples.clear();
+    m_pitchDetector->signal_finished().connect(
+        sigc::mem_fun(*this, &MainWindow::on_pitch_detection_finished));
+    m_pitchDetector->signal_error().connect(
+        sigc::mem_fun(*this, &MainWindow::on_pitch_detection_stopped));
+    m_pitchDetector->signal_cancelled().connect(
+        sigc::mem_fun(*this, &MainWindow::on_pitch_detection_stopped));
+    JobScheduler::singleton()->submit(m_pitchDetector);
+}
+
+void MainWindow::on_pitch_detection_finished() {
+    std::shared_ptr<PitchDetector> detector = m_pitchDetector;
+    m_pitchDetector.reset();
+
+    const PitchDetectionParams params;
+    int applied = 0;
+    file_structure_to_be_changed_signal.emit(this->file);
+    for (int i = 0; i < detector->jobs.size(); ++i) {
+        const PitchEstimate& pitch = detector->jobs[i].result;
+        if (!pitch.valid || pitch.confidence < params.minConfidence) continue;
+        gig::Sample* sample = detector->samples[i];
+        pitchToUnityNote(pitch, sample->MIDIUnityNote, sample->FineTune);
+        ++applied;
     }
+    file_structure_changed_signal.emit(this->file);
+    printf("Pitch detected for %d of %d samples\n", applied,
+           int(detector->jobs.size()));
+
+    PitchDetectionDialog dialog(*this, detector->jobs,
+                                detector->samples, params);
+    dialog.run();
+
+    if (applied) file_changed();
+
+    // samples added meanwhile
+    detect_pitch_of_added_samples();
+}
+
+void MainWindow::on_pitch_detection_stopped() {
+    // results of the stopped detection are discarded, but samples added
+    // meanwhile are still detected
+    m_pitchDetector.reset();
+    detect_pitch_of_added_samples();
 }
 
 void MainWindow::on_action_replace_all_samples_in_all_groups()
@@ -4922,18 +5709,9 @@ void MainWindow::on_action_replace_all_samples_in_all_groups()
             try
             {
                 if (!hFile) throw std::string(_("could not open file"));
-                switch (info.format & 0xff) {
-                    case SF_FORMAT_PCM_S8:
-                    case SF_FORMAT_PCM_16:
-                    case SF_FORMAT_PCM_U8:
-                    case SF_FORMAT_PCM_24:
-                    case SF_FORMAT_PCM_32:
-                    case SF_FORMAT_FLOAT:
-                    case SF_FORMAT_DOUBLE:
-                        break;
-                    default:
-                        sf_close(hFile);
-                        throw std::string(_("format not supported"));
+                if (!bitDepthOfSoundFileFormat(info.format)) {
+                    sf_close(hFile);
+                    throw std::string(_("format not supported"));
                 }
                 SampleImportItem sched_item;
                 sched_item.gig_sample  = sample;
@@ -5034,27 +5812,7 @@ void MainWindow::on_action_remove_unused_samples() {
     if (!file) return;
 
     // collect all samples that are not referenced by any instrument
-    std::list<gig::Sample*> lsamples;
-    for (int iSample = 0; file->GetSample(iSample); ++iSample) {
-        gig::Sample* sample = file->GetSample(iSample);
-        bool isUsed = false;
-        for (gig::Instrument* instrument = file->GetFirstInstrument(); instrument;
-                              instrument = file->GetNextInstrument())
-        {
-            for (gig::Region* rgn = instrument->GetFirstRegion(); rgn;
-                              rgn = instrument->GetNextRegion())
-            {
-                for (int i = 0; i < 256; ++i) {
-                    if (!rgn->pDimensionRegions[i]) continue;
-                    if (rgn->pDimensionRegions[i]->pSample != sample) continue;
-                    isUsed = true;
-                    goto endOfRefSearch;
-                }
-            }
-        }
-        endOfRefSearch:
-        if (!isUsed) lsamples.push_back(sample);
-    }
+    std::list<gig::Sample*> lsamples = findUnusedSamples(file);
 
     if (lsamples.empty()) return;
 
@@ -5369,13 +6127,14 @@ void MainWindow::instrument_name_changed(const Gtk::TreeModel::Path& path,
     gig::String gigname(gig_from_utf8(name));
     if (instrument && instrument->pInfo->Name != gigname) {
         instrument->pInfo->Name = gigname;
+        m_recoveryJournal.instrumentChanged(instrument);
 
         // change name in the instrument properties window
         if (instrumentProps.get_instrument() == instrument) {
             instrumentProps.update_name();
         }
 
-        file_changed();
+        file_articulation_changed();
     }
 }
 
@@ -5383,25 +6142,16 @@ bool MainWindow::instrument_row_visible(const Gtk::TreeModel::const_iterator& it
     if (!iter)
         return true;
 
-    Glib::ustring pattern = m_searchText.get_text().lowercase();
-    trim(pattern);
-    if (pattern.empty()) return true;
-
 #if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && GTKMM_MINOR_VERSION > 24)
     //HACK: on GTKMM4 development branch const_iterator cannot be easily converted to iterator, probably going to be fixed before final GTKMM4 release though.
     Gtk::TreeModel::Row row = **(Gtk::TreeModel::iterator*)(&iter);
 #else
     Gtk::TreeModel::Row row = *iter;
 #endif
-    Glib::ustring name = row[m_Columns.m_col_name];
-    name = name.lowercase();
-
-    std::vector<Glib::ustring> tokens = Glib::Regex::split_simple(" ", pattern);
-    for (int t = 0; t < tokens.size(); ++t)
-        if (name.find(tokens[t]) == Glib::ustring::npos)
-            return false;
-
-    return true;
+    // rows shown by on_loader_headers_loaded() have no instrument yet
+    gig::Instrument* instrument = row[m_Columns.m_col_instr];
+    if (!instrument) return true;
+    return m_instrumentSearch.matches(row);
 }
 
 void MainWindow::on_action_combine_instruments() {
@@ -5437,6 +6187,246 @@ void MainWindow::on_action_combine_instruments() {
     delete d;
 }
 
+void MainWindow::on_action_find_dimension_regions() {
+    m_dimRegionSearch.show();
+    m_dimRegionSearch.present();
+}
+
+/**
+ * Makes @a dimregs the set of dimension regions modified by the dimension
+ * region editor, until the user selects another region or dimension region.
+ */
+void MainWindow::select_edit_set(const std::set<gig::DimensionRegion*>& dimregs) {
+    if (dimregs.empty()) return;
+    if (!select_dimension_region(*dimregs.begin())) return;
+    dimreg_edit.dimregs = dimregs;
+    updateClipboardCopyAvailable();
+}
+
+void MainWindow::on_action_find_duplicate_samples() {
+    if (!file) return;
+
+    // samples not imported yet have no audio data to compare
+    std::set<gig::Sample*> ignore;
+    for (std::map<gig::Sample*, SampleImportItem>::iterator it = m_SampleImportQueue.begin();
+         it != m_SampleImportQueue.end(); ++it)
+    {
+        ignore.insert(it->first);
+    }
+
+    DuplicateSamplesDialog* d = new DuplicateSamplesDialog(*this, file, ignore);
+#if HAS_GTKMM_SHOW_ALL_CHILDREN
+    d->show_all();
+#else
+    d->show();
+#endif
+    d->run();
+    if (d->mergeRequested())
+        merge_duplicate_samples(d->selectedSets());
+    delete d;
+}
+
+/**
+ * Lets all dimension regions referencing one of the duplicates of the given
+ * sets reference the respective set's first sample instead and deletes the
+ * duplicates from the file. The sampler is notified only once for the whole
+ * operation.
+ */
+void MainWindow::merge_duplicate_samples(const std::vector<DuplicateSampleSet>& sets) {
+    if (!file || sets.empty()) return;
+
+    std::map<gig::Sample*,gig::Sample*> replacements;
+    std::list<gig::Sample*> lsamples;
+    for (int iSet = 0; iSet < sets.size(); ++iSet) {
+        for (int s = 1; s < sets[iSet].size(); ++s) {
+            replacements[sets[iSet][s]] = sets[iSet][0];
+            lsamples.push_back(sets[iSet][s]);
+        }
+    }
+
+    file_structure_to_be_changed_signal.emit(this->file);
+
+    const int refs = replaceSampleReferences(file, replacements);
+    printf("Merged %d duplicate samples, %d references changed\n",
+           int(lsamples.size()), refs);
+
+    samples_to_be_removed_signal.emit(lsamples);
+    try {
+        for (std::list<gig::Sample*>::iterator itSample = lsamples.begin();
+             itSample != lsamples.end(); ++itSample)
+        {
+            file->DeleteSample(*itSample);
+        }
+    } catch (RIFF::Exception e) {
+        // show error message
+        Gtk::MessageDialog msg(*this, e.Message.c_str(), false, Gtk::MESSAGE_ERROR);
+        msg.run();
+    }
+    samples_removed_signal.emit();
+
+    file_structure_changed_signal.emit(this->file);
+
+    dimreg_changed();
+    file_changed();
+    __refreshEntireGUI();
+}
+
+void MainWindow::show_loop_finder(gig::DimensionRegion* dimrgn) {
+    if (!dimrgn || !dimrgn->pSample || !dimrgn->SampleLoops) return;
+    if (m_SampleImportQueue.count(dimrgn->pSample)) {
+        Gtk::MessageDialog msg(
+            *this, _("The sample's audio data is not imported yet. Save the file first."),
+            false, Gtk::MESSAGE_INFO
+        );
+        msg.run();
+        return;
+    }
+
+    LoopFinderDialog d(*this, dimrgn->pSample,
+                       dimrgn->pSampleLoops[0].LoopStart,
+                       dimrgn->pSampleLoops[0].LoopLength);
+#if HAS_GTKMM_SHOW_ALL_CHILDREN
+    d.show_all();
+#else
+    d.show();
+#endif
+    d.run();
+    LoopCandidate loop;
+    if (d.selectedLoop(loop))
+        dimreg_edit.set_loop(loop.start, loop.length);
+}
+
+LoopSearch::LoopSearch(const std::vector<LoopFinderJob>& jobs) :
+    Job(_("Searching Loops") + Glib::ustring(" ..."), Job::PRIORITY_HIGH),
+    jobs(jobs)
+{
+    // the samples' audio data is read from the file meanwhile
+    setModal(true);
+}
+
+void LoopSearch::run() {
+    findLoopCandidatesBatch(jobs, LoopSearchParams(), cancelToken(),
+        [this](float fraction) { setProgress(fraction); }
+    );
+    checkCancelled();
+}
+
+/**
+ * Searches the best loop for each selected sample (or all samples of the
+ * selected groups) on background threads. Samples with a loop are searched
+ * around their current loop, samples without loop around the second half of
+ * the sample.
+ */
+void MainWindow::on_action_find_sample_loops() {
+    if (!file || (m_loopSearch && !m_loopSearch->isCompleted())) return;
+
+    std::set<gig::Sample*> samples;
+    Glib::RefPtr<Gtk::TreeSelection> sel = m_TreeViewSamples.get_selection();
+    std::vector<Gtk::TreeModel::Path> rows = sel->get_selected_rows();
+    for (int r = 0; r < rows.size(); ++r) {
+        Gtk::TreeModel::iterator it = m_refSamplesTreeModel->get_iter(rows[r]);
+        if (!it) continue;
+        Gtk::TreeModel::Row row = *it;
+        gig::Group* group   = row[m_SamplesModel.m_col_group];
+        gig::Sample* sample = row[m_SamplesModel.m_col_sample];
+        if (group) {
+            for (gig::Sample* pSample = group->GetFirstSample();
+                 pSample; pSample = group->GetNextSample())
+            {
+                samples.insert(pSample);
+            }
+        } else if (sample) {
+            samples.insert(sample);
+        }
+    }
+
+    const LoopSearchParams params;
+    std::vector<LoopFinderJob> jobs;
+    for (std::set<gig::Sample*>::iterator it = samples.begin();
+         it != samples.end(); ++it)
+    {
+        gig::Sample* sample = *it;
+        // audio data of samples not imported yet is not available
+        if (m_SampleImportQueue.count(sample)) continue;
+        if (sample->SamplesTotal < 4 * params.windowSize) continue;
+        LoopFinderJob job;
+        job.sample = sample;
+        if (sample->Loops) {
+            job.roughStart  = sample->LoopStart;
+            job.roughLength = sample->LoopSize;
+        } else {
+            job.roughStart  = sample->SamplesTotal / 2;
+            job.roughLength = sample->SamplesTotal * 2 / 5;
+        }
+        jobs.push_back(job);
+    }
+    if (jobs.empty()) return;
+
+    // progress is shown by the job progress view, cancelling discards all
+    // results
+    m_loopSearch.reset(new LoopSearch(jobs));
+    m_loopSearch->signal_finished().connect(
+        sigc::mem_fun(*this, &MainWindow::on_loop_search_finished));
+    m_loopSearch->signal_error().connect(
+        sigc::mem_fun(*this, &MainWindow::on_loop_search_error));
+    JobScheduler::singleton()->submit(m_loopSearch);
+}
+
+void MainWindow::on_loop_search_error() {
+    Glib::ustring txt = _("Could not search loops: ") + m_loopSearch->errorMessage();
+    m_loopSearch.reset();
+    Gtk::MessageDialog msg(*this, txt, false, Gtk::MESSAGE_ERROR);
+    msg.run();
+}
+
+void MainWindow::on_loop_search_finished() {
+    std::vector<LoopFinderJob> jobs;
+    jobs.swap(m_loopSearch->jobs);
+    m_loopSearch.reset();
+
+    std::map<gig::Sample*, LoopCandidate> best;
+    for (int i = 0; i < jobs.size(); ++i)
+        if (!jobs[i].result.empty())
+            best[jobs[i].sample] = jobs[i].result[0];
+    if (best.empty()) return;
+
+    // apply the best loop to the samples and to all dimension regions using
+    // them which already have a loop, with only one notification
+    file_structure_to_be_changed_signal.emit(this->file);
+    for (std::map<gig::Sample*, LoopCandidate>::iterator it = best.begin();
+         it != best.end(); ++it)
+    {
+        gig::Sample* sample = it->first;
+        if (!sample->Loops) {
+            sample->Loops = 1;
+            sample->LoopType = gig::loop_type_normal;
+            sample->LoopPlayCount = 0;
+        }
+        sample->LoopStart = it->second.start;
+        sample->LoopSize  = it->second.length;
+        sample->LoopEnd   = it->second.start + it->second.length - 1;
+    }
+    for (gig::Instrument* instrument = file->GetFirstInstrument(); instrument;
+         instrument = file->GetNextInstrument())
+    {
+        for (gig::Region* rgn = instrument->GetFirstRegion(); rgn;
+             rgn = instrument->GetNextRegion())
+        {
+            for (int i = 0; i < rgn->DimensionRegions; ++i) {
+                gig::DimensionRegion* d = rgn->pDimensionRegions[i];
+                if (!d || !d->SampleLoops || !best.count(d->pSample)) continue;
+                d->pSampleLoops[0].LoopStart  = best[d->pSample].start;
+                d->pSampleLoops[0].LoopLength = best[d->pSample].length;
+            }
+        }
+    }
+    file_structure_changed_signal.emit(this->file);
+
+    printf("Loops found for %d samples\n", int(best.size()));
+    dimreg_changed();
+    file_changed();
+}
+
 void MainWindow::on_action_view_references() {
     Glib::RefPtr<Gtk::TreeSelection> sel = m_TreeViewSamples.get_selection();
     std::vector<Gtk::TreeModel::Path> rows = sel->get_selected_rows();
@@ -5535,24 +6525,7 @@ void MainWindow::mergeFiles(const std::vector<std::string>& filenames) {
         std::cout << "Saving file\n" << std::flush;
         file_structure_to_be_changed_signal.emit(this->file);
 
-        progress_dialog = new ProgressDialog( //FIXME: memory leak!
-            _("Saving") +  Glib::ustring(" '") +
-            Glib::filename_display_basename(this->filename) + "' ...",
-            *this
-        );
-#if HAS_GTKMM_SHOW_ALL_CHILDREN
-        progress_dialog->show_all();
-#else
-        progress_dialog->show();
-#endif
-        saver = new Saver(this->file); //FIXME: memory leak!
-        saver->signal_progress().connect(
-            sigc::mem_fun(*this, &MainWindow::on_saver_progress));
-        saver->signal_finished().connect(
-            sigc::mem_fun(*this, &MainWindow::on_saver_finished));
-        saver->signal_error().connect(
-            sigc::mem_fun(*this, &MainWindow::on_saver_error));
-        saver->launch();
+        launch_saver(std::shared_ptr<Saver>(new Saver(this->file)));
     }
 }
 
@@ -5681,21 +6654,25 @@ void MainWindow::on_sample_ref_count_incremented(gig::Sample* sample, int offset
     sample_ref_count[sample] += offset;
     const int refcount = sample_ref_count[sample];
 
-    Glib::RefPtr<Gtk::TreeModel> model = m_TreeViewSamples.get_model();
-    for (int g = 0; g < model->children().size(); ++g) {
-        Gtk::TreeModel::Row rowGroup = model->children()[g];
-        for (int s = 0; s < rowGroup.children().size(); ++s) {
-            Gtk::TreeModel::Row rowSample = rowGroup.children()[s];
-            if (rowSample[m_SamplesModel.m_col_sample] != sample) continue;
-            rowSample[m_SamplesModel.m_col_refcount] = ToString(refcount) + " " + _("Refs.");
-            rowSample[m_SamplesModel.m_color] = refcount ? "black" : "red";
-        }
+    Gtk::TreeModel::iterator it = m_sampleRows.find(sample);
+    if (it) {
+        Gtk::TreeModel::Row rowSample = *it;
+        rowSample[m_SamplesModel.m_col_refcount] = ToString(refcount) + " " + _("Refs.");
+        rowSample[m_SamplesModel.m_color] = refcount ? "black" : "red";
     }
 }
 
+void MainWindow::on_sample_props_changed() {
+    gig::Sample* sample = sampleProps.get_sample();
+    // sample properties dialog only modifies the sample's header
+    if (sample) sample_data_changed_signal.emit(sample, SampleChange());
+}
+
 void MainWindow::on_sample_ref_changed(gig::Sample* oldSample, gig::Sample* newSample) {
     on_sample_ref_count_incremented(oldSample, -1);
     on_sample_ref_count_incremented(newSample, +1);
+    // sample references are also stored outside the instrument chunks
+    file_structure_is_changed = true;
 }
 
 void MainWindow::on_samples_to_be_removed(std::list<gig::Sample*> samples) {
@@ -5706,6 +6683,14 @@ void MainWindow::on_samples_to_be_removed(std::list<gig::Sample*> samples) {
     {
         sample_ref_count.erase(*it);
     }
+    // drop queued pitch detections of these samples (the running detection
+    // is modal, so its samples cannot be removed meanwhile)
+    for (int i = int(m_pitchDetectionSamples.size()) - 1; i >= 0; --i) {
+        if (std::find(samples.begin(), samples.end(),
+                      m_pitchDetectionSamples[i]) == samples.end()) continue;
+        m_pitchDetectionJobs.erase(m_pitchDetectionJobs.begin() + i);
+        m_pitchDetectionSamples.erase(m_pitchDetectionSamples.begin() + i);
+    }
 }
 
 void MainWindow::show_samples_tab() {
@@ -5727,12 +6712,14 @@ void MainWindow::select_instrument_by_dir(int dir) {
         select_instrument( file->GetInstrument(0) );
         return;
     }
-    for (int i = 0; file->GetInstrument(i); ++i) {
-        if (file->GetInstrument(i) == pInstrument) {
-            select_instrument( file->GetInstrument(i + dir) );
-            return;
-        }
-    }
+    // the instruments list is in file order
+    const int current = m_instrumentRows.position(pInstrument);
+    if (current < 0) return;
+    const int index = current + dir;
+    if (index < 0 || index >= int(m_refTreeModel->children().size())) return;
+    Gtk::TreeModel::Row row = m_refTreeModel->children()[index];
+    gig::Instrument* instrument = row[m_Columns.m_col_instr];
+    select_instrument(instrument);
 }
 
 void MainWindow::select_prev_instrument() {
@@ -5820,6 +6807,134 @@ void MainWindow::adjust_clipboard_content() {
     editor->show();
 }
 
+void MainWindow::schedule_undo_step()
+{
+    updateUndoRedoAvailable();
+    if (m_undoStepScheduled) return;
+    m_undoStepScheduled = true;
+    // all modifications until the main loop becomes idle form one undo step
+    Glib::signal_idle().connect_once(
+        sigc::mem_fun(*this, &MainWindow::end_undo_step)
+    );
+}
+
+void MainWindow::end_undo_step()
+{
+    m_undoStepScheduled = false;
+    m_undoJournal.endStep();
+    updateUndoRedoAvailable();
+}
+
+void MainWindow::clear_undo_history()
+{
+    m_undoJournal.clear();
+    updateUndoRedoAvailable();
+}
+
+void MainWindow::on_action_undo()
+{
+    if (!m_undoJournal.canUndo()) return;
+    const std::set<gig::Region*> regions = m_undoJournal.regionsToUndo();
+    m_undoJournal.setRecording(false);
+    {
+        std::list<RegionChangeGuard> guards;
+        for (std::set<gig::Region*>::const_iterator it = regions.begin();
+             it != regions.end(); ++it)
+        {
+            guards.emplace_back(this, *it);
+        }
+        m_undoJournal.undo();
+    }
+    m_undoJournal.setRecording(true);
+    for (std::set<gig::Region*>::const_iterator it = regions.begin();
+         it != regions.end(); ++it)
+    {
+        for (int i = 0; i < int((*it)->DimensionRegions); ++i)
+            m_recoveryJournal.dimRegionChanged((*it)->pDimensionRegions[i]);
+    }
+    on_undo_redo_applied();
+}
+
+void MainWindow::on_action_redo()
+{
+    if (!m_undoJournal.canRedo()) return;
+    const std::set<gig::Region*> regions = m_undoJournal.regionsToRedo();
+    m_undoJournal.setRecording(false);
+    {
+        std::list<RegionChangeGuard> guards;
+        for (std::set<gig::Region*>::const_iterator it = regions.begin();
+             it != regions.end(); ++it)
+        {
+            guards.emplace_back(this, *it);
+        }
+        m_undoJournal.redo();
+    }
+    m_undoJournal.setRecording(true);
+    for (std::set<gig::Region*>::const_iterator it = regions.begin();
+         it != regions.end(); ++it)
+    {
+        for (int i = 0; i < int((*it)->DimensionRegions); ++i)
+            m_recoveryJournal.dimRegionChanged((*it)->pDimensionRegions[i]);
+    }
+    on_undo_redo_applied();
+}
+
+void MainWindow::on_undo_redo_applied()
+{
+    // key ranges might have changed, and libgig recreates all dimension
+    // regions of a region whose dimensions were restored
+    m_RegionChooser.queue_draw();
+    region_changed();
+    dimreg_changed();
+
+    instrument_name_connection.block();
+    for (Gtk::TreeModel::iterator it = m_refTreeModel->children().begin();
+         it; ++it)
+    {
+        Gtk::TreeModel::Row row = *it;
+        gig::Instrument* instrument = row[m_Columns.m_col_instr];
+        if (!instrument) continue;
+        row[m_Columns.m_col_name] = gig_to_utf8(instrument->pInfo->Name);
+        m_recoveryJournal.instrumentChanged(instrument);
+    }
+    instrument_name_connection.unblock();
+    if (instrumentProps.get_instrument())
+        instrumentProps.set_instrument(instrumentProps.get_instrument());
+
+    // not file_changed(), since nothing was added or removed, so the edits
+    // can still be journaled for crash recovery
+    file_structure_is_changed = true;
+    file_articulation_changed();
+    updateUndoRedoAvailable();
+}
+
+void MainWindow::schedule_recovery_flush()
+{
+    if (m_recoveryFlushScheduled || !m_recoveryJournal.isActive()) return;
+    m_recoveryFlushScheduled = true;
+    // encode all objects modified until the main loop becomes idle at once
+    Glib::signal_idle().connect_once(
+        [this]() {
+            m_recoveryFlushScheduled = false;
+            m_recoveryJournal.flush();
+        }
+    );
+}
+
+void MainWindow::updateUndoRedoAvailable() {
+#if USE_GTKMM_BUILDER
+    m_actionUndo->property_enabled() = m_undoJournal.canUndo();
+    m_actionRedo->property_enabled() = m_undoJournal.canRedo();
+#else
+    static_cast<Gtk::MenuItem*>(
+        uiManager->get_widget("/MenuBar/MenuEdit/Undo")
+    )->set_sensitive(m_undoJournal.canUndo());
+    static_cast<Gtk::MenuItem*>(
+        uiManager->get_widget("/MenuBar/MenuEdit/Redo")
+    )->set_sensitive(m_undoJournal.canRedo());
+#endif
+}
+
 void MainWindow::updateClipboardPasteAvailable() {
     Glib::RefPtr<Gtk::Clipboard> clipboard = Gtk::Clipboard::get();
     clipboard->request_targets(
@@ -5870,18 +6985,65 @@ void MainWindow::applyMacro(Serialization::Archive& macro) {
     gig::DimensionRegion* pDimRgn = m_DimRegionChooser.get_main_dimregion();
     if (!pDimRgn) return;
 
-    for (std::set<gig::DimensionRegion*>::iterator itDimReg = dimreg_edit.dimregs.begin();
-         itDimReg != dimreg_edit.dimregs.end(); ++itDimReg)
+    // resolve the macro's members just once for all dimregions (falls back to
+    // deserialize() for each dimregion if the macro cannot be compiled)
+    CompiledMacro compiled;
+    compiled.compile(macro, pDimRgn);
+
+    applyToDimRegions(dimreg_edit.dimregs, compiled, &macro);
+    // a macro only consists of dimregion parameters
+    file_articulation_changed();
+    dimreg_changed();
+}
+
+/**
+ * Applies @a compiled to all dimension regions @a dimregs, or deserializes
+ * @a macro to them if @a compiled is not valid.
+ */
+void MainWindow::applyToDimRegions(const std::set<gig::DimensionRegion*>& dimregs,
+                                   const CompiledMacro& compiled,
+                                   Serialization::Archive* macro)
+{
+    if (!compiled.isValid() && !macro) return;
+
+    // notify the sampler just once per region instead of per dimregion
+    std::set<gig::Region*> regions;
+    for (std::set<gig::DimensionRegion*>::const_iterator itDimReg = dimregs.begin();
+         itDimReg != dimregs.end(); ++itDimReg)
     {
-        gig::DimensionRegion* pDimRgn = *itDimReg;
-        DimRegionChangeGuard(this, pDimRgn);
-        macro.deserialize(pDimRgn);
+        regions.insert((gig::Region*) (*itDimReg)->GetParent());
     }
-    //region_changed()
-    file_changed();
+    std::list<RegionChangeGuard> guards;
+    for (std::set<gig::Region*>::iterator itRgn = regions.begin();
+         itRgn != regions.end(); ++itRgn)
+    {
+        guards.emplace_back(this, *itRgn);
+    }
+
+    applyMacroToDimRegions(dimregs, compiled, macro);
+
+    for (std::set<gig::DimensionRegion*>::const_iterator itDimReg = dimregs.begin();
+         itDimReg != dimregs.end(); ++itDimReg)
+    {
+        m_recoveryJournal.dimRegionChanged(*itDimReg);
+    }
+}
+
+void MainWindow::on_param_sheet_apply(const CompiledMacro& compiled,
+                                      const std::set<gig::DimensionRegion*>& dimregs)
+{
+    // the region guards also refresh the sheet and record the undo step
+    applyToDimRegions(dimregs, compiled, NULL);
+    file_articulation_changed();
     dimreg_changed();
 }
 
+void MainWindow::on_action_view_param_sheet() {
+    m_paramSheet.set_file(file, get_instrument());
+    m_paramSheet.show();
+    m_paramSheet.present();
+}
+
 void MainWindow::on_clipboard_received(const Gtk::SelectionData& selection_data) {
     const std::string target = selection_data.get_target();
     if (target == CLIPBOARD_DIMENSIONREGION_TARGET) {
@@ -5951,6 +7113,10 @@ sigc::signal<void, gig::Sample*>& MainWindow::signal_sample_changed() {
     return sample_changed_signal;
 }
 
+sigc::signal<void, gig::Sample*, SampleChange>& MainWindow::signal_sample_data_changed() {
+    return sample_data_changed_signal;
+}
+
 sigc::signal<void, gig::Sample*/*old*/, gig::Sample*/*new*/>& MainWindow::signal_sample_ref_changed() {
     return sample_ref_changed_signal;
 }
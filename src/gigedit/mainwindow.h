@@ -68,6 +68,23 @@
 #include <mutex>
 #endif
 #include "ManagedWindow.h"
+#include "gigedit.h"
+#include "DuplicateSamples.h"
+#include "MappedImport.h"
+#include "LoopFinder.h"
+#include "PitchDetection.h"
+#include "SampleConverter.h"
+#include "UndoJournal.h"
+#include "RecoveryJournal.h"
+#include "ParamSheet.h"
+#include "DimRegionSearch.h"
+#include "LintView.h"
+#include "TreeRowIndex.h"
+#include "TreeSearch.h"
+#include "JobScheduler.h"
+#include "JobProgressView.h"
+#include <thread>
+#include <atomic>
 
 class MainWindow;
 
@@ -233,62 +250,67 @@ protected:
     StringEntry eSubject;
 };
 
-class ProgressDialog : public Gtk::Dialog {
-public:
-    ProgressDialog(const Glib::ustring& title, Gtk::Window& parent);
-    void set_fraction(float fraction) { progressBar.set_fraction(fraction); }
-protected:
-    Gtk::ProgressBar progressBar;
-};
-
-class LoaderSaverBase {
+class LoaderSaverBase : public Job {
 public:
-    void launch();
-    Glib::Dispatcher& signal_progress();
-    Glib::Dispatcher& signal_finished(); ///< Finished successfully, without error.
-    Glib::Dispatcher& signal_error();
     void progress_callback(float fraction);
-    float get_progress();
-    void join();
     const Glib::ustring filename;
-    Glib::ustring error_message;
     gig::File* gig;
 
 protected:
-    LoaderSaverBase(const Glib::ustring filename, gig::File* gig);
+    LoaderSaverBase(const Glib::ustring& title, const Glib::ustring filename,
+                    gig::File* gig, bool cancellable);
 
 private:
-#ifdef GLIB_THREADS
-    Glib::Threads::Thread* thread;
-    Glib::Threads::Mutex progressMutex;
-#else
-    std::thread thread;
-    std::mutex progressMutex;
-#endif
-    void thread_function();
+    void run();
     virtual void thread_function_sub(gig::progress_t& progress) = 0;
-    Glib::Dispatcher finished_dispatcher;
-    Glib::Dispatcher progress_dispatcher;
-    Glib::Dispatcher error_dispatcher;
-    float progress;
 };
 
 class Loader : public LoaderSaverBase {
 public:
     Loader(const char* filename);
+    sigc::signal<void>& signal_headers_loaded(); ///< Instrument names were read, instruments are still being loaded.
+
+    std::vector<std::string> instrumentNames; ///< only valid after signal_headers_loaded() was emitted
 
 private:
     void thread_function_sub(gig::progress_t& progress);
+    sigc::signal<void> headers_loaded_signal;
 };
 
 class Saver : public LoaderSaverBase {
 public:
     Saver(gig::File* file, Glib::ustring filename = ""); ///< one argument means "save", two arguments means "save as"
 
+    bool articulationOnly; ///< if true, only articulation was changed since last save (allows in-place save of just the instrument chunks)
+
 private:
     void thread_function_sub(gig::progress_t& progress);
 };
 
+/// Searches the best loops of samples, see MainWindow::on_action_find_sample_loops().
+class LoopSearch : public Job {
+public:
+    LoopSearch(const std::vector<LoopFinderJob>& jobs);
+
+    std::vector<LoopFinderJob> jobs; ///< results are only valid once finished
+
+private:
+    void run();
+};
+
+/// Detects the pitch of added audio files, see MainWindow::detect_pitch_of_added_samples().
+class PitchDetector : public Job {
+public:
+    PitchDetector(const std::vector<PitchDetectionJob>& jobs,
+                  const std::vector<gig::Sample*>& samples);
+
+    std::vector<PitchDetectionJob> jobs; ///< results are only valid once finished
+    const std::vector<gig::Sample*> samples; ///< sample of each job
+
+private:
+    void run();
+};
+
 class MainWindow : public ManagedWindow {
 public:
     MainWindow();
@@ -296,6 +318,7 @@ public:
     void load_file(const char* name);
     void load_instrument(gig::Instrument* instr);
     void file_changed();
+    void file_articulation_changed(); ///< like file_changed(), but only instrument articulation was modified
     sigc::signal<void, gig::File*>& signal_file_structure_to_be_changed();
     sigc::signal<void, gig::File*>& signal_file_structure_changed();
     sigc::signal<void, std::list<gig::Sample*> >& signal_samples_to_be_removed();
@@ -305,6 +328,7 @@ public:
     sigc::signal<void, gig::DimensionRegion*>& signal_dimreg_to_be_changed();
     sigc::signal<void, gig::DimensionRegion*>& signal_dimreg_changed();
     sigc::signal<void, gig::Sample*>& signal_sample_changed();
+    sigc::signal<void, gig::Sample*, SampleChange>& signal_sample_data_changed();
     sigc::signal<void, gig::Sample*/*old*/, gig::Sample*/*new*/>& signal_sample_ref_changed();
 
     sigc::signal<void, int/*key*/, int/*velocity*/>& signal_note_on();
@@ -336,6 +360,8 @@ protected:
 #if USE_GLIB_ACTION
     Glib::RefPtr<Gio::SimpleAction> m_actionMIDIRules;
 
+    Glib::RefPtr<Gio::SimpleAction> m_actionUndo;
+    Glib::RefPtr<Gio::SimpleAction> m_actionRedo;
     Glib::RefPtr<Gio::SimpleAction> m_actionCopyDimRgn;
     Glib::RefPtr<Gio::SimpleAction> m_actionPasteDimRgn;
     Glib::RefPtr<Gio::SimpleAction> m_actionAdjustClipboard;
@@ -360,6 +386,9 @@ protected:
     Glib::RefPtr<Gio::SimpleAction> m_actionToggleStatusBar;
     Glib::RefPtr<Gio::SimpleAction> m_actionToggleRestoreWinDim;
     Glib::RefPtr<Gio::SimpleAction> m_actionToggleSaveWithTempFile;
+    Glib::RefPtr<Gio::SimpleAction> m_actionToggleDetectPitchOnImport;
+    Glib::RefPtr<Gio::SimpleAction> m_actionToggleLiveParameterEditing;
+    Glib::RefPtr<Gio::SimpleAction> m_actionToggleRecordTrace;
     Glib::RefPtr<Gio::SimpleAction> m_actionToggleWarnOnExtensions;
     Glib::RefPtr<Gio::SimpleAction> m_actionToggleShowTooltips;
     Glib::RefPtr<Gio::SimpleAction> m_actionToggleSyncSamplerSelection;
@@ -377,6 +406,9 @@ protected:
     InstrumentProps instrumentProps;
     SampleProps sampleProps;
     MidiRules midiRules;
+    ParamSheet m_paramSheet;
+    DimRegionSearch m_dimRegionSearch;
+    LintView m_lintView;
 
     /**
      * Ensures that the 2 signals MainWindow::dimreg_to_be_changed_signal and
@@ -391,6 +423,19 @@ protected:
         }
     };
 
+    /**
+     * Same as DimRegionChangeGuard, for the 2 signals
+     * MainWindow::region_to_be_changed_signal and
+     * MainWindow::region_changed_signal.
+     */
+    class RegionChangeGuard : public SignalGuard<gig::Region*> {
+    public:
+        RegionChangeGuard(MainWindow* w, gig::Region* pRegion) :
+        SignalGuard<gig::Region*>(w->region_to_be_changed_signal, w->region_changed_signal, pRegion)
+        {
+        }
+    };
+
     sigc::signal<void, gig::File*> file_structure_to_be_changed_signal;
     sigc::signal<void, gig::File*> file_structure_changed_signal;
     sigc::signal<void, std::list<gig::Sample*> > samples_to_be_removed_signal;
@@ -400,6 +445,7 @@ protected:
     sigc::signal<void, gig::DimensionRegion*> dimreg_to_be_changed_signal;
     sigc::signal<void, gig::DimensionRegion*> dimreg_changed_signal;
     sigc::signal<void, gig::Sample*> sample_changed_signal;
+    sigc::signal<void, gig::Sample*, SampleChange> sample_data_changed_signal;
     sigc::signal<void, gig::Sample*/*old*/, gig::Sample*/*new*/> sample_ref_changed_signal;
 
     sigc::signal<void, int/*key*/, int/*velocity*/> note_on_signal;
@@ -417,17 +463,24 @@ protected:
     void select_instrument(gig::Instrument* instrument);
     bool select_dimension_region(gig::DimensionRegion* dimRgn);
     void select_sample(gig::Sample* sample);
-    void on_loader_progress();
+    bool show_instrument_row(gig::Instrument* instrument);
+    void on_loader_headers_loaded();
     void on_loader_finished();
     void on_loader_error();
-    void on_saver_progress();
+    void on_loader_cancelled();
     void on_saver_error();
     void on_saver_finished();
+    void launch_saver(const std::shared_ptr<Saver>& job);
     void updateMacroMenu();
     void onMacroSelected(int iMacro);
     void setupMacros();
     void onMacrosSetupChanged(const std::vector<Serialization::Archive>& macros);
     void applyMacro(Serialization::Archive& macro);
+    void applyToDimRegions(const std::set<gig::DimensionRegion*>& dimregs,
+                           const CompiledMacro& compiled,
+                           Serialization::Archive* macro);
+    void on_param_sheet_apply(const CompiledMacro& compiled,
+                              const std::set<gig::DimensionRegion*>& dimregs);
     void onScriptSlotsModified(gig::Instrument* pInstrument);
     void bringToFront();
 
@@ -460,6 +513,7 @@ protected:
 
     Gtk::TreeView m_TreeView;
     Glib::RefPtr<Gtk::ListStore> m_refTreeModel;
+    TreeRowIndex<gig::Instrument> m_instrumentRows; ///< rows of m_refTreeModel (in file order)
     Glib::RefPtr<Gtk::TreeModelFilter> m_refTreeModelFilter; //FIXME: I really would love to get rid of TreeModelFilter, because it causes behavior conflicts with get_model() all over the place (see the respective comments regarding get_model()), however I found no other way to filter a treeview effectively.
 
 #if USE_GTKMM_BUILDER
@@ -500,6 +554,7 @@ protected:
     Gtk::ScrolledWindow m_ScrolledWindowSamples;
     Gtk::TreeView m_TreeViewSamples;
     Glib::RefPtr<SamplesTreeStore> m_refSamplesTreeModel;
+    TreeRowIndex<gig::Sample> m_sampleRows;
 
     class ScriptsModel : public Gtk::TreeModel::ColumnRecord {
     public:
@@ -551,6 +606,12 @@ protected:
     HBox m_searchField;
     Gtk::Label m_searchLabel;
     Gtk::Entry m_searchText;
+    sigc::connection m_searchTextConnection;
+    int m_searchPage; ///< notebook page the search field applies to
+    Glib::ustring m_searchPatterns[3]; ///< search pattern of each notebook page
+    TreeSearch m_instrumentSearch;
+    TreeSearch m_sampleSearch;
+    TreeSearch m_scriptSearch;
 
     struct SampleImportItem {
         gig::Sample*  gig_sample;  // pointer to the gig::Sample to
@@ -558,6 +619,8 @@ protected:
                                    // imported to
         Glib::ustring sample_path; // file name of the sample to be
                                    // imported
+        SampleConversion conversion; // format conversion applied on
+                                     // import
     };
     std::map<gig::Sample*, SampleImportItem> m_SampleImportQueue;
 
@@ -579,7 +642,12 @@ protected:
     void on_auto_restore_win_dim();
     void on_instr_double_click_opens_props();
     void on_save_with_temporary_file();
+    void on_detect_pitch_on_import();
+    void on_live_parameter_editing();
+    void on_action_record_trace();
+    void on_action_save_trace();
     void on_action_refresh_all();
+    void on_action_view_param_sheet();
     void on_action_warn_user_on_extensions();
     void on_action_show_tooltips();
     void on_show_tooltips_changed();
@@ -588,6 +656,8 @@ protected:
     void on_action_help_about();
 
     void on_notebook_tab_switched(void* page, guint page_num);
+    void on_search_text_changed();
+    void select_search_results(TreeSearch& search, Gtk::TreeView& view, const Glib::ustring& pattern);
 
     // sample right-click popup actions
 #if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && (GTKMM_MINOR_VERSION > 91 || (GTKMM_MINOR_VERSION == 91 && GTKMM_MICRO_VERSION >= 2))) // GTKMM >= 3.91.2
@@ -616,6 +686,10 @@ protected:
     void on_action_remove_script();
 
     void on_action_add_instrument();
+    void on_action_add_instrument_from_folder();
+    void add_mapped_instrument(const Glib::ustring& name,
+                               const std::vector<MappedImportFile>& files,
+                               const MappedImportPlan& plan);
     void on_action_duplicate_instrument();
     void on_action_remove_instrument();
 
@@ -637,6 +711,25 @@ protected:
     void select_prev_dimension();
     void select_next_dimension();
 
+    UndoJournal m_undoJournal; ///< Undo/redo history of the current file.
+    bool m_undoStepScheduled;
+
+    void on_action_undo();
+    void on_action_redo();
+    void on_undo_redo_applied();
+    void schedule_undo_step();
+    void end_undo_step();
+    void clear_undo_history();
+    void updateUndoRedoAvailable();
+
+    RecoveryJournal m_recoveryJournal; ///< Crash recovery journal of the current file.
+    bool m_recoveryFlushScheduled;
+
+    void schedule_recovery_flush();
+    bool recover_unsaved_edits(gig::File* gig, const std::string& filename,
+                               RecoveryJournal::Recovered& recovered);
+    void journal_recovered_edits(const RecoveryJournal::Recovered& recovered);
+
     Serialization::Archive m_serializationArchive; ///< Clipboard content.
     std::vector<Serialization::Archive> m_macros; ///< User configured list of macros.
 
@@ -663,9 +756,16 @@ protected:
 #endif
     bool onQueryTreeViewTooltip(int x, int y, bool keyboardTip, const Glib::RefPtr<Gtk::Tooltip>& tooltip);
 
-    ProgressDialog* progress_dialog;
-    Loader* loader;
-    Saver* saver;
+    std::shared_ptr<Loader> loader;
+    std::shared_ptr<Saver> saver;
+    JobProgressView m_jobProgressView;
+
+    std::shared_ptr<LoopSearch> m_loopSearch;
+
+    // pitch detection of added samples
+    std::vector<PitchDetectionJob> m_pitchDetectionJobs; ///< not submitted yet
+    std::vector<gig::Sample*> m_pitchDetectionSamples; ///< sample of each job
+    std::shared_ptr<PitchDetector> m_pitchDetector;
     void load_gig(gig::File* gig, const char* filename, bool isSharedInstrument = false);
     void updateSampleRefCountMap(gig::File* gig);
 
@@ -673,6 +773,7 @@ protected:
     bool file_is_shared;
     bool file_has_name;
     bool file_is_changed;
+    bool file_structure_is_changed; ///< whether anything else than articulation was modified since last save
     std::string filename;
     std::string current_gig_dir;
     std::string current_sample_dir;
@@ -682,6 +783,10 @@ protected:
     bool file_save();
     bool file_save_as();
     bool check_if_savable();
+    std::vector<LintFinding> check_file();
+    void on_idle_check_file();
+    void on_action_check_file();
+    void on_lint_finding_activated(const LintFinding& finding);
 
 #if GTKMM_MAJOR_VERSION > 3 || (GTKMM_MAJOR_VERSION == 3 && (GTKMM_MINOR_VERSION > 91 || (GTKMM_MINOR_VERSION == 91 && GTKMM_MICRO_VERSION >= 2))) // GTKMM >= 3.91.2
     bool on_button_release(Gdk::EventButton& button);
@@ -721,7 +826,19 @@ protected:
     void on_action_view_references();
     void on_action_merge_files();
     void mergeFiles(const std::vector<std::string>& filenames);
-
+    void on_action_find_duplicate_samples();
+    void on_action_find_dimension_regions();
+    void select_edit_set(const std::set<gig::DimensionRegion*>& dimregs);
+    void merge_duplicate_samples(const std::vector<DuplicateSampleSet>& sets);
+    void show_loop_finder(gig::DimensionRegion* dimrgn);
+    void on_action_find_sample_loops();
+    void on_loop_search_finished();
+    void on_loop_search_error();
+    void detect_pitch_of_added_samples();
+    void on_pitch_detection_finished();
+    void on_pitch_detection_stopped();
+
+    void on_sample_props_changed();
     void on_sample_ref_changed(gig::Sample* oldSample, gig::Sample* newSample);
     void on_sample_ref_count_incremented(gig::Sample* sample, int offset);
     void on_samples_to_be_removed(std::list<gig::Sample*> samples);
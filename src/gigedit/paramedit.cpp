@@ -527,7 +527,8 @@ void ChoiceEntryLeverageCtrl::set_value(gig::leverage_ctrl_t value)
         comboIndex = -1;
         break;
     }
-    combobox.set_active(comboIndex);
+    if (combobox.get_active_row_number() != comboIndex)
+        combobox.set_active(comboIndex);
 }
 
 
@@ -613,7 +614,8 @@ void ChoiceEntryLfoWave::set_value(gig::lfo_wave_t value) {
             comboIndex = -1;
             break;
     }
-    combobox.set_active(comboIndex);
+    if (combobox.get_active_row_number() != comboIndex)
+        combobox.set_active(comboIndex);
 }
 
 
@@ -285,7 +285,9 @@ void ChoiceEntry<T>::set_value(T value)
     for (; row < nb_rows ; row++) {
         if (value == values[row]) break;
     }
-    combobox.set_active(row == nb_rows ? -1 : row);
+    if (row == nb_rows) row = -1;
+    if (combobox.get_active_row_number() != row)
+        combobox.set_active(row);
 }
 
 
@@ -38,6 +38,7 @@
 #include <gtkmm/dialog.h>
 
 #include "Settings.h"
+#include "Trace.h"
 #include "gfx/builtinpix.h"
 
 #define REGION_BLOCK_HEIGHT             30
@@ -359,6 +360,7 @@ bool RegionChooser::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
     double clipx1, clipx2, clipy1, clipy2;
     cr->get_clip_extents(clipx1, clipy1, clipx2, clipy2);
 #endif
+    GIGEDIT_TRACE_SCOPE("RegionChooser::on_draw");
 
     cr->save();
     cr->set_line_width(1);
@@ -1265,6 +1267,7 @@ void RegionChooser::add_region()
 void RegionChooser::delete_region()
 {
     instrument_struct_to_be_changed_signal.emit(instrument);
+    region_to_be_deleted_signal.emit(region);
     instrument->DeleteRegion(region);
     instrument_struct_changed_signal.emit(instrument);
     regions.update(instrument);
@@ -1304,6 +1307,10 @@ sigc::signal<void, gig::Region*>& RegionChooser::signal_region_changed_signal()
     return region_changed_signal;
 }
 
+sigc::signal<void, gig::Region*>& RegionChooser::signal_region_to_be_deleted() {
+    return region_to_be_deleted_signal;
+}
+
 sigc::signal<void, int/*key*/, int/*velocity*/>& RegionChooser::signal_keyboard_key_hit() {
     return keyboard_key_hit_signal;
 }
@@ -83,6 +83,7 @@ public:
 
     sigc::signal<void, gig::Region*>& signal_region_to_be_changed();
     sigc::signal<void, gig::Region*>& signal_region_changed_signal();
+    sigc::signal<void, gig::Region*>& signal_region_to_be_deleted();
 
     sigc::signal<void, int/*key*/, int/*velocity*/>& signal_keyboard_key_hit();
     sigc::signal<void, int/*key*/, int/*velocity*/>& signal_keyboard_key_released();
@@ -121,6 +122,7 @@ protected:
 
     sigc::signal<void, gig::Region*> region_to_be_changed_signal;
     sigc::signal<void, gig::Region*> region_changed_signal;
+    sigc::signal<void, gig::Region*> region_to_be_deleted_signal;
 
     sigc::signal<void, int/*key*/, int/*velocity*/> keyboard_key_hit_signal;
     sigc::signal<void, int/*key*/, int/*velocity*/> keyboard_key_released_signal;
@@ -0,0 +1,137 @@
+/*
+    Copyright (c) 2020 Christian Schoenebeck
+
+    This file is part of "gigedit" and released under the terms of the
+    GNU General Public License version 2.
+*/
+
+// Regression test of saving a .gig file over itself, alternating between
+// saving with a temporary file and saving directly into the existing file
+// (like the main window's "Save" does, depending on the settings). Run by
+// "make check".
+
+#include "global.h"
+#include "SyntheticGig.h"
+#include "InPlaceSave.h"
+
+#ifdef LIBGIG_HEADER_FILE
+# include LIBGIG_HEADER_FILE(gig.h)
+#else
+# include <gig.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+static int g_failures = 0;
+
+static void check(bool ok, const std::string& what) {
+    fprintf(stderr, "  %s: %s\n", ok ? "ok" : "FAILED", what.c_str());
+    if (!ok) ++g_failures;
+}
+
+static gig::DimensionRegion* firstDimRegion(gig::File* gig) {
+    gig::Instrument* instr = gig->GetFirstInstrument();
+    gig::Region* rgn = instr ? instr->GetFirstRegion() : NULL;
+    return rgn ? rgn->pDimensionRegions[0] : NULL;
+}
+
+/// Reads the first dimension region's sample start offset from a fresh copy of the file at @a path.
+static int savedSampleStartOffset(const std::string& path) {
+    RIFF::File riff(path);
+    gig::File gig(&riff);
+    gig::DimensionRegion* dimrgn = firstDimRegion(&gig);
+    return dimrgn ? dimrgn->SampleStartOffset : -1;
+}
+
+/**
+ * Changes an articulation parameter of @a gig, saves the file by @a save and
+ * checks that the file is still associated with its original path afterwards,
+ * that no temporary file is left over and that the change was written.
+ */
+static void saveAndCheck(gig::File* gig, const std::string& path,
+                         const std::string& name, uint16_t value,
+                         void (*save)(gig::File*))
+{
+    fprintf(stderr, "%s\n", name.c_str());
+    firstDimRegion(gig)->SampleStartOffset = value;
+    save(gig);
+    check(gig->GetFileName() == path, "file name is " + gig->GetFileName());
+    check(access((path + ".TMP").c_str(), F_OK) != 0, "no temporary file left");
+    check(savedSampleStartOffset(path) == value, "change was saved");
+}
+
+static void saveArticulationWithTemporaryFile(gig::File* gig) {
+    saveWithTemporaryFile(gig, true);
+}
+
+static void saveAllWithTemporaryFile(gig::File* gig) {
+    saveWithTemporaryFile(gig, false);
+}
+
+static void saveArticulationDirectly(gig::File* gig) {
+    if (saveArticulationInPlace(gig) < 0) gig->Save();
+}
+
+static void saveAllDirectly(gig::File* gig) {
+    gig->Save();
+}
+
+int main() {
+    const char* tmp = getenv("TMPDIR");
+    const std::string baseDir = (tmp && *tmp) ? tmp : "/tmp";
+    std::string dirTemplate = baseDir + "/gigedit-savetest-XXXXXX";
+    std::vector<char> buf(dirTemplate.begin(), dirTemplate.end());
+    buf.push_back(0);
+    if (!mkdtemp(&buf[0])) {
+        fprintf(stderr, "Could not create temporary directory in %s\n", baseDir.c_str());
+        return 1;
+    }
+    const std::string dir = &buf[0];
+    const std::string path = dir + "/savetest.gig";
+
+    try {
+        SyntheticGigParams params;
+        params.regions = 4;
+        params.samples = 4;
+        params.sampleFrames = 1024;
+        createSyntheticGig(path, params);
+
+        RIFF::File* riff = new RIFF::File(path);
+        gig::File* gig = new gig::File(riff);
+        gig->GetFirstSample();
+        gig->GetFirstInstrument();
+
+        // each save has to find the file at its original path, regardless
+        // how the previous save was done
+        saveAndCheck(gig, path, "articulation with temporary file", 100,
+                     saveArticulationWithTemporaryFile);
+        saveAndCheck(gig, path, "articulation with temporary file again", 200,
+                     saveArticulationWithTemporaryFile);
+        saveAndCheck(gig, path, "articulation directly", 300,
+                     saveArticulationDirectly);
+        saveAndCheck(gig, path, "whole file with temporary file", 400,
+                     saveAllWithTemporaryFile);
+        saveAndCheck(gig, path, "whole file with temporary file again", 500,
+                     saveAllWithTemporaryFile);
+        saveAndCheck(gig, path, "articulation directly", 600,
+                     saveArticulationDirectly);
+        saveAndCheck(gig, path, "whole file directly", 700,
+                     saveAllDirectly);
+
+        delete gig;
+        delete riff;
+    } catch (RIFF::Exception e) {
+        fprintf(stderr, "Error: %s\n", e.Message.c_str());
+        ++g_failures;
+    }
+    unlink(path.c_str());
+    unlink((path + ".TMP").c_str());
+    rmdir(dir.c_str());
+
+    if (g_failures) fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return g_failures ? 1 : 0;
+}
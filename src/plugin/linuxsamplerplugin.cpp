@@ -31,6 +31,7 @@
 
 #include "../gigedit/gigedit.h"
 #include "../gigedit/global.h"
+#include "../gigedit/Trace.h"
 
 #include <iostream>
 #ifdef SIGCPP_HEADER_FILE
@@ -75,7 +76,7 @@ int LinuxSamplerPlugin::Main(void* pInstrument, String sTypeName, String sTypeVe
     app->signal_file_structure_to_be_changed().connect(
         sigc::bind(
             sigc::mem_fun(
-                *this, &LinuxSamplerPlugin::NotifyDataStructureToBeChanged
+                *this, &LinuxSamplerPlugin::__onDataStructureToBeChanged
             ),
             "gig::File"
         )
@@ -83,7 +84,7 @@ int LinuxSamplerPlugin::Main(void* pInstrument, String sTypeName, String sTypeVe
     app->signal_file_structure_changed().connect(
         sigc::bind(
             sigc::mem_fun(
-                *this, &LinuxSamplerPlugin::NotifyDataStructureChanged
+                *this, &LinuxSamplerPlugin::__onDataStructureChanged
             ),
             "gig::File"
         )
@@ -92,12 +93,12 @@ int LinuxSamplerPlugin::Main(void* pInstrument, String sTypeName, String sTypeVe
         sigc::mem_fun(*this, &LinuxSamplerPlugin::__onSamplesToBeRemoved)
     );
     app->signal_samples_removed().connect(
-        sigc::mem_fun(*this, &LinuxSamplerPlugin::NotifySamplesRemoved)
+        sigc::mem_fun(*this, &LinuxSamplerPlugin::__onSamplesRemoved)
     );
     app->signal_region_to_be_changed().connect(
         sigc::bind(
             sigc::mem_fun(
-                *this, &LinuxSamplerPlugin::NotifyDataStructureToBeChanged
+                *this, &LinuxSamplerPlugin::__onDataStructureToBeChanged
             ),
             "gig::Region"
         )
@@ -105,7 +106,7 @@ int LinuxSamplerPlugin::Main(void* pInstrument, String sTypeName, String sTypeVe
     app->signal_region_changed().connect(
         sigc::bind(
             sigc::mem_fun(
-                *this, &LinuxSamplerPlugin::NotifyDataStructureChanged
+                *this, &LinuxSamplerPlugin::__onDataStructureChanged
             ),
             "gig::Region"
         )
@@ -132,16 +133,14 @@ int LinuxSamplerPlugin::Main(void* pInstrument, String sTypeName, String sTypeVe
         // ... because we are doing some event debouncing here :
         sigc::mem_fun(*this, &LinuxSamplerPlugin::__onDimRegionChanged)
     );
-    app->signal_sample_changed().connect(
-        sigc::bind(
-            sigc::mem_fun(
-                *this, &LinuxSamplerPlugin::NotifyDataStructureChanged
-            ),
-            "gig::Sample"
-        )
+    app->signal_sample_data_changed().connect(
+        // not connecting signal_sample_changed() to NotifyDataStructureChanged()
+        // anymore, because we only need to let the sampler refresh its
+        // RAM cache if the cached part of the sample was modified
+        sigc::mem_fun(*this, &LinuxSamplerPlugin::__onSampleDataChanged)
     );
     app->signal_sample_ref_changed().connect(
-        sigc::mem_fun(*this, &LinuxSamplerPlugin::NotifySampleReferenceChanged)
+        sigc::mem_fun(*this, &LinuxSamplerPlugin::__onSampleReferenceChanged)
     );
 
     app->signal_keyboard_key_hit().connect(
@@ -156,7 +155,7 @@ int LinuxSamplerPlugin::Main(void* pInstrument, String sTypeName, String sTypeVe
     app->signal_script_to_be_changed.connect(
         sigc::bind(
             sigc::mem_fun(
-                *this, &LinuxSamplerPlugin::NotifyDataStructureToBeChanged
+                *this, &LinuxSamplerPlugin::__onDataStructureToBeChanged
             ),
             "gig::Script"
         )
@@ -164,7 +163,7 @@ int LinuxSamplerPlugin::Main(void* pInstrument, String sTypeName, String sTypeVe
     app->signal_script_changed.connect(
         sigc::bind(
             sigc::mem_fun(
-                *this, &LinuxSamplerPlugin::NotifyDataStructureChanged
+                *this, &LinuxSamplerPlugin::__onDataStructureChanged
             ),
             "gig::Script"
         )
@@ -181,11 +180,38 @@ int LinuxSamplerPlugin::Main(void* pInstrument, String sTypeName, String sTypeVe
     );
     timeout_source->attach(Glib::MainContext::get_default());
 
-    // run gigedit application
-    return app->run(pGigInstr);
+    // run gigedit application (the sampler expects this call to block until
+    // the editor window was closed, other editor windows are not affected)
+    const int result = app->run(pGigInstr);
+
+    // stop polling for this editor session (thread-safe)
+    timeout_source->destroy();
+
+    return result;
+}
+
+void LinuxSamplerPlugin::__onDataStructureToBeChanged(void* pStruct, String sStructType) {
+    GIGEDIT_TRACE_SCOPE("LinuxSamplerPlugin::NotifyDataStructureToBeChanged");
+    NotifyDataStructureToBeChanged(pStruct, sStructType);
+}
+
+void LinuxSamplerPlugin::__onDataStructureChanged(void* pStruct, String sStructType) {
+    GIGEDIT_TRACE_SCOPE("LinuxSamplerPlugin::NotifyDataStructureChanged");
+    NotifyDataStructureChanged(pStruct, sStructType);
+}
+
+void LinuxSamplerPlugin::__onSamplesRemoved() {
+    GIGEDIT_TRACE_SCOPE("LinuxSamplerPlugin::NotifySamplesRemoved");
+    NotifySamplesRemoved();
+}
+
+void LinuxSamplerPlugin::__onSampleReferenceChanged(void* pOldSample, void* pNewSample) {
+    GIGEDIT_TRACE_SCOPE("LinuxSamplerPlugin::NotifySampleReferenceChanged");
+    NotifySampleReferenceChanged(pOldSample, pNewSample);
 }
 
 void LinuxSamplerPlugin::__onDimRegionToBeChanged(gig::DimensionRegion* pDimRgn) {
+    GIGEDIT_TRACE_SCOPE("LinuxSamplerPlugin::__onDimRegionToBeChanged");
     // instead of sending this signal per dimregion ...
     //NotifyDataStructureToBeChanged(pDimRgn, "gig::DimensionRegion");
 
@@ -228,6 +254,7 @@ void LinuxSamplerPlugin::__onDimRegionChangedDebounced() {
     // while, which is not the case if the app is still changing instrument
     // parameters (except if the app is i.e. currently showing an error dialog
     // to the user).
+    GIGEDIT_TRACE_SCOPE("LinuxSamplerPlugin::__onDimRegionChangedDebounced");
     priv->debounceRegionChangedScheduled = false;
     for (std::set<gig::Region*>::const_iterator it = priv->debounceRegionChange.begin();
          it != priv->debounceRegionChange.end(); ++it)
@@ -255,6 +282,7 @@ bool LinuxSamplerPlugin::__onPollPeriod() {
 }
 
 void LinuxSamplerPlugin::__onSamplesToBeRemoved(std::list<gig::Sample*> lSamples) {
+    GIGEDIT_TRACE_SCOPE("LinuxSamplerPlugin::__onSamplesToBeRemoved");
     // we have to convert the gig::Sample* list to a void* list first
     std::set<void*> samples;
     for (
@@ -265,6 +293,15 @@ void LinuxSamplerPlugin::__onSamplesToBeRemoved(std::list<gig::Sample*> lSamples
     NotifySamplesToBeRemoved(samples);
 }
 
+void LinuxSamplerPlugin::__onSampleDataChanged(gig::Sample* pSample, SampleChange change) {
+    GIGEDIT_TRACE_SCOPE("LinuxSamplerPlugin::__onSampleDataChanged");
+    if (!pSample) return;
+    // the sampler reads the sample's header information (i.e. loop points)
+    // whenever a voice is triggered, so no need to notify it about that
+    if (!change.pcmChanged) return;
+    NotifyDataStructureChanged(pSample, "gig::Sample");
+}
+
 void LinuxSamplerPlugin::__onVirtualKeyboardKeyHit(int Key, int Velocity) {
     #if HAVE_LINUXSAMPLER_VIRTUAL_MIDI_DEVICE
     SendNoteOnToSampler(Key, Velocity);
@@ -36,6 +36,8 @@
 # include <gig.h>
 #endif
 
+struct SampleChange;
+
 class LinuxSamplerPlugin : public LinuxSampler::InstrumentEditor {
     public:
         LinuxSamplerPlugin();
@@ -51,7 +53,12 @@ class LinuxSamplerPlugin : public LinuxSampler::InstrumentEditor {
         void* pApp;
         class LSPluginPrivate* priv;
 
+        void __onDataStructureToBeChanged(void* pStruct, String sStructType);
+        void __onDataStructureChanged(void* pStruct, String sStructType);
+        void __onSamplesRemoved();
+        void __onSampleReferenceChanged(void* pOldSample, void* pNewSample);
         void __onSamplesToBeRemoved(std::list<gig::Sample*> lSamples);
+        void __onSampleDataChanged(gig::Sample* pSample, SampleChange change);
         void __onVirtualKeyboardKeyHit(int Key, int Velocity);
         void __onVirtualKeyboardKeyReleased(int Key, int Velocity);
         void __requestSamplerToSwitchInstrument(gig::Instrument* pInstrument);